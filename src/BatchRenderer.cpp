@@ -0,0 +1,325 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "BatchRenderer.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Directory.h>
+#include <File.h>
+#include <String.h>
+#include <TranslatorFormats.h>
+#include <TranslatorRoster.h>
+
+#include "BitmapExporter.h"
+#include "Document.h"
+#include "MessageImporter.h"
+#include "support.h"
+#include "WonderBrush2Importer.h"
+
+// Calls the function for each bitmap output format of the installed
+// translators, until it returns true.
+template<typename Function>
+static void
+for_each_bitmap_format(Function& function)
+{
+	BTranslatorRoster* roster = BTranslatorRoster::Default();
+	translator_id* translatorIDs;
+	int32 idCount;
+	if (roster->GetAllTranslators(&translatorIDs, &idCount) != B_OK)
+		return;
+
+	for (int32 t = 0; t < idCount; t++) {
+		const translation_format* formats;
+		int32 formatCount;
+		if (roster->GetOutputFormats(translatorIDs[t], &formats,
+				&formatCount) != B_OK) {
+			continue;
+		}
+		for (int32 f = 0; f < formatCount; f++) {
+			if (formats[f].group != B_TRANSLATOR_BITMAP)
+				continue;
+			if (formats[f].type == B_TRANSLATOR_BITMAP)
+				continue;
+			if (function(formats[f])) {
+				delete[] translatorIDs;
+				return;
+			}
+		}
+	}
+
+	delete[] translatorIDs;
+}
+
+struct FindFormat {
+	FindFormat(const char* name)
+		: name(name)
+		, type(0)
+	{
+	}
+
+	bool operator()(const translation_format& format)
+	{
+		if (strcmp(format.name, name) != 0)
+			return false;
+		type = format.type;
+		return true;
+	}
+
+	const char*	name;
+	uint32		type;
+};
+
+struct PrintFormat {
+	bool operator()(const translation_format& format)
+	{
+		printf("  \"%s\"\n", format.name);
+		return false;
+	}
+};
+
+// #pragma mark -
+
+// constructor
+BatchRenderer::BatchRenderer()
+	: fTargetWidth(0)
+	, fTargetHeight(0)
+	, fTargetFolder(".")
+	, fTargetFormat(B_PNG_FORMAT)
+	, fFiles(NULL)
+	, fFileCount(0)
+	, fNextFile(0)
+	, fFailedCount(0)
+{
+}
+
+// Run
+int
+BatchRenderer::Run(int argc, char** argv)
+{
+	int32 threadCount = get_optimal_worker_thread_count();
+
+	int32 i = 1;
+	for (; i < argc; i++) {
+		if (strcmp(argv[i], "-o") == 0) {
+			if (i == argc - 1)
+				break;
+			fTargetFolder = argv[++i];
+		} else if (strcmp(argv[i], "-w") == 0) {
+			if (i == argc - 1)
+				break;
+			fTargetWidth = max_c(0, atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-h") == 0) {
+			if (i == argc - 1)
+				break;
+			fTargetHeight = max_c(0, atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-j") == 0) {
+			if (i == argc - 1)
+				break;
+			threadCount = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-f") == 0) {
+			if (i == argc - 1)
+				break;
+			FindFormat findFormat(argv[++i]);
+			for_each_bitmap_format(findFormat);
+			if (findFormat.type == 0) {
+				printf("Did not find translator \"%s\". Use -l to "
+					"list available translators.\n", findFormat.name);
+				return 1;
+			}
+			fTargetFormat = findFormat.type;
+		} else if (strcmp(argv[i], "-l") == 0) {
+			printf("Available formats:\n");
+			PrintFormat printFormat;
+			for_each_bitmap_format(printFormat);
+			return 0;
+		} else
+			break;
+	}
+	if (i == argc) {
+		_PrintUsage(argv[0]);
+		return 1;
+	}
+	create_directory(fTargetFolder.Path(), 0777);
+
+	fFiles = argv + i;
+	fFileCount = argc - i;
+	fNextFile = 0;
+	fFailedCount = 0;
+
+	if (threadCount > fFileCount)
+		threadCount = fFileCount;
+	if (threadCount < 1)
+		threadCount = 1;
+
+	// Each document is loaded, rendered and exported entirely by one
+	// thread, the threads pick the next document when they are done.
+	thread_id* threads = new(std::nothrow) thread_id[threadCount];
+	if (threads == NULL)
+		threadCount = 1;
+	int32 spawnedCount = 0;
+	for (int32 t = 1; t < threadCount; t++) {
+		thread_id thread = spawn_thread(_WorkerEntry, "batch renderer",
+			B_NORMAL_PRIORITY, this);
+		if (thread < 0 || resume_thread(thread) != B_OK)
+			break;
+		threads[spawnedCount++] = thread;
+	}
+
+	_Worker();
+
+	for (int32 t = 0; t < spawnedCount; t++) {
+		status_t ret;
+		wait_for_thread(threads[t], &ret);
+	}
+	delete[] threads;
+
+	if (fFailedCount > 0) {
+		fprintf(stderr, "Failed to render %ld of %ld documents.\n",
+			fFailedCount, fFileCount);
+		return 1;
+	}
+
+	return 0;
+}
+
+// #pragma mark -
+
+// _PrintUsage
+void
+BatchRenderer::_PrintUsage(const char* appPath)
+{
+	printf("Usage: %s -o <target folder> -f <translator> -w <width> "
+		"-h <height> -j <threads> [documents]\n", appPath);
+	printf("  -o  - The target folder to place the rendered images in.\n");
+	printf("  -w  - The maximum width of the resulting images.\n");
+	printf("  -h  - The maximum height of the resulting images. Documents "
+		"are scaled to fit while maintaining their aspect ratio.\n");
+	printf("  -f  - Use the specified translator (default is PNG).\n");
+	printf("  -j  - The number of documents to render in parallel.\n");
+	printf("Usage: %s -l\n", appPath);
+	printf("  -l  - List all available translators.\n");
+}
+
+// _WorkerEntry
+int32
+BatchRenderer::_WorkerEntry(void* cookie)
+{
+	BatchRenderer* renderer = (BatchRenderer*)cookie;
+	renderer->_Worker();
+	return 0;
+}
+
+// _Worker
+void
+BatchRenderer::_Worker()
+{
+	while (true) {
+		int32 index = atomic_add(&fNextFile, 1);
+		if (index >= fFileCount)
+			break;
+		if (_RenderDocument(fFiles[index]) != B_OK)
+			atomic_add(&fFailedCount, 1);
+	}
+}
+
+// _RenderDocument
+status_t
+BatchRenderer::_RenderDocument(const char* documentPath) const
+{
+	BFile file(documentPath, B_READ_ONLY);
+	status_t ret = file.InitCheck();
+	if (ret != B_OK) {
+		fprintf(stderr, "Failed to open '%s': %s\n", documentPath,
+			strerror(ret));
+		return ret;
+	}
+
+	DocumentRef document(new(std::nothrow) Document(BRect(0, 0, 799, 599)),
+		true);
+	if (document.Get() == NULL)
+		return B_NO_MEMORY;
+
+	{
+		AutoWriteLocker locker(document.Get());
+
+		// Native WonderBrush 3.0 images
+		MessageImporter msgImporter(document);
+		ret = msgImporter.Import(documentPath);
+		if (ret != B_OK) {
+			// Legacy WonderBrush 2.x images
+			file.Seek(0, SEEK_SET);
+			WonderBrush2Importer legacyImporter(document);
+			ret = legacyImporter.Import(file);
+		}
+	}
+	if (ret != B_OK) {
+		fprintf(stderr, "Failed to load '%s': %s\n", documentPath,
+			strerror(ret));
+		return ret;
+	}
+
+	BitmapExporter exporter(fTargetWidth, fTargetHeight);
+	exporter.SetFormat(fTargetFormat);
+
+	BPath path;
+	_GetTargetPath(documentPath, exporter.MIMEType(), path);
+
+	BFile targetFile(path.Path(), B_CREATE_FILE | B_ERASE_FILE | B_WRITE_ONLY);
+	ret = targetFile.InitCheck();
+	if (ret != B_OK) {
+		fprintf(stderr, "Failed to create file '%s': %s\n", path.Path(),
+			strerror(ret));
+		return ret;
+	}
+
+	ret = exporter.Export(document, &targetFile);
+	if (ret != B_OK) {
+		fprintf(stderr, "Failed to render '%s': %s\n", documentPath,
+			strerror(ret));
+		return ret;
+	}
+
+	printf("%s -> %s\n", documentPath, path.Path());
+	return B_OK;
+}
+
+// _GetTargetPath
+void
+BatchRenderer::_GetTargetPath(const char* documentPath, const char* mimeType,
+	BPath& path) const
+{
+	// Use the document name with the extension replaced by the MIME sub-type
+	// of the target format, "image/x-portable-anymap" for example
+	// becomes ".portable-anymap".
+	BString name(BPath(documentPath).Leaf());
+	const char* dot = strrchr(name.String(), '.');
+	if (dot != NULL && dot != name.String())
+		name.Truncate(dot - name.String());
+
+	const char* extension = mimeType != NULL ? strchr(mimeType, '/') : NULL;
+	if (extension != NULL) {
+		extension++;
+		if (strncmp(extension, "x-", 2) == 0)
+			extension += 2;
+		name << "." << extension;
+	}
+
+	path = fTargetFolder;
+	path.Append(name.String());
+}
+
+// #pragma mark -
+
+// main
+int
+main(int argc, char* argv[])
+{
+	BatchRenderer app;
+	return app.Run(argc, argv);
+}
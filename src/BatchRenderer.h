@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <OS.h>
+#include <Path.h>
+
+class BatchRenderer {
+public:
+								BatchRenderer();
+
+			int					Run(int argc, char** argv);
+
+private:
+			void				_PrintUsage(const char* appPath);
+
+	static	int32				_WorkerEntry(void* cookie);
+			void				_Worker();
+
+			status_t			_RenderDocument(const char* documentPath)
+									const;
+			void				_GetTargetPath(const char* documentPath,
+									const char* mimeType, BPath& path) const;
+
+			uint32				fTargetWidth;
+			uint32				fTargetHeight;
+			BPath				fTargetFolder;
+			uint32				fTargetFormat;
+
+			char**				fFiles;
+			int32				fFileCount;
+			vint32				fNextFile;
+			vint32				fFailedCount;
+};
+
+#endif // BATCH_RENDERER_H
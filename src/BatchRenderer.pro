@@ -0,0 +1,87 @@
+TARGET = BatchRenderer
+
+include (tools_common.pro)
+
+SOURCES += \
+	BatchRenderer.cpp \
+	edits/base/CompoundEdit.cpp \
+	edits/base/EditContext.cpp \
+	edits/base/EditManager.cpp \
+	edits/base/EditStack.cpp \
+	edits/base/SpillFile.cpp \
+	edits/base/UndoableEdit.cpp \
+	import_export/Exporter.cpp \
+	import_export/bitmap/BitmapExporter.cpp \
+	import_export/message/ChunkFile.cpp \
+	import_export/message/MessageImporter.cpp \
+	import_export/message/WonderBrush2Importer.cpp \
+	model/document/Document.cpp \
+	model/fills/Brush.cpp \
+	model/fills/Style.cpp \
+	model/objects/BoundedObject.cpp \
+	model/objects/BrushStroke.cpp \
+	model/objects/Filter.cpp \
+	model/objects/FilterBrightness.cpp \
+	model/objects/FilterContrast.cpp \
+	model/objects/FilterDropShadow.cpp \
+	model/objects/FilterSaturation.cpp \
+	model/objects/Image.cpp \
+	model/objects/Layer.cpp \
+	model/objects/LayerObserver.cpp \
+	model/objects/Object.cpp \
+	model/objects/PathInstance.cpp \
+	model/objects/Rect.cpp \
+	model/objects/Shape.cpp \
+	model/objects/ShapeObserver.cpp \
+	model/objects/Styleable.cpp \
+	model/objects/Text.cpp \
+	model/snapshots/BoundedObjectSnapshot.cpp \
+	model/snapshots/BrushStrokeSnapshot.cpp \
+	model/snapshots/FilterBrightnessSnapshot.cpp \
+	model/snapshots/FilterContrastSnapshot.cpp \
+	model/snapshots/FilterDropShadowSnapshot.cpp \
+	model/snapshots/FilterSaturationSnapshot.cpp \
+	model/snapshots/FilterSnapshot.cpp \
+	model/snapshots/ImageSnapshot.cpp \
+	model/snapshots/LayerSnapshot.cpp \
+	model/snapshots/ObjectSnapshot.cpp \
+	model/snapshots/RectSnapshot.cpp \
+	model/snapshots/ShapeSnapshot.cpp \
+	model/snapshots/StyleableSnapshot.cpp \
+	model/snapshots/TextSnapshot.cpp \
+	model/text/CharacterStyle.cpp \
+	model/text/Font.cpp \
+	model/text/StyleRun.cpp \
+	model/text/StyleRunList.cpp \
+	render/AlphaBuffer.cpp \
+	render/BlurResultCache.cpp \
+	render/BoxBlurFilter.cpp \
+	render/FlattenedPath.cpp \
+	render/FontCache.cpp \
+	render/LayoutContext.cpp \
+	render/OffscreenRenderer.cpp \
+	render/Path.cpp \
+	render/StackBlurFilter.cpp \
+	render/TextLayout.cpp \
+	render/TextRenderer.cpp \
+	render/TileCache.cpp \
+	render/TiledRenderBuffer.cpp \
+	render/VertexSource.cpp \
+	render/text/FontRegistry.cpp \
+	savers/DocumentSaver.cpp \
+	support/bitmap_compression.cpp \
+	support/bitmap_support.cpp \
+	support/HashString.cpp \
+	support/ListenerAdapter.cpp \
+	support/ObjectTracker.cpp \
+	support/RWLocker.cpp \
+	support/SpatialIndex.cpp
+
+HEADERS += \
+	BatchRenderer.h \
+	import_export/Exporter.h \
+	import_export/bitmap/BitmapExporter.h \
+	import_export/message/ChunkFile.h \
+	import_export/message/MessageImporter.h \
+	import_export/message/WonderBrush2Importer.h \
+	render/OffscreenRenderer.h
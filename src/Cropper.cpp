@@ -1,11 +1,16 @@
 #include "Cropper.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <Bitmap.h>
 #include <BitmapStream.h>
 #include <Directory.h>
 #include <File.h>
 #include <Rect.h>
 #include <TranslationUtils.h>
+#include <TranslatorFormats.h>
 #include <TranslatorRoster.h>
 
 #include "RenderBuffer.h"
@@ -13,40 +18,17 @@
 
 // constructor
 Cropper::Cropper()
-	: BApplication("application/x-vnd.yellowbites.Cropper")
-	, fPrintUsage(true)
-	, fTargetWidth(-1)
+	: fTargetWidth(-1)
 	, fTargetHeight(-1)
 	, fTargetFolder("/boot/home/Desktop")
 	, fTargetFormat(B_JPEG_FORMAT)
 {
 }
 
-// MessageReceived
-void
-Cropper::MessageReceived(BMessage* message)
-{
-	switch (message->what) {
-		default:
-			BApplication::MessageReceived(message);
-			break;
-	}
-}
-
-// ReadyToRun
-void
-Cropper::ReadyToRun()
-{
-	if (fPrintUsage)
-		_PrintUsage("Cropper");
-	PostMessage(B_QUIT_REQUESTED);
-}
-
-// ArgvReceived
-void
-Cropper::ArgvReceived(int32 argc, char** argv)
+// Run
+int
+Cropper::Run(int argc, char** argv)
 {
-	fPrintUsage = false;
 	int32 i = 1;
 	for (; i < argc; i++) {
 		if (strcmp(argv[i], "-o") == 0) {
@@ -93,7 +75,7 @@ Cropper::ArgvReceived(int32 argc, char** argv)
 			if (!found) {
 				printf("Did not find translator \"%s\". Use -l to "
 					"list available transators.\n", name);
-				return;
+				return 1;
 			}
 			delete[] translatorIDs;
 		} else if (strcmp(argv[i], "-l") == 0) {
@@ -116,13 +98,13 @@ Cropper::ArgvReceived(int32 argc, char** argv)
 				}
 			}
 			delete[] translatorIDs;
-			return;
+			return 0;
 		} else
 			break;
 	}
 	if (i == argc) {
 		_PrintUsage(argv[0]);
-		return;
+		return 1;
 	}
 	create_directory(fTargetFolder.Path(), 0777);
 
@@ -144,13 +126,8 @@ Cropper::ArgvReceived(int32 argc, char** argv)
 
 		delete original;
 	}
-}
 
-// RefsReceived
-void
-Cropper::RefsReceived(BMessage* message)
-{
-	printf("Cropper::RefsReceived()\n");
+	return 0;
 }
 
 // #pragma mark -
@@ -197,9 +174,7 @@ Cropper::_CropImage(const BBitmap* bitmap, int width, int height, BPath path,
 
 	BBitmapStream bitmapStream(resultBitmap);
 
-	BString name(originalPath);
-	name.Remove(0, name.FindLast('/') + 1);
-	path.Append(name);
+	path.Append(BPath(originalPath).Leaf());
 	BFile file(path.Path(), B_CREATE_FILE | B_ERASE_FILE | B_READ_WRITE);
 	if (file.InitCheck() != B_OK) {
 		fprintf(stderr, "Failed to create file '%s': %s\n",
@@ -222,10 +197,9 @@ Cropper::_CropImage(const BBitmap* bitmap, int width, int height, BPath path,
 
 // main
 int
-main(int argc, const char* argv[])
+main(int argc, char* argv[])
 {
 	Cropper app;
-	app.Run();
-	return 0;
+	return app.Run(argc, argv);
 }
 
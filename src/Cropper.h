@@ -1,18 +1,15 @@
 #ifndef CROPPER_H
 #define CROPPER_H
 
-#include <Application.h>
 #include <Path.h>
 #include <String.h>
 
-class Cropper : public BApplication {
+class BBitmap;
+class Cropper {
 public:
 								Cropper();
 
-	virtual	void				MessageReceived(BMessage* message);
-	virtual void				ReadyToRun();
-	virtual	void				ArgvReceived(int32 argc, char** argv);
-	virtual	void				RefsReceived(BMessage* message);
+			int					Run(int argc, char** argv);
 
 private:
 			void				_PrintUsage(const char* appPath);
@@ -20,7 +17,6 @@ private:
 									int width, int height,
 									BPath path, const char* originalPath) const;
 
-			bool				fPrintUsage;
 			int32				fTargetWidth;
 			int32				fTargetHeight;
 			BPath				fTargetFolder;
@@ -0,0 +1,9 @@
+TARGET = Cropper
+
+include (tools_common.pro)
+
+SOURCES += \
+	Cropper.cpp
+
+HEADERS += \
+	Cropper.h
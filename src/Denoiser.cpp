@@ -1,21 +1,23 @@
 #include "Denoiser.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <Bitmap.h>
 #include <BitmapStream.h>
 #include <Directory.h>
 #include <File.h>
 #include <Rect.h>
 #include <TranslationUtils.h>
+#include <TranslatorFormats.h>
 #include <TranslatorRoster.h>
 
 #include <CImg.h>
 
 // constructor
 Denoiser::Denoiser()
-	: BApplication("application/x-vnd.yellowbites.Denoiser")
-	, fPrintUsage(true)
-
-	, fAmplitude(60.0f)
+	: fAmplitude(60.0f)
 	, fSharpness(0.7f)
 	, fAnisotropy(0.6f)
 	, fAlpha(0.6f)
@@ -31,31 +33,10 @@ Denoiser::Denoiser()
 {
 }
 
-// MessageReceived
-void
-Denoiser::MessageReceived(BMessage* message)
-{
-	switch (message->what) {
-		default:
-			BApplication::MessageReceived(message);
-			break;
-	}
-}
-
-// ReadyToRun
-void
-Denoiser::ReadyToRun()
-{
-	if (fPrintUsage)
-		_PrintUsage("Denoiser");
-	PostMessage(B_QUIT_REQUESTED);
-}
-
-// ArgvReceived
-void
-Denoiser::ArgvReceived(int32 argc, char** argv)
+// Run
+int
+Denoiser::Run(int argc, char** argv)
 {
-	fPrintUsage = false;
 	int32 i = 1;
 	for (; i < argc; i++) {
 		if (strcmp(argv[i], "-o") == 0) {
@@ -94,7 +75,7 @@ Denoiser::ArgvReceived(int32 argc, char** argv)
 			if (!found) {
 				printf("Did not find translator \"%s\". Use -l to "
 					"list available transators.\n", name);
-				return;
+				return 1;
 			}
 			delete[] translatorIDs;
 		} else if (strcmp(argv[i], "-l") == 0) {
@@ -117,13 +98,13 @@ Denoiser::ArgvReceived(int32 argc, char** argv)
 				}
 			}
 			delete[] translatorIDs;
-			return;
+			return 0;
 		} else
 			break;
 	}
 	if (i == argc) {
 		_PrintUsage(argv[0]);
-		return;
+		return 1;
 	}
 	create_directory(fTargetFolder.Path(), 0777);
 
@@ -138,13 +119,8 @@ Denoiser::ArgvReceived(int32 argc, char** argv)
 
 		delete original;
 	}
-}
 
-// RefsReceived
-void
-Denoiser::RefsReceived(BMessage* message)
-{
-	printf("Denoiser::RefsReceived()\n");
+	return 0;
 }
 
 // #pragma mark -
@@ -219,9 +195,7 @@ Denoiser::_DenoiseImage(BBitmap* bitmap, BPath path,
 
 	BBitmapStream bitmapStream(bitmap);
 
-	BString name(originalPath);
-	name.Remove(0, name.FindLast('/') + 1);
-	path.Append(name);
+	path.Append(BPath(originalPath).Leaf());
 	BFile file(path.Path(), B_CREATE_FILE | B_ERASE_FILE | B_READ_WRITE);
 	status_t ret = file.InitCheck();
 	if (ret != B_OK) {
@@ -248,10 +222,9 @@ Denoiser::_DenoiseImage(BBitmap* bitmap, BPath path,
 
 // main
 int
-main(int argc, const char* argv[])
+main(int argc, char* argv[])
 {
 	Denoiser app;
-	app.Run();
-	return 0;
+	return app.Run(argc, argv);
 }
 
@@ -1,18 +1,15 @@
 #ifndef DENOISER_H
 #define DENOISER_H
 
-#include <Application.h>
 #include <Path.h>
 #include <String.h>
 
-class Denoiser : public BApplication {
+class BBitmap;
+class Denoiser {
 public:
 								Denoiser();
 
-	virtual	void				MessageReceived(BMessage* message);
-	virtual void				ReadyToRun();
-	virtual	void				ArgvReceived(int32 argc, char** argv);
-	virtual	void				RefsReceived(BMessage* message);
+			int					Run(int argc, char** argv);
 
 private:
 			void				_PrintUsage(const char* appPath);
@@ -21,8 +18,6 @@ private:
 									const char* originalPath) const;
 
 private:
-			bool				fPrintUsage;
-
 			float				fAmplitude;
 			float				fSharpness;
 			float				fAnisotropy;
@@ -0,0 +1,9 @@
+TARGET = Denoiser
+
+include (tools_common.pro)
+
+SOURCES += \
+	Denoiser.cpp
+
+HEADERS += \
+	Denoiser.h
@@ -0,0 +1,884 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "RenderBenchmark.h"
+
+#include <new>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef __HAIKU__
+#	include <sys/resource.h>
+#endif
+
+#include <File.h>
+
+#include "BoundedObject.h"
+#include "Brush.h"
+#include "BrushStroke.h"
+#include "Filter.h"
+#include "FilterDropShadow.h"
+#include "FontRegistry.h"
+#include "Image.h"
+#include "Layer.h"
+#include "MessageImporter.h"
+#include "Path.h"
+#include "Rect.h"
+#include "RenderBuffer.h"
+#include "RenderTrace.h"
+#include "Shape.h"
+#include "support.h"
+#include "Text.h"
+#include "WonderBrush2Importer.h"
+
+// Version of the output records, increase when fields change meaning.
+static const int32 kOutputVersion = 2;
+
+static const BlendingMode kBlendingModes[] = {
+	CompOpMultiply,
+	CompOpScreen,
+	CompOpOverlay,
+	CompOpDarken,
+	CompOpLighten,
+	CompOpSoftLight,
+	CompOpSrcOver
+};
+
+static const char* kText
+	= "The quick brown fox jumps over the lazy dog. Pack my box with five "
+	"dozen liquor jugs. How vexingly quick daft zebras jump!";
+
+// The generated documents must be the same on every platform and with
+// every C library, so rand() is not used.
+struct RenderBenchmark::Random {
+	Random(uint32 seed)
+		: state(seed != 0 ? seed : 0x9e3779b9)
+	{
+	}
+
+	uint32 Next()
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	float Float(float min, float max)
+	{
+		return min + (max - min) * (Next() & 0xffffff) / (float)0xffffff;
+	}
+
+	BPoint Point(const BRect& area)
+	{
+		return BPoint(Float(area.left, area.right),
+			Float(area.top, area.bottom));
+	}
+
+	rgb_color Color(uint8 minAlpha)
+	{
+		rgb_color color;
+		color.red = Next() & 0xff;
+		color.green = Next() & 0xff;
+		color.blue = Next() & 0xff;
+		color.alpha = minAlpha + Next() % (256 - minAlpha);
+		return color;
+	}
+
+	uint32	state;
+};
+
+struct RenderBenchmark::PassResult {
+	PassResult()
+		: area()
+		, wallTime(0)
+		, status(B_OK)
+	{
+		memset(&timing, 0, sizeof(timing));
+	}
+
+	BRect			area;
+	bigtime_t		wallTime;
+	render_timing	timing;
+	status_t		status;
+};
+
+// peak_memory_usage
+/*!	Returns the largest resident size of the process so far in KiB, or -1
+	if it is not known on this platform.
+*/
+static int64
+peak_memory_usage()
+{
+#ifdef __HAIKU__
+	return -1;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+#	ifdef __APPLE__
+	return usage.ru_maxrss / 1024;
+#	else
+	return usage.ru_maxrss;
+#	endif
+#endif
+}
+
+// print_json_string
+static void
+print_json_string(FILE* output, const char* string)
+{
+	fputc('"', output);
+	for (; *string != '\0'; string++) {
+		uint8 c = (uint8)*string;
+		if (c == '"' || c == '\\')
+			fprintf(output, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(output, "\\u%04x", c);
+		else
+			fputc(c, output);
+	}
+	fputc('"', output);
+}
+
+// count_objects
+static int32
+count_objects(const Layer* layer)
+{
+	int32 count = layer->CountObjects();
+	int32 total = count;
+	for (int32 i = 0; i < count; i++) {
+		const Layer* subLayer = dynamic_cast<const Layer*>(
+			layer->ObjectAtFast(i));
+		if (subLayer != NULL)
+			total += count_objects(subLayer);
+	}
+	return total;
+}
+
+// #pragma mark -
+
+// constructor
+RenderBenchmark::RenderBenchmark()
+	: fWidth(1024)
+	, fHeight(768)
+	, fShapeCount(200)
+	, fStrokeCount(50)
+	, fTextCount(4)
+	, fLayerDepth(3)
+	, fFilterCount(1)
+	, fImageSize(2048)
+	, fSeed(1)
+	, fRepeatCount(3)
+	, fZoomLevels()
+	, fThreadCounts()
+	, fOutput(stdout)
+{
+}
+
+// destructor
+RenderBenchmark::~RenderBenchmark()
+{
+	if (fOutput != stdout)
+		fclose(fOutput);
+}
+
+// Run
+int
+RenderBenchmark::Run(int argc, char** argv)
+{
+	bool synthetic = true;
+	const char* tracePath = NULL;
+
+	int32 i = 1;
+	for (; i < argc; i++) {
+		const char* option = argv[i];
+		if (option[0] != '-')
+			break;
+		if (strcmp(option, "--no-synthetic") == 0) {
+			synthetic = false;
+			continue;
+		}
+		if (i == argc - 1) {
+			_PrintUsage(argv[0]);
+			return 1;
+		}
+		const char* value = argv[++i];
+
+		if (strcmp(option, "-w") == 0)
+			fWidth = max_c(1, atoi(value));
+		else if (strcmp(option, "-h") == 0)
+			fHeight = max_c(1, atoi(value));
+		else if (strcmp(option, "-s") == 0)
+			fShapeCount = max_c(0, atoi(value));
+		else if (strcmp(option, "-b") == 0)
+			fStrokeCount = max_c(0, atoi(value));
+		else if (strcmp(option, "-t") == 0)
+			fTextCount = max_c(0, atoi(value));
+		else if (strcmp(option, "-d") == 0)
+			fLayerDepth = max_c(0, atoi(value));
+		else if (strcmp(option, "-f") == 0)
+			fFilterCount = max_c(0, atoi(value));
+		else if (strcmp(option, "-i") == 0)
+			fImageSize = max_c(0, atoi(value));
+		else if (strcmp(option, "-r") == 0)
+			fRepeatCount = max_c(1, atoi(value));
+		else if (strcmp(option, "--seed") == 0)
+			fSeed = strtoul(value, NULL, 0);
+		else if (strcmp(option, "--fonts") == 0)
+			_LoadFonts(value);
+		else if (strcmp(option, "--trace") == 0)
+			tracePath = value;
+		else if (strcmp(option, "-z") == 0) {
+			if (!_ParseZoomLevels(value)) {
+				fprintf(stderr, "Invalid zoom levels '%s'\n", value);
+				return 1;
+			}
+		} else if (strcmp(option, "-j") == 0) {
+			if (!_ParseThreadCounts(value)) {
+				fprintf(stderr, "Invalid thread counts '%s'\n", value);
+				return 1;
+			}
+		} else if (strcmp(option, "-o") == 0) {
+			FILE* output = fopen(value, "w");
+			if (output == NULL) {
+				fprintf(stderr, "Failed to create '%s': %s\n", value,
+					strerror(errno));
+				return 1;
+			}
+			if (fOutput != stdout)
+				fclose(fOutput);
+			fOutput = output;
+		} else {
+			_PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (!synthetic && i == argc) {
+		_PrintUsage(argv[0]);
+		return 1;
+	}
+
+	if (fZoomLevels.CountItems() == 0)
+		_ParseZoomLevels("0.5,1,2");
+	if (fThreadCounts.CountItems() == 0) {
+		fThreadCounts.Add(1);
+		int32 threadCount = get_optimal_worker_thread_count();
+		if (threadCount > 1)
+			fThreadCounts.Add(threadCount);
+	}
+
+	fprintf(fOutput, "{\"type\":\"benchmark\",\"version\":%ld,"
+		"\"seed\":%lu,\"repeat\":%ld,\"cpus\":%ld}\n",
+		(long)kOutputVersion, (unsigned long)fSeed, (long)fRepeatCount,
+		(long)get_optimal_worker_thread_count());
+
+	int32 failedCount = 0;
+
+	RenderTrace::SetEnabled(tracePath != NULL);
+
+	if (synthetic) {
+		bigtime_t startTime = system_time();
+		Object* probe = NULL;
+		DocumentRef document(_CreateDocument(&probe), true);
+		if (document.Get() == NULL) {
+			fprintf(stderr, "Failed to create the synthetic document.\n");
+			return 1;
+		}
+		if (_RunDocument("synthetic", document.Get(), probe,
+				system_time() - startTime) != B_OK) {
+			failedCount++;
+		}
+	}
+
+	for (; i < argc; i++) {
+		bigtime_t startTime = system_time();
+		Object* probe = NULL;
+		DocumentRef document;
+		if (_LoadDocument(argv[i], document, &probe) != B_OK
+			|| _RunDocument(argv[i], document.Get(), probe,
+				system_time() - startTime) != B_OK) {
+			failedCount++;
+		}
+	}
+
+	fflush(fOutput);
+
+	if (tracePath != NULL) {
+		status_t ret = RenderTrace::Dump(tracePath);
+		if (ret != B_OK) {
+			fprintf(stderr, "Failed to write the trace to '%s': %s\n",
+				tracePath, strerror(ret));
+			failedCount++;
+		}
+	}
+
+	return failedCount > 0 ? 1 : 0;
+}
+
+// #pragma mark -
+
+// _PrintUsage
+void
+RenderBenchmark::_PrintUsage(const char* appPath)
+{
+	printf("Usage: %s [options] [documents]\n", appPath);
+	printf("Renders a generated document and the given documents and "
+		"prints the timings\nas one JSON object per line.\n");
+	printf("  -w <width>      - Width of the generated document "
+		"(default 1024).\n");
+	printf("  -h <height>     - Height of the generated document "
+		"(default 768).\n");
+	printf("  -s <count>      - Number of shapes (default 200).\n");
+	printf("  -b <count>      - Number of brush strokes (default 50).\n");
+	printf("  -t <count>      - Number of text blocks (default 4).\n");
+	printf("  -d <depth>      - Depth of nested layers (default 3).\n");
+	printf("  -f <count>      - Filters per layer (default 1).\n");
+	printf("  -i <size>       - Size of the image, 0 for none "
+		"(default 2048).\n");
+	printf("  -z <list>       - Zoom levels (default \"0.5,1,2\").\n");
+	printf("  -j <list>       - Thread counts (default 1 and the number "
+		"of CPUs).\n");
+	printf("  -r <count>      - Repetitions per pass, the fastest is "
+		"reported (default 3).\n");
+	printf("  -o <file>       - Write the results to the file.\n");
+	printf("  --seed <seed>   - Seed for generating the document.\n");
+	printf("  --fonts <path>  - Folder with the fonts for the text "
+		"blocks.\n");
+	printf("  --trace <file>  - Record the render passes and write them "
+		"as Chrome trace.\n");
+	printf("  --no-synthetic  - Only render the given documents.\n");
+}
+
+// _ParseZoomLevels
+bool
+RenderBenchmark::_ParseZoomLevels(const char* list)
+{
+	fZoomLevels.Clear();
+	while (*list != '\0') {
+		char* end;
+		double zoomLevel = strtod(list, &end);
+		if (end == list || zoomLevel <= 0.0 || zoomLevel > 32.0)
+			return false;
+		if (!fZoomLevels.Add(zoomLevel))
+			return false;
+		list = *end == ',' ? end + 1 : end;
+		if (*end != ',' && *end != '\0')
+			return false;
+	}
+	return fZoomLevels.CountItems() > 0;
+}
+
+// _ParseThreadCounts
+bool
+RenderBenchmark::_ParseThreadCounts(const char* list)
+{
+	fThreadCounts.Clear();
+	while (*list != '\0') {
+		char* end;
+		long threadCount = strtol(list, &end, 10);
+		if (end == list || threadCount < 1 || threadCount > 256)
+			return false;
+		if (!fThreadCounts.Add((int32)threadCount))
+			return false;
+		list = *end == ',' ? end + 1 : end;
+		if (*end != ',' && *end != '\0')
+			return false;
+	}
+	return fThreadCounts.CountItems() > 0;
+}
+
+// _LoadFonts
+void
+RenderBenchmark::_LoadFonts(const char* path)
+{
+	FontRegistry* registry = FontRegistry::Default();
+	if (!registry->Lock())
+		return;
+	registry->AddFontDirectory(path);
+	registry->Unlock();
+
+	// The fonts are scanned asynchronously, but the text blocks need to
+	// find them when the document is generated.
+	registry->Scan();
+	for (int32 i = 0; i < 500; i++) {
+		snooze(10000);
+		if (!registry->Lock())
+			return;
+		int32 count = registry->CountFontFiles();
+		registry->Unlock();
+		if (count > 0)
+			return;
+	}
+	fprintf(stderr, "No fonts found in '%s'\n", path);
+}
+
+// #pragma mark -
+
+// _CreateDocument
+/*!	Generates a document from the parameters. The same parameters always
+	result in the same document. The objects are spread over the root layer
+	and the nested layers, each nested layer uses another blending mode.
+	The probe is an object at the top of the root layer, which is moved for
+	the incremental passes.
+*/
+Document*
+RenderBenchmark::_CreateDocument(Object** _probe) const
+{
+	BRect bounds(0, 0, fWidth - 1, fHeight - 1);
+	Document* document = new(std::nothrow) Document(bounds);
+	if (document == NULL)
+		return NULL;
+
+	AutoWriteLocker locker(document);
+
+	Random random(fSeed);
+	Layer* layer = document->RootLayer();
+
+	if (fImageSize > 0) {
+		RenderBuffer* buffer = _CreatePixels(fImageSize, random);
+		if (buffer != NULL) {
+			Image* image = new(std::nothrow) Image(buffer);
+			if (image != NULL) {
+				double scale = (double)fWidth / fImageSize;
+				image->ScaleBy(BPoint(0, 0), scale, scale);
+				layer->AddObject(image);
+			}
+			buffer->RemoveReference();
+		}
+	}
+
+	uint32 layerCount = fLayerDepth + 1;
+	for (uint32 level = 0; level < layerCount; level++) {
+		// Spread the objects evenly, the remainders go to the root layer.
+		uint32 shapeCount = fShapeCount / layerCount;
+		uint32 strokeCount = fStrokeCount / layerCount;
+		uint32 textCount = fTextCount / layerCount;
+		if (level == 0) {
+			shapeCount += fShapeCount % layerCount;
+			strokeCount += fStrokeCount % layerCount;
+			textCount += fTextCount % layerCount;
+		}
+
+		if (level > 0) {
+			Layer* subLayer = new(std::nothrow) Layer(bounds);
+			if (subLayer == NULL || !layer->AddObject(subLayer)) {
+				delete subLayer;
+				break;
+			}
+			subLayer->SetBlendingMode(kBlendingModes[(level - 1)
+				% (sizeof(kBlendingModes) / sizeof(kBlendingModes[0]))]);
+			subLayer->RotateBy(bounds.LeftTop()
+				+ BPoint(fWidth / 2, fHeight / 2), random.Float(-20, 20));
+			layer = subLayer;
+		}
+
+		_FillLayer(layer, random, shapeCount, strokeCount, textCount,
+			fFilterCount, bounds);
+	}
+
+	Rect* probe = new(std::nothrow) Rect(BRect(fWidth / 4, fHeight / 4,
+		fWidth / 4 + fWidth / 10, fHeight / 4 + fHeight / 10),
+		random.Color(128));
+	if (probe != NULL && !document->RootLayer()->AddObject(probe)) {
+		delete probe;
+		probe = NULL;
+	}
+	*_probe = probe;
+
+	return document;
+}
+
+// _FillLayer
+void
+RenderBenchmark::_FillLayer(Layer* layer, Random& random, uint32 shapeCount,
+	uint32 strokeCount, uint32 textCount, uint32 filterCount,
+	BRect area) const
+{
+	float size = min_c(area.Width(), area.Height()) / 4;
+
+	// Objects of different kinds are interleaved, like they usually are
+	// in real documents.
+	uint32 count = max_c(shapeCount, max_c(strokeCount, textCount));
+	for (uint32 i = 0; i < count; i++) {
+		if (i < shapeCount && (i & 1) == 0) {
+			BPoint center = random.Point(area);
+			float width = random.Float(4, size);
+			float height = random.Float(4, size);
+			Rect* rect = new(std::nothrow) Rect(BRect(center.x, center.y,
+				center.x + width, center.y + height), random.Color(40));
+			if (rect == NULL)
+				break;
+			rect->SetRoundCornerRadius(random.Float(0, width / 4));
+			rect->RotateBy(center, random.Float(-45, 45));
+			layer->AddObject(rect);
+		} else if (i < shapeCount) {
+			PathRef path(new(std::nothrow) Path(), true);
+			if (path.Get() == NULL)
+				break;
+			BPoint center = random.Point(area);
+			float radius = random.Float(4, size / 2);
+			int32 pointCount = 3 + random.Next() % 6;
+			for (int32 p = 0; p < pointCount; p++) {
+				double angle = 2 * M_PI * p / pointCount;
+				float distance = radius * random.Float(0.5, 1.0);
+				BPoint point(center.x + distance * cos(angle),
+					center.y + distance * sin(angle));
+				BPoint control(random.Float(-radius, radius) / 3,
+					random.Float(-radius, radius) / 3);
+				path->AddPoint(point, point - control, point + control,
+					false);
+			}
+			path->SetClosed(true);
+			Shape* shape = new(std::nothrow) Shape(path, random.Color(40));
+			if (shape == NULL)
+				break;
+			layer->AddObject(shape);
+		}
+
+		if (i < strokeCount) {
+			BrushStroke* stroke = new(std::nothrow) BrushStroke();
+			Brush* brush = new(std::nothrow) Brush(0.0f, 1.0f,
+				random.Float(1, 5), random.Float(5, 30), 0.0f,
+				random.Float(0.3, 1.0),
+				Brush::FLAG_PRESSURE_CONTROLS_APHLA
+					| Brush::FLAG_PRESSURE_CONTROLS_RADIUS);
+			if (stroke == NULL || brush == NULL) {
+				delete stroke;
+				if (brush != NULL)
+					brush->RemoveReference();
+				break;
+			}
+			stroke->SetBrush(brush);
+			brush->RemoveReference();
+
+			BPoint point = random.Point(area);
+			int32 pointCount = 8 + random.Next() % 57;
+			for (int32 p = 0; p < pointCount; p++) {
+				stroke->AppendPoint(StrokePoint(point,
+					random.Float(0.1, 1.0), 0.0f, 0.0f));
+				point += BPoint(random.Float(-10, 10),
+					random.Float(-10, 10));
+			}
+			layer->AddObject(stroke);
+		}
+
+		if (i < textCount) {
+			Text* text = new(std::nothrow) Text(random.Color(255));
+			if (text == NULL)
+				break;
+			text->TranslateBy(random.Point(area));
+			text->SetWidth(random.Float(100, size * 2));
+			text->Append(kText, Font("DejaVu Serif", "Book",
+				random.Float(8, 40)), random.Color(255));
+			text->Append(kText, Font("DejaVu Sans", "Bold",
+				random.Float(8, 40)), random.Color(160));
+			layer->AddObject(text);
+		}
+	}
+
+	for (uint32 i = 0; i < filterCount; i++) {
+		if ((i & 1) == 0) {
+			Filter* filter = new(std::nothrow) Filter(random.Float(2, 20));
+			if (filter == NULL || !layer->AddObject(filter))
+				delete filter;
+		} else {
+			FilterDropShadow* dropShadow = new(std::nothrow) FilterDropShadow(
+				random.Float(2, 20));
+			if (dropShadow == NULL)
+				break;
+			dropShadow->SetOpacity(random.Float(100, 255));
+			dropShadow->SetOffsetX(random.Float(-8, 8));
+			dropShadow->SetOffsetY(random.Float(-8, 8));
+			if (!layer->AddObject(dropShadow))
+				delete dropShadow;
+		}
+	}
+}
+
+// _CreatePixels
+/*!	Creates an opaque image with smooth gradients and some noise, which is
+	about as hard to compress and to sample as a photo.
+*/
+RenderBuffer*
+RenderBenchmark::_CreatePixels(uint32 size, Random& random) const
+{
+	RenderBuffer* buffer = new(std::nothrow) RenderBuffer(size, size);
+	if (buffer == NULL)
+		return NULL;
+	if (!buffer->IsValid()) {
+		buffer->RemoveReference();
+		return NULL;
+	}
+
+	uint8* bits = buffer->Bits();
+	for (uint32 y = 0; y < size; y++) {
+		uint16* pixel = (uint16*)(bits + y * buffer->BytesPerRow());
+		for (uint32 x = 0; x < size; x++) {
+			uint32 noise = random.Next() & 0x0fff;
+			pixel[0] = (uint16)((x * 65535 / size) ^ noise);
+			pixel[1] = (uint16)((y * 65535 / size) ^ noise);
+			pixel[2] = (uint16)(((x + y) * 32767 / size) ^ noise);
+			pixel[3] = 65535;
+			pixel += 4;
+		}
+	}
+
+	return buffer;
+}
+
+// _LoadDocument
+status_t
+RenderBenchmark::_LoadDocument(const char* path, DocumentRef& document,
+	Object** _probe) const
+{
+	BFile file(path, B_READ_ONLY);
+	status_t ret = file.InitCheck();
+	if (ret != B_OK) {
+		fprintf(stderr, "Failed to open '%s': %s\n", path, strerror(ret));
+		return ret;
+	}
+
+	document.SetTo(new(std::nothrow) Document(BRect(0, 0, 799, 599)), true);
+	if (document.Get() == NULL)
+		return B_NO_MEMORY;
+
+	AutoWriteLocker locker(document.Get());
+
+	// Native WonderBrush 3.0 images
+	MessageImporter msgImporter(document);
+	ret = msgImporter.Import(path);
+	if (ret != B_OK) {
+		// Legacy WonderBrush 2.x images
+		file.Seek(0, SEEK_SET);
+		WonderBrush2Importer legacyImporter(document);
+		ret = legacyImporter.Import(file);
+	}
+	if (ret != B_OK) {
+		fprintf(stderr, "Failed to load '%s': %s\n", path, strerror(ret));
+		return ret;
+	}
+
+	// Use the top-most object with bounds on the root layer as probe.
+	*_probe = NULL;
+	Layer* rootLayer = document->RootLayer();
+	for (int32 i = rootLayer->CountObjects() - 1; i >= 0; i--) {
+		Object* object = rootLayer->ObjectAtFast(i);
+		if (dynamic_cast<BoundedObject*>(object) != NULL) {
+			*_probe = object;
+			break;
+		}
+	}
+
+	return B_OK;
+}
+
+// #pragma mark -
+
+// _RunDocument
+status_t
+RenderBenchmark::_RunDocument(const char* name, Document* document,
+	Object* probe, bigtime_t loadTime)
+{
+	BRect bounds;
+	int32 objectCount = 0;
+	{
+		AutoReadLocker locker(document);
+		bounds = document->Bounds();
+		objectCount = count_objects(document->RootLayer());
+	}
+
+	fprintf(fOutput, "{\"type\":\"document\",\"name\":");
+	print_json_string(fOutput, name);
+	fprintf(fOutput, ",\"width\":%ld,\"height\":%ld,\"objects\":%ld,"
+		"\"load_us\":%lld,\"peak_rss_kb\":%lld}\n",
+		(long)bounds.IntegerWidth() + 1, (long)bounds.IntegerHeight() + 1,
+		(long)objectCount, (long long)loadTime,
+		(long long)peak_memory_usage());
+
+	status_t ret = B_OK;
+	for (int32 z = 0; z < fZoomLevels.CountItems(); z++) {
+		for (int32 t = 0; t < fThreadCounts.CountItems(); t++) {
+			status_t passRet = _RunPasses(name, document, probe,
+				fZoomLevels.ItemAtFast(z), fThreadCounts.ItemAtFast(t));
+			if (passRet != B_OK && ret == B_OK)
+				ret = passRet;
+		}
+	}
+	return ret;
+}
+
+// _RunPasses
+/*!	Measures three kinds of passes:
+	 - "full": A new renderer builds the snapshot and renders everything.
+	 - "warm": The renderer renders everything again, without changes. The
+	   snapshot, the tiles of the layers and the caches are kept.
+	 - "incremental": The probe is moved and only the changed area is
+	   rendered, like the RenderManager does while the user edits.
+	All threads share the snapshot and render disjoint blocks of tiles.
+	Each pass is repeated and the fastest one is reported.
+*/
+status_t
+RenderBenchmark::_RunPasses(const char* name, Document* document,
+	Object* probe, double zoomLevel, int32 threadCount)
+{
+	BRect bounds;
+	{
+		AutoReadLocker locker(document);
+		bounds = document->Bounds();
+	}
+	bounds = OffscreenRenderer::ZoomedBounds(bounds, zoomLevel);
+
+	RenderBuffer* buffer = new(std::nothrow) RenderBuffer(bounds);
+	if (buffer == NULL || !buffer->IsValid()) {
+		if (buffer != NULL)
+			buffer->RemoveReference();
+		fprintf(stderr, "Not enough memory to render '%s' at zoom %.3f\n",
+			name, zoomLevel);
+		return B_NO_MEMORY;
+	}
+
+	PassResult best[3];
+	status_t ret = B_OK;
+
+	for (int32 r = 0; r < fRepeatCount && ret == B_OK; r++) {
+		OffscreenRenderer* renderer
+			= new(std::nothrow) OffscreenRenderer(document);
+		if (renderer == NULL) {
+			ret = B_NO_MEMORY;
+			break;
+		}
+		renderer->SetKeepTiles(true);
+		ret = renderer->SetThreadCount(threadCount);
+
+		PassResult results[3];
+		if (ret == B_OK) {
+			ret = _RenderPass(renderer, buffer, buffer->Bounds(), zoomLevel,
+				results[0]);
+		}
+		if (ret == B_OK) {
+			ret = _RenderPass(renderer, buffer, buffer->Bounds(), zoomLevel,
+				results[1]);
+		}
+		if (ret == B_OK && probe != NULL) {
+			BRect dirtyArea = _MoveProbe(document, probe, 8.0f);
+			dirtyArea = OffscreenRenderer::ZoomedBounds(dirtyArea,
+				zoomLevel).InsetByCopy(-2, -2) & buffer->Bounds();
+			if (dirtyArea.IsValid()) {
+				ret = _RenderPass(renderer, buffer, dirtyArea, zoomLevel,
+					results[2]);
+			}
+			// Move the probe back, so that every repetition (and the
+			// next zoom level) renders the same document.
+			_MoveProbe(document, probe, -8.0f);
+		}
+
+		delete renderer;
+
+		for (int32 i = 0; i < 3; i++) {
+			if (r == 0 || results[i].wallTime < best[i].wallTime)
+				best[i] = results[i];
+		}
+	}
+
+	buffer->RemoveReference();
+
+	if (ret != B_OK) {
+		fprintf(stderr, "Failed to render '%s': %s\n", name, strerror(ret));
+		return ret;
+	}
+
+	_PrintPass(name, "full", zoomLevel, threadCount, best[0]);
+	_PrintPass(name, "warm", zoomLevel, threadCount, best[1]);
+	if (best[2].area.IsValid())
+		_PrintPass(name, "incremental", zoomLevel, threadCount, best[2]);
+
+	return B_OK;
+}
+
+// _RenderPass
+/*!	Renders the area of the buffer and measures the time it took.
+*/
+status_t
+RenderBenchmark::_RenderPass(OffscreenRenderer* renderer,
+	RenderBuffer* buffer, BRect area, double zoomLevel,
+	PassResult& result) const
+{
+	RenderBuffer* target = new(std::nothrow) RenderBuffer(buffer, area,
+		false);
+	if (target == NULL)
+		return B_NO_MEMORY;
+
+	bigtime_t startTime = system_time();
+	status_t ret = renderer->Render(target, zoomLevel);
+
+	result.area = area;
+	result.wallTime = system_time() - startTime;
+	result.timing = renderer->LastTiming();
+	result.status = ret;
+
+	target->RemoveReference();
+
+	return ret;
+}
+
+// _MoveProbe
+/*!	Moves the probe diagonally and returns the area of the document which
+	needs to be rendered again.
+*/
+BRect
+RenderBenchmark::_MoveProbe(Document* document, Object* probe,
+	float offset) const
+{
+	AutoWriteLocker locker(document);
+
+	BoundedObject* object = dynamic_cast<BoundedObject*>(probe);
+	if (object == NULL)
+		return document->Bounds();
+
+	BRect dirtyArea = object->TransformedBounds();
+	probe->TranslateBy(BPoint(offset, offset));
+	return dirtyArea | object->TransformedBounds();
+}
+
+// _PrintPass
+void
+RenderBenchmark::_PrintPass(const char* name, const char* pass,
+	double zoomLevel, int32 threadCount, const PassResult& result) const
+{
+	double megaPixels = (result.area.IntegerWidth() + 1.0)
+		* (result.area.IntegerHeight() + 1.0) / 1000000.0;
+	double seconds = result.wallTime / 1000000.0;
+
+	fprintf(fOutput, "{\"type\":\"pass\",\"document\":");
+	print_json_string(fOutput, name);
+	fprintf(fOutput, ",\"pass\":\"%s\",\"zoom\":%.4f,\"threads\":%ld,"
+		"\"width\":%ld,\"height\":%ld,\"megapixels\":%.4f,"
+		"\"wall_us\":%lld,\"sync_us\":%lld,\"layout_us\":%lld,"
+		"\"render_us\":%lld,\"blend_us\":%lld,\"mpps\":%.3f,"
+		"\"peak_rss_kb\":%lld}\n",
+		pass, zoomLevel, (long)threadCount,
+		(long)result.area.IntegerWidth() + 1,
+		(long)result.area.IntegerHeight() + 1, megaPixels,
+		(long long)result.wallTime, (long long)result.timing.sync,
+		(long long)result.timing.layout, (long long)result.timing.render,
+		(long long)result.timing.blend,
+		seconds > 0.0 ? megaPixels / seconds : 0.0,
+		(long long)peak_memory_usage());
+	fflush(fOutput);
+}
+
+// #pragma mark -
+
+// main
+int
+main(int argc, char* argv[])
+{
+	RenderBenchmark benchmark;
+	return benchmark.Run(argc, argv);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef RENDER_BENCHMARK_H
+#define RENDER_BENCHMARK_H
+
+#include <stdio.h>
+
+#include <OS.h>
+#include <Rect.h>
+
+#include "Document.h"
+#include "List.h"
+#include "OffscreenRenderer.h"
+
+class Layer;
+class Object;
+class RenderBuffer;
+
+// The RenderBenchmark renders generated and loaded documents with the
+// OffscreenRenderer at several zoom levels and thread counts. It writes
+// one JSON object per line for each measured pass, so that the results
+// of different versions can be compared by scripts.
+
+class RenderBenchmark {
+public:
+								RenderBenchmark();
+								~RenderBenchmark();
+
+			int					Run(int argc, char** argv);
+
+private:
+			struct Random;
+			struct PassResult;
+
+			typedef List<double, true>	ZoomList;
+			typedef List<int32, true>	ThreadCountList;
+
+			void				_PrintUsage(const char* appPath);
+			bool				_ParseZoomLevels(const char* list);
+			bool				_ParseThreadCounts(const char* list);
+			void				_LoadFonts(const char* path);
+
+			Document*			_CreateDocument(Object** probe) const;
+			void				_FillLayer(Layer* layer, Random& random,
+									uint32 shapeCount, uint32 strokeCount,
+									uint32 textCount, uint32 filterCount,
+									BRect area) const;
+			RenderBuffer*		_CreatePixels(uint32 size,
+									Random& random) const;
+			status_t			_LoadDocument(const char* path,
+									DocumentRef& document,
+									Object** probe) const;
+
+			status_t			_RunDocument(const char* name,
+									Document* document, Object* probe,
+									bigtime_t loadTime);
+			status_t			_RunPasses(const char* name,
+									Document* document, Object* probe,
+									double zoomLevel, int32 threadCount);
+			status_t			_RenderPass(OffscreenRenderer* renderer,
+									RenderBuffer* buffer, BRect area,
+									double zoomLevel,
+									PassResult& result) const;
+			BRect				_MoveProbe(Document* document,
+									Object* probe, float offset) const;
+
+			void				_PrintPass(const char* name,
+									const char* pass, double zoomLevel,
+									int32 threadCount,
+									const PassResult& result) const;
+
+			uint32				fWidth;
+			uint32				fHeight;
+			uint32				fShapeCount;
+			uint32				fStrokeCount;
+			uint32				fTextCount;
+			uint32				fLayerDepth;
+			uint32				fFilterCount;
+			uint32				fImageSize;
+			uint32				fSeed;
+			int32				fRepeatCount;
+
+			ZoomList			fZoomLevels;
+			ThreadCountList		fThreadCounts;
+
+			FILE*				fOutput;
+};
+
+#endif // RENDER_BENCHMARK_H
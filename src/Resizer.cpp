@@ -1,21 +1,28 @@
 #include "Resizer.h"
 
+#include <math.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <Bitmap.h>
 #include <BitmapStream.h>
 #include <Directory.h>
 #include <File.h>
 #include <Rect.h>
 #include <TranslationUtils.h>
+#include <TranslatorFormats.h>
 #include <TranslatorRoster.h>
 
+#include "Interpolation.h"
+#include "MipPyramid.h"
 #include "RenderBuffer.h"
 #include "RenderEngine.h"
 
 // constructor
 Resizer::Resizer()
-	: BApplication("application/x-vnd.yellowbites.Resizer")
-	, fPrintUsage(true)
-	, fTargetSize(1536)
+	: fTargetSize(1536)
 	, fTargetThumbSize(308)
 	, fTargetScale(1.0)
 	, fTargetThumbScale(1.0)
@@ -25,31 +32,10 @@ Resizer::Resizer()
 {
 }
 
-// MessageReceived
-void
-Resizer::MessageReceived(BMessage* message)
-{
-	switch (message->what) {
-		default:
-			BApplication::MessageReceived(message);
-			break;
-	}
-}
-
-// ReadyToRun
-void
-Resizer::ReadyToRun()
-{
-	if (fPrintUsage)
-		_PrintUsage("Resizer");
-	PostMessage(B_QUIT_REQUESTED);
-}
-
-// ArgvReceived
-void
-Resizer::ArgvReceived(int32 argc, char** argv)
+// Run
+int
+Resizer::Run(int argc, char** argv)
 {
-	fPrintUsage = false;
 	int32 i = 1;
 	for (; i < argc; i++) {
 		if (strcmp(argv[i], "-o") == 0) {
@@ -65,7 +51,7 @@ Resizer::ArgvReceived(int32 argc, char** argv)
 	}
 	if (i == argc) {
 		_PrintUsage(argv[0]);
-		return;
+		return 1;
 	}
 	create_directory(fTargetFolder.Path(), 0777);
 
@@ -96,13 +82,8 @@ Resizer::ArgvReceived(int32 argc, char** argv)
 
 		delete original;
 	}
-}
 
-// RefsReceived
-void
-Resizer::RefsReceived(BMessage* message)
-{
-	printf("Resizer::RefsReceived()\n");
+	return 0;
 }
 
 // #pragma mark -
@@ -135,7 +116,10 @@ Resizer::_ResizeImage(const RenderBuffer& buffer, RenderEngine& engine,
 	scaling.ScaleBy(B_ORIGIN, scale, scale);
 	engine.SetTransformation(scaling);
 
-	engine.DrawImage(&buffer, resized.Bounds());
+	// The pixels don't change while the pyramid exists.
+	MipPyramidRef pyramid(new(std::nothrow) MipPyramid(&buffer), true);
+	engine.DrawImage(&buffer, resized.Bounds(), INTERPOLATION_RESAMPLE, 255,
+		pyramid.Get());
 
 	BBitmap* bitmap = new BBitmap(resized.Bounds(), B_BITMAP_NO_SERVER_LINK,
 		B_RGBA32);
@@ -150,9 +134,7 @@ Resizer::_ResizeImage(const RenderBuffer& buffer, RenderEngine& engine,
 
 	BBitmapStream bitmapStream(bitmap);
 
-	BString name(originalPath);
-	name.Remove(0, name.FindLast('/') + 1);
-	path.Append(name);
+	path.Append(BPath(originalPath).Leaf());
 	BFile file(path.Path(), B_CREATE_FILE | B_ERASE_FILE | B_READ_WRITE);
 	if (file.InitCheck() != B_OK) {
 		fprintf(stderr, "Failed to create file '%s': %s\n",
@@ -175,10 +157,9 @@ Resizer::_ResizeImage(const RenderBuffer& buffer, RenderEngine& engine,
 
 // main
 int
-main(int argc, const char* argv[])
+main(int argc, char* argv[])
 {
 	Resizer app;
-	app.Run();
-	return 0;
+	return app.Run(argc, argv);
 }
 
@@ -1,21 +1,17 @@
 #ifndef RESIZER_H
 #define RESIZER_H
 
-#include <Application.h>
 #include <Path.h>
 #include <String.h>
 
 class RenderBuffer;
 class RenderEngine;
 
-class Resizer : public BApplication {
+class Resizer {
 public:
 								Resizer();
 
-	virtual	void				MessageReceived(BMessage* message);
-	virtual void				ReadyToRun();
-	virtual	void				ArgvReceived(int32 argc, char** argv);
-	virtual	void				RefsReceived(BMessage* message);
+			int					Run(int argc, char** argv);
 
 private:
 			void				_PrintUsage(const char* appPath);
@@ -23,7 +19,6 @@ private:
 									RenderEngine& engine, double scale,
 									BPath path, const char* originalPath) const;
 
-			bool				fPrintUsage;
 			int32				fTargetSize;
 			int32				fTargetThumbSize;
 			double				fTargetScale;
@@ -0,0 +1,9 @@
+TARGET = Resizer
+
+include (tools_common.pro)
+
+SOURCES += \
+	Resizer.cpp
+
+HEADERS += \
+	Resizer.h
@@ -5,6 +5,7 @@
 #include <Alert.h>
 #include <Bitmap.h>
 #include <Catalog.h>
+#include <Entry.h>
 #include <Path.h>
 #include <Roster.h>
 #include <String.h>
@@ -25,6 +26,7 @@
 #include "NativeSaver.h"
 #include "Rect.h"
 #include "RenderBuffer.h"
+#include "RenderTrace.h"
 #include "Shape.h"
 #include "SimpleFileSaver.h"
 #include "Text.h"
@@ -239,13 +241,13 @@ WonderBrushBase::WonderBrushBase(BRect bounds)
 			| Brush::FLAG_TILT_CONTROLS_SHAPE);
 	brushStroke->SetBrush(brush);
 	brush->RemoveReference();
-	brushStroke->Stroke().AppendObject(
+	brushStroke->AppendPoint(
 		StrokePoint(BPoint(150, 50), 0.2f, 0.0f, 0.0f));
-	brushStroke->Stroke().AppendObject(
+	brushStroke->AppendPoint(
 		StrokePoint(BPoint(200, 20), 1.0f, 0.0f, 0.0f));
-	brushStroke->Stroke().AppendObject(
+	brushStroke->AppendPoint(
 		StrokePoint(BPoint(250, 80), 0.8f, 0.0f, 0.0f));
-	brushStroke->Stroke().AppendObject(
+	brushStroke->AppendPoint(
 		StrokePoint(BPoint(300, 50), 0.1f, 0.0f, 0.0f));
 	subLayer->AddObject(brushStroke);
 
@@ -442,9 +444,15 @@ WonderBrush::ImportDocument(Document* document, const entry_ref& ref) const
 
 	// try different file types
 
-	// Native WonderBrush 3.0 images
+	// Native WonderBrush 3.0 images. The importer opens the file itself,
+	// since it keeps it open for reading the pixels of images later.
+	BPath path;
+	ret = BEntry(&ref, true).GetPath(&path);
+	if (ret != B_OK)
+		return ret;
+
 	MessageImporter msgImporter(documentRef);
-	ret = msgImporter.Import(file);
+	ret = msgImporter.Import(path.Path());
 	if (ret == B_OK) {
 		document->SetNativeSaver(new(std::nothrow) NativeSaver(ref));
 		return B_OK;
@@ -582,11 +590,15 @@ WonderBrush::_NotifyFontsLoaded(Layer* layer)
 int
 main(int argc, char* argv[])
 {
-	for (int i = 1; i < argc; i++) {
-		if (strcmp(argv[i], "--fonts") == 0 && i < argc - 1) {
+	const char* tracePath = NULL;
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--fonts") == 0) {
 			sFontsDirectory = argv[i + 1];
 			printf("Using font folder: '%s'\n", sFontsDirectory.String());
-			break;
+		} else if (strcmp(argv[i], "--trace") == 0) {
+			// Record the render passes, they are written when quitting.
+			tracePath = argv[i + 1];
+			RenderTrace::SetEnabled(true);
 		}
 	}
 	// Create app already here. For Qt this must be the first event loop
@@ -602,5 +614,14 @@ main(int argc, char* argv[])
 	}
 
 	app.Run();
+
+	if (tracePath != NULL) {
+		status_t ret = RenderTrace::Dump(tracePath);
+		if (ret != B_OK) {
+			fprintf(stderr, "Failed to write the trace to '%s': %s\n",
+				tracePath, strerror(ret));
+		}
+	}
+
 	return 0;
 }
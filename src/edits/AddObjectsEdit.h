@@ -6,12 +6,11 @@
 #ifndef ADD_OBJECTS_EDIT_H
 #define ADD_OBJECTS_EDIT_H
 
+#include "CompactedBuffer.h"
+#include "Layer.h"
 #include "Selection.h"
 #include "UndoableEdit.h"
 
-class Layer;
-class Object;
-
 class AddObjectsEdit : public UndoableEdit, public Selection::Controller {
 public:
 	AddObjectsEdit(Object** objects, int32 objectCount, Layer* insertionLayer,
@@ -24,6 +23,8 @@ public:
 		, fInsertionIndex(insertionIndex)
 
 		, fSelection(selection)
+
+		, fRemoved(false)
 	{
 		if (fInsertionLayer != NULL)
 			fInsertionLayer->AddReference();
@@ -76,6 +77,7 @@ public:
 		}
 
 		fInsertionLayer->SuspendUpdates(false);
+		fRemoved = false;
 
 		return B_OK;
 	}
@@ -94,6 +96,7 @@ public:
 		}
 
 		fInsertionLayer->SuspendUpdates(false);
+		fRemoved = true;
 
 		return B_OK;
 	}
@@ -106,6 +109,37 @@ public:
 			name << "Add object";
 	}
 
+	virtual size_t MemoryFootprint() const
+	{
+		size_t footprint = UndoableEdit::MemoryFootprint();
+
+		// The objects are only kept alive by this edit while it is undone.
+		for (int32 i = 0; i < fObjectCount; i++) {
+			if (fObjects[i] == NULL)
+				continue;
+			if (fRemoved)
+				footprint += CompactedBuffer::ObjectFootprint(fObjects[i]);
+			else
+				footprint += CompactedBuffer::OBJECT_FOOTPRINT;
+		}
+
+		return footprint;
+	}
+
+	virtual status_t Compact(SpillFile* file)
+	{
+		if (!fRemoved)
+			return B_OK;
+
+		status_t ret = B_OK;
+		for (int32 i = 0; i < fObjectCount && ret == B_OK; i++) {
+			if (fObjects[i] != NULL)
+				ret = CompactedBuffer::CompactObject(fObjects[i], file);
+		}
+
+		return ret;
+	}
+
 private:
 			Object**			fObjects;
 			int32				fObjectCount;
@@ -114,6 +148,8 @@ private:
 			int32				fInsertionIndex;
 
 			Selection*			fSelection;
+
+			bool				fRemoved;
 };
 
 #endif // ADD_OBJECTS_EDIT_H
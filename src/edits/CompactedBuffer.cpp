@@ -0,0 +1,218 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "CompactedBuffer.h"
+
+#include <new>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AutoLocker.h"
+#include "bitmap_compression.h"
+#include "Layer.h"
+#include "RenderBuffer.h"
+
+// constructor
+CompactedBuffer::CompactedBuffer()
+	: fLock("compacted buffer")
+	, fBounds()
+	, fCompression(0)
+	, fData(NULL)
+	, fSize(0)
+	, fFile()
+	, fOffset(0)
+	, fBuffer()
+	, fLoadStatus(B_NO_INIT)
+{
+}
+
+// destructor
+CompactedBuffer::~CompactedBuffer()
+{
+	free(fData);
+	if (fFile.Get() != NULL)
+		fFile->Free(fOffset, fSize);
+}
+
+// Init
+/*!	Compresses the pixels of the buffer. If a file is given, the compressed
+	pixels are written to it, otherwise they are kept in memory.
+*/
+status_t
+CompactedBuffer::Init(const RenderBuffer* buffer, SpillFile* file)
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	free(fData);
+	fData = NULL;
+	if (fFile.Get() != NULL)
+		fFile->Free(fOffset, fSize);
+	fFile.Unset();
+	fBuffer.Unset();
+
+	fBounds = buffer->Bounds();
+	status_t ret = compress_buffer(buffer, &fData, &fSize, &fCompression);
+	if (ret != B_OK)
+		return ret;
+
+	if (file != NULL && file->Write(fData, fSize, &fOffset) == B_OK) {
+		fFile.SetTo(file);
+		free(fData);
+		fData = NULL;
+	}
+
+	fLoadStatus = B_OK;
+	return B_OK;
+}
+
+// Bounds
+BRect
+CompactedBuffer::Bounds() const
+{
+	return fBounds;
+}
+
+// Buffer
+RenderBufferRef
+CompactedBuffer::Buffer()
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	// Don't try again if reading failed once.
+	if (fBuffer.Get() != NULL || fLoadStatus != B_OK)
+		return fBuffer;
+
+	void* data = fData;
+	if (data == NULL) {
+		data = malloc(fSize);
+		if (data == NULL) {
+			fLoadStatus = B_NO_MEMORY;
+			return fBuffer;
+		}
+		fLoadStatus = fFile->Read(fOffset, data, fSize);
+	}
+
+	if (fLoadStatus == B_OK) {
+		RenderBuffer* buffer = decompress_buffer(data, fSize, fBounds,
+			fCompression);
+		if (buffer != NULL)
+			fBuffer.SetTo(buffer, true);
+		else
+			fLoadStatus = B_BAD_DATA;
+	}
+	if (data != fData)
+		free(data);
+
+	if (fLoadStatus != B_OK) {
+		fprintf(stderr, "CompactedBuffer::Buffer() - failed to read "
+			"pixels: %s\n", strerror(fLoadStatus));
+	}
+
+	return fBuffer;
+}
+
+// Unload
+/*!	Forgets the pixels which were read back, unless someone else still uses
+	them. They are read again when needed.
+*/
+void
+CompactedBuffer::Unload()
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	if (fBuffer.Get() != NULL && fBuffer->CountReferences() == 1)
+		fBuffer.Unset();
+}
+
+// MemoryUsage
+size_t
+CompactedBuffer::MemoryUsage() const
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	size_t usage = fData != NULL ? fSize : 0;
+	if (fBuffer.Get() != NULL)
+		usage += fBuffer->BitsLength();
+	return usage;
+}
+
+// #pragma mark -
+
+// ObjectFootprint
+/*!	Estimates the memory which is kept alive by an object, including the
+	pixels of images which are not shared with anyone else.
+*/
+/*static*/ size_t
+CompactedBuffer::ObjectFootprint(const Object* object)
+{
+	size_t footprint = OBJECT_FOOTPRINT;
+
+	const Image* image = dynamic_cast<const Image*>(object);
+	if (image != NULL) {
+		CompactedBuffer* compacted = dynamic_cast<CompactedBuffer*>(
+			image->GetLazyBuffer());
+		if (compacted != NULL) {
+			footprint += compacted->MemoryUsage();
+		} else if (image->GetLazyBuffer() == NULL) {
+			// Pixels which are shared with other images are not kept alive
+			// by the edit alone.
+			RenderBuffer* buffer = image->Buffer();
+			if (buffer != NULL && buffer->CountReferences() == 1)
+				footprint += buffer->BitsLength();
+		}
+	}
+
+	const Layer* layer = dynamic_cast<const Layer*>(object);
+	if (layer != NULL) {
+		int32 count = layer->CountObjects();
+		for (int32 i = 0; i < count; i++)
+			footprint += ObjectFootprint(layer->ObjectAtFast(i));
+	}
+
+	return footprint;
+}
+
+// CompactObject
+/*!	Replaces the pixels of all images in the object by CompactedBuffers,
+	unless they are shared with other images.
+*/
+/*static*/ status_t
+CompactedBuffer::CompactObject(Object* object, SpillFile* file)
+{
+	status_t ret = B_OK;
+
+	Image* image = dynamic_cast<Image*>(object);
+	if (image != NULL) {
+		CompactedBuffer* compacted = dynamic_cast<CompactedBuffer*>(
+			image->GetLazyBuffer());
+		if (compacted != NULL) {
+			// The pixels may have been read back when the edit was undone.
+			compacted->Unload();
+		} else if (image->GetLazyBuffer() == NULL) {
+			RenderBuffer* buffer = image->Buffer();
+			if (buffer != NULL && buffer->CountReferences() == 1) {
+				compacted = new(std::nothrow) CompactedBuffer();
+				LazyBufferRef lazyBuffer(compacted, true);
+				if (compacted == NULL)
+					ret = B_NO_MEMORY;
+				else
+					ret = compacted->Init(buffer, file);
+				if (ret == B_OK)
+					image->SetLazyBuffer(lazyBuffer);
+			}
+		}
+	}
+
+	Layer* layer = dynamic_cast<Layer*>(object);
+	if (layer != NULL) {
+		int32 count = layer->CountObjects();
+		for (int32 i = 0; i < count && ret == B_OK; i++)
+			ret = CompactObject(layer->ObjectAtFast(i), file);
+	}
+
+	return ret;
+}
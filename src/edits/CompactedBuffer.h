@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef COMPACTED_BUFFER_H
+#define COMPACTED_BUFFER_H
+
+#include <Locker.h>
+
+#include "Image.h"
+#include "SpillFile.h"
+
+// Replaces the pixels of an Image which is only kept alive by an old edit.
+// The pixels are compressed and, if possible, moved into the SpillFile of
+// the EditManager. They are read back when the edit is undone and the image
+// is rendered again.
+class CompactedBuffer : public LazyBuffer {
+public:
+	enum {
+		// A rough estimate of the memory used by an object besides its
+		// pixels.
+		OBJECT_FOOTPRINT = 512
+	};
+
+public:
+								CompactedBuffer();
+	virtual						~CompactedBuffer();
+
+			status_t			Init(const RenderBuffer* buffer,
+									SpillFile* file);
+
+	// LazyBuffer interface
+	virtual	BRect				Bounds() const;
+	virtual	RenderBufferRef		Buffer();
+
+	// CompactedBuffer
+			void				Unload();
+			size_t				MemoryUsage() const;
+
+	// Helpers for edits which keep objects alive
+	static	size_t				ObjectFootprint(const Object* object);
+	static	status_t			CompactObject(Object* object,
+									SpillFile* file);
+
+private:
+	mutable	BLocker				fLock;
+			BRect				fBounds;
+			uint32				fCompression;
+
+			void*				fData;
+			size_t				fSize;
+			SpillFileRef		fFile;
+			off_t				fOffset;
+
+			RenderBufferRef		fBuffer;
+			status_t			fLoadStatus;
+};
+
+#endif // COMPACTED_BUFFER_H
@@ -135,7 +135,9 @@ MoveObjectsEdit::InitCheck()
 status_t
 MoveObjectsEdit::Perform(EditContext& context)
 {
-	fInsertionLayer->SuspendUpdates(true);
+	// The changes reach the listeners of the layers all at once when
+	// the transaction is committed.
+	LayerTransaction transaction(fInsertionLayer);
 
 	if (fSelection != NULL)
 		fSelection->DeselectAll(this);
@@ -150,17 +152,13 @@ MoveObjectsEdit::Perform(EditContext& context)
 	for (int32 i = 0; i < fObjectCount; i++) {
 		if (fObjects[i] == NULL)
 			continue;
-		if (!fInsertionLayer->AddObject(fObjects[i], index)) {
-			fInsertionLayer->SuspendUpdates(false);
+		if (!fInsertionLayer->AddObject(fObjects[i], index))
 			return B_NO_MEMORY;
-		}
 		index++;
 		if (fSelection != NULL)
 			fSelection->Select(Selectable(fObjects[i]), this, true);
 	}
 
-	fInsertionLayer->SuspendUpdates(false);
-
 	return B_OK;
 }
 
@@ -168,7 +166,7 @@ MoveObjectsEdit::Perform(EditContext& context)
 status_t
 MoveObjectsEdit::Undo(EditContext& context)
 {
-	fInsertionLayer->SuspendUpdates(true);
+	LayerTransaction transaction(fInsertionLayer);
 
 	if (fSelection != NULL)
 		fSelection->DeselectAll(this);
@@ -189,8 +187,6 @@ MoveObjectsEdit::Undo(EditContext& context)
 			fSelection->Select(Selectable(fObjects[i]), this, true);
 	}
 
-	fInsertionLayer->SuspendUpdates(false);
-
 	return B_OK;
 }
 
@@ -6,6 +6,7 @@
 #ifndef OBJECT_ADDED_EDIT_H
 #define OBJECT_ADDED_EDIT_H
 
+#include "CompactedBuffer.h"
 #include "Layer.h"
 #include "UndoableEdit.h"
 #include "Selection.h"
@@ -20,6 +21,8 @@ public:
 		, fInsertionIndex(-1)
 
 		, fSelection(selection)
+
+		, fRemoved(false)
 	{
 		if (fObject == NULL)
 			return;
@@ -68,6 +71,7 @@ public:
 		fInsertionLayer->RemoveObject(fObject);
 
 		fInsertionLayer->SuspendUpdates(false);
+		fRemoved = true;
 
 		return B_OK;
 	}
@@ -87,6 +91,7 @@ public:
 			fSelection->Select(Selectable(fObject), this, true);
 
 		fInsertionLayer->SuspendUpdates(false);
+		fRemoved = false;
 
 		return B_OK;
 	}
@@ -96,6 +101,29 @@ public:
 		name << "Add object";
 	}
 
+	virtual size_t MemoryFootprint() const
+	{
+		size_t footprint = UndoableEdit::MemoryFootprint();
+
+		// The object is only kept alive by this edit while it is undone.
+		if (fObject != NULL) {
+			if (fRemoved)
+				footprint += CompactedBuffer::ObjectFootprint(fObject);
+			else
+				footprint += CompactedBuffer::OBJECT_FOOTPRINT;
+		}
+
+		return footprint;
+	}
+
+	virtual status_t Compact(SpillFile* file)
+	{
+		if (!fRemoved || fObject == NULL)
+			return B_OK;
+
+		return CompactedBuffer::CompactObject(fObject, file);
+	}
+
 private:
 			Object*				fObject;
 
@@ -103,6 +131,8 @@ private:
 			int32				fInsertionIndex;
 
 			Selection*			fSelection;
+
+			bool				fRemoved;
 };
 
 #endif // OBJECT_ADDED_EDIT_H
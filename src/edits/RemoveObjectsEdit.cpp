@@ -9,8 +9,12 @@
 
 #include <stdio.h>
 
+#include "CompactedBuffer.h"
 #include "Layer.h"
 
+// #pragma mark -
+
+
 // constructor
 RemoveObjectsEdit::RemoveObjectsEdit(const ObjectList& objects,
 		Selection* selection)
@@ -120,6 +124,43 @@ RemoveObjectsEdit::GetName(BString& name)
 		name << "Remove object";
 }
 
+// MemoryFootprint
+size_t
+RemoveObjectsEdit::MemoryFootprint() const
+{
+	size_t footprint = UndoableEdit::MemoryFootprint();
+
+	for (int32 i = 0; i < fObjects.CountItems(); i++) {
+		if (_IsRemoved(i)) {
+			footprint += CompactedBuffer::ObjectFootprint(
+				fObjects.ItemAt(i).Get());
+		} else
+			footprint += CompactedBuffer::OBJECT_FOOTPRINT;
+	}
+
+	return footprint;
+}
+
+// Compact
+/*!	Compresses the pixels of removed images, or moves them into the file.
+	Objects which are part of the document again, because the edit was
+	undone, are left alone.
+*/
+status_t
+RemoveObjectsEdit::Compact(SpillFile* file)
+{
+	status_t ret = B_OK;
+
+	for (int32 i = 0; i < fObjects.CountItems() && ret == B_OK; i++) {
+		if (_IsRemoved(i)) {
+			ret = CompactedBuffer::CompactObject(fObjects.ItemAt(i).Get(),
+				file);
+		}
+	}
+
+	return ret;
+}
+
 // #pragma mark -
 
 // _ObjectIsDistantChildOf
@@ -139,3 +180,11 @@ RemoveObjectsEdit::_ObjectIsDistantChildOf(const Object* object,
 	}
 	return false;
 }
+
+// _IsRemoved
+bool
+RemoveObjectsEdit::_IsRemoved(int32 index) const
+{
+	return fOldPositions != NULL && fOldPositions[index].parent != NULL
+		&& fObjects.ItemAt(index)->Parent() == NULL;
+}
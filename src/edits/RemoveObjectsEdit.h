@@ -29,9 +29,13 @@ public:
 
 	virtual void				GetName(BString& name);
 
+	virtual	size_t				MemoryFootprint() const;
+	virtual	status_t			Compact(SpillFile* file);
+
 private:
 			bool				_ObjectIsDistantChildOf(const Object* object,
 									const Layer* layer) const;
+			bool				_IsRemoved(int32 index) const;
 
 private:
 			ObjectList			fObjects;
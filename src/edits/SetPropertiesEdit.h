@@ -6,6 +6,7 @@
 #ifndef SET_PROPERTIES_EDIT_H
 #define SET_PROPERTIES_EDIT_H
 
+#include "Layer.h"
 #include "UndoableEdit.h"
 
 class BaseObject;
@@ -42,6 +43,7 @@ public:
 
 	virtual status_t Perform(EditContext& context)
 	{
+		LayerTransaction transaction(_Layer());
 		for (int32 i = 0; i < fObjectCount; i++) {
 			if (fObjects[i])
 				fObjects[i]->SetToPropertyObject(fNewProperties);
@@ -51,6 +53,7 @@ public:
 
 	virtual status_t Undo(EditContext& context)
 	{
+		LayerTransaction transaction(_Layer());
 		for (int32 i = 0; i < fObjectCount; i++) {
 			if (fObjects[i])
 				fObjects[i]->SetToPropertyObject(fOldProperties);
@@ -74,6 +77,19 @@ public:
 		}
 	}
 
+private:
+	// Returns a layer of the document, so that the changes of all objects
+	// reach the listeners at once.
+	Layer* _Layer() const
+	{
+		for (int32 i = 0; i < fObjectCount; i++) {
+			Object* object = dynamic_cast<Object*>(fObjects[i]);
+			if (object != NULL && object->Parent() != NULL)
+				return object->Parent();
+		}
+		return NULL;
+	}
+
 private:
 	BaseObject**				fObjects;
 	int32						fObjectCount;
@@ -109,6 +109,32 @@ CompoundEdit::GetName(BString& name)
 	name << fName;
 }
 
+// MemoryFootprint
+size_t
+CompoundEdit::MemoryFootprint() const
+{
+	size_t footprint = UndoableEdit::MemoryFootprint();
+
+	int32 count = fEdits.CountItems();
+	for (int32 i = 0; i < count; i++)
+		footprint += fEdits.ItemAtFast(i)->MemoryFootprint();
+
+	return footprint;
+}
+
+// Compact
+status_t
+CompoundEdit::Compact(SpillFile* file)
+{
+	status_t status = B_OK;
+
+	int32 count = fEdits.CountItems();
+	for (int32 i = 0; i < count && status == B_OK; i++)
+		status = fEdits.ItemAtFast(i)->Compact(file);
+
+	return status;
+}
+
 // AppendEdit
 bool
 CompoundEdit::AppendEdit(const UndoableEditRef& edit)
@@ -24,6 +24,9 @@ public:
 
 	virtual void				GetName(BString& name);
 
+	virtual	size_t				MemoryFootprint() const;
+	virtual	status_t			Compact(SpillFile* file);
+
 			bool				AppendEdit(const UndoableEditRef& edit);
 
 private:
@@ -5,6 +5,7 @@
 
 #include "EditManager.h"
 
+#include <new>
 #include <stdio.h>
 #include <string.h>
 
@@ -13,11 +14,20 @@
 
 #include "RWLocker.h"
 
+// The memory which the undo history may use before old edits are compacted.
+static const size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+
+// The most recent edits are never compacted, so that they can still be
+// combined with the next edit and are quick to undo.
+static const int32 kRecentEditCount = 8;
+
 // constructor
 EditManager::EditManager(RWLocker* locker)
 	: Notifier()
 	, fLocker(locker)
 	, fEditAtSave()
+	, fMemoryBudget(kDefaultMemoryBudget)
+	, fSpillFile()
 {
 }
 
@@ -55,6 +65,8 @@ EditManager::Perform(const UndoableEditRef& edit, EditContext& context)
 		ret = _AddEdit(edit);
 		if (ret != B_OK)
 			edit->Undo(context);
+		else
+			_EnforceMemoryBudget();
 	}
 
 	fLocker->WriteUnlock();
@@ -153,6 +165,9 @@ EditManager::Clear()
 			fUndoHistory.Pop();
 		while (!fRedoHistory.IsEmpty())
 			fRedoHistory.Pop();
+		// Compacted edits which are still referenced elsewhere keep the
+		// file alive, a new one is created when needed.
+		fSpillFile.Unset();
 		fLocker->WriteUnlock();
 	}
 
@@ -188,6 +203,36 @@ EditManager::IsSaved()
 	return saved;
 }
 
+// SetMemoryBudget
+/*!	Sets how much memory the undo and redo history may keep alive. Beyond
+	that, old edits are merged where possible, their payloads compressed or
+	moved into a temporary file, and finally the oldest edits are forgotten.
+	A budget of 0 means no limit.
+*/
+void
+EditManager::SetMemoryBudget(size_t budget)
+{
+	if (fLocker->WriteLock()) {
+		fMemoryBudget = budget;
+		_EnforceMemoryBudget();
+		fLocker->WriteUnlock();
+	}
+
+	Notify();
+}
+
+// MemoryFootprint
+size_t
+EditManager::MemoryFootprint()
+{
+	size_t footprint = 0;
+	if (fLocker->ReadLock()) {
+		footprint = _MemoryFootprint();
+		fLocker->ReadUnlock();
+	}
+	return footprint;
+}
+
 // #pragma mark -
 
 // _AddEdit
@@ -212,6 +257,9 @@ EditManager::_AddEdit(const UndoableEditRef& edit)
 			// (the commands reversed each other)
 			if (top->InitCheck() != B_OK) {
 				fUndoHistory.Pop();
+			} else {
+				fUndoHistory.UpdateMemoryFootprint(
+					fUndoHistory.CountItems() - 1);
 			}
 		} else if (edit->CombineWithPrevious(top.Get())) {
 			fUndoHistory.Pop();
@@ -239,4 +287,104 @@ EditManager::_AddEdit(const UndoableEditRef& edit)
 	return status;
 }
 
+// _MemoryFootprint
+/*!	Both stacks keep a running total of the footprint of their edits, so this
+	doesn't need to walk the history.
+*/
+size_t
+EditManager::_MemoryFootprint() const
+{
+	return fUndoHistory.MemoryFootprint() + fRedoHistory.MemoryFootprint();
+}
+
+// _EnforceMemoryBudget
+void
+EditManager::_EnforceMemoryBudget()
+{
+	if (fMemoryBudget == 0)
+		return;
 
+	size_t footprint = _MemoryFootprint();
+	if (footprint <= fMemoryBudget)
+		return;
+
+	_MergeOldEdits();
+
+	footprint = _MemoryFootprint();
+	if (footprint <= fMemoryBudget)
+		return;
+
+	// The oldest edits are compacted first, in both directions of the
+	// history.
+	footprint = _CompactEdits(fUndoHistory, kRecentEditCount, footprint);
+	footprint = _CompactEdits(fRedoHistory, 1, footprint);
+
+	// Forget the oldest edits as a last resort.
+	while (footprint > fMemoryBudget
+		&& fUndoHistory.CountItems() > kRecentEditCount) {
+		fUndoHistory.RemoveItemAt(0);
+		footprint = _MemoryFootprint();
+	}
+}
+
+// _MergeOldEdits
+/*!	Tries to combine each old edit with the one following it. Edits usually
+	combine only when they happened in quick succession, but the time between
+	old edits no longer matters, so the later one is made to look as if it
+	happened at the same time.
+*/
+void
+EditManager::_MergeOldEdits()
+{
+	int32 i = 0;
+	while (i < fUndoHistory.CountItems() - 1 - kRecentEditCount) {
+		UndoableEditRef previous(fUndoHistory.ItemAt(i));
+		UndoableEditRef next(fUndoHistory.ItemAt(i + 1));
+		// The saved state needs to remain reachable.
+		if (previous == fEditAtSave || next == fEditAtSave) {
+			i++;
+			continue;
+		}
+
+		bigtime_t timeStamp = next->TimeStamp();
+		next->SetTimeStamp(previous->TimeStamp());
+		if (!previous->CombineWithNext(next.Get())) {
+			next->SetTimeStamp(timeStamp);
+			i++;
+			continue;
+		}
+
+		fUndoHistory.RemoveItemAt(i + 1);
+		// The edits may have reversed each other.
+		if (previous->InitCheck() != B_OK)
+			fUndoHistory.RemoveItemAt(i);
+		else
+			fUndoHistory.UpdateMemoryFootprint(i);
+	}
+}
+
+// _CompactEdits
+size_t
+EditManager::_CompactEdits(EditStack& history, int32 keepCount,
+	size_t footprint)
+{
+	if (fSpillFile.Get() == NULL)
+		fSpillFile.SetTo(new(std::nothrow) SpillFile(), true);
+
+	SpillFile* file = fSpillFile.Get();
+	if (file != NULL && file->InitCheck() != B_OK)
+		file = NULL;
+
+	int32 count = history.CountItems() - keepCount;
+	for (int32 i = 0; i < count && footprint > fMemoryBudget; i++) {
+		status_t ret = history.ItemAt(i)->Compact(file);
+		if (ret != B_OK) {
+			fprintf(stderr, "EditManager: failed to compact edit: %s\n",
+				strerror(ret));
+		}
+		history.UpdateMemoryFootprint(i);
+		footprint = _MemoryFootprint();
+	}
+
+	return footprint;
+}
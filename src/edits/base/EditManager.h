@@ -7,6 +7,7 @@
 
 #include "EditStack.h"
 #include "Notifier.h"
+#include "SpillFile.h"
 #include "UndoableEdit.h"
 
 class BString;
@@ -33,15 +34,29 @@ public:
 			void				Save();
 			bool				IsSaved();
 
+			void				SetMemoryBudget(size_t budget);
+	inline	size_t				MemoryBudget() const
+									{ return fMemoryBudget; }
+			size_t				MemoryFootprint();
+
 private:
 			status_t			_AddEdit(const UndoableEditRef& edit);
 
+			size_t				_MemoryFootprint() const;
+			void				_EnforceMemoryBudget();
+			void				_MergeOldEdits();
+			size_t				_CompactEdits(EditStack& history,
+									int32 keepCount, size_t footprint);
+
 private:
 			RWLocker*			fLocker;
 
 			EditStack			fUndoHistory;
 			EditStack			fRedoHistory;
 			UndoableEditRef		fEditAtSave;
+
+			size_t				fMemoryBudget;
+			SpillFileRef		fSpillFile;
 };
 
 #endif // EDIT_MANAGER_H
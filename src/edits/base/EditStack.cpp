@@ -10,6 +10,8 @@
 // constructor
 EditStack::EditStack()
 	: fEdits()
+	, fFootprints()
+	, fMemoryFootprint(0)
 {
 }
 
@@ -22,7 +24,15 @@ EditStack::~EditStack()
 bool
 EditStack::Push(const UndoableEditRef& edit)
 {
-	return fEdits.Add(edit);
+	size_t footprint = edit->MemoryFootprint();
+	if (!fFootprints.Add(footprint))
+		return false;
+	if (!fEdits.Add(edit)) {
+		fFootprints.Remove();
+		return false;
+	}
+	fMemoryFootprint += footprint;
+	return true;
 }
 
 // Pop
@@ -30,7 +40,11 @@ UndoableEditRef
 EditStack::Pop()
 {
 	UndoableEditRef edit(Top());
-	fEdits.Remove();
+	if (!IsEmpty()) {
+		fMemoryFootprint -= fFootprints.LastItem();
+		fFootprints.Remove();
+		fEdits.Remove();
+	}
 	return edit;
 }
 
@@ -47,3 +61,46 @@ EditStack::IsEmpty() const
 {
 	return fEdits.CountItems() == 0;
 }
+
+// CountItems
+int32
+EditStack::CountItems() const
+{
+	return fEdits.CountItems();
+}
+
+// ItemAt
+const UndoableEditRef&
+EditStack::ItemAt(int32 index) const
+{
+	return fEdits.ItemAt(index);
+}
+
+// RemoveItemAt
+void
+EditStack::RemoveItemAt(int32 index)
+{
+	if (index < 0 || index >= fEdits.CountItems())
+		return;
+
+	fMemoryFootprint -= fFootprints.ItemAtFast(index);
+	fFootprints.Remove(index);
+	fEdits.Remove(index);
+}
+
+// UpdateMemoryFootprint
+/*!	Measures the edit at the given index again. This needs to be called
+	whenever an edit on the stack was changed, by combining it with another
+	edit or by compacting it.
+*/
+void
+EditStack::UpdateMemoryFootprint(int32 index)
+{
+	if (index < 0 || index >= fEdits.CountItems())
+		return;
+
+	size_t footprint = fEdits.ItemAtFast(index)->MemoryFootprint();
+	fMemoryFootprint = fMemoryFootprint - fFootprints.ItemAtFast(index)
+		+ footprint;
+	fFootprints.Replace(index, footprint);
+}
@@ -21,10 +21,24 @@ public:
 
 			bool				IsEmpty() const;
 
+	// Access from the bottom of the stack, for compacting old edits.
+			int32				CountItems() const;
+			const UndoableEditRef&	ItemAt(int32 index) const;
+			void				RemoveItemAt(int32 index);
+
+	// The memory footprint of all edits, as measured when they were pushed
+	// or last updated.
+	inline	size_t				MemoryFootprint() const
+									{ return fMemoryFootprint; }
+			void				UpdateMemoryFootprint(int32 index);
+
 private:
 			typedef List<UndoableEditRef, false>	EditList;
+			typedef List<size_t, true>				FootprintList;
 
 			EditList			fEdits;
+			FootprintList		fFootprints;
+			size_t				fMemoryFootprint;
 };
 
 #endif // EDIT_STACK_H
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "SpillFile.h"
+
+#include <unistd.h>
+
+#include "AutoLocker.h"
+
+// constructor
+SpillFile::SpillFile()
+	: Referenceable()
+	, fLock("spill file")
+	, fFile(tmpfile())
+	, fSize(0)
+	, fFreeRanges()
+{
+	if (fFile == NULL)
+		fprintf(stderr, "SpillFile() - failed to create temporary file\n");
+}
+
+// destructor
+SpillFile::~SpillFile()
+{
+	if (fFile != NULL)
+		fclose(fFile);
+}
+
+// InitCheck
+status_t
+SpillFile::InitCheck() const
+{
+	return fFile != NULL ? B_OK : B_NO_INIT;
+}
+
+// Write
+status_t
+SpillFile::Write(const void* data, size_t size, off_t* _offset)
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	if (fFile == NULL)
+		return B_NO_INIT;
+
+	off_t offset;
+	bool reused = _Allocate(size, &offset);
+
+	if (fseeko(fFile, offset, SEEK_SET) != 0
+		|| fwrite(data, 1, size, fFile) != size) {
+		// The file may be left with a partial write, which is overwritten
+		// the next time.
+		if (reused)
+			Free(offset, size);
+		return B_IO_ERROR;
+	}
+
+	if (!reused)
+		fSize += size;
+
+	*_offset = offset;
+	return B_OK;
+}
+
+// Read
+/*!	Reads data which was written before. This may be called from any thread.
+*/
+status_t
+SpillFile::Read(off_t offset, void* data, size_t size)
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	if (fFile == NULL)
+		return B_NO_INIT;
+	if (offset < 0 || offset + (off_t)size > fSize)
+		return B_BAD_VALUE;
+
+	if (fseeko(fFile, offset, SEEK_SET) != 0
+		|| fread(data, 1, size, fFile) != size) {
+		return B_IO_ERROR;
+	}
+	return B_OK;
+}
+
+// Free
+/*!	Marks a range which was written before as unused, so that it can be
+	overwritten by later writes.
+*/
+void
+SpillFile::Free(off_t offset, size_t size)
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	if (fFile == NULL || size == 0 || offset < 0
+		|| offset + (off_t)size > fSize) {
+		return;
+	}
+
+	// Keep the ranges sorted and merge adjacent ones.
+	Range range(offset, size);
+	int32 index = 0;
+	int32 count = fFreeRanges.CountItems();
+	while (index < count && fFreeRanges.ItemAtFast(index).offset < offset)
+		index++;
+
+	if (index > 0) {
+		const Range& previous = fFreeRanges.ItemAtFast(index - 1);
+		if (previous.offset + (off_t)previous.size == range.offset) {
+			range.offset = previous.offset;
+			range.size += previous.size;
+			fFreeRanges.Remove(index - 1);
+			index--;
+			count--;
+		}
+	}
+	if (index < count) {
+		const Range& next = fFreeRanges.ItemAtFast(index);
+		if (range.offset + (off_t)range.size == next.offset) {
+			range.size += next.size;
+			fFreeRanges.Remove(index);
+			count--;
+		}
+	}
+
+	if (range.offset + (off_t)range.size == fSize) {
+		// The end of the file is no longer used.
+		fSize = range.offset;
+		fflush(fFile);
+		if (ftruncate(fileno(fFile), fSize) != 0)
+			fprintf(stderr, "SpillFile::Free() - failed to truncate file\n");
+		return;
+	}
+
+	if (!fFreeRanges.Add(range, index)) {
+		// The range is lost until the file is removed.
+		fprintf(stderr, "SpillFile::Free() - no memory\n");
+	}
+}
+
+// #pragma mark -
+
+// _Allocate
+/*!	Finds the first free range which is large enough, and takes the data
+	from its beginning. Returns false if the data needs to be appended.
+*/
+bool
+SpillFile::_Allocate(size_t size, off_t* _offset)
+{
+	int32 count = fFreeRanges.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		Range range = fFreeRanges.ItemAtFast(i);
+		if (range.size < size)
+			continue;
+
+		*_offset = range.offset;
+		if (range.size == size) {
+			fFreeRanges.Remove(i);
+		} else {
+			range.offset += size;
+			range.size -= size;
+			fFreeRanges.Replace(i, range);
+		}
+		return true;
+	}
+
+	*_offset = fSize;
+	return false;
+}
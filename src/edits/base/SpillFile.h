@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef SPILL_FILE_H
+#define SPILL_FILE_H
+
+#include <stdio.h>
+
+#include <Locker.h>
+
+#include "List.h"
+#include "Referenceable.h"
+
+// A temporary file into which the EditManager moves large payloads of old
+// edits, when the undo history grows beyond its memory budget. Ranges which
+// are freed again are reused by later writes, and the file is truncated when
+// its end is freed. The file is removed when the last reference is gone.
+class SpillFile : public Referenceable {
+public:
+								SpillFile();
+	virtual						~SpillFile();
+
+			status_t			InitCheck() const;
+
+			status_t			Write(const void* data, size_t size,
+									off_t* _offset);
+			status_t			Read(off_t offset, void* data,
+									size_t size);
+			void				Free(off_t offset, size_t size);
+
+	inline	off_t				Size() const
+									{ return fSize; }
+
+	inline	int32				CountFreeRanges() const
+									{ return fFreeRanges.CountItems(); }
+
+private:
+			struct Range {
+				off_t			offset;
+				size_t			size;
+
+				Range()
+					: offset(0), size(0) {}
+				Range(off_t offset, size_t size)
+					: offset(offset), size(size) {}
+			};
+
+			typedef List<Range, true>	RangeList;
+
+			bool				_Allocate(size_t size, off_t* _offset);
+
+private:
+			BLocker				fLock;
+			FILE*				fFile;
+			off_t				fSize;
+			RangeList			fFreeRanges;
+};
+
+typedef Reference<SpillFile> SpillFileRef;
+
+#endif // SPILL_FILE_H
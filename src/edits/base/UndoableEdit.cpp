@@ -83,3 +83,27 @@ UndoableEdit::CombineWithPrevious(const UndoableEdit* previous)
 {
 	return false;
 }
+
+// MemoryFootprint
+/*!	Returns an estimate of the memory which the edit keeps alive, including
+	the objects and pixels it holds on to. The default is meant for edits
+	which only remember a few values.
+*/
+size_t
+UndoableEdit::MemoryFootprint() const
+{
+	return 256;
+}
+
+// Compact
+/*!	Called by the EditManager for old edits, when the history has grown
+	beyond its memory budget. Edits which hold on to large payloads can
+	compress them or move them into the given file, from which they need to
+	read them back when they are undone or redone. The file may be NULL if no
+	temporary file could be created.
+*/
+status_t
+UndoableEdit::Compact(SpillFile* file)
+{
+	return B_OK;
+}
@@ -10,6 +10,7 @@
 
 class BString;
 class EditContext;
+class SpillFile;
 
 class UndoableEdit : public Referenceable {
 public:
@@ -29,8 +30,13 @@ public:
 	virtual	bool				CombineWithPrevious(
 									const UndoableEdit* previous);
 
+	virtual	size_t				MemoryFootprint() const;
+	virtual	status_t			Compact(SpillFile* file);
+
 	inline	bigtime_t			TimeStamp() const
 									{ return fTimeStamp; }
+	inline	void				SetTimeStamp(bigtime_t timeStamp)
+									{ fTimeStamp = timeStamp; }
 
 protected:
 			bigtime_t			fTimeStamp;
@@ -23,6 +23,7 @@
 enum {
 	MSG_AUTO_SCROLL				= 'ascr',
 	MSG_DOCUMENT_BOUNDS_CHANGED	= 'dbch',
+	MSG_REFINE_RENDERING		= 'rfrn',
 };
 
 class DocumentListener : public Document::Listener {
@@ -61,6 +62,9 @@ CanvasView::CanvasView(BRect frame, Document* document, EditContext& editContext
 	, fDelayedScrolling(false)
 
 	, fAutoScroller(NULL)
+
+	, fRefineRunner(NULL)
+	, fLastInteractionTime(0)
 {
 	SetLocker(fDocument);
 	fDocument->AddListener(fDocumentListener);
@@ -86,6 +90,9 @@ CanvasView::CanvasView(Document* document, EditContext& editContext,
 	, fDelayedScrolling(false)
 
 	, fAutoScroller(NULL)
+
+	, fRefineRunner(NULL)
+	, fLastInteractionTime(0)
 {
 	SetLocker(fDocument);
 	fDocument->AddListener(fDocumentListener);
@@ -98,6 +105,7 @@ CanvasView::~CanvasView()
 	fDocument->RemoveListener(fDocumentListener);
 	delete fDocumentListener;
 	delete fAutoScroller;
+	delete fRefineRunner;
 	delete fPlatformDelegate;
 }
 
@@ -206,6 +214,24 @@ CanvasView::MessageReceived(BMessage* message)
 				BPoint(canvasRect.Width() / 2, canvasRect.Height() / 2));
 			break;
 		}
+		case MSG_REFINE_RENDERING:
+		{
+			delete fRefineRunner;
+			fRefineRunner = NULL;
+
+			// Keep the preview while the mouse is dragging, MouseUp() will
+			// schedule the refinement again.
+			if (fScrollTracking || MouseInfo()->buttons != 0)
+				break;
+
+			bigtime_t idleTime = system_time() - fLastInteractionTime;
+			if (idleTime < CANVAS_VIEW_REFINE_DELAY)
+				_ScheduleRefinement(CANVAS_VIEW_REFINE_DELAY - idleTime);
+			else
+				fRenderManager->SetPreviewMode(false);
+			break;
+		}
+
 		case MSG_DOCUMENT_BOUNDS_CHANGED:
 			Invalidate();
 			SetDataRect(_LayoutCanvas());
@@ -297,6 +323,8 @@ CanvasView::MouseDown(BPoint where)
 	if (!IsFocus())
 		MakeFocus(true);
 
+	_PreviewRendering();
+
 	uint32 buttons;
 	if (Window()->CurrentMessage()->FindInt32("buttons",
 		(int32*)&buttons) != B_OK) {
@@ -337,6 +365,8 @@ CanvasView::MouseUp(BPoint where)
 		StateView::MouseUp(where);
 	}
 	SetAutoScrolling(false);
+
+	_PreviewRendering();
 }
 
 // MouseMoved
@@ -355,6 +385,8 @@ CanvasView::MouseMoved(BPoint where, uint32 transit, const BMessage* dragMessage
 		ConvertToCanvas(&where);
 		SetScrollOffset(ScrollOffset() + fScrollTrackingStart - where);
 	} else {
+		if (MouseInfo()->buttons != 0)
+			_PreviewRendering();
 		// normal mouse movement handled by StateView
 //		if (!fSpaceHeldDown)
 			StateView::MouseMoved(where, transit, dragMessage);
@@ -501,6 +533,8 @@ CanvasView::ScrollOffsetChanged(BPoint oldOffset, BPoint newOffset)
 		return;
 	}
 
+	_PreviewRendering();
+
 #if CANVAS_VIEW_USE_DELAYED_SCROLLING
 	fDelayedScrolling = fRenderManager->ScrollBy(offset);
 	if (!fDelayedScrolling)
@@ -618,6 +652,8 @@ void
 CanvasView::SetZoomLevel(double zoomLevel, BPoint viewAnchor,
 	BPoint canvasAnchor)
 {
+	_PreviewRendering();
+
 	fZoomLevel = zoomLevel;
 	BRect dataRect = _LayoutCanvas();
 
@@ -788,12 +824,38 @@ CanvasView::_SetRenderManagerZoom()
 	else {
 		// upscaling depends on zoom policy
 		if (fZoomPolicy == ZOOM_POLICY_ENLARGE_PIXELS)
-			fRenderManager->SetZoomLevel(1.0);
+			fRenderManager->SetZoomLevel(1.0, fZoomLevel);
 		else
 			fRenderManager->SetZoomLevel(fZoomLevel);
 	}
 }
 
+// _PreviewRendering
+//
+// Called for every user input which changes the canvas. The RenderManager
+// renders with reduced quality until the input settles.
+void
+CanvasView::_PreviewRendering()
+{
+	fLastInteractionTime = system_time();
+	fRenderManager->SetPreviewMode(true);
+
+	if (fRefineRunner == NULL)
+		_ScheduleRefinement(CANVAS_VIEW_REFINE_DELAY);
+}
+
+// _ScheduleRefinement
+void
+CanvasView::_ScheduleRefinement(bigtime_t delay)
+{
+	delete fRefineRunner;
+
+	BMessenger messenger(this, Window());
+	BMessage message(MSG_REFINE_RENDERING);
+	fRefineRunner = new(std::nothrow) BMessageRunner(messenger, &message,
+		delay, 1);
+}
+
 // #pragma mark -
 
 // _UpdateToolCursor
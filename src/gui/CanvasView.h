@@ -13,6 +13,7 @@ class RenderManager;
 
 
 #define CANVAS_VIEW_AUTO_SCROLL_DELAY		40000 // 40 ms
+#define CANVAS_VIEW_REFINE_DELAY			250000 // 250 ms
 #define CANVAS_VIEW_USE_DELAYED_SCROLLING	0
 #define CANVAS_VIEW_USE_NATIVE_SCROLLING	1
 
@@ -117,6 +118,8 @@ private:
 			BRect				_LayoutCanvas();
 
 			void				_SetRenderManagerZoom();
+			void				_PreviewRendering();
+			void				_ScheduleRefinement(bigtime_t delay);
 
 			void				_UpdateToolCursor();
 
@@ -137,6 +140,9 @@ private:
 			bool				fDelayedScrolling;
 
 			BMessageRunner*		fAutoScroller;
+
+			BMessageRunner*		fRefineRunner;
+			bigtime_t			fLastInteractionTime;
 };
 
 
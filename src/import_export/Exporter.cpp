@@ -5,25 +5,35 @@
 
 #include "Exporter.h"
 
-#include <fs_attr.h>
+#include <errno.h>
 #include <new>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
-#include <Alert.h>
-#include <Catalog.h>
 #include <File.h>
-#include <Locale.h>
-#include <Node.h>
-#include <NodeInfo.h>
 #include <Path.h>
-#include <Roster.h>
-#include <String.h>
+#include <StorageDefs.h>
+
+#ifdef __HAIKU__
+#	include <fs_attr.h>
+
+#	include <Alert.h>
+#	include <Catalog.h>
+#	include <Locale.h>
+#	include <Node.h>
+#	include <NodeInfo.h>
+#	include <Roster.h>
+#	include <String.h>
+#endif
 
 #include "EditManager.h"
 #include "Layer.h"
 
-#undef B_TRANSLATION_CONTEXT
-#define B_TRANSLATION_CONTEXT "WonderBrush-Exporter"
+#ifdef __HAIKU__
+#	undef B_TRANSLATION_CONTEXT
+#	define B_TRANSLATION_CONTEXT "WonderBrush-Exporter"
+#endif
 
 using std::nothrow;
 
@@ -49,11 +59,18 @@ Exporter::Export(const DocumentRef& document, const entry_ref& ref)
 	if (document.Get() == NULL || ref.name == NULL)
 		return B_BAD_VALUE;
 
-	fDocument.SetTo((Document*)document->BaseObject::Clone(), true);
+	// The clone shares the image pixels, brush stroke points and text
+	// layouts with the document, so it is cheap to make. The document must
+	// not change while it is cloned, though.
+	{
+		AutoReadLocker locker(document.Get());
+		if (!locker.IsLocked())
+			return B_ERROR;
 
-	AutoReadLocker locker(fDocument.Get());
-	if (!locker.IsLocked())
-		return B_ERROR;
+		fDocument.SetTo((Document*)document->BaseObject::Clone(), true);
+	}
+	if (fDocument.Get() == NULL)
+		return B_NO_MEMORY;
 
 	fRef = ref;
 
@@ -101,6 +118,7 @@ int32
 Exporter::_ExportThread()
 {
 	status_t ret = _Export(fDocument, &fRef);
+#ifdef __HAIKU__
 	if (ret != B_OK) {
 		// inform user of failure at this point
 		BString helper(B_TRANSLATE("Saving your document failed!"));
@@ -117,6 +135,15 @@ Exporter::_ExportThread()
 		// add to recent document list
 		be_roster->AddToRecentDocuments(&fRef);
 	}
+#else
+	if (ret != B_OK) {
+		fprintf(stderr, "Saving the document \"%s\" failed: %s\n",
+			fRef.name, strerror(ret));
+	}
+#endif
+
+	// The clone is no longer needed.
+	fDocument.Unset();
 
 	if (fSelfDestroy)
 		delete this;
@@ -128,37 +155,37 @@ Exporter::_ExportThread()
 status_t
 Exporter::_Export(const DocumentRef& document, const entry_ref* docRef)
 {
-	// TODO: reenable the commented out code, but make it work
-	// the opposite direction, ie *copy* the file contents
-
 	BEntry entry(docRef, true);
 	if (entry.IsDirectory())
 		return B_BAD_VALUE;
 
-	const entry_ref* ref = docRef;
-//	entry_ref tempRef;
-//
-//	if (entry.Exists()) {
-//		// if the file exists create a temporary file in the same folder
-//		// and hope that it doesn't already exist...
-//		BPath tempPath(docRef);
-//		if (tempPath.GetParent(&tempPath) >= B_OK) {
-//			BString helper(docRef->name);
-//			helper << system_time();
-//			if (tempPath.Append(helper.String()) >= B_OK
-//				&& entry.SetTo(tempPath.Path()) >= B_OK
-//				&& entry.GetRef(&tempRef) >= B_OK) {
-//				// have the output ref point to the temporary
-//				// file instead
-//				ref = &tempRef;
-//			}
-//		}
-//	}
-
-	status_t ret = B_BAD_VALUE;
+	BPath docPath;
+	status_t ret = entry.GetPath(&docPath);
+	if (ret != B_OK)
+		return ret;
+
+	// If the document file exists, the document is written into a temporary
+	// file in the same folder, which replaces the document file once it is
+	// complete. Objects of the document may still read from the old file,
+	// for example the lazily loaded pixels of images. They keep the file
+	// open, so they can continue to do that after it has been replaced.
+	BPath tempPath;
+	bool replaceFile = entry.Exists();
+	if (replaceFile) {
+		ret = docPath.GetParent(&tempPath);
+		if (ret == B_OK) {
+			char tempName[B_FILE_NAME_LENGTH];
+			snprintf(tempName, sizeof(tempName), ".%s.%lld", docPath.Leaf(),
+				(long long)system_time());
+			ret = tempPath.Append(tempName);
+		}
+		if (ret != B_OK)
+			return ret;
+	}
+	const char* path = replaceFile ? tempPath.Path() : docPath.Path();
 
 	// do the actual save operation into a file
-	BFile outFile(ref, B_CREATE_FILE | B_READ_WRITE | B_ERASE_FILE);
+	BFile outFile(path, B_CREATE_FILE | B_READ_WRITE | B_ERASE_FILE);
 	ret = outFile.InitCheck();
 	if (ret == B_OK) {
 		try {
@@ -179,49 +206,47 @@ Exporter::_Export(const DocumentRef& document, const entry_ref* docRef)
 	}
 	outFile.Unset();
 
-//	if (ret < B_OK && ref != docRef) {
-//		// in case of failure, remove temporary file
-//		entry.Remove();
-//	}
-//
-//	if (ret >= B_OK && ref != docRef) {
-//		// move temp file overwriting actual document file
-//		BEntry docEntry(docRef, true);
-//		// copy attributes of previous document file
-//		BNode sourceNode(&docEntry);
-//		BNode destNode(&entry);
-//		if (sourceNode.InitCheck() >= B_OK && destNode.InitCheck() >= B_OK) {
-//			// lock the nodes
-//			if (sourceNode.Lock() >= B_OK) {
-//				if (destNode.Lock() >= B_OK) {
-//					// iterate over the attributes
-//					char attrName[B_ATTR_NAME_LENGTH];
-//					while (sourceNode.GetNextAttrName(attrName) >= B_OK) {
-////						// skip the icon, since we probably wrote that
-////						// before
-////						if (strcmp(attrName, "BEOS:ICON") == 0)
-////							continue;
-//						attr_info info;
-//						if (sourceNode.GetAttrInfo(attrName, &info) >= B_OK) {
-//							char *buffer = new (nothrow) char[info.size];
-//							if (buffer && sourceNode.ReadAttr(attrName, info.type, 0,
-//															  buffer, info.size) == info.size) {
-//								destNode.WriteAttr(attrName, info.type, 0,
-//												   buffer, info.size);
-//							}
-//							delete[] buffer;
-//						}
-//					}
-//					destNode.Unlock();
-//				}
-//				sourceNode.Unlock();
-//			}
-//		}
-//		// clobber the orginal file with the new temporary one
-//		ret = entry.Rename(docRef->name, true);
-//	}
-
-	if (ret >= B_OK && MIMEType()) {
+	if (ret < B_OK) {
+		// in case of failure, remove temporary file
+		if (replaceFile)
+			unlink(path);
+		return ret;
+	}
+
+	if (replaceFile) {
+#ifdef __HAIKU__
+		// copy attributes of previous document file
+		BNode sourceNode(docPath.Path());
+		BNode destNode(path);
+		if (sourceNode.InitCheck() >= B_OK && destNode.InitCheck() >= B_OK) {
+			char attrName[B_ATTR_NAME_LENGTH];
+			while (sourceNode.GetNextAttrName(attrName) >= B_OK) {
+				attr_info info;
+				if (sourceNode.GetAttrInfo(attrName, &info) < B_OK)
+					continue;
+				char* buffer = new(nothrow) char[info.size];
+				if (buffer != NULL && sourceNode.ReadAttr(attrName, info.type,
+						0, buffer, info.size) == info.size) {
+					destNode.WriteAttr(attrName, info.type, 0, buffer,
+						info.size);
+				}
+				delete[] buffer;
+			}
+		}
+#endif
+
+		// clobber the orginal file with the new temporary one
+		if (rename(path, docPath.Path()) != 0) {
+			fprintf(stderr, "Exporter::_Export() - "
+				"failed to replace the document file: %s\n",
+				strerror(errno));
+			unlink(path);
+			return B_ERROR;
+		}
+	}
+
+#ifdef __HAIKU__
+	if (MIMEType()) {
 		// set file type
 		BNode node(docRef);
 		if (node.InitCheck() == B_OK) {
@@ -230,5 +255,6 @@ Exporter::_Export(const DocumentRef& document, const entry_ref* docRef)
 				nodeInfo.SetType(MIMEType());
 		}
 	}
+#endif
 	return ret;
 }
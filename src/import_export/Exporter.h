@@ -18,6 +18,8 @@ public:
 								Exporter();
 	virtual						~Exporter();
 
+			// Exports asynchronously into the file and informs the user of
+			// errors.
 			status_t			Export(const DocumentRef& document,
 									const entry_ref& ref);
 
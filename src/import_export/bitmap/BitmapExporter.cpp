@@ -11,7 +11,7 @@
 #include <TranslatorRoster.h>
 
 #include "Document.h"
-#include "RenderManager.h"
+#include "OffscreenRenderer.h"
 
 // constructor
 BitmapExporter::BitmapExporter()
@@ -52,27 +52,35 @@ BitmapExporter::~BitmapExporter()
 status_t
 BitmapExporter::Export(const DocumentRef& document, BPositionIO* stream)
 {
-	// Attach RenderManager to document
-	RenderManager renderer(document.Get());
-
-	// TODO: Use fWidth and fHeight if non-zero!
+	BRect bounds;
+	{
+		AutoReadLocker locker(document.Get());
+		if (!locker.IsLocked())
+			return B_ERROR;
+		bounds = document->Bounds();
+	}
 
-	status_t ret = renderer.Init();
+	// Scale the document to fit within the requested size, if any
+	double zoomLevel = 1.0;
+	double scaleX = fWidth > 0 ? fWidth / (bounds.Width() + 1) : 0.0;
+	double scaleY = fHeight > 0 ? fHeight / (bounds.Height() + 1) : 0.0;
+	if (scaleX > 0.0 && scaleY > 0.0)
+		zoomLevel = min_c(scaleX, scaleY);
+	else if (scaleX > 0.0)
+		zoomLevel = scaleX;
+	else if (scaleY > 0.0)
+		zoomLevel = scaleY;
+
+	BBitmap bitmap(OffscreenRenderer::ZoomedBounds(bounds, zoomLevel),
+		B_BITMAP_NO_SERVER_LINK, B_RGBA32);
+	status_t ret = bitmap.InitCheck();
 	if (ret != B_OK)
 		return ret;
-	
-	// Trigger render
-	renderer.AreaInvalidated(document->RootLayer(), document->Bounds());
-	renderer.AllAreasInvalidated();
-
-	// Wait for it to finish
-	while (!renderer.RenderingDone()) {
-		printf("Waiting for rendering to finish.\n");
-		snooze(250000);
-	}
 
-	if (!renderer.LockDisplay())
-		return B_ERROR;
+	OffscreenRenderer renderer(document.Get());
+	ret = renderer.Render(&bitmap, zoomLevel);
+	if (ret != B_OK)
+		return ret;
 
 	// save bitmap to translator
 	BTranslatorRoster* roster = BTranslatorRoster::Default();
@@ -88,15 +96,13 @@ BitmapExporter::Export(const DocumentRef& document, BPositionIO* stream)
 	memcpy(info.name, fFormat.name, sizeof(info.name));
 	memcpy(info.MIME, fFormat.MIME, sizeof(info.name));
 
-	BBitmapStream bitmapStream(const_cast<BBitmap*>(renderer.DisplayBitmap()));
+	BBitmapStream bitmapStream(&bitmap);
 	ret = roster->Translate(&bitmapStream, &info, NULL, stream, fFormat.type,
 		0);
 
 	BBitmap* dummy;
 	bitmapStream.DetachBitmap(&dummy);
 
-	renderer.UnlockDisplay();
-
 	return ret;
 }
 
@@ -140,8 +146,6 @@ BitmapExporter::SetFormat(uint32 format)
 				fTranslatorID = translatorIDs[i];
 				bestQuality = formats[j].quality;
 				bestCapability = formats[j].quality;
-				printf("found Translator: %ld, %.1f, %.1f\n", fTranslatorID,
-					bestQuality, bestCapability);
 			}
 		}
 	}
@@ -23,8 +23,16 @@
 
 static const char* kType = "type";
 
-ArchiveVisitor::ArchiveVisitor(const DocumentRef& document, BMessage* archive)
+BufferArchiver::~BufferArchiver()
+{
+}
+
+// #pragma mark -
+
+ArchiveVisitor::ArchiveVisitor(const DocumentRef& document, BMessage* archive,
+		BufferArchiver* bufferArchiver)
 	: fDocument(document)
+	, fBufferArchiver(bufferArchiver)
 	, status(B_OK)
 {
 	VisitDocument(fDocument.Get(), archive);
@@ -203,8 +211,12 @@ bool
 ArchiveVisitor::VisitImage(Image* image, BMessage* context)
 {
 	status = context->AddString(kType, "Image");
-	if (status == B_OK)
-		status = archive_buffer(image->Buffer(), context, "bitmap");
+	if (status == B_OK) {
+		if (fBufferArchiver != NULL)
+			status = fBufferArchiver->ArchiveBuffer(image, context);
+		else
+			status = archive_buffer(image->Buffer(), context, "bitmap");
+	}
 	return status == B_OK;
 }
 
@@ -12,12 +12,23 @@ class Color;
 class ColorShade;
 class Gradient;
 
+// Stores the pixels of an image outside of the archive. The archive of the
+// image then only refers to them.
+class BufferArchiver {
+public:
+	virtual						~BufferArchiver();
+
+	virtual	status_t			ArchiveBuffer(Image* image,
+									BMessage* archive) = 0;
+};
+
 class ArchiveVisitor : public DocumentVisitor<BMessage> {
 	typedef DocumentVisitor<BMessage> inherited;
 	
 public:
 								ArchiveVisitor(const DocumentRef& document,
-									BMessage* archive);
+									BMessage* archive,
+									BufferArchiver* bufferArchiver = NULL);
 	
 	virtual	bool				VisitDocument(Document* document,
 									BMessage* context);
@@ -111,6 +122,7 @@ private:
 
 private:
 			DocumentRef			fDocument;
+			BufferArchiver*		fBufferArchiver;
 
 public:
 			status_t			status;
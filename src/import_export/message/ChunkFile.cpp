@@ -0,0 +1,436 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "ChunkFile.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ByteOrder.h>
+#include <DataIO.h>
+#include <Message.h>
+
+#include "AutoLocker.h"
+#include "bitmap_compression.h"
+#include "RenderBuffer.h"
+
+enum {
+	HEADER_SIZE		= 16,
+	ENTRY_SIZE		= 24,
+	COPY_BUFFER_SIZE	= 256 * 1024
+};
+
+// The table of contents should never be larger than this. It protects
+// against allocating huge amounts of memory for corrupted files.
+static const uint32 kMaxChunkCount = 16 * 1024 * 1024;
+
+// read_exactly
+static status_t
+read_exactly(BPositionIO* stream, off_t position, void* buffer, size_t size)
+{
+	ssize_t read = stream->ReadAt(position, buffer, size);
+	if (read < 0)
+		return (status_t)read;
+	if ((size_t)read != size)
+		return B_IO_ERROR;
+	return B_OK;
+}
+
+// is_known_chunk_type
+static bool
+is_known_chunk_type(uint32 type)
+{
+	switch (type) {
+		case CHUNK_DOCUMENT:
+		case CHUNK_RESOURCES:
+		case CHUNK_OBJECTS:
+		case CHUNK_PIXELS:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// #pragma mark - ChunkFile
+
+// constructor
+ChunkFile::ChunkFile(BPositionIO* stream, bool adopt)
+	: fLock("chunk file")
+	, fStream(stream)
+	, fOwnsStream(adopt)
+	, fBase(0)
+	, fChunks()
+{
+}
+
+// destructor
+ChunkFile::~ChunkFile()
+{
+	if (fOwnsStream)
+		delete fStream;
+}
+
+// Init
+/*!	Reads the header and the table of contents, starting at the current
+	position of the stream. New chunk types come with a new file version,
+	so a chunk of unknown type means the file is corrupt.
+*/
+status_t
+ChunkFile::Init()
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	if (fStream == NULL)
+		return B_NO_INIT;
+
+	fChunks.Clear();
+	fBase = fStream->Position();
+	if (fBase < 0)
+		return (status_t)fBase;
+
+	uint8 header[HEADER_SIZE];
+	status_t ret = read_exactly(fStream, fBase, header, sizeof(header));
+	if (ret != B_OK)
+		return ret;
+
+	uint32 magic = B_BENDIAN_TO_HOST_INT32(*(uint32*)header);
+	uint32 version = B_BENDIAN_TO_HOST_INT32(*(uint32*)(header + 4));
+	uint64 tocOffset = B_BENDIAN_TO_HOST_INT64(*(uint64*)(header + 8));
+	if (magic != CHUNK_FILE_MAGIC)
+		return B_BAD_VALUE;
+	if (version > CHUNK_FILE_VERSION) {
+		fprintf(stderr, "ChunkFile::Init() - unsupported version %lu\n",
+			(unsigned long)version);
+		return B_BAD_VALUE;
+	}
+
+	uint32 count;
+	ret = read_exactly(fStream, fBase + tocOffset, &count, sizeof(count));
+	if (ret != B_OK)
+		return ret;
+	count = B_BENDIAN_TO_HOST_INT32(count);
+	if (count > kMaxChunkCount)
+		return B_BAD_DATA;
+
+	size_t tocSize = (size_t)count * ENTRY_SIZE;
+	uint8* toc = (uint8*)malloc(tocSize);
+	if (toc == NULL && tocSize > 0)
+		return B_NO_MEMORY;
+
+	ret = read_exactly(fStream, fBase + tocOffset + 8, toc, tocSize);
+	for (uint32 i = 0; ret == B_OK && i < count; i++) {
+		const uint8* data = toc + i * ENTRY_SIZE;
+		chunk_entry entry;
+		entry.type = B_BENDIAN_TO_HOST_INT32(*(uint32*)data);
+		entry.reserved = 0;
+		entry.offset = B_BENDIAN_TO_HOST_INT64(*(uint64*)(data + 8));
+		entry.size = B_BENDIAN_TO_HOST_INT64(*(uint64*)(data + 16));
+		if (entry.offset + entry.size > tocOffset
+			|| entry.offset + entry.size < entry.offset
+			|| !is_known_chunk_type(entry.type)) {
+			ret = B_BAD_DATA;
+		} else if (!fChunks.Add(entry))
+			ret = B_NO_MEMORY;
+	}
+	free(toc);
+
+	if (ret != B_OK)
+		fChunks.Clear();
+
+	return ret;
+}
+
+// ChunkType
+uint32
+ChunkFile::ChunkType(int32 index) const
+{
+	if (index < 0 || index >= fChunks.CountItems())
+		return 0;
+	return fChunks.ItemAtFast(index).type;
+}
+
+// ChunkSize
+uint64
+ChunkFile::ChunkSize(int32 index) const
+{
+	if (index < 0 || index >= fChunks.CountItems())
+		return 0;
+	return fChunks.ItemAtFast(index).size;
+}
+
+// FindChunk
+int32
+ChunkFile::FindChunk(uint32 type) const
+{
+	int32 count = fChunks.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		if (fChunks.ItemAtFast(i).type == type)
+			return i;
+	}
+	return -1;
+}
+
+// ReadChunk
+status_t
+ChunkFile::ReadChunk(int32 index, void* buffer, size_t size, uint64 offset)
+{
+	if (index < 0 || index >= fChunks.CountItems())
+		return B_BAD_INDEX;
+
+	const chunk_entry& entry = fChunks.ItemAtFast(index);
+	if (offset + size > entry.size)
+		return B_BAD_VALUE;
+
+	AutoLocker<BLocker> locker(fLock);
+	return read_exactly(fStream, fBase + entry.offset + offset, buffer, size);
+}
+
+// ReadMessage
+status_t
+ChunkFile::ReadMessage(int32 index, BMessage* message)
+{
+	uint64 size = ChunkSize(index);
+	if (size == 0)
+		return B_BAD_INDEX;
+
+	char* buffer = (char*)malloc(size);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	status_t ret = ReadChunk(index, buffer, size);
+	if (ret == B_OK)
+		ret = message->Unflatten(buffer);
+
+	free(buffer);
+	return ret;
+}
+
+// #pragma mark - ChunkWriter
+
+// constructor
+ChunkWriter::ChunkWriter(BPositionIO* stream)
+	: fStream(stream)
+	, fHeaderOffset(0)
+	, fPosition(0)
+	, fChunks()
+{
+}
+
+// destructor
+ChunkWriter::~ChunkWriter()
+{
+}
+
+// WriteHeader
+/*!	Writes a preliminary header at the current position of the stream. The
+	offset of the table of contents is written by Finish().
+*/
+status_t
+ChunkWriter::WriteHeader()
+{
+	fHeaderOffset = fStream->Position();
+	if (fHeaderOffset < 0)
+		return (status_t)fHeaderOffset;
+
+	fPosition = 0;
+	fChunks.Clear();
+
+	uint8 header[HEADER_SIZE];
+	memset(header, 0, sizeof(header));
+	*(uint32*)header = B_HOST_TO_BENDIAN_INT32(CHUNK_FILE_MAGIC);
+	*(uint32*)(header + 4) = B_HOST_TO_BENDIAN_INT32(CHUNK_FILE_VERSION);
+
+	return _Write(header, sizeof(header));
+}
+
+// AddChunk
+status_t
+ChunkWriter::AddChunk(uint32 type, const void* data, size_t size,
+	int32* _index)
+{
+	uint64 offset = fPosition;
+	status_t ret = _Write(data, size);
+	if (ret != B_OK)
+		return ret;
+
+	return _AddEntry(type, offset, size, _index);
+}
+
+// AddMessage
+status_t
+ChunkWriter::AddMessage(uint32 type, const BMessage& message)
+{
+	uint64 offset = fPosition;
+	ssize_t size = 0;
+	status_t ret = message.Flatten(fStream, &size);
+	if (ret != B_OK)
+		return ret;
+
+	fPosition += size;
+	return _AddEntry(type, offset, size, NULL);
+}
+
+// CopyChunk
+/*!	Copies a chunk of another file without looking at its contents. This
+	is how unchanged pixels are saved again.
+*/
+status_t
+ChunkWriter::CopyChunk(ChunkFile* file, int32 index, int32* _index)
+{
+	uint64 size = file->ChunkSize(index);
+	size_t bufferSize = (size_t)min_c(size, (uint64)COPY_BUFFER_SIZE);
+	uint8* buffer = (uint8*)malloc(bufferSize);
+	if (buffer == NULL && bufferSize > 0)
+		return B_NO_MEMORY;
+
+	uint64 offset = fPosition;
+	status_t ret = B_OK;
+	for (uint64 copied = 0; ret == B_OK && copied < size;) {
+		size_t toCopy = (size_t)min_c(size - copied, (uint64)bufferSize);
+		ret = file->ReadChunk(index, buffer, toCopy, copied);
+		if (ret == B_OK)
+			ret = _Write(buffer, toCopy);
+		copied += toCopy;
+	}
+	free(buffer);
+
+	if (ret != B_OK)
+		return ret;
+
+	return _AddEntry(file->ChunkType(index), offset, size, _index);
+}
+
+// Finish
+/*!	Writes the table of contents and completes the header.
+*/
+status_t
+ChunkWriter::Finish()
+{
+	uint64 tocOffset = fPosition;
+
+	uint32 count = fChunks.CountItems();
+	uint8 tocHeader[8];
+	memset(tocHeader, 0, sizeof(tocHeader));
+	*(uint32*)tocHeader = B_HOST_TO_BENDIAN_INT32(count);
+	status_t ret = _Write(tocHeader, sizeof(tocHeader));
+
+	for (uint32 i = 0; ret == B_OK && i < count; i++) {
+		const chunk_entry& entry = fChunks.ItemAtFast(i);
+		uint8 data[ENTRY_SIZE];
+		memset(data, 0, sizeof(data));
+		*(uint32*)data = B_HOST_TO_BENDIAN_INT32(entry.type);
+		*(uint64*)(data + 8) = B_HOST_TO_BENDIAN_INT64(entry.offset);
+		*(uint64*)(data + 16) = B_HOST_TO_BENDIAN_INT64(entry.size);
+		ret = _Write(data, sizeof(data));
+	}
+	if (ret != B_OK)
+		return ret;
+
+	uint64 offset = B_HOST_TO_BENDIAN_INT64(tocOffset);
+	ssize_t written = fStream->WriteAt(fHeaderOffset + 8, &offset,
+		sizeof(offset));
+	if (written < 0)
+		return (status_t)written;
+	if (written != sizeof(offset))
+		return B_IO_ERROR;
+	return B_OK;
+}
+
+// _Write
+status_t
+ChunkWriter::_Write(const void* data, size_t size)
+{
+	ssize_t written = fStream->Write(data, size);
+	if (written < 0)
+		return (status_t)written;
+	if ((size_t)written != size)
+		return B_IO_ERROR;
+
+	fPosition += size;
+	return B_OK;
+}
+
+// _AddEntry
+status_t
+ChunkWriter::_AddEntry(uint32 type, uint64 offset, uint64 size,
+	int32* _index)
+{
+	chunk_entry entry;
+	entry.type = type;
+	entry.reserved = 0;
+	entry.offset = offset;
+	entry.size = size;
+	if (!fChunks.Add(entry))
+		return B_NO_MEMORY;
+
+	if (_index != NULL)
+		*_index = fChunks.CountItems() - 1;
+	return B_OK;
+}
+
+// #pragma mark - PixelChunk
+
+// constructor
+PixelChunk::PixelChunk(ChunkFile* file, int32 index, BRect bounds,
+		uint32 compression)
+	: fLock("pixel chunk")
+	, fFile(file)
+	, fIndex(index)
+	, fBounds(bounds)
+	, fCompression(compression)
+	, fBuffer()
+	, fLoadStatus(B_NO_INIT)
+{
+}
+
+// destructor
+PixelChunk::~PixelChunk()
+{
+}
+
+// Bounds
+BRect
+PixelChunk::Bounds() const
+{
+	return fBounds;
+}
+
+// Buffer
+RenderBufferRef
+PixelChunk::Buffer()
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	// Don't try again if reading failed once.
+	if (fBuffer.Get() != NULL || fLoadStatus != B_NO_INIT)
+		return fBuffer;
+
+	uint64 size = fFile->ChunkSize(fIndex);
+	void* data = malloc(size);
+	if (data == NULL) {
+		fLoadStatus = B_NO_MEMORY;
+		return fBuffer;
+	}
+
+	fLoadStatus = fFile->ReadChunk(fIndex, data, size);
+	if (fLoadStatus == B_OK) {
+		RenderBuffer* buffer = decompress_buffer(data, size, fBounds,
+			fCompression);
+		if (buffer != NULL)
+			fBuffer.SetTo(buffer, true);
+		else
+			fLoadStatus = B_BAD_DATA;
+	}
+	free(data);
+
+	if (fLoadStatus != B_OK) {
+		fprintf(stderr, "PixelChunk::Buffer() - failed to read pixels: %s\n",
+			strerror(fLoadStatus));
+	}
+
+	return fBuffer;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef CHUNK_FILE_H
+#define CHUNK_FILE_H
+
+#include <Locker.h>
+#include <Rect.h>
+
+#include "Image.h"
+#include "List.h"
+#include "Referenceable.h"
+
+class BMessage;
+class BPositionIO;
+
+// The native file format is a container of chunks. The file starts with a
+// header, which holds the offset of the table of contents at the end of the
+// file. The table lists the type, offset and size of each chunk. The
+// structure of the document is stored in flattened BMessages, the pixels of
+// each image in a separate chunk, so that they can be read when they are
+// first needed. All numbers are stored in big endian.
+
+enum {
+	CHUNK_FILE_MAGIC		= 'WBI3',
+	CHUNK_FILE_VERSION		= 1,
+
+	CHUNK_DOCUMENT			= 'DOCU',
+	CHUNK_RESOURCES			= 'RSRC',
+	CHUNK_OBJECTS			= 'OBJS',
+	CHUNK_PIXELS			= 'PIXL'
+};
+
+struct chunk_entry {
+	uint32	type;
+	uint32	reserved;
+	uint64	offset;
+	uint64	size;
+};
+
+class ChunkFile : public Referenceable {
+public:
+								ChunkFile(BPositionIO* stream, bool adopt);
+	virtual						~ChunkFile();
+
+			status_t			Init();
+
+			int32				CountChunks() const
+									{ return fChunks.CountItems(); }
+			uint32				ChunkType(int32 index) const;
+			uint64				ChunkSize(int32 index) const;
+			int32				FindChunk(uint32 type) const;
+
+			status_t			ReadChunk(int32 index, void* buffer,
+									size_t size, uint64 offset = 0);
+			status_t			ReadMessage(int32 index, BMessage* message);
+
+private:
+			typedef List<chunk_entry, true> ChunkList;
+
+			BLocker				fLock;
+			BPositionIO*		fStream;
+			bool				fOwnsStream;
+			off_t				fBase;
+			ChunkList			fChunks;
+};
+
+typedef Reference<ChunkFile> ChunkFileRef;
+
+
+class ChunkWriter {
+public:
+								ChunkWriter(BPositionIO* stream);
+								~ChunkWriter();
+
+			status_t			WriteHeader();
+
+			status_t			AddChunk(uint32 type, const void* data,
+									size_t size, int32* _index = NULL);
+			status_t			AddMessage(uint32 type,
+									const BMessage& message);
+			status_t			CopyChunk(ChunkFile* file, int32 index,
+									int32* _index = NULL);
+
+			status_t			Finish();
+
+private:
+			status_t			_Write(const void* data, size_t size);
+			status_t			_AddEntry(uint32 type, uint64 offset,
+									uint64 size, int32* _index);
+
+private:
+			typedef List<chunk_entry, true> ChunkList;
+
+			BPositionIO*		fStream;
+			off_t				fHeaderOffset;
+			uint64				fPosition;
+			ChunkList			fChunks;
+};
+
+
+// A PixelChunk reads the compressed pixels of an image from the ChunkFile
+// and keeps them once they were needed.
+class PixelChunk : public LazyBuffer {
+public:
+								PixelChunk(ChunkFile* file, int32 index,
+									BRect bounds, uint32 compression);
+	virtual						~PixelChunk();
+
+	virtual	BRect				Bounds() const;
+	virtual	RenderBufferRef		Buffer();
+
+	inline	ChunkFile*			File() const
+									{ return fFile.Get(); }
+	inline	int32				Index() const
+									{ return fIndex; }
+	inline	uint32				Compression() const
+									{ return fCompression; }
+
+private:
+			BLocker				fLock;
+			ChunkFileRef		fFile;
+			int32				fIndex;
+			BRect				fBounds;
+			uint32				fCompression;
+			RenderBufferRef		fBuffer;
+			status_t			fLoadStatus;
+};
+
+#endif // CHUNK_FILE_H
@@ -5,14 +5,102 @@
 
 #include "MessageExporter.h"
 
+#include <new>
+#include <stdlib.h>
+
 #include <ByteOrder.h>
 #include <DataIO.h>
 #include <Message.h>
 
 #include "ArchiveVisitor.h"
+#include "bitmap_compression.h"
+#include "ChunkFile.h"
+#include "HashMapHugo.h"
+#include "RenderBuffer.h"
+
+// PixelChunkArchiver
+/*!	Writes the pixels of each image into a separate chunk. Pixels shared by
+	several images are written only once. Pixels which have not been read
+	from the original file yet are copied without decompressing them.
+*/
+class PixelChunkArchiver : public BufferArchiver {
+public:
+	PixelChunkArchiver(ChunkWriter& writer, compression_codec codec)
+		: fWriter(writer)
+		, fCodec(codec)
+		, fChunks()
+	{
+	}
+
+	virtual status_t ArchiveBuffer(Image* image, BMessage* archive)
+	{
+		PixelChunk* pixelChunk = dynamic_cast<PixelChunk*>(
+			image->GetLazyBuffer());
+
+		// Shared pixels are identified by the object holding them.
+		void* key = pixelChunk;
+		if (key == NULL)
+			key = image->Buffer();
+		if (key == NULL)
+			return B_BAD_VALUE;
+
+		HashKey64<uint64> hashKey((uint64)(addr_t)key);
+		int32 index;
+		status_t ret = B_OK;
+		BRect bounds = image->Bounds();
+		uint32 compression;
+		if (fChunks.ContainsKey(hashKey)) {
+			ChunkInfo info = fChunks.Get(hashKey);
+			index = info.index;
+			compression = info.compression;
+		} else {
+			if (pixelChunk != NULL) {
+				ret = fWriter.CopyChunk(pixelChunk->File(),
+					pixelChunk->Index(), &index);
+				compression = pixelChunk->Compression();
+			} else {
+				void* data;
+				size_t size;
+				ret = compress_buffer(image->Buffer(), &data, &size,
+					&compression, fCodec);
+				if (ret == B_OK) {
+					ret = fWriter.AddChunk(CHUNK_PIXELS, data, size, &index);
+					free(data);
+				}
+			}
+			if (ret == B_OK) {
+				ChunkInfo info;
+				info.index = index;
+				info.compression = compression;
+				ret = fChunks.Put(hashKey, info);
+			}
+		}
+
+		if (ret == B_OK)
+			ret = archive->AddInt32("pixels", index);
+		if (ret == B_OK)
+			ret = archive->AddInt32("compression", compression);
+		if (ret == B_OK)
+			ret = archive->AddRect("construction bounds", bounds);
+		return ret;
+	}
+
+private:
+	struct ChunkInfo {
+		int32	index;
+		uint32	compression;
+	};
+
+	ChunkWriter&	fWriter;
+	compression_codec fCodec;
+	HashMap<HashKey64<uint64>, ChunkInfo> fChunks;
+};
+
+// #pragma mark -
 
 // constructor
 MessageExporter::MessageExporter()
+	: fCodec(COMPRESSION_CODEC_FAST)
 {
 }
 
@@ -22,39 +110,47 @@ MessageExporter::~MessageExporter()
 }
 
 // Export
+/*!	Writes the document into a ChunkFile. The pixels of the images are
+	written while the document is archived, the archive itself is split
+	into the resources, the objects and the remaining document properties.
+*/
 status_t
 MessageExporter::Export(const DocumentRef& document, BPositionIO* stream)
 {
-	status_t ret = B_OK;
-
-	// Prepend the magic number to the file which later tells us that this file
-	// is one of us
-	if (ret == B_OK) {
-		ssize_t size = sizeof(uint32);
-		uint32 magic = B_HOST_TO_BENDIAN_INT32('WBI2');
-		ssize_t written = stream->Write(&magic, size);
-		if (written != size) {
-			if (written < 0)
-				ret = (status_t)written;
-			else
-				ret = B_IO_ERROR;
-		}
+	ChunkWriter writer(stream);
+	status_t ret = writer.WriteHeader();
+	if (ret != B_OK)
+		return ret;
+
+	BMessage archive;
+	PixelChunkArchiver pixelArchiver(writer, fCodec);
+	ArchiveVisitor visitor(document, &archive, &pixelArchiver);
+	ret = visitor.status;
+	if (ret != B_OK) {
+		fprintf(stderr, "Error archiving document: %s\n", strerror(ret));
+		return ret;
 	}
 
-	if (ret == B_OK) {
-		BMessage archive;
-		
-		ArchiveVisitor visitor(document, &archive);
-		ret = visitor.status;
+	BMessage resources;
+	ret = archive.FindMessage("resources", &resources);
+	if (ret == B_OK)
+		ret = writer.AddMessage(CHUNK_RESOURCES, resources);
 
-		archive.PrintToStream();
+	BMessage objects;
+	if (ret == B_OK)
+		ret = archive.FindMessage("object", &objects);
+	if (ret == B_OK)
+		ret = writer.AddMessage(CHUNK_OBJECTS, objects);
 
-		if (ret == B_OK)
-			ret = archive.Flatten(stream);
-		else
-			fprintf(stderr, "Error archiving document: %s\n", strerror(ret));
+	if (ret == B_OK) {
+		archive.RemoveName("resources");
+		archive.RemoveName("object");
+		ret = writer.AddMessage(CHUNK_DOCUMENT, archive);
 	}
 
+	if (ret == B_OK)
+		ret = writer.Finish();
+
 	return ret;
 }
 
@@ -65,6 +161,13 @@ MessageExporter::MIMEType()
 	return "image/x-wonderbrush-2";
 }
 
+// SetCompressionCodec
+void
+MessageExporter::SetCompressionCodec(compression_codec codec)
+{
+	fCodec = codec;
+}
+
 
 
 
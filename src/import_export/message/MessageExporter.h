@@ -6,6 +6,7 @@
 #define MESSAGE_EXPORTER_H
 
 
+#include "bitmap_compression.h"
 #include "Exporter.h"
 
 class BMessage;
@@ -21,7 +22,11 @@ public:
 
 	virtual	const char*			MIMEType();
 
+			void				SetCompressionCodec(
+									compression_codec codec);
+
 private:
+			compression_codec	fCodec;
 };
 
 #endif // MESSAGE_EXPORTER_H
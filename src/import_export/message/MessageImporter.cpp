@@ -10,11 +10,15 @@
 #include <Message.h>
 #include <TypeConstants.h>
 
+#include <File.h>
+
+#include "AutoDeleter.h"
 #include "bitmap_compression.h"
 #include "BoundedObject.h"
 #include "Brush.h"
 #include "BrushStroke.h"
 #include "CharacterStyle.h"
+#include "ChunkFile.h"
 #include "Color.h"
 #include "ColorShade.h"
 #include "Document.h"
@@ -45,6 +49,8 @@ static const char* kType = "type";
 // constructor
 MessageImporter::MessageImporter(const DocumentRef& document)
 	: fDocument(document)
+	, fChunkFile(NULL)
+	, fLazyPixels(false)
 {
 }
 
@@ -54,31 +60,40 @@ MessageImporter::~MessageImporter()
 }
 
 // Import
+/*!	Imports the document from the stream. All pixels of images are read
+	before this method returns.
+*/
 status_t
 MessageImporter::Import(BPositionIO& stream) const
 {
-	if (fDocument.Get() == NULL)
-		return B_NO_INIT;
+	return _Import(stream, NULL);
+}
 
-	uint32 magic = 0;
-	ssize_t size = sizeof(magic);
-	ssize_t read = stream.Read(&magic, size);
-	if (read != size) {
-		if (read < 0)
-			return (status_t)read;
-		else
-			return B_IO_ERROR;
+// Import
+/*!	Imports the document from the file. The pixels of images in a chunked
+	file are only read when they are first needed, the file stays open until
+	then.
+*/
+status_t
+MessageImporter::Import(const char* path) const
+{
+	BFile* file = new(std::nothrow) BFile(path, B_READ_ONLY);
+	if (file == NULL)
+		return B_NO_MEMORY;
+
+	// The PixelChunks of the imported images keep a reference to the
+	// ChunkFile, which owns the BFile.
+	ChunkFileRef chunkFile(new(std::nothrow) ChunkFile(file, true), true);
+	if (chunkFile.Get() == NULL) {
+		delete file;
+		return B_NO_MEMORY;
 	}
 
-	if (B_BENDIAN_TO_HOST_INT32(magic) != 'WBI2')
-		return B_BAD_VALUE;
-
-	BMessage archive;
-	status_t ret = archive.Unflatten(&stream);
+	status_t ret = file->InitCheck();
 	if (ret != B_OK)
 		return ret;
 
-	return ImportDocument(archive);
+	return _Import(*file, chunkFile.Get());
 }
 
 // ImportDocument
@@ -355,7 +370,11 @@ MessageImporter::ImportImage(const BMessage& archive) const
 	Image* image = new(std::nothrow) Image();
 	if (image != NULL) {
 		RenderBuffer* buffer;
-		if (extract_buffer(&buffer, &archive, "bitmap") == B_OK)
+		int32 pixelChunk;
+		if (fChunkFile != NULL
+			&& archive.FindInt32("pixels", &pixelChunk) == B_OK) {
+			_ImportPixelChunk(image, pixelChunk, archive);
+		} else if (extract_buffer(&buffer, &archive, "bitmap") == B_OK)
 			image->SetBuffer(RenderBufferRef(buffer, true));
 		else {
 			fprintf(stderr, "MessageImporter::ImportImage() - "
@@ -708,6 +727,117 @@ MessageImporter::ImportStyle(const BMessage& archive) const
 
 // #pragma mark -
 
+// _Import
+/*!	If a ChunkFile is passed, it is the file for the stream and may keep the
+	stream for reading the pixels of images later.
+*/
+status_t
+MessageImporter::_Import(BPositionIO& stream, ChunkFile* file) const
+{
+	if (fDocument.Get() == NULL)
+		return B_NO_INIT;
+
+	off_t start = stream.Position();
+
+	uint32 magic = 0;
+	ssize_t size = sizeof(magic);
+	ssize_t read = stream.Read(&magic, size);
+	if (read != size) {
+		if (read < 0)
+			return (status_t)read;
+		else
+			return B_IO_ERROR;
+	}
+
+	magic = B_BENDIAN_TO_HOST_INT32(magic);
+	if (magic == CHUNK_FILE_MAGIC) {
+		stream.Seek(start, SEEK_SET);
+		if (file != NULL)
+			return _ImportChunks(file, true);
+
+		// The ChunkFile must not outlive the stream, so the pixels are
+		// read right away.
+		ChunkFileRef chunkFile(new(std::nothrow) ChunkFile(&stream, false),
+			true);
+		if (chunkFile.Get() == NULL)
+			return B_NO_MEMORY;
+		return _ImportChunks(chunkFile.Get(), false);
+	}
+
+	if (magic != 'WBI2')
+		return B_BAD_VALUE;
+
+	BMessage archive;
+	status_t ret = archive.Unflatten(&stream);
+	if (ret != B_OK)
+		return ret;
+
+	return ImportDocument(archive);
+}
+
+// _ImportChunks
+status_t
+MessageImporter::_ImportChunks(ChunkFile* file, bool lazyPixels) const
+{
+	status_t ret = file->Init();
+	if (ret != B_OK)
+		return ret;
+
+	BMessage document;
+	ret = file->ReadMessage(file->FindChunk(CHUNK_DOCUMENT), &document);
+	if (ret != B_OK)
+		return ret;
+
+	BRect bounds;
+	if (document.FindRect("bounds", &bounds) == B_OK)
+		fDocument->SetBounds(bounds);
+
+	fChunkFile = file;
+	fLazyPixels = lazyPixels;
+
+	BMessage resources;
+	ret = file->ReadMessage(file->FindChunk(CHUNK_RESOURCES), &resources);
+	if (ret == B_OK)
+		ret = ImportGlobalResources(resources);
+
+	BMessage objects;
+	if (ret == B_OK)
+		ret = file->ReadMessage(file->FindChunk(CHUNK_OBJECTS), &objects);
+	if (ret == B_OK)
+		ret = ImportObjects(objects, fDocument->RootLayer());
+
+	fChunkFile = NULL;
+	fLazyPixels = false;
+
+	return ret;
+}
+
+// _ImportPixelChunk
+void
+MessageImporter::_ImportPixelChunk(Image* image, int32 index,
+	const BMessage& archive) const
+{
+	BRect bounds;
+	uint32 compression;
+	if (fChunkFile->ChunkType(index) != CHUNK_PIXELS
+		|| archive.FindRect("construction bounds", &bounds) != B_OK
+		|| archive.FindInt32("compression", (int32*)&compression) != B_OK) {
+		fprintf(stderr, "MessageImporter::_ImportPixelChunk() - "
+			"invalid pixel chunk %ld!\n", (long)index);
+		return;
+	}
+
+	LazyBufferRef pixels(new(std::nothrow) PixelChunk(fChunkFile, index,
+		bounds, compression), true);
+	if (pixels.Get() == NULL)
+		return;
+
+	if (fLazyPixels)
+		image->SetLazyBuffer(pixels);
+	else
+		image->SetBuffer(pixels->Buffer());
+}
+
 // ImportGlobalResources
 template<class Type, class Container>
 status_t
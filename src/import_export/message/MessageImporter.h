@@ -11,6 +11,8 @@ class BMessage;
 class BPositionIO;
 class BaseObject;
 class BoundedObject;
+class ChunkFile;
+class Image;
 class Object;
 class Styleable;
 
@@ -20,6 +22,7 @@ public:
 	virtual						~MessageImporter();
 
 			status_t			Import(BPositionIO& stream) const;
+			status_t			Import(const char* path) const;
 
 			status_t			ImportDocument(const BMessage& archive) const;
 
@@ -72,6 +75,14 @@ public:
 									const BMessage& archive) const;
 
 private:
+			status_t			_Import(BPositionIO& stream,
+									ChunkFile* file) const;
+			status_t			_ImportChunks(ChunkFile* file,
+									bool lazyPixels) const;
+			void				_ImportPixelChunk(Image* image,
+									int32 index,
+									const BMessage& archive) const;
+
 			template<class Type, class Container>
 			status_t			_ImportObjects(const BMessage& archive,
 									Container* container) const;
@@ -87,6 +98,10 @@ private:
 
 private:
 			DocumentRef			fDocument;
+
+			// Only valid while a ChunkFile is imported.
+	mutable	ChunkFile*			fChunkFile;
+	mutable	bool				fLazyPixels;
 };
 
 #endif // MESSAGE_IMPORTER_H
@@ -177,6 +177,20 @@ Document::HasLayer(Layer* layer) const
 	return _HasLayer(fRootLayer, layer);
 }
 
+// BeginTransaction
+void
+Document::BeginTransaction()
+{
+	fRootLayer->BeginTransaction();
+}
+
+// CommitTransaction
+void
+Document::CommitTransaction()
+{
+	fRootLayer->CommitTransaction();
+}
+
 // IsEmpty
 bool
 Document::IsEmpty() const
@@ -56,6 +56,10 @@ public:
 									{ return fRootLayer; }
 			bool				HasLayer(Layer* layer) const;
 
+								// see Layer::BeginTransaction()
+			void				BeginTransaction();
+			void				CommitTransaction();
+
 	inline	ResourceList&		GlobalResources()
 									{ return fGlobalResources; }
 	inline	const ResourceList&	GlobalResources() const
@@ -5,6 +5,7 @@
 
 #include "Brush.h"
 
+#include <math.h>
 #include <stdio.h>
 
 #include <agg_pixfmt_brush.h>
@@ -19,6 +20,7 @@
 #include <agg_span_gradient.h>
 #include <agg_span_interpolator_trans.h>
 
+#include "BrushStampCache.h"
 #include "support.h"
 
 // init_gauss_table
@@ -277,6 +279,26 @@ Brush::SetFlags(uint32 flags)
 
 // #pragma mark -
 
+// operator==
+bool
+Brush::operator==(const Brush& other) const
+{
+	return fMinOpacity == other.fMinOpacity
+		&& fMaxOpacity == other.fMaxOpacity
+		&& fMinRadius == other.fMinRadius
+		&& fMaxRadius == other.fMaxRadius
+		&& fMinHardness == other.fMinHardness
+		&& fMaxHardness == other.fMaxHardness
+		&& fFlags == other.fFlags;
+}
+
+// operator!=
+bool
+Brush::operator!=(const Brush& other) const
+{
+	return !(*this == other);
+}
+
 static inline float
 value_in_range(float min, float max, float scale, bool scaled)
 {
@@ -335,18 +357,91 @@ typedef agg::renderer_scanline_aa<BrushBaseRenderer,
 	GradientAllocator, GradientGenerator>				GradientRenderer;
 
 
+// Quantization of the dab parameters for the stamp cache. Radius and matrix
+// are quantized relative to their magnitude, so that small and large dabs
+// are reproduced with the same relative precision.
+enum {
+	STAMP_RADIUS_STEPS		= 64,
+	STAMP_MATRIX_STEPS		= 256,
+	STAMP_HARDNESS_STEPS	= 64,
+	STAMP_SUBPIXEL_STEPS	= 4,
+
+	// Larger dabs are rasterized directly. Their stamps would use a lot of
+	// memory, while the rasterization overhead is small compared to the
+	// number of pixels to blend.
+	STAMP_MAX_RADIUS		= 64
+};
+
+static inline int32
+quantize(double value, int exponent, int32 steps)
+{
+	return (int32)floor(ldexp(value, -exponent) * steps + 0.5);
+}
+
+static inline double
+dequantize(int32 value, int exponent, int32 steps)
+{
+	return ldexp((double)value / steps, exponent);
+}
+
+// rasterize_dab
+static void
+rasterize_dab(RenderingBuffer& buffer, const Transformable& ellipseTransform,
+	double radius, double hardness, uint8 color, uint8 coverScale, bool solid)
+{
+	// Create transformed ellipse vertex source and rasterize it.
+	agg::ellipse ellipse(0.0, 0.0, radius, radius, 64);
+	agg::conv_transform<agg::ellipse, Transformable> transformedEllipse(
+		ellipse, ellipseTransform);
+
+	agg::rasterizer_scanline_aa<> rasterizer;
+	rasterizer.clip_box(0, 0, buffer.width(), buffer.height());
+	rasterizer.add_path(transformedEllipse);
+
+	agg::scanline_u8 scanlineU;
+
+	BrushPixelFormat pixelFormat(buffer);
+	pixelFormat.cover_scale(coverScale);
+	pixelFormat.solid(solid);
+
+	BrushBaseRenderer rendererBase(pixelFormat);
+
+	// special case for hardness = 1.0
+	if (hardness == 1.0) {
+		BrushRenderer renderer(rendererBase);
+		renderer.color(Color(color));
+		agg::render_scanlines(rasterizer, scanlineU, renderer);
+	} else {
+		// Brush gradient transformation
+		Transformable gradientTransform = ellipseTransform;
+		gradientTransform.invert();
+	
+		// Defining the brush gradient
+		GradientFunction gradientFunction;
+		Interpolator interpolator(gradientTransform);
+		GradientAllocator spanAllocator;
+		ColorArray array(reinterpret_cast<agg::gray8*>(sGaussTable));
+		GradientGenerator gradientGenerator(interpolator, gradientFunction,
+			array, hardness * radius, radius * 2 - hardness * radius + 1.0);
+		GradientRenderer gradientRenderer(rendererBase, spanAllocator,
+			gradientGenerator);
+	
+		agg::render_scanlines(rasterizer, scanlineU, gradientRenderer);
+	}
+}
+
 // Draw
+/*!	Draws a single dab into the 8 bit alpha buffer. If a stamp cache is
+	given, the dab is blended from a pre-rendered stamp when possible,
+	otherwise it is rasterized directly.
+*/
 void
 Brush::Draw(BPoint where, float pressure, float tiltX, float tiltY,
 	uint8* bits, uint32 bpr, const Transformable& transform,
-	const BRect& constrainRect) const
+	const BRect& constrainRect, BrushStampCache* stampCache) const
 {
-//printf("Brush::Draw()\n");
-//bigtime_t startTime = system_time();
-	if (!constrainRect.IsValid()) {
-//printf("  invalid constrain rect\n");
+	if (!constrainRect.IsValid())
 		return;
-	}
 
 	double radius = Radius(pressure);
 
@@ -354,11 +449,8 @@ Brush::Draw(BPoint where, float pressure, float tiltX, float tiltY,
 	BRect clipTest(where.x - radius, where.y - radius,
 		where.x + radius, where.y + radius);
 	clipTest = transform.TransformBounds(clipTest);
-	if (!constrainRect.Intersects(clipTest)) {
-//printf("  brush shape outside clipping\n");
+	if (!constrainRect.Intersects(clipTest))
 		return;
-	}
-//printf("  drawing brush (%f, %f)\n", where.x, where.y);
 
 	double hardness = Hardness(pressure);
 	uint8 opacity = Opacity(pressure);
@@ -379,6 +471,12 @@ Brush::Draw(BPoint where, float pressure, float tiltX, float tiltY,
 		ellipseTransform *= agg::trans_affine_rotation(angle);
 	}
 
+	if (stampCache != NULL
+		&& _DrawStamp(where, radius, hardness, opacity, ellipseTransform,
+			bits, bpr, transform, constrainRect, *stampCache)) {
+		return;
+	}
+
 	// Calculate transformation:
 	// Move ellipse to virtual brush location
 	ellipseTransform *= agg::trans_affine_translation(where.x, where.y);
@@ -388,11 +486,6 @@ Brush::Draw(BPoint where, float pressure, float tiltX, float tiltY,
 	ellipseTransform *= agg::trans_affine_translation(
 		-constrainRect.left, -constrainRect.top);
 
-	// Create transformed ellipse vertex source and rasterize it.
-	agg::ellipse ellipse(0.0, 0.0, radius, radius, 64);
-	agg::conv_transform<agg::ellipse, Transformable> transformedEllipse(
-		ellipse, ellipseTransform);
-
 	// Attach the AGG buffer to the memory
 	RenderingBuffer buffer;
 	int width = constrainRect.IntegerWidth() + 1;
@@ -400,46 +493,153 @@ Brush::Draw(BPoint where, float pressure, float tiltX, float tiltY,
 	bits += (int32)constrainRect.left + (int32)constrainRect.top * bpr;
 	buffer.attach(bits, width, height, bpr);
 
-	// Rasterize the ellipse
-//bigtime_t renderTime = system_time();
+	rasterize_dab(buffer, ellipseTransform, radius, hardness, opacity,
+		opacity, (fFlags & FLAG_SOLID) != 0);
+}
 
-	agg::rasterizer_scanline_aa<> rasterizer;
-	rasterizer.clip_box(0, 0, width, height);
-	rasterizer.add_path(transformedEllipse);
+// _DrawStamp
+/*!	Blends the dab from the stamp cache, rendering the stamp first if it is
+	not yet cached. The coverage of a stamp is what rasterizing the dab with
+	full opacity produces, the opacity is applied here exactly like the
+	pixfmt_brush applies it. So stamps only differ from directly rasterized
+	dabs by the quantization of the dab parameters. Returns false if the
+	dab cannot be drawn from a stamp.
+*/
+bool
+Brush::_DrawStamp(BPoint where, double radius, double hardness,
+	uint8 opacity, const Transformable& shape, uint8* bits, uint32 bpr,
+	const Transformable& transform, const BRect& constrainRect,
+	BrushStampCache& stampCache) const
+{
+	if (transform.IsPerspective())
+		return false;
+
+	// The linear part of the dab transformation in device space
+	Transformable linear(shape);
+	linear *= transform;
+	double matrix[4] = { linear.sx, linear.shy, linear.shx, linear.sy };
+	double magnitude = max_c(max_c(fabs(matrix[0]), fabs(matrix[1])),
+		max_c(fabs(matrix[2]), fabs(matrix[3])));
+	if (radius <= 0.0 || magnitude == 0.0) {
+		// The dab has no area
+		return true;
+	}
 
-	agg::scanline_u8 scanlineU;
+	BrushStampKey key;
+	int exponent;
+	frexp(radius, &exponent);
+	key.radius = quantize(radius, exponent, STAMP_RADIUS_STEPS);
+	key.radiusExponent = exponent;
+	frexp(magnitude, &exponent);
+	for (int32 i = 0; i < 4; i++)
+		key.matrix[i] = quantize(matrix[i], exponent, STAMP_MATRIX_STEPS);
+	key.matrixExponent = exponent;
+	key.hardness = min_c((int32)floor(hardness * STAMP_HARDNESS_STEPS + 0.5),
+		(int32)STAMP_HARDNESS_STEPS);
+
+	// The stamp is rendered from the quantized parameters, so that it is
+	// the same no matter which dab caused it to be rendered.
+	double stampRadius = dequantize(key.radius, key.radiusExponent,
+		STAMP_RADIUS_STEPS);
+	Transformable stampTransform;
+	stampTransform.sx = dequantize(key.matrix[0], key.matrixExponent,
+		STAMP_MATRIX_STEPS);
+	stampTransform.shy = dequantize(key.matrix[1], key.matrixExponent,
+		STAMP_MATRIX_STEPS);
+	stampTransform.shx = dequantize(key.matrix[2], key.matrixExponent,
+		STAMP_MATRIX_STEPS);
+	stampTransform.sy = dequantize(key.matrix[3], key.matrixExponent,
+		STAMP_MATRIX_STEPS);
+
+	double extentX = stampRadius * sqrt(stampTransform.sx * stampTransform.sx
+		+ stampTransform.shx * stampTransform.shx);
+	double extentY = stampRadius * sqrt(stampTransform.shy * stampTransform.shy
+		+ stampTransform.sy * stampTransform.sy);
+	if (extentX > STAMP_MAX_RADIUS || extentY > STAMP_MAX_RADIUS)
+		return false;
+
+	// Center of the dab in the constrain window
+	double centerX = where.x;
+	double centerY = where.y;
+	transform.Transform(&centerX, &centerY);
+	centerX -= constrainRect.left;
+	centerY -= constrainRect.top;
+	int32 pixelX = (int32)floor(centerX);
+	int32 pixelY = (int32)floor(centerY);
+	key.subpixelX = (int32)floor((centerX - pixelX) * STAMP_SUBPIXEL_STEPS
+		+ 0.5);
+	key.subpixelY = (int32)floor((centerY - pixelY) * STAMP_SUBPIXEL_STEPS
+		+ 0.5);
+	if (key.subpixelX == STAMP_SUBPIXEL_STEPS) {
+		key.subpixelX = 0;
+		pixelX++;
+	}
+	if (key.subpixelY == STAMP_SUBPIXEL_STEPS) {
+		key.subpixelY = 0;
+		pixelY++;
+	}
 
-	BrushPixelFormat pixelFormat(buffer);
-	pixelFormat.cover_scale(opacity);
-	pixelFormat.solid((fFlags & FLAG_SOLID) != 0);
+	const BrushStamp* stamp = stampCache.Get(key);
+	if (stamp == NULL) {
+		int32 left = -(int32)ceil(extentX) - 1;
+		int32 top = -(int32)ceil(extentY) - 1;
+		BrushStamp* newStamp = stampCache.Create(key, left, top, -2 * left,
+			-2 * top);
+		if (newStamp == NULL)
+			return false;
+
+		stampTransform *= agg::trans_affine_translation(
+			-left + (double)key.subpixelX / STAMP_SUBPIXEL_STEPS,
+			-top + (double)key.subpixelY / STAMP_SUBPIXEL_STEPS);
+
+		RenderingBuffer buffer;
+		buffer.attach(newStamp->bits, newStamp->width, newStamp->height,
+			newStamp->width);
+		rasterize_dab(buffer, stampTransform, stampRadius,
+			(double)key.hardness / STAMP_HARDNESS_STEPS, 255, 255, false);
+
+		stamp = newStamp;
+	}
 
-	BrushBaseRenderer rendererBase(pixelFormat);
+	// Clip the stamp to the constrain window
+	int32 stampLeft = pixelX + stamp->left;
+	int32 stampTop = pixelY + stamp->top;
+	int32 left = max_c(0, stampLeft);
+	int32 top = max_c(0, stampTop);
+	int32 right = min_c(constrainRect.IntegerWidth() + 1,
+		stampLeft + stamp->width);
+	int32 bottom = min_c(constrainRect.IntegerHeight() + 1,
+		stampTop + stamp->height);
+	if (left >= right || top >= bottom)
+		return true;
 
-	// special case for hardness = 1.0
-	if (hardness == 1.0) {
-		BrushRenderer renderer(rendererBase);
-		renderer.color(Color(opacity));
-		agg::render_scanlines(rasterizer, scanlineU, renderer);
-	} else {
-		// Brush gradient transformation
-		Transformable gradientTransform = ellipseTransform;
-		gradientTransform.invert();
-	
-		// Defining the brush gradient
-		GradientFunction gradientFunction;
-		Interpolator interpolator(gradientTransform);
-		GradientAllocator spanAllocator;
-		ColorArray array(reinterpret_cast<agg::gray8*>(sGaussTable));
-		GradientGenerator gradientGenerator(interpolator, gradientFunction,
-			array, hardness * radius, radius * 2 - hardness * radius + 1.0);
-		GradientRenderer gradientRenderer(rendererBase, spanAllocator,
-			gradientGenerator);
-	
-		agg::render_scanlines(rasterizer, scanlineU, gradientRenderer);
+	bits += (int32)constrainRect.left + (int32)constrainRect.top * bpr;
+
+	// For hard dabs, the rasterizer is given the opacity as the color in
+	// addition to the cover scale.
+	bool hard = key.hardness == STAMP_HARDNESS_STEPS;
+	bool solid = (fFlags & FLAG_SOLID) != 0;
+	int32 opacityHalf = opacity / 2;
+
+	for (int32 y = top; y < bottom; y++) {
+		const uint8* src = stamp->bits + (y - stampTop) * stamp->width
+			+ left - stampLeft;
+		uint8* dst = bits + y * bpr + left;
+		for (int32 x = left; x < right; x++, src++, dst++) {
+			int32 alpha = *src;
+			if (alpha == 0)
+				continue;
+			if (hard)
+				alpha = Color::int_mult_cover(opacity, alpha);
+			alpha = Color::int_mult_cover(alpha, opacity);
+
+			if (solid) {
+				if (alpha > opacityHalf)
+					*dst = max_c(*dst, opacity);
+			} else if (*dst < opacity)
+				*dst += (alpha * (opacity - *dst)) / opacity;
+		}
 	}
 
-//bigtime_t finishTime = system_time();
-//printf("  init time: %lld, render time: %lld, total: %lld  (radius: %f, hardness: %f)\n",
-//	   renderTime - startTime, finishTime - renderTime, finishTime - startTime, radius, hardness);
+	return true;
 }
-
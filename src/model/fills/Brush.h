@@ -8,6 +8,8 @@
 #include "BaseObject.h"
 #include "Transformable.h"
 
+class BrushStampCache;
+
 class Brush : public BaseObject {
 public:
 	// NOTE: Some of these flags are mutually exclusive,
@@ -44,6 +46,9 @@ public:
 	virtual	const char*			DefaultName() const;
 
 	// Brush
+			bool				operator==(const Brush& other) const;
+			bool				operator!=(const Brush& other) const;
+
 			void				SetMinOpacity(float opacity);
 			void				SetMaxOpacity(float opacity);
 			void				SetOpacity(float minOpacity, float maxOpacity);
@@ -79,7 +84,17 @@ public:
 									float tiltX, float tiltY,
 									uint8* dest, uint32 bytesPerRow,
 									const Transformable& transform,
-									const BRect& constrainRect) const;
+									const BRect& constrainRect,
+									BrushStampCache* stampCache = NULL) const;
+
+private:
+			bool				_DrawStamp(BPoint where, double radius,
+									double hardness, uint8 opacity,
+									const Transformable& shape,
+									uint8* dest, uint32 bytesPerRow,
+									const Transformable& transform,
+									const BRect& constrainRect,
+									BrushStampCache& stampCache) const;
 
 private:
 			float				fMinOpacity;
@@ -4,10 +4,13 @@
 
 #include "BoundedObject.h"
 
+#include "Layer.h"
+
 // constructor
 BoundedObject::BoundedObject()
 	: Object()
 	, fOpacity(255)
+	, fBounds(0, 0, -1, -1)
 	, fTransformedBounds(0, 0, -1, -1)
 {
 }
@@ -16,6 +19,7 @@ BoundedObject::BoundedObject()
 BoundedObject::BoundedObject(const BoundedObject& other)
 	: Object(other)
 	, fOpacity(other.fOpacity)
+	, fBounds(other.fBounds)
 	, fTransformedBounds(other.fTransformedBounds)
 {
 }
@@ -69,36 +73,46 @@ BoundedObject::TransformationChanged()
 void
 BoundedObject::InitBounds()
 {
+	fBounds = Bounds();
 	Transformable globalTransform = Transformation();
-	fTransformedBounds = globalTransform.TransformBounds(Bounds());
+	fTransformedBounds = globalTransform.TransformBounds(fBounds);
 }
 
 // UpdateBounds
 void
 BoundedObject::UpdateBounds()
 {
-	Transformable globalTransform = Transformation();
-	BRect newTransformedBounds = globalTransform.TransformBounds(Bounds());
-	newTransformedBounds.left = floorf(newTransformedBounds.left) - 1.0f;
-	newTransformedBounds.top = floorf(newTransformedBounds.top) - 1.0f;
-	newTransformedBounds.right = ceilf(newTransformedBounds.right) + 1.0f;
-	newTransformedBounds.bottom = ceilf(newTransformedBounds.bottom) + 1.0f;
+	fBounds = Bounds();
+	BRect oldTransformedBounds = fTransformedBounds;
+	fTransformedBounds = _TransformedBounds();
 
-	bool oldValid = fTransformedBounds.IsValid();
-	bool newValid = newTransformedBounds.IsValid();
+	if (Parent() != NULL)
+		Parent()->ObjectBoundsUpdated(this);
+
+	bool oldValid = oldTransformedBounds.IsValid();
+	bool newValid = fTransformedBounds.IsValid();
 
 	if (oldValid && newValid)
-		InvalidateParent(newTransformedBounds | fTransformedBounds);
+		InvalidateParent(fTransformedBounds | oldTransformedBounds);
 	else if (oldValid)
-		InvalidateParent(fTransformedBounds);
+		InvalidateParent(oldTransformedBounds);
 	else if (newValid)
-		InvalidateParent(newTransformedBounds);
-
-	fTransformedBounds = newTransformedBounds;
+		InvalidateParent(fTransformedBounds);
 
 	// TODO: Notification would be nice?
 }
 
+// ParentTransformationChanged
+//
+// Called by the parent layer when its global transformation changed. The
+// layer invalidates itself completely in that case, so the transformed
+// bounds only need to be recalculated.
+void
+BoundedObject::ParentTransformationChanged()
+{
+	fTransformedBounds = _TransformedBounds();
+}
+
 // SetOpacity
 void
 BoundedObject::SetOpacity(uint8 opacity)
@@ -120,3 +134,17 @@ BoundedObject::NotifyAndUpdate()
 	Notify();
 }
 
+// #pragma mark -
+
+// _TransformedBounds
+BRect
+BoundedObject::_TransformedBounds() const
+{
+	Transformable globalTransform = Transformation();
+	BRect bounds = globalTransform.TransformBounds(fBounds);
+	bounds.left = floorf(bounds.left) - 1.0f;
+	bounds.top = floorf(bounds.top) - 1.0f;
+	bounds.right = ceilf(bounds.right) + 1.0f;
+	bounds.bottom = ceilf(bounds.bottom) + 1.0f;
+	return bounds;
+}
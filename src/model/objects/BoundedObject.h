@@ -22,11 +22,14 @@ public:
 
 	// BoundedObject
 	virtual	BRect				Bounds() = 0;
+	inline	BRect				LocalBounds() const
+									{ return fBounds; }
 	inline	BRect				TransformedBounds() const
 									{ return fTransformedBounds; }
 
 			void				InitBounds();
 			void				UpdateBounds();
+			void				ParentTransformationChanged();
 
 			void				SetOpacity(uint8 opacity);
 	inline	uint8				Opacity() const
@@ -34,8 +37,12 @@ public:
 
 			void				NotifyAndUpdate();
 
+private:
+			BRect				_TransformedBounds() const;
+
 private:
 			uint8				fOpacity;
+			BRect				fBounds;
 			BRect				fTransformedBounds;
 };
 
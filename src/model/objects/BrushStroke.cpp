@@ -72,6 +72,7 @@ BrushStroke::BrushStroke()
 	: BoundedObject()
 	, fBrush(new(std::nothrow) ::Brush(), true)
 	, fPaint(new(std::nothrow) ::Paint((rgb_color){ 0, 0, 0, 255 }), true)
+	, fStroke(new(std::nothrow) SharedStroke(), true)
 {
 	if (fPaint.Get() != NULL)
 		fPaint->AddListener(this);
@@ -150,18 +151,21 @@ BrushStroke::SetToPropertyObject(const PropertyObject* object, uint32 flags)
 bool
 BrushStroke::HitTest(const BPoint& canvasPoint)
 {
-	int32 count = fStroke.CountObjects();
-	if (count == 0 || !TransformedBounds().Contains(canvasPoint))
+	const ::Stroke& stroke = Stroke();
+	int32 count = stroke.CountObjects();
+	if (count == 0 || fBrush.Get() == NULL
+		|| !TransformedBounds().Contains(canvasPoint)) {
 		return false;
+	}
 
 	BPoint objectPoint(canvasPoint);
 	Transformation().InverseTransform(&objectPoint);
 
-	const StrokePoint* previous = fStroke.ObjectAt(0);
+	const StrokePoint* previous = stroke.ObjectAt(0);
 	const float radius = max_c(fBrush->MinRadius(), fBrush->MaxRadius());
 	if (count > 1) {
 		for (int32 i = 1; i < count; i++) {
-			const StrokePoint* current = fStroke.ObjectAt(i);
+			const StrokePoint* current = stroke.ObjectAt(i);
 
 			float dist = point_stroke_distance(previous->point, current->point,
 				objectPoint, radius);
@@ -190,9 +194,10 @@ BrushStroke::Bounds()
 	if (fBrush.Get() == NULL)
 		return bounds;
 
-	uint32 count = fStroke.CountObjects();
+	const ::Stroke& stroke = Stroke();
+	uint32 count = stroke.CountObjects();
 	for (uint32 i = 0; i < count; i++) {
-		StrokePoint* point = fStroke.ObjectAtFast(i);
+		const StrokePoint* point = stroke.ObjectAtFast(i);
 
 		float radius = fBrush->Radius(point->pressure);
 		BRect brushBounds(
@@ -248,19 +253,41 @@ BrushStroke::SetPaint(::Paint* paint)
 	}
 }
 
+// Stroke
+/*!	Returns the points of the stroke. A stroke whose points could not be
+	allocated has none.
+*/
+const ::Stroke&
+BrushStroke::Stroke() const
+{
+	static const ::Stroke sNoPoints;
+
+	if (fStroke.Get() == NULL)
+		return sNoPoints;
+	return fStroke->points;
+}
+
 // AppendPoint
 bool
 BrushStroke::AppendPoint(const StrokePoint& point)
 {
+	if (!_MakeStrokeWritable()) {
+		fprintf(stderr, "BrushStroke::AppendPoint(): Failed to copy "
+			"the shared stroke. Out of memory\n");
+		return false;
+	}
+
+	::Stroke& stroke = fStroke->points;
+
 	BRect invalid(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
-	if (StrokePoint* lastPoint = fStroke.LastObject()) {
+	if (StrokePoint* lastPoint = stroke.LastObject()) {
 		invalid.Set(lastPoint->point.x, lastPoint->point.y,
 			lastPoint->point.x, lastPoint->point.y);
 		float radius = fBrush->Radius(lastPoint->pressure);
 		invalid.InsetBy(-radius, -radius);
 	}
 
-	if (!fStroke.AppendObject(point)) {
+	if (!stroke.AppendObject(point)) {
 		fprintf(stderr, "BrushStroke::AppendPoint(): Failed to add "
 			"tracking point to BrushStroke. Out of memory\n");
 		return false;
@@ -284,3 +311,35 @@ BrushStroke::AppendPoint(const StrokePoint& point)
 
 	return true;
 }
+
+// #pragma mark -
+
+// _MakeStrokeWritable
+/*!	Makes sure the points are not shared with any clone, which would see the
+	changes otherwise.
+*/
+bool
+BrushStroke::_MakeStrokeWritable()
+{
+	if (fStroke.Get() == NULL) {
+		// The allocation in the constructor failed.
+		fStroke.SetTo(new(std::nothrow) SharedStroke(), true);
+		return fStroke.Get() != NULL;
+	}
+
+	if (fStroke->CountReferences() == 1)
+		return true;
+
+	SharedStroke* copy = new(std::nothrow) SharedStroke();
+	if (copy == NULL)
+		return false;
+
+	copy->points = fStroke->points;
+	if (copy->points.CountObjects() != fStroke->points.CountObjects()) {
+		delete copy;
+		return false;
+	}
+
+	fStroke.SetTo(copy, true);
+	return true;
+}
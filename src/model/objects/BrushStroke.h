@@ -30,6 +30,13 @@ public:
 
 typedef ObjectCache<StrokePoint, false> Stroke;
 
+// The points of a BrushStroke, which are shared with its clones until
+// either one is changed.
+class SharedStroke : public Referenceable {
+public:
+			::Stroke			points;
+};
+
 class BrushStroke : public BoundedObject, public Listener {
 public:
 								BrushStroke();
@@ -66,17 +73,17 @@ public:
 	inline	::Paint*			Paint() const
 									{ return fPaint.Get(); }
 
-	inline	const ::Stroke&		Stroke() const
-									{ return fStroke; }
-	inline	::Stroke&			Stroke()
-									{ return fStroke; }
+			const ::Stroke&		Stroke() const;
 
 			bool				AppendPoint(const StrokePoint& point);
 
+private:
+			bool				_MakeStrokeWritable();
+
 private:
 			Reference< ::Brush>	fBrush;
 			Reference< ::Paint>	fPaint;
-			::Stroke			fStroke;
+			Reference<SharedStroke> fStroke;
 };
 
 #endif // BRUSH_STROKE_H
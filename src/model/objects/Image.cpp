@@ -33,6 +33,7 @@ ImageListener::Deleted(Image* rect)
 Image::Image()
 	: BoundedObject()
 	, fBuffer()
+	, fLazyBuffer()
 	, fInterpolation(INTERPOLATION_RESAMPLE)
 	, fListeners(4)
 {
@@ -42,6 +43,7 @@ Image::Image()
 Image::Image(RenderBuffer* buffer)
 	: BoundedObject()
 	, fBuffer(buffer)
+	, fLazyBuffer()
 	, fInterpolation(INTERPOLATION_RESAMPLE)
 	, fListeners(4)
 {
@@ -51,6 +53,7 @@ Image::Image(RenderBuffer* buffer)
 Image::Image(const Image& other)
 	: BoundedObject(other)
 	, fBuffer(other.fBuffer)
+	, fLazyBuffer(other.fLazyBuffer)
 	, fInterpolation(INTERPOLATION_RESAMPLE)
 	, fListeners(4)
 {
@@ -127,10 +130,11 @@ Image::Snapshot() const
 bool
 Image::HitTest(const BPoint& canvasPoint)
 {
-	if (fBuffer.Get() == NULL)
+	BRect bounds = Bounds();
+	if (!bounds.IsValid() || !TransformedBounds().Contains(canvasPoint))
 		return false;
 	RenderEngine engine(Transformation());
-	return engine.HitTest(fBuffer->Bounds(), canvasPoint);
+	return engine.HitTest(bounds, canvasPoint);
 }
 
 // #pragma mark -
@@ -141,6 +145,8 @@ Image::Bounds()
 {
 	if (fBuffer != NULL)
 		return fBuffer->Bounds();
+	if (fLazyBuffer != NULL)
+		return fLazyBuffer->Bounds();
 	return BRect();
 }
 
@@ -152,6 +158,33 @@ Image::SetBuffer(const RenderBufferRef& buffer)
 		return;
 
 	fBuffer = buffer;
+	fLazyBuffer.Unset();
+
+	NotifyAndUpdate();
+}
+
+// Buffer
+/*!	Returns the pixels of the image. If they are provided by a LazyBuffer,
+	they are read now, unless that already happened.
+*/
+RenderBuffer*
+Image::Buffer() const
+{
+	if (fBuffer.Get() != NULL || fLazyBuffer.Get() == NULL)
+		return fBuffer.Get();
+	// The LazyBuffer keeps the loaded pixels.
+	return fLazyBuffer->Buffer().Get();
+}
+
+// SetLazyBuffer
+void
+Image::SetLazyBuffer(const LazyBufferRef& buffer)
+{
+	if (fLazyBuffer == buffer)
+		return;
+
+	fBuffer.Unset();
+	fLazyBuffer = buffer;
 
 	NotifyAndUpdate();
 }
@@ -15,6 +15,17 @@ class RenderBuffer;
 
 typedef Reference<RenderBuffer> RenderBufferRef;
 
+// A LazyBuffer provides the pixels of an Image, which are only read when
+// they are first needed, for example from the document file. Buffer() may
+// be called from multiple threads at once.
+class LazyBuffer : public Referenceable {
+public:
+	virtual	BRect				Bounds() const = 0;
+	virtual	RenderBufferRef		Buffer() = 0;
+};
+
+typedef Reference<LazyBuffer> LazyBufferRef;
+
 class ImageListener {
 public:
 								ImageListener();
@@ -48,8 +59,11 @@ public:
 
 	// Image
 			void				SetBuffer(const RenderBufferRef& buffer);
-	inline	RenderBuffer*		Buffer() const
-									{ return fBuffer.Get(); }
+			RenderBuffer*		Buffer() const;
+
+			void				SetLazyBuffer(const LazyBufferRef& buffer);
+	inline	LazyBuffer*			GetLazyBuffer() const
+									{ return fLazyBuffer.Get(); }
 
 			void				SetInterpolation(uint32 interpolation);
 	inline	uint32				Interpolation() const
@@ -63,6 +77,7 @@ private:
 
 private:
 			RenderBufferRef		fBuffer;
+			LazyBufferRef		fLazyBuffer;
 			uint32				fInterpolation;
 
 			BList				fListeners;
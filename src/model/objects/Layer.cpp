@@ -15,6 +15,24 @@
 
 using std::nothrow;
 
+enum {
+	// When the area invalidated during a transaction consists of more rects
+	// than this, it is delivered as its bounding box. Each rect is extended
+	// by the objects above the changed one.
+	MAX_PENDING_RECTS = 16
+};
+
+// object_bounds
+static BRect
+object_bounds(Object* object)
+{
+	BoundedObject* boundedObject = dynamic_cast<BoundedObject*>(object);
+	if (boundedObject != NULL)
+		return boundedObject->TransformedBounds();
+	// Unbounded objects, like filters or sub-layers, are found everywhere.
+	return BRect();
+}
+
 // constructor
 Layer::Listener::Listener()
 	:
@@ -95,6 +113,18 @@ Layer::Layer(const BRect& bounds)
 	, fBlendingMode(CompOpSrcOver)
 	, fObjects(64)
 	, fListeners(8)
+	, fSpatialIndex()
+	, fChanges(NULL)
+	, fChangeCapacity(0)
+	, fFirstChange(0)
+	, fChangeCount(0)
+	, fJournalStart(ChangeCounter())
+	, fTransactionDepth(0)
+	, fPendingLayers()
+	, fHasPendingChanges(false)
+	, fPendingRegion()
+	, fPendingIndex(-1)
+	, fPendingObjects()
 {
 }
 
@@ -105,6 +135,13 @@ Layer::~Layer()
 		Object* object = (Object*)fObjects.ItemAtFast(i);
 		object->RemoveReference();
 	}
+
+	for (int32 i = fPendingObjects.CountItems() - 1; i >= 0; i--)
+		fPendingObjects.ItemAtFast(i)->RemoveReference();
+	for (int32 i = fPendingLayers.CountItems() - 1; i >= 0; i--)
+		fPendingLayers.ItemAtFast(i)->RemoveReference();
+
+	delete[] fChanges;
 }
 
 // #pragma mark -
@@ -221,9 +258,17 @@ Layer::TransformationChanged()
 
 	int32 count = CountObjects();
 	for (int32 i = 0; i < count; i++) {
-		Layer* layer = dynamic_cast<Layer*>(ObjectAtFast(i));
-		if (layer != NULL)
+		Object* object = ObjectAtFast(i);
+		Layer* layer = dynamic_cast<Layer*>(object);
+		if (layer != NULL) {
 			layer->TransformationChanged();
+			continue;
+		}
+		BoundedObject* boundedObject = dynamic_cast<BoundedObject*>(object);
+		if (boundedObject != NULL) {
+			boundedObject->ParentTransformationChanged();
+			fSpatialIndex.Update(i, boundedObject->TransformedBounds());
+		}
 	}
 }
 
@@ -257,8 +302,12 @@ Layer::Clone(CloneContext& context) const
 bool
 Layer::HitTest(const BPoint& canvasPoint)
 {
-	for (int32 i = CountObjects() - 1; i >= 0; i--) {
-		Object* object = ObjectAtFast(i);
+	IndexList indices;
+	if (fSpatialIndex.Query(canvasPoint, indices) != B_OK)
+		return false;
+
+	for (int32 i = indices.CountItems() - 1; i >= 0; i--) {
+		Object* object = ObjectAtFast(indices.ItemAtFast(i));
 		if (object->HitTest(canvasPoint))
 			return true;
 	}
@@ -280,6 +329,12 @@ Layer::AddObject(Object* object, int32 index)
 {
 //printf("%p->Layer::AddObject(%p, %ld)\n", this, object, index);
 	if (object && fObjects.AddItem(object, index)) {
+		if (fSpatialIndex.Insert(index, object_bounds(object)) != B_OK) {
+			fObjects.RemoveItem(index);
+			return false;
+		}
+		_UpdateIndices(index);
+
 		object->AddReference();
 
 		BList listeners(fListeners);
@@ -290,6 +345,7 @@ Layer::AddObject(Object* object, int32 index)
 		}
 
 		UpdateChangeCounter();
+		_JournalChange(OBJECT_ADDED, object, index);
 		object->SetParent(this);
 
 		BoundedObject* boundedObject = dynamic_cast<BoundedObject*>(object);
@@ -325,6 +381,11 @@ Layer::RemoveObject(int32 index)
 			object->SetParent(this);
 			return NULL;
 		}
+		fSpatialIndex.Remove(index);
+		object->fIndex = -1;
+		_UpdateIndices(index);
+
+		_JournalChange(OBJECT_REMOVED, object, index);
 
 		BList listeners(fListeners);
 		int32 count = listeners.CountItems();
@@ -364,6 +425,15 @@ Layer::ObjectAtFast(int32 index) const
 int32
 Layer::IndexOf(Object* object) const
 {
+	// The object knows its index, unless it was just added and its parent
+	// is not yet set.
+	if (object != NULL) {
+		int32 index = object->fIndex;
+		if (index >= 0 && index < fObjects.CountItems()
+			&& fObjects.ItemAtFast(index) == object) {
+			return index;
+		}
+	}
 	return fObjects.IndexOf(object);
 }
 
@@ -378,7 +448,7 @@ Layer::CountObjects() const
 bool
 Layer::HasObject(Object* object) const
 {
-	return fObjects.HasItem(object);
+	return IndexOf(object) >= 0;
 }
 
 // CloneObjects
@@ -414,32 +484,19 @@ Layer::SuspendUpdates(bool suspend)
 void
 Layer::Invalidate(const BRect& area, int32 objectIndex)
 {
-	// calculate the *visually changed area* from the lowest
-	// changed object to the top object, giving each object
-	// a chance to extend the area
-	BRect visuallyChangedArea = area;
-	int32 count = CountObjects();
-	for (int32 i = objectIndex; i < count; i++) {
-		Object* object = ObjectAtFast(i);
-		object->ExtendDirtyArea(visuallyChangedArea);
-	}
-
-	// notify listeners
-	BList listeners(fListeners);
-	count = listeners.CountItems();
-	for (int32 i = 0; i < count; i++) {
-		Listener* listener = (Listener*)listeners.ItemAtFast(i);
-		listener->SuspendUpdates(true);
-		listener->AreaInvalidated(this, visuallyChangedArea);
+	Layer* root = _TransactionRoot();
+	if (root != NULL && _AddPendingChanges(root)) {
+		// Areas far apart stay separate, like in the dirty regions of the
+		// RenderManager.
+		fPendingRegion.Include(area);
+		if (fPendingIndex < 0)
+			fPendingIndex = objectIndex;
+		else
+			fPendingIndex = min_c(fPendingIndex, objectIndex);
+		return;
 	}
 
-	if (Parent())
-		Parent()->Invalidate(visuallyChangedArea, Parent()->IndexOf(this));
-
-	for (int32 i = 0; i < count; i++) {
-		Listener* listener = (Listener*)listeners.ItemAtFast(i);
-		listener->SuspendUpdates(false);
-	}
+	_NotifyAreaInvalidated(area, objectIndex);
 }
 
 // ObjectChanged
@@ -449,6 +506,19 @@ Layer::ObjectChanged(Object* object)
 	int32 index = IndexOf(object);
 	if (index < 0)
 		return;
+
+	Layer* root = _TransactionRoot();
+	if (root != NULL && _AddPendingChanges(root)) {
+		// Consecutive changes of the same object are reported once.
+		int32 count = fPendingObjects.CountItems();
+		if (count > 0 && fPendingObjects.ItemAtFast(count - 1) == object)
+			return;
+		if (fPendingObjects.Add(object)) {
+			object->AddReference();
+			return;
+		}
+	}
+
 	// notify listeners
 	BList listeners(fListeners);
 	int32 count = listeners.CountItems();
@@ -458,13 +528,100 @@ Layer::ObjectChanged(Object* object)
 	}
 }
 
+// Root
+Layer*
+Layer::Root()
+{
+	Layer* root = this;
+	while (root->Parent() != NULL)
+		root = root->Parent();
+	return root;
+}
+
+// BeginTransaction
+void
+Layer::BeginTransaction()
+{
+	Root()->fTransactionDepth++;
+}
+
+// CommitTransaction
+void
+Layer::CommitTransaction()
+{
+	Layer* root = Root();
+	if (root->fTransactionDepth == 0) {
+		debugger("Layer::CommitTransaction() without open transaction.");
+		return;
+	}
+
+	if (--root->fTransactionDepth == 0)
+		root->_CommitTransaction();
+}
+
+// HasChangesSince
+//
+// Returns whether the journal contains all changes since the layer had the
+// given change counter. Only in that case, applying the journaled changes
+// with a newer change counter brings a copy of the object list up to date.
+bool
+Layer::HasChangesSince(uint32 changeCounter) const
+{
+	return changeCounter >= fJournalStart;
+}
+
+// ChangeAt
+const Layer::Change&
+Layer::ChangeAt(int32 index) const
+{
+	return fChanges[(fFirstChange + index) % fChangeCapacity];
+}
+
+// ObjectChangeCounterUpdated
+//
+// Called by the object whenever its change counter is updated, after the
+// change counter of the layer has been updated.
+void
+Layer::ObjectChangeCounterUpdated(Object* object)
+{
+	if (fChangeCount > 0) {
+		// Consecutive changes to the same object, like while it is being
+		// dragged, don't need more than one entry.
+		Change& last = fChanges[(fFirstChange + fChangeCount - 1)
+			% fChangeCapacity];
+		if (last.type == OBJECT_CHANGED && last.object == object) {
+			last.changeCounter = ChangeCounter();
+			return;
+		}
+	}
+
+	int32 index = IndexOf(object);
+	if (index >= 0)
+		_JournalChange(OBJECT_CHANGED, object, index);
+}
+
+// ObjectBoundsUpdated
+//
+// Called by bounded objects whenever their transformed bounds changed.
+void
+Layer::ObjectBoundsUpdated(Object* object)
+{
+	int32 index = IndexOf(object);
+	if (index >= 0)
+		fSpatialIndex.Update(index, object_bounds(object));
+}
+
 // HitTest
 bool
 Layer::HitTest(const BPoint& canvasPoint, Layer** _layer, Object** _object,
 	bool recursive) const
 {
-	for (int32 i = CountObjects() - 1; i >= 0; i--) {
-		Object* object = ObjectAtFast(i);
+	IndexList indices;
+	if (fSpatialIndex.Query(canvasPoint, indices) != B_OK)
+		return false;
+
+	for (int32 i = indices.CountItems() - 1; i >= 0; i--) {
+		Object* object = ObjectAtFast(indices.ItemAtFast(i));
 		Layer* subLayer = dynamic_cast<Layer*>(object);
 		if (subLayer != NULL) {
 			if (recursive
@@ -600,3 +757,204 @@ Layer::SetBlendingMode(::BlendingMode blendingMode)
 	Notify();
 }
 
+// #pragma mark -
+
+// _UpdateIndices
+void
+Layer::_UpdateIndices(int32 firstIndex)
+{
+	int32 count = CountObjects();
+	for (int32 i = firstIndex; i < count; i++)
+		ObjectAtFast(i)->fIndex = i;
+}
+
+// _ExtendDirtyArea
+void
+Layer::_ExtendDirtyArea(BRect& area, int32 objectIndex) const
+{
+	// calculate the *visually changed area* from the lowest
+	// changed object to the top object, giving each object
+	// a chance to extend the area
+	int32 count = CountObjects();
+	for (int32 i = objectIndex; i < count; i++) {
+		Object* object = ObjectAtFast(i);
+		object->ExtendDirtyArea(area);
+	}
+}
+
+// _NotifyAreaInvalidated
+void
+Layer::_NotifyAreaInvalidated(const BRect& area, int32 objectIndex)
+{
+	BRect visuallyChangedArea = area;
+	_ExtendDirtyArea(visuallyChangedArea, objectIndex);
+
+	// notify listeners
+	BList listeners(fListeners);
+	int32 count = listeners.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		Listener* listener = (Listener*)listeners.ItemAtFast(i);
+		listener->SuspendUpdates(true);
+		listener->AreaInvalidated(this, visuallyChangedArea);
+	}
+
+	if (Parent())
+		Parent()->Invalidate(visuallyChangedArea, Parent()->IndexOf(this));
+
+	for (int32 i = 0; i < count; i++) {
+		Listener* listener = (Listener*)listeners.ItemAtFast(i);
+		listener->SuspendUpdates(false);
+	}
+}
+
+// _TransactionRoot
+Layer*
+Layer::_TransactionRoot()
+{
+	Layer* root = Root();
+	return root->fTransactionDepth > 0 ? root : NULL;
+}
+
+// _AddPendingChanges
+//
+// Makes sure the pending changes of this layer are delivered when the
+// transaction of the given root layer is committed.
+bool
+Layer::_AddPendingChanges(Layer* root)
+{
+	if (fHasPendingChanges)
+		return true;
+	if (!root->fPendingLayers.Add(this))
+		return false;
+	AddReference();
+	fHasPendingChanges = true;
+	return true;
+}
+
+// _DeliverPendingChanges
+void
+Layer::_DeliverPendingChanges()
+{
+	fHasPendingChanges = false;
+
+	// The listeners may cause more changes, which are collected again.
+	for (int32 i = 0; i < fPendingObjects.CountItems(); i++) {
+		Object* object = fPendingObjects.ItemAtFast(i);
+		int32 index = IndexOf(object);
+		if (index >= 0) {
+			BList listeners(fListeners);
+			int32 count = listeners.CountItems();
+			for (int32 j = 0; j < count; j++) {
+				Listener* listener = (Listener*)listeners.ItemAtFast(j);
+				listener->ObjectChanged(this, object, index);
+			}
+		}
+		object->RemoveReference();
+	}
+	fPendingObjects.Clear();
+
+	if (fPendingIndex >= 0) {
+		BRegion region(fPendingRegion);
+		int32 objectIndex = fPendingIndex;
+		fPendingRegion.MakeEmpty();
+		fPendingIndex = -1;
+
+		if (region.CountRects() > MAX_PENDING_RECTS) {
+			_NotifyAreaInvalidated(region.Frame(), objectIndex);
+		} else {
+			int32 count = region.CountRects();
+			for (int32 i = 0; i < count; i++)
+				_NotifyAreaInvalidated(region.RectAt(i), objectIndex);
+		}
+	}
+}
+
+// _CommitTransaction
+//
+// Called on the root layer when the outermost transaction is committed.
+void
+Layer::_CommitTransaction()
+{
+	// Keep collecting while the changes are delivered, so the area which
+	// a layer invalidates in its parent is merged with the other changes
+	// of the parent. That is why the deepest layers go first.
+	if (fPendingLayers.CountItems() == 0)
+		return;
+
+	fTransactionDepth++;
+	SuspendUpdates(true);
+
+	while (fPendingLayers.CountItems() > 0) {
+		int32 deepestIndex = 0;
+		int32 deepestLevel = -1;
+		int32 count = fPendingLayers.CountItems();
+		for (int32 i = 0; i < count; i++) {
+			int32 level = fPendingLayers.ItemAtFast(i)->Level();
+			if (level > deepestLevel) {
+				deepestIndex = i;
+				deepestLevel = level;
+			}
+		}
+
+		Layer* layer = fPendingLayers.ItemAtFast(deepestIndex);
+		fPendingLayers.Remove(deepestIndex);
+		layer->_DeliverPendingChanges();
+		layer->RemoveReference();
+	}
+
+	SuspendUpdates(false);
+	fTransactionDepth--;
+}
+
+// _JournalChange
+void
+Layer::_JournalChange(ChangeType type, const Object* object, int32 index)
+{
+	if (fChangeCount == fChangeCapacity && !_GrowJournal()) {
+		if (fChangeCapacity == 0) {
+			// Out of memory, snapshots need to compare all objects.
+			fJournalStart = ChangeCounter();
+			return;
+		}
+		// Drop the oldest change, the journal no longer reaches back
+		// further than that.
+		fJournalStart = fChanges[fFirstChange].changeCounter;
+		fFirstChange = (fFirstChange + 1) % fChangeCapacity;
+		fChangeCount--;
+	}
+
+	Change& change = fChanges[(fFirstChange + fChangeCount)
+		% fChangeCapacity];
+	change.type = type;
+	change.object = object;
+	change.index = index;
+	change.changeCounter = ChangeCounter();
+	fChangeCount++;
+}
+
+// _GrowJournal
+//
+// Doubles the capacity of the journal, unless it already holds more changes
+// than there are objects.
+bool
+Layer::_GrowJournal()
+{
+	int32 limit = max_c((int32)MIN_JOURNALED_CHANGES, CountObjects());
+	if (fChangeCapacity >= limit)
+		return false;
+
+	int32 capacity = max_c((int32)MIN_JOURNALED_CHANGES,
+		min_c(fChangeCapacity * 2, limit));
+	Change* changes = new(std::nothrow) Change[capacity];
+	if (changes == NULL)
+		return false;
+
+	for (int32 i = 0; i < fChangeCount; i++)
+		changes[i] = fChanges[(fFirstChange + i) % fChangeCapacity];
+
+	delete[] fChanges;
+	fChanges = changes;
+	fChangeCapacity = capacity;
+	fFirstChange = 0;
+	return true;
+}
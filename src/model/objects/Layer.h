@@ -8,9 +8,11 @@
 
 #include <List.h>
 #include <Rect.h>
+#include <Region.h>
 
 #include "BlendingMode.h"
 #include "Object.h"
+#include "SpatialIndex.h"
 
 class Layer : public Object {
 public:
@@ -38,6 +40,30 @@ public:
 				int32			fUpdatesSuspended;
 	};
 
+	// The change journal records the most recent changes to the list of
+	// objects and to the objects themselves, so that snapshots can catch up
+	// without looking at every object. Each change is tagged with the
+	// ChangeCounter() of the layer after the change. The journal grows with
+	// the number of objects, so that even an edit of all objects can be
+	// replayed. Only more changes than that are cheaper to catch up with by
+	// comparing all objects.
+	enum ChangeType {
+		OBJECT_ADDED = 0,
+		OBJECT_REMOVED,
+		OBJECT_CHANGED
+	};
+
+	struct Change {
+		ChangeType				type;
+		const Object*			object;
+		int32					index;
+		uint32					changeCounter;
+	};
+
+	enum {
+		MIN_JOURNALED_CHANGES	= 32
+	};
+
 								Layer(const BRect& bounds);
 	virtual						~Layer();
 
@@ -81,10 +107,28 @@ public:
 									int32 objectIndex = 0);
 			void				ObjectChanged(Object* object);
 
+								// While a transaction is open anywhere in
+								// the tree, invalidated areas and changed
+								// objects are collected per layer and the
+								// listeners learn about them all at once
+								// when the outermost transaction is
+								// committed. Transactions may be nested.
+			Layer*				Root();
+			void				BeginTransaction();
+			void				CommitTransaction();
+
 			bool				HitTest(const BPoint& canvasPoint,
 									Layer** layer, Object** object,
 									bool recursive) const;
 
+			bool				HasChangesSince(uint32 changeCounter) const;
+			int32				CountChanges() const
+									{ return fChangeCount; }
+			const Change&		ChangeAt(int32 index) const;
+			void				ObjectChangeCounterUpdated(
+									Object* object);
+			void				ObjectBoundsUpdated(Object* object);
+
 			bool				AddListener(Listener* listener);
 			void				RemoveListener(Listener* listener);
 
@@ -105,6 +149,22 @@ public:
 			::BlendingMode		BlendingMode() const
 									{ return fBlendingMode; }
 
+private:
+			void				_JournalChange(ChangeType type,
+									const Object* object, int32 index);
+			bool				_GrowJournal();
+			void				_UpdateIndices(int32 firstIndex);
+
+			void				_ExtendDirtyArea(BRect& area,
+									int32 objectIndex) const;
+			void				_NotifyAreaInvalidated(const BRect& area,
+									int32 objectIndex);
+
+			Layer*				_TransactionRoot();
+			bool				_AddPendingChanges(Layer* root);
+			void				_DeliverPendingChanges();
+			void				_CommitTransaction();
+
 private:
 			BRect				fBounds;
 			uint8				fGlobalAlpha;
@@ -112,6 +172,48 @@ private:
 
 			BList				fObjects;
 			BList				fListeners;
+
+			// The transformed bounds of the objects, to find the objects
+			// which are hit by a point without asking all of them.
+			SpatialIndex		fSpatialIndex;
+
+			Change*				fChanges;
+			int32				fChangeCapacity;
+			int32				fFirstChange;
+			int32				fChangeCount;
+			uint32				fJournalStart;
+
+			// The open transactions and the layers with pending changes,
+			// only used in the root layer.
+			int32				fTransactionDepth;
+			List<Layer*, true>	fPendingLayers;
+
+			// The changes of this layer during the transaction.
+			bool				fHasPendingChanges;
+			BRegion				fPendingRegion;
+			int32				fPendingIndex;
+			List<Object*, true>	fPendingObjects;
+};
+
+// Keeps a transaction open on the tree of the given layer for as long as
+// it exists.
+class LayerTransaction {
+public:
+	LayerTransaction(Layer* layer)
+		: fRoot(layer != NULL ? layer->Root() : NULL)
+	{
+		if (fRoot != NULL)
+			fRoot->BeginTransaction();
+	}
+
+	~LayerTransaction()
+	{
+		if (fRoot != NULL)
+			fRoot->CommitTransaction();
+	}
+
+private:
+	Layer*	fRoot;
 };
 
 #endif // LAYER_H
@@ -16,6 +16,7 @@ Object::Object()
 	BaseObject(),
 	fChangeCounter(0),
 	fParent(NULL),
+	fIndex(-1),
 	fIsVisible(true)
 {
 }
@@ -27,6 +28,7 @@ Object::Object(const Object& other)
 	BaseObject(other),
 	fChangeCounter(0),
 	fParent(NULL),
+	fIndex(-1),
 	fIsVisible(other.fIsVisible)
 {
 }
@@ -141,8 +143,10 @@ Object::HitTest(const BPoint& canvasPoint)
 void
 Object::UpdateChangeCounter()
 {
-	if (fParent)
+	if (fParent) {
 		fParent->UpdateChangeCounter();
+		fParent->ObjectChangeCounterUpdated(this);
+	}
 	fChangeCounter++;
 }
 
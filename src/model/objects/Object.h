@@ -66,8 +66,12 @@ protected:
 	virtual	void				TransformationChanged();
 
 private:
+			friend class Layer;
+
 			uint32				fChangeCounter;
 			Layer*				fParent;
+			// The position in the parent, kept up to date by the Layer.
+			int32				fIndex;
 			bool				fIsVisible;
 };
 
@@ -69,6 +69,9 @@ Rect::Snapshot() const
 bool
 Rect::HitTest(const BPoint& canvasPoint)
 {
+	if (!TransformedBounds().Contains(canvasPoint))
+		return false;
+
 	RenderEngine engine(Transformation());
 	return engine.HitTest(fArea, canvasPoint);
 }
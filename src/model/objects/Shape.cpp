@@ -167,6 +167,9 @@ Shape::SetToPropertyObject(const PropertyObject* object, uint32 flags)
 bool
 Shape::HitTest(const BPoint& canvasPoint)
 {
+	if (!TransformedBounds().Contains(canvasPoint))
+		return false;
+
 	PathStorage path;
 	GetPath(path);
 	RenderEngine engine(Transformation());
@@ -275,6 +278,18 @@ Shape::GetPath(PathStorage& pathStorage) const
 	}
 }
 
+// GetFlattenedPaths
+void
+Shape::GetFlattenedPaths(double scale, FlattenedPathList& paths) const
+{
+	for (int32 i = fPaths.CountItems() - 1; i >= 0; i--) {
+		const PathRef& path = fPaths.ItemAtFast(i)->Path();
+		FlattenedPathRef flattenedPath = path->GetFlattenedPath(scale);
+		if (flattenedPath.Get() != NULL)
+			paths.Add(flattenedPath);
+	}
+}
+
 // AddShapeListener
 void
 Shape::AddShapeListener(Listener* listener)
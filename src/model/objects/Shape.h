@@ -10,6 +10,7 @@
 #include <List.h>
 #include <Rect.h>
 
+#include "FlattenedPath.h"
 #include "List.h"
 #include "RenderEngine.h"
 #include "Styleable.h"
@@ -80,6 +81,8 @@ public:
 	virtual	BRect				Bounds();
 
 			void				GetPath(PathStorage& path) const;
+			void				GetFlattenedPaths(double scale,
+									FlattenedPathList& paths) const;
 
 			void				AddShapeListener(Listener* listener);
 			void				RemoveShapeListener(Listener* listener);
@@ -32,11 +32,11 @@ Text::Text(const Text& other, CloneContext& context)
 	, fTextLayout(FontCache::getInstance())
 	, fStyleRuns(other.fStyleRuns, context)
 {
-	InitBounds();
-	
+	// The layout is already valid for the cloned text and style runs. It
+	// shares its buffers with the original until either one changes.
 	fTextLayout = other.fTextLayout;
-	
-	UpdateLayout();
+
+	InitBounds();
 }
 
 // destructor
@@ -73,6 +73,9 @@ Text::Snapshot() const
 bool
 Text::HitTest(const BPoint& canvasPoint)
 {
+	if (!TransformedBounds().Contains(canvasPoint))
+		return false;
+
 	RenderEngine engine(Transformation());
 	return engine.HitTest(Bounds(), canvasPoint);
 }
@@ -205,6 +208,7 @@ void
 Text::SetText(const char* utf8String, const Font& font, const StyleRef& style)
 {
 	fText = "";
+	fCharCount = 0;
 	fStyleRuns.MakeEmpty();
 
 	Insert(0, utf8String, font, style);
@@ -286,7 +290,7 @@ Text::Insert(int32 textOffset, const char* utf8String, const Font& font,
 
 	styleRef.Detach();
 
-	UpdateLayout();
+	_UpdateLayout(textOffset, 0, charCount);
 }
 
 // Insert
@@ -305,7 +309,7 @@ Text::Insert(int32 textOffset, const BString& utf8String,
 	fText.InsertChars(utf8String, textOffset);
 	fCharCount += charCount;
 
-	UpdateLayout();
+	_UpdateLayout(textOffset, 0, charCount);
 }
 
 // Append
@@ -352,7 +356,7 @@ Text::ReplaceStyles(int32 textOffset, int32 length,
 	fStyleRuns.Remove(textOffset, length);
 	fStyleRuns.Insert(textOffset, styleRuns);
 
-	UpdateLayout();
+	_UpdateLayout(textOffset, length, length);
 }
 
 // Remove
@@ -366,7 +370,7 @@ Text::Remove(int32 textOffset, int32 length)
 	fStyleRuns.Remove(textOffset, length);
 	fCharCount -= length;
 
-	UpdateLayout();
+	_UpdateLayout(textOffset, length, 0);
 }
 
 // GetSubString
@@ -415,7 +419,7 @@ Text::SetStyle(int32 textOffset, int32 length, const Font& font,
 
 	styleRef.Detach();
 
-	UpdateLayout();
+	_UpdateLayout(textOffset, length, length);
 }
 
 // SetFont
@@ -426,6 +430,9 @@ Text::SetFont(int32 textOffset, int32 length, const char* family,
 	if (textOffset < 0 || textOffset + length > fCharCount || length == 0)
 		return;
 
+	int32 changeOffset = textOffset;
+	int32 changeLength = length;
+
 	while (length > 0) {
 		// TODO: Make more efficient
 		const StyleRun* run = fStyleRuns.FindStyleRun(textOffset);
@@ -454,7 +461,7 @@ Text::SetFont(int32 textOffset, int32 length, const char* family,
 		length--;
 	}
 
-	UpdateLayout();
+	_UpdateLayout(changeOffset, changeLength, changeLength);
 }
 
 // SetSize
@@ -464,6 +471,9 @@ Text::SetSize(int32 textOffset, int32 length, double size)
 	if (textOffset < 0 || textOffset + length > fCharCount || length == 0)
 		return;
 
+	int32 changeOffset = textOffset;
+	int32 changeLength = length;
+
 	while (length > 0) {
 		// TODO: Make more efficient
 		const StyleRun* run = fStyleRuns.FindStyleRun(textOffset);
@@ -491,7 +501,7 @@ Text::SetSize(int32 textOffset, int32 length, double size)
 		length--;
 	}
 
-	UpdateLayout();
+	_UpdateLayout(changeOffset, changeLength, changeLength);
 }
 
 // SetColor
@@ -509,6 +519,9 @@ Text::SetColor(int32 textOffset, int32 length, const rgb_color& color)
 
 	StyleRef styleRef(style, true);
 
+	int32 changeOffset = textOffset;
+	int32 changeLength = length;
+
 	while (length > 0) {
 		// TODO: Make more efficient
 		const StyleRun* run = fStyleRuns.FindStyleRun(textOffset);
@@ -534,7 +547,7 @@ Text::SetColor(int32 textOffset, int32 length, const rgb_color& color)
 		length--;
 	}
 
-	UpdateLayout();
+	_UpdateLayout(changeOffset, changeLength, changeLength);
 }
 
 // getTextLayout
@@ -559,6 +572,36 @@ Text::UpdateLayout()
 {
 //	printf("UpdateLayout() (%p)\n", &fTextLayout);
 
+	_UpdateStyleRuns();
+
+	fTextLayout.setText(fText.String());
+	fTextLayout.validateLayout();
+
+	NotifyAndUpdate();
+}
+
+// _UpdateLayout
+/*!	Updates the layout after the chars from textOffset have changed, where
+	insertedLength chars replaced removedLength chars. The TextLayout keeps
+	the glyphs and lines which are not affected.
+*/
+void
+Text::_UpdateLayout(int32 textOffset, int32 removedLength,
+	int32 insertedLength)
+{
+	_UpdateStyleRuns();
+
+	fTextLayout.replaceText(fText.String(), textOffset, removedLength,
+		insertedLength);
+	fTextLayout.validateLayout();
+
+	NotifyAndUpdate();
+}
+
+// _UpdateStyleRuns
+void
+Text::_UpdateStyleRuns()
+{
 	fTextLayout.clearStyleRuns();
 
 	int32 start = 0;
@@ -603,11 +646,7 @@ Text::UpdateLayout()
 
 //	printf("  chars: %ld, total run length: %ld\n",
 //		fText.CountChars(), start);
-	if (fText.CountChars() != start)
+	if (fCharCount != start)
 		debugger("Text::UpdateLayout() - StyleRunList invalid!");
-
-	fTextLayout.setText(fText.String());
-
-	NotifyAndUpdate();
 }
 
@@ -120,6 +120,12 @@ public:
 
 			void				UpdateLayout();
 
+private:
+			void				_UpdateLayout(int32 textOffset,
+									int32 removedLength,
+									int32 insertedLength);
+			void				_UpdateStyleRuns();
+
 private:
 			BString				fText;
 			int32				fCharCount;
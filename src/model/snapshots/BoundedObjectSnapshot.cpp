@@ -4,6 +4,8 @@
  */
 #include "BoundedObjectSnapshot.h"
 
+#include <math.h>
+
 #include "BoundedObject.h"
 #include "RenderEngine.h"
 
@@ -11,6 +13,8 @@
 BoundedObjectSnapshot::BoundedObjectSnapshot(const BoundedObject* object)
 	: ObjectSnapshot(object)
 	, fOpacity(object->Opacity())
+	, fBounds(object->LocalBounds())
+	, fLayoutedBounds()
 	, fOriginal(object)
 {
 }
@@ -28,6 +32,7 @@ BoundedObjectSnapshot::Sync()
 {
 	if (ObjectSnapshot::Sync()) {
 		fOpacity = fOriginal->Opacity();
+		fBounds = fOriginal->LocalBounds();
 		return true;
 	}
 	return false;
@@ -39,6 +44,15 @@ BoundedObjectSnapshot::Layout(LayoutContext& context, uint32 flags)
 {
 	ObjectSnapshot::Layout(context, flags);
 	context.SetOpacity(fOpacity);
+
+	if (fBounds.IsValid()) {
+		// Include the anti-aliased edges in the pixel bounds.
+		BRect bounds = LayoutedState().Matrix.TransformBounds(fBounds);
+		fLayoutedBounds.Set(floorf(bounds.left) - 1.0f,
+			floorf(bounds.top) - 1.0f, ceilf(bounds.right) + 1.0f,
+			ceilf(bounds.bottom) + 1.0f);
+	} else
+		fLayoutedBounds = BRect();
 }
 
 // PrepareRenderEngine
@@ -47,3 +61,10 @@ BoundedObjectSnapshot::PrepareRenderEngine(RenderEngine& engine) const
 {
 	engine.SetOpacity(fOpacity);
 }
+
+// LayoutedBounds
+BRect
+BoundedObjectSnapshot::LayoutedBounds() const
+{
+	return fLayoutedBounds;
+}
@@ -19,6 +19,7 @@ public:
 	virtual	bool				Sync();
 	virtual	void				Layout(LayoutContext& context, uint32 flags);
 	virtual	void				PrepareRenderEngine(RenderEngine& engine) const;
+	virtual	BRect				LayoutedBounds() const;
 
 	// BoundedObjectSnapshot
 	inline	uint8				Opacity() const
@@ -26,6 +27,8 @@ public:
 
 private:
 			uint8				fOpacity;
+			BRect				fBounds;
+			BRect				fLayoutedBounds;
 			const BoundedObject*	fOriginal;
 };
 
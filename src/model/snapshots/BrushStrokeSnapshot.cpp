@@ -4,11 +4,135 @@
  */
 #include "BrushStrokeSnapshot.h"
 
+#include <new>
 #include <stdio.h>
+#include <string.h>
 
+#include "AutoLocker.h"
+#include "BrushStampCache.h"
 #include "RenderBuffer.h"
 #include "RenderEngine.h"
 
+enum {
+	// The number of mask rows which are rasterized at once.
+	BAND_HEIGHT				= 128,
+	// Runs of equal coverage from this length on are stored as solid spans.
+	MIN_SOLID_SPAN_LENGTH	= 3,
+};
+
+// CoverageMask
+struct BrushStrokeSnapshot::CoverageMask {
+	ScanlineContainer	scanlines;
+	CoverAllocator		coverAllocator;
+	SpanAllocator		spanAllocator;
+};
+
+// span_extent
+static void
+span_extent(const Span& span, int& minX, int& maxX)
+{
+	minX = span.x;
+	maxX = span.x + (span.len < 0 ? -span.len : span.len) - 1;
+}
+
+// scanline_extent
+static void
+scanline_extent(const Scanline& scanline, int& minX, int& maxX)
+{
+	int dummy;
+	span_extent(*scanline.begin(), minX, dummy);
+	span_extent(*(scanline.begin() + scanline.num_spans() - 1), dummy, maxX);
+}
+
+// copy_spans
+/*!	Appends the part of the spans of the source scanline between minX and
+	maxX to the target scanline.
+*/
+static void
+copy_spans(const Scanline& source, Scanline& target, int minX, int maxX)
+{
+	Scanline::const_iterator span = source.begin();
+	for (unsigned count = source.num_spans(); count > 0; count--, span++) {
+		int start;
+		int end;
+		span_extent(*span, start, end);
+		start = max_c(start, minX);
+		end = min_c(end, maxX);
+		if (start > end)
+			continue;
+		if (span->len < 0)
+			target.add_span(start, end - start + 1, *span->covers);
+		else {
+			target.add_cells(start, end - start + 1,
+				span->covers + (start - span->x));
+		}
+	}
+}
+
+// decode_spans
+/*!	Writes the coverage of the source scanline between left and
+	left + width - 1 into the row.
+*/
+static void
+decode_spans(const Scanline& source, uint8* row, int left, int width)
+{
+	int right = left + width - 1;
+	Scanline::const_iterator span = source.begin();
+	for (unsigned count = source.num_spans(); count > 0; count--, span++) {
+		int start;
+		int end;
+		span_extent(*span, start, end);
+		start = max_c(start, left);
+		end = min_c(end, right);
+		if (start > end)
+			continue;
+		if (span->len < 0)
+			memset(row + start - left, *span->covers, end - start + 1);
+		else {
+			memcpy(row + start - left, span->covers + (start - span->x),
+				end - start + 1);
+		}
+	}
+}
+
+// encode_row
+/*!	Appends the non-zero coverage of the row to the target scanline. Runs
+	of equal coverage become solid spans.
+*/
+static void
+encode_row(const uint8* row, int left, int width, Scanline& target)
+{
+	int x = 0;
+	while (x < width) {
+		uint8 cover = row[x];
+		int end = x + 1;
+		while (end < width && row[end] == cover)
+			end++;
+		if (cover != 0) {
+			if (end - x >= MIN_SOLID_SPAN_LENGTH)
+				target.add_span(left + x, end - x, cover);
+			else {
+				for (int i = x; i < end; i++)
+					target.add_cell(left + i, cover);
+			}
+		}
+		x = end;
+	}
+}
+
+// is_empty_row
+static bool
+is_empty_row(const uint8* row, int width)
+{
+	for (int x = 0; x < width; x++) {
+		if (row[x] != 0)
+			return false;
+	}
+	return true;
+}
+
+// #pragma mark -
+
 // constructor
 BrushStrokeSnapshot::BrushStrokeSnapshot(const BrushStroke* stroke)
 	: BoundedObjectSnapshot(stroke)
@@ -18,6 +142,14 @@ BrushStrokeSnapshot::BrushStrokeSnapshot(const BrushStroke* stroke)
 
 	// TODO: Move this into Brush?
 	, fMaxSpacing(0.1f)
+
+	, fRasterizerLock("brush stroke lock")
+	, fNeedsRasterizing(1)
+
+	, fMask(NULL)
+	, fMaskClipping()
+	, fRasterizedCount(0)
+	, fStepDistLeftOver(0.0f)
 {
 	_Sync();
 }
@@ -26,6 +158,7 @@ BrushStrokeSnapshot::BrushStrokeSnapshot(const BrushStroke* stroke)
 BrushStrokeSnapshot::~BrushStrokeSnapshot()
 {
 	Paint::PaintCache().Put(fPaint);
+	delete fMask;
 }
 
 // #pragma mark -
@@ -48,46 +181,51 @@ BrushStrokeSnapshot::Sync()
 	return false;
 }
 
-// Render
+// Layout
 void
-BrushStrokeSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
-	BRect area) const
+BrushStrokeSnapshot::Layout(LayoutContext& context, uint32 flags)
 {
-	if (!Transformable::IsValid())
+	Transformable previous = LayoutedState().Matrix;
+	BoundedObjectSnapshot::Layout(context, flags);
+	if (previous != LayoutedState().Matrix) {
+		fRasterizedCount = 0;
+		atomic_set(&fNeedsRasterizing, 1);
+	}
+}
+
+// PrepareRendering
+void
+BrushStrokeSnapshot::PrepareRendering(BRect documentBounds)
+{
+	if (atomic_get(&fNeedsRasterizing) == 0)
 		return;
-	engine.SetTransformation(LayoutedState().Matrix);
 
-	area = bitmap->Bounds() & area;
+	AutoLocker<BLocker> lock(fRasterizerLock);
+	if (!lock.IsLocked())
+		return;
 
-	// TODO: Move actual Brush drawing into RenderEngine.
-	uint8* dest = (uint8*)engine.AlphaBuffer().buf();
-	uint32 bpr = engine.AlphaBuffer().stride();
-	if (dest == NULL)
+	if (atomic_get(&fNeedsRasterizing) == 0)
 		return;
 
-	engine.ClearAlphaBufferScanlines();
+	_RasterizeStroke(documentBounds);
 
-	// traverse lines
-	float stepDistLeftOver = 0.0f;
-	const StrokePoint* previous = fStroke.ObjectAt(0);
-	int32 count = fStroke.CountObjects();
-	bool drawnAnything = false;
-	if (count > 1) {
-		for (int32 i = 1; i < count; i++) {
-			const StrokePoint* current = fStroke.ObjectAt(i);
-			drawnAnything |= _StrokeLine(previous, current, dest, bpr,
-				area, stepDistLeftOver);
-			previous = current;
-		}
-	} else if (previous != NULL) {
-		drawnAnything = _StrokeLine(previous, previous, dest, bpr,
-			area, stepDistLeftOver);
-	}
-	if (drawnAnything) {
-		// Blend alpha map with our paint
-		engine.SetFillPaint(fPaint);
-		engine.RenderAlphaBufferScanlines();
-	}
+	atomic_set(&fNeedsRasterizing, 0);
+}
+
+// Render
+void
+BrushStrokeSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
+	BRect area) const
+{
+	if (!Transformable::IsValid() || fMask == NULL || fPaint == NULL)
+		return;
+
+	PrepareRenderEngine(engine);
+	engine.SetTransformation(LayoutedState().Matrix);
+
+	// Blend the coverage mask with our paint
+	engine.SetFillPaint(fPaint);
+	engine.RenderScanlines(fMask->scanlines, true);
 }
 
 // #pragma mark -
@@ -96,10 +234,17 @@ BrushStrokeSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
 void
 BrushStrokeSnapshot::_Sync()
 {
+	Brush brush;
 	if (fOriginal->Brush() != NULL)
-		fBrush = *fOriginal->Brush();
-	else
-		fBrush = Brush();
+		brush = *fOriginal->Brush();
+
+	// The coverage mask can be extended as long as points have only been
+	// appended to the stroke since it was built. The paint is applied when
+	// rendering and does not affect the mask.
+	if (brush != fBrush || !_IsAppendedStroke(fOriginal->Stroke()))
+		fRasterizedCount = 0;
+
+	fBrush = brush;
 
 	if (fOriginal->Paint() != NULL) {
 		// We can compare the SharedPaint pointers, since the cache should
@@ -111,6 +256,246 @@ BrushStrokeSnapshot::_Sync()
 	}
 
 	fStroke = fOriginal->Stroke();
+
+	atomic_set(&fNeedsRasterizing, 1);
+}
+
+// _IsAppendedStroke
+/*!	Returns whether the given stroke starts with the points which are
+	already contained in the coverage mask.
+*/
+bool
+BrushStrokeSnapshot::_IsAppendedStroke(const ::Stroke& stroke) const
+{
+	if (fRasterizedCount == 0
+		|| stroke.CountObjects() < (uint32)fRasterizedCount) {
+		return false;
+	}
+
+	for (int32 i = fRasterizedCount - 1; i >= 0; i--) {
+		if (*stroke.ObjectAtFast(i) != *fStroke.ObjectAtFast(i))
+			return false;
+	}
+	return true;
+}
+
+// _StrokeBounds
+/*!	Returns the bounds in layer pixels of the dabs which are drawn for the
+	stroke segments starting at the given point.
+*/
+BRect
+BrushStrokeSnapshot::_StrokeBounds(int32 firstPoint) const
+{
+	BRect bounds(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
+
+	int32 count = fStroke.CountObjects();
+	for (int32 i = max_c(0, firstPoint - 1); i < count; i++) {
+		const StrokePoint* point = fStroke.ObjectAtFast(i);
+
+		float radius = fBrush.Radius(point->pressure);
+		bounds = bounds | BRect(
+			point->point.x - radius,
+			point->point.y - radius,
+			point->point.x + radius,
+			point->point.y + radius);
+	}
+	if (!bounds.IsValid())
+		return bounds;
+
+	// Include the anti-aliased edges of the dabs.
+	bounds = LayoutedState().Matrix.TransformBounds(bounds);
+	return BRect(floorf(bounds.left - 1), floorf(bounds.top - 1),
+		ceilf(bounds.right + 1), ceilf(bounds.bottom + 1));
+}
+
+// _RasterizeStroke
+/*!	Updates the coverage mask. Only the dabs of the stroke segments which
+	are not yet contained in the mask are drawn. The rows of the mask which
+	they touch are decoded, the dabs are drawn into them and they are encoded
+	again. Everything else is copied from the previous mask.
+*/
+void
+BrushStrokeSnapshot::_RasterizeStroke(BRect documentBounds)
+{
+	if (fMask == NULL || documentBounds != fMaskClipping
+		|| fRasterizedCount < 2) {
+		// A single point stroke draws a single dab, which a stroke
+		// segment would draw again. So it is rasterized from scratch.
+		fRasterizedCount = 0;
+		fStepDistLeftOver = 0.0f;
+		fMaskClipping = documentBounds;
+	}
+
+	int32 firstPoint = fRasterizedCount;
+	int32 count = fStroke.CountObjects();
+	if (firstPoint > 0 && firstPoint == count)
+		return;
+
+	CoverageMask* mask = new(std::nothrow) CoverageMask;
+	if (mask == NULL)
+		return;
+
+	CoverageMask emptyMask;
+	const CoverageMask& previous = firstPoint > 0 ? *fMask : emptyMask;
+	uint32 previousCount = previous.scanlines.CountObjects();
+	uint32 previousIndex = 0;
+
+	// Preallocate the space for the unchanged rows at once.
+	if (mask->coverAllocator.Reserve(previous.coverAllocator.Size()) != NULL)
+		mask->coverAllocator.Clear();
+	if (mask->spanAllocator.Reserve(previous.spanAllocator.Size()) != NULL)
+		mask->spanAllocator.Clear();
+
+	BRect area = _StrokeBounds(firstPoint) & documentBounds;
+
+	int left = (int)area.left;
+	int right = (int)area.right;
+	int width = right - left + 1;
+	int top = (int)area.top;
+	int bottom = (int)area.bottom;
+
+	uint8* band = NULL;
+	if (area.IsValid()) {
+		band = new(std::nothrow) uint8[width * min_c(BAND_HEIGHT,
+			bottom - top + 1)];
+	}
+
+	float stepDistLeftOver = fStepDistLeftOver;
+	if (band == NULL) {
+		// Nothing is visible, but the stroke needs to be traversed
+		// in order to continue it correctly later.
+		_StrokeSegments(firstPoint, NULL, 0, BRect(), NULL,
+			stepDistLeftOver);
+		top = bottom + 1;
+	}
+
+	BrushStampCache stampCache;
+
+	for (int bandTop = top; bandTop <= bottom; bandTop += BAND_HEIGHT) {
+		int bandBottom = min_c(bandTop + BAND_HEIGHT - 1, bottom);
+
+		// Copy the rows above the band
+		for (; previousIndex < previousCount; previousIndex++) {
+			const Scanline* scanline
+				= previous.scanlines.ObjectAtFast(previousIndex);
+			if (scanline->y() >= bandTop)
+				break;
+			int minX;
+			int maxX;
+			scanline_extent(*scanline, minX, maxX);
+			Scanline* copy = mask->scanlines.AppendObject();
+			if (copy == NULL)
+				break;
+			copy->SetAllocators(&mask->coverAllocator, &mask->spanAllocator);
+			copy->reset(minX, maxX);
+			copy_spans(*scanline, *copy, minX, maxX);
+			copy->finalize(scanline->y());
+		}
+
+		// Decode the rows within the band
+		memset(band, 0, width * (bandBottom - bandTop + 1));
+		for (uint32 i = previousIndex; i < previousCount; i++) {
+			const Scanline* scanline = previous.scanlines.ObjectAtFast(i);
+			if (scanline->y() > bandBottom)
+				break;
+			decode_spans(*scanline, band + (scanline->y() - bandTop) * width,
+				left, width);
+		}
+
+		// Draw the new dabs
+		stepDistLeftOver = fStepDistLeftOver;
+		_StrokeSegments(firstPoint, band - bandTop * width - left, width,
+			BRect(left, bandTop, right, bandBottom), &stampCache,
+			stepDistLeftOver);
+
+		// Encode the rows within the band
+		for (int y = bandTop; y <= bandBottom; y++) {
+			const uint8* row = band + (y - bandTop) * width;
+			const Scanline* scanline = NULL;
+			if (previousIndex < previousCount
+				&& previous.scanlines.ObjectAtFast(previousIndex)->y() == y) {
+				scanline = previous.scanlines.ObjectAtFast(previousIndex++);
+			}
+			int minX = left;
+			int maxX = right;
+			if (scanline != NULL) {
+				int scanlineMinX;
+				int scanlineMaxX;
+				scanline_extent(*scanline, scanlineMinX, scanlineMaxX);
+				minX = min_c(minX, scanlineMinX);
+				maxX = max_c(maxX, scanlineMaxX);
+			} else if (is_empty_row(row, width))
+				continue;
+
+			Scanline* encoded = mask->scanlines.AppendObject();
+			if (encoded == NULL)
+				break;
+			encoded->SetAllocators(&mask->coverAllocator,
+				&mask->spanAllocator);
+			encoded->reset(minX, maxX);
+			if (scanline != NULL)
+				copy_spans(*scanline, *encoded, minX, left - 1);
+			encode_row(row, left, width, *encoded);
+			if (scanline != NULL)
+				copy_spans(*scanline, *encoded, right + 1, maxX);
+			encoded->finalize(y);
+		}
+	}
+
+	delete[] band;
+
+	// Copy the rows below the changed area
+	for (; previousIndex < previousCount; previousIndex++) {
+		const Scanline* scanline
+			= previous.scanlines.ObjectAtFast(previousIndex);
+		int minX;
+		int maxX;
+		scanline_extent(*scanline, minX, maxX);
+		Scanline* copy = mask->scanlines.AppendObject();
+		if (copy == NULL)
+			break;
+		copy->SetAllocators(&mask->coverAllocator, &mask->spanAllocator);
+		copy->reset(minX, maxX);
+		copy_spans(*scanline, *copy, minX, maxX);
+		copy->finalize(scanline->y());
+	}
+
+	// Validate the data to avoid stale pointers after relocation of
+	// memory buffers.
+	uint32 scanlineCount = mask->scanlines.CountObjects();
+	for (uint32 i = 0; i < scanlineCount; i++)
+		mask->scanlines.ObjectAtFast(i)->Validate();
+
+	delete fMask;
+	fMask = mask;
+	fRasterizedCount = count;
+	fStepDistLeftOver = stepDistLeftOver;
+}
+
+// _StrokeSegments
+/*!	Draws the dabs of the stroke segments starting at the given point. If
+	the point is 0, the whole stroke is drawn.
+*/
+void
+BrushStrokeSnapshot::_StrokeSegments(int32 firstPoint, uint8* dest,
+	uint32 bpr, const BRect& constrainRect, BrushStampCache* stampCache,
+	float& stepDistLeftOver) const
+{
+	int32 count = fStroke.CountObjects();
+	if (count == 1) {
+		const StrokePoint* point = fStroke.ObjectAtFast(0);
+		_StrokeLine(point, point, dest, bpr, constrainRect, stampCache,
+			stepDistLeftOver);
+		return;
+	}
+
+	const StrokePoint* previous = fStroke.ObjectAt(max_c(0, firstPoint - 1));
+	for (int32 i = max_c(1, firstPoint); i < count; i++) {
+		const StrokePoint* current = fStroke.ObjectAtFast(i);
+		_StrokeLine(previous, current, dest, bpr, constrainRect, stampCache,
+			stepDistLeftOver);
+		previous = current;
+	}
 }
 
 // _StepDist
@@ -134,12 +519,13 @@ BrushStrokeSnapshot::_StepDist(float scale) const
 bool
 BrushStrokeSnapshot::_StrokeLine(const StrokePoint* a,
 	const StrokePoint* b, uint8* dest, uint32 bpr,
-	const BRect& constrainRect, float& stepDistLeftOver) const
+	const BRect& constrainRect, BrushStampCache* stampCache,
+	float& stepDistLeftOver) const
 {
 	if (a == b) {
 		BPoint p = a->point;
-		fBrush.Draw(p, a->pressure, a->tiltX, a->tiltY, dest, bpr, *this,
-			constrainRect);
+		fBrush.Draw(p, a->pressure, a->tiltX, a->tiltY, dest, bpr,
+			LayoutedState().Matrix, constrainRect, stampCache);
 		return true;
 	}
 
@@ -179,7 +565,7 @@ BrushStrokeSnapshot::_StrokeLine(const StrokePoint* a,
 				pA.x + vector.x * iterationScale,
 				pA.y + vector.y * iterationScale);
 			fBrush.Draw(center, currentPressure, currentTiltX, currentTiltY,
-				dest, bpr, LayoutedState().Matrix, constrainRect);
+				dest, bpr, LayoutedState().Matrix, constrainRect, stampCache);
 		}
 		stepDistLeftOver = dist - (p - currentStepDist);
 		drawnAnything = true;
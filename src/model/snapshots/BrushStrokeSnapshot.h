@@ -5,6 +5,8 @@
 #ifndef BRUSH_STROKE_SNAPSHOT_H
 #define BRUSH_STROKE_SNAPSHOT_H
 
+#include <Locker.h>
+
 #include "BrushStroke.h"
 #include "BoundedObjectSnapshot.h"
 #include "RenderEngine.h"
@@ -17,15 +19,30 @@ public:
 	virtual	const Object*		Original() const;
 	virtual	bool				Sync();
 
+	virtual	void				Layout(LayoutContext& context, uint32 flags);
+
+	virtual	void				PrepareRendering(BRect documentBounds);
 	virtual	void				Render(RenderEngine& engine,
 									RenderBuffer* bitmap, BRect area) const;
 
 private:
+			struct CoverageMask;
+
 			void				_Sync();
+			bool				_IsAppendedStroke(const ::Stroke& stroke)
+									const;
+			BRect				_StrokeBounds(int32 firstPoint) const;
+			void				_RasterizeStroke(BRect documentBounds);
+			void				_StrokeSegments(int32 firstPoint,
+									uint8* dest, uint32 bpr,
+									const BRect& constrainRect,
+									BrushStampCache* stampCache,
+									float& stepDistLeftOver) const;
 			float				_StepDist(float scale) const;
 			bool				_StrokeLine(const StrokePoint* a,
 									const StrokePoint* b, uint8* dest,
 									uint32 bpr, const BRect& constrainRect,
+									BrushStampCache* stampCache,
 									float& stepDistLeftOver) const;
 
 private:
@@ -36,11 +53,17 @@ private:
 
 			// TODO: Move this into Brush?
 			float				fMaxSpacing;
-//			float				fStepDistLeftOver;
 
-			ScanlineContainer	fScanlines;
-			CoverAllocator		fCoverAllocator;
-			SpanAllocator		fSpanAllocator;
+			BLocker				fRasterizerLock;
+			int32				fNeedsRasterizing;
+
+			// The coverage of the stroke in layer pixels, built in
+			// PrepareRendering() and reused until the stroke, the brush
+			// or the transformation change. Appended points extend it.
+			CoverageMask*		fMask;
+			BRect				fMaskClipping;
+			int32				fRasterizedCount;
+			float				fStepDistLeftOver;
 };
 
 #endif // BRUSH_STROKE_SNAPSHOT_H
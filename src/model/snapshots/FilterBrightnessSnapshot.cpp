@@ -68,8 +68,8 @@ FilterBrightnessSnapshot::Render(RenderEngine& engine,
 	const int right = (int)area.right;
 
 	uint8* bits = bitmap->Bits();
-	bits += top * bitmap->BytesPerRow();
-	bits += left * 8;
+	bits += (top - bitmap->Top()) * bitmap->BytesPerRow();
+	bits += (left - bitmap->Left()) * 8;
 
 	for (int y = top; y <= bottom; y++) {
 		uint16* p = (uint16*)bits;
@@ -13,6 +13,7 @@
 #include "support.h"
 
 #include "FilterContrast.h"
+#include "PixelKernels.h"
 #include "RenderBuffer.h"
 
 
@@ -68,40 +69,12 @@ FilterContrastSnapshot::Render(RenderEngine& engine,
 	const int right = (int)area.right;
 
 	uint8* bits = bitmap->Bits();
-	bits += top * bitmap->BytesPerRow();
-	bits += left * 8;
+	bits += (top - bitmap->Top()) * bitmap->BytesPerRow();
+	bits += (left - bitmap->Left()) * 8;
 
 	for (int y = top; y <= bottom; y++) {
-		uint16* p = (uint16*)bits;
-		for (int x = left; x <= right; x++) {
-			float b = p[0] / 256.0f;
-			float g = p[1] / 256.0f;
-			float r = p[2] / 256.0f;
-
-			b = fCenter + (b - fCenter) * fContrast;
-			g = fCenter + (g - fCenter) * fContrast;
-			r = fCenter + (r - fCenter) * fContrast;
-
-			p[0] = constrain_int32_0_65535(
-				(int32)(b * 256.0f));
-			p[1] = constrain_int32_0_65535(
-				(int32)(g * 256.0f));
-			p[2] = constrain_int32_0_65535(
-				(int32)(r * 256.0f));
-
-			// TODO: Confirm/improve this code which is supposed
-			// to implement the pre-multiplication of the alpha-channel
-			// (which results in the restriction that no color-channel
-			// has a higher value than the alpha-channel).
-			if (p[0] > p[3])
-				p[0] = p[3];
-			if (p[1] > p[3])
-				p[1] = p[3];
-			if (p[2] > p[3])
-				p[2] = p[3];
-
-			p += 4;
-		}
+		PixelKernels::ContrastRow((uint16*)bits, right - left + 1, fCenter,
+			fContrast);
 		bits += bitmap->BytesPerRow();
 	}
 }
@@ -7,20 +7,17 @@
 
 #include <algorithm>
 #include <stdio.h>
+#include <string.h>
 
 #include <Bitmap.h>
 
-#include <agg_blur.h>
-#include <agg_pixfmt_gray.h>
-#include <agg_rendering_buffer.h>
-
 #include "AlphaBuffer.h"
+#include "BoxBlurFilter.h"
 #include "FilterDropShadow.h"
-#include "GaussFilter.h"
 #include "LayoutContext.h"
+#include "PixelKernels.h"
 #include "RenderBuffer.h"
 #include "RenderEngine.h"
-#include "StackBlurFilter.h"
 #include "ui_defines.h"
 
 // constructor
@@ -37,6 +34,8 @@ FilterDropShadowSnapshot::FilterDropShadowSnapshot(
 	, fLayoutedFilterRadius(fFilterRadius)
 	, fLayoutedOffsetX(fOffsetX)
 	, fLayoutedOffsetY(fOffsetY)
+	, fLayoutedExtent(0)
+	, fResultCache()
 {
 	if (fOriginal->Color().Get() != NULL)
 		fColor = fOriginal->Color()->GetColor();
@@ -83,12 +82,21 @@ FilterDropShadowSnapshot::Layout(LayoutContext& context, uint32 flags)
 	ObjectSnapshot::Layout(context, flags);
 	double scale = LayoutedState().Matrix.Scale();
 	fLayoutedFilterRadius = fFilterRadius * scale;
+	if (context.IsPreview())
+		fLayoutedFilterRadius /= 2;
 //	fLayoutedOffsetX = fOffsetX * scale;
 //	fLayoutedOffsetY = fOffsetY * scale;
 
 	fLayoutedOffsetX = fOffsetX;
 	fLayoutedOffsetY = fOffsetY;
 	LayoutedState().Matrix.Transform(&fLayoutedOffsetX, &fLayoutedOffsetY);
+
+	BoxBlurFilter filter(
+		BoxBlurFilter::SigmaForStackBlurRadius(fLayoutedFilterRadius));
+	fLayoutedExtent = filter.Extent();
+
+	// The pixels below the filter may have changed.
+	fResultCache.MakeEmpty();
 }
 
 // Render
@@ -96,114 +104,63 @@ void
 FilterDropShadowSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
 	BRect area) const
 {
-	int32 extend = (int32)ceilf(fLayoutedFilterRadius) + 3;
-	BRect source(area);
-	source.InsetBy(-extend, -extend);
-	source.OffsetBy(-fLayoutedOffsetX, -fLayoutedOffsetY);
-
-	if (source.Width() <= 0 || source.Height() <= 0)
+	area = area & bitmap->Bounds();
+	if (!area.IsValid())
 		return;
 
-	AlphaBuffer alphaBuffer(source);
-	
-	source = source & bitmap->Bounds();
-
-	int32 left = (int32)floorf(source.left);
-	int32 top = (int32)floorf(source.top);
-	int32 right = (int32)ceilf(source.right);
-	int32 bottom = (int32)ceilf(source.bottom);
-
-	// handles and byte lengths
-	uint8* dst = alphaBuffer.Bits();
-	uint32 dstBPR = alphaBuffer.BytesPerRow();
-
-	// Clear alpha buffer
-	memset(dst, 0, dstBPR * alphaBuffer.Height());
-
-	uint8* src = bitmap->Bits();
-	uint32 srcBPR = bitmap->BytesPerRow();
+	int32 offsetX = (int32)fLayoutedOffsetX;
+	int32 offsetY = (int32)fLayoutedOffsetY;
 
-	// offsets into bitmaps
-	src += left * 8 + top * srcBPR;
-	dst += (left - alphaBuffer.Left()) * 2
-		+ (top - alphaBuffer.Top()) * dstBPR;
+	// The blurred alpha channel is needed for the area shifted back by the
+	// shadow offset. The render jobs of neighbouring areas may already have
+	// blurred parts of it.
+	BRect shadowArea(area);
+	shadowArea.OffsetBy(-offsetX, -offsetY);
 
-	uint16 opacity = std::max((uint16)0, std::min((uint16)65535,
-		(uint16)(fOpacity * 65535.0 / 255.0)));
+	AlphaBuffer alphaBuffer(shadowArea);
+	if (!alphaBuffer.IsValid())
+		return;
 
-	// first pass:
-	// copy alpha channel of bitmap and blur it
-	for (int32 y = top; y <= bottom; y++) {
+	BRect missing = fResultCache.MissingArea(shadowArea);
+	if (missing.IsValid()) {
+		BoxBlurFilter filter(
+			BoxBlurFilter::SigmaForStackBlurRadius(fLayoutedFilterRadius));
 
-		uint16* dstHandle = (uint16*)dst;
-		uint16* srcHandle = (uint16*)src;
+		BRect source(missing);
+		source.InsetBy(-filter.Extent(), -filter.Extent());
 
-		for (int32 x = left; x <= right; x++) {
+		AlphaBuffer sourceBuffer(source);
+		if (!sourceBuffer.IsValid())
+			return;
 
-//			dstHandle[0] = INT_MULT(srcHandle[3], fOpacity, t);
-			dstHandle[0] = (uint16)((uint32)srcHandle[3] * opacity / 65535);
+		_ExtractAlpha(bitmap, &sourceBuffer);
+		filter.FilterGray16(&sourceBuffer);
 
-			dstHandle += 1;
-			srcHandle += 4;
-		}
-		dst += dstBPR;
-		src += srcBPR;
+		sourceBuffer.CopyTo(&alphaBuffer, missing);
+		fResultCache.Store(&sourceBuffer, missing);
 	}
+	fResultCache.CopyTo(&alphaBuffer, shadowArea);
 
-//	StackBlurFilter filter;
-//	filter.FilterGray16(&alphaBuffer, fLayoutedFilterRadius);
+	int32 left = (int32)area.left;
+	int32 top = (int32)area.top;
+	int32 right = (int32)area.right;
+	int32 bottom = (int32)area.bottom;
 
-	agg::rendering_buffer aggBuffer;
-	aggBuffer.attach(alphaBuffer.Bits(), alphaBuffer.Width(),
-		alphaBuffer.Height(), alphaBuffer.BytesPerRow());
-	agg::pixfmt_gray16 pixelFormat(aggBuffer);
-	
-	agg::stack_blur<agg::gray16, agg::stack_blur_calc_gray<> > stackBlur;
-	stackBlur.blur(pixelFormat, agg::uround(fLayoutedFilterRadius));
-//
-
-	source = alphaBuffer.Bounds();
-	source.InsetBy(extend, extend);
-	source.OffsetBy(fLayoutedOffsetX, fLayoutedOffsetY);
-	source = source & bitmap->Bounds();
-
-	left = (int32)floorf(source.left);
-	top = (int32)floorf(source.top);
-	right = (int32)ceilf(source.right);
-	bottom = (int32)ceilf(source.bottom);
-
-	// reset offsets into bitmaps
-	dst = bitmap->Bits();
-	dstBPR = bitmap->BytesPerRow();
-	src = alphaBuffer.Bits();
-	srcBPR = alphaBuffer.BytesPerRow();
+	uint8* dst = bitmap->Bits();
+	uint32 dstBPR = bitmap->BytesPerRow();
+	const uint8* src = alphaBuffer.Bits();
+	uint32 srcBPR = alphaBuffer.BytesPerRow();
 	dst += (left - bitmap->Left()) * 8 + (top - bitmap->Top()) * dstBPR;
-	src += ((left - (int32)fLayoutedOffsetX) - alphaBuffer.Left()) * 2
-		+ ((top - (int32)fLayoutedOffsetY) - alphaBuffer.Top()) * srcBPR;
-	
-	for (int32 y = top; y <= bottom; y++) {
-
-		uint16* d = (uint16*)dst;
-		uint16* s = (uint16*)src;
 
-		for (int32 x = left; x <= right; x++) {
-			agg::rgba16 color(
-				RenderEngine::GammaToLinear(fColor.red),
-				RenderEngine::GammaToLinear(fColor.green),
-				RenderEngine::GammaToLinear(fColor.blue),
-				s[0]);
-			color.premultiply();
+	const uint16 color[3] = {
+		RenderEngine::GammaToLinear(fColor.blue),
+		RenderEngine::GammaToLinear(fColor.green),
+		RenderEngine::GammaToLinear(fColor.red)
+	};
 
-			uint16 alpha = 65535 - d[3];
-
-			d[0] = (uint16)((((uint32)color.b * alpha) / 65535) + d[0]);
-			d[1] = (uint16)((((uint32)color.g * alpha) / 65535) + d[1]);
-			d[2] = (uint16)((((uint32)color.r * alpha) / 65535) + d[2]);
-			d[3] = (uint16)(65535 - (((uint32)alpha * (65535 - s[0])) / 65535));
-
-			d += 4;
-			s += 1;
-		}
+	for (int32 y = top; y <= bottom; y++) {
+		PixelKernels::ShadowRow((uint16*)dst, (uint16*)src, right - left + 1,
+			color);
 		dst += dstBPR;
 		src += srcBPR;
 	}
@@ -225,10 +182,49 @@ FilterDropShadowSnapshot::RebuildAreaForDirtyArea(BRect& area) const
 	BRect source(area);
 	source.OffsetBy(-fLayoutedOffsetX, -fLayoutedOffsetY);
 
-	float extend = ceilf(fLayoutedFilterRadius) + 3;
-		// + 3 to account for the required 3 edge pixles
-	source.InsetBy(-extend, -extend);
+	source.InsetBy(-fLayoutedExtent - 1, -fLayoutedExtent - 1);
+		// + 1 since Render() truncates the offset
 	
 	area = area | source;
 }
 
+// #pragma mark -
+
+// _ExtractAlpha
+/*!	Fills the alpha buffer with the alpha channel of the bitmap multiplied
+	by the opacity of the shadow. Pixels outside the bitmap are transparent.
+*/
+void
+FilterDropShadowSnapshot::_ExtractAlpha(const RenderBuffer* bitmap,
+	AlphaBuffer* alphaBuffer) const
+{
+	uint8* dst = alphaBuffer->Bits();
+	uint32 dstBPR = alphaBuffer->BytesPerRow();
+	memset(dst, 0, dstBPR * alphaBuffer->Height());
+
+	BRect source = alphaBuffer->Bounds() & bitmap->Bounds();
+	if (!source.IsValid())
+		return;
+
+	int32 left = (int32)source.left;
+	int32 top = (int32)source.top;
+	int32 right = (int32)source.right;
+	int32 bottom = (int32)source.bottom;
+
+	const uint8* src = bitmap->Bits();
+	uint32 srcBPR = bitmap->BytesPerRow();
+
+	src += (left - bitmap->Left()) * 8 + (top - bitmap->Top()) * srcBPR;
+	dst += (left - alphaBuffer->Left()) * 2
+		+ (top - alphaBuffer->Top()) * dstBPR;
+
+	uint16 opacity = std::max((uint16)0, std::min((uint16)65535,
+		(uint16)(fOpacity * 65535.0 / 255.0)));
+
+	for (int32 y = top; y <= bottom; y++) {
+		PixelKernels::ExtractAlphaRow((uint16*)dst, (const uint16*)src,
+			right - left + 1, opacity);
+		dst += dstBPR;
+		src += srcBPR;
+	}
+}
@@ -8,8 +8,10 @@
 
 #include <GraphicsDefs.h>
 
+#include "BlurResultCache.h"
 #include "ObjectSnapshot.h"
 
+class AlphaBuffer;
 class FilterDropShadow;
 
 class FilterDropShadowSnapshot : public ObjectSnapshot {
@@ -27,6 +29,10 @@ class FilterDropShadowSnapshot : public ObjectSnapshot {
 									RenderBuffer* bitmap, BRect area) const;
 	virtual	void				RebuildAreaForDirtyArea(BRect& area) const;
 
+ private:
+			void				_ExtractAlpha(const RenderBuffer* bitmap,
+									AlphaBuffer* alphaBuffer) const;
+
  private:
 			const FilterDropShadow*	fOriginal;
 			float				fFilterRadius;
@@ -36,7 +42,10 @@ class FilterDropShadowSnapshot : public ObjectSnapshot {
 			float				fLayoutedFilterRadius;
 			double				fLayoutedOffsetX;
 			double				fLayoutedOffsetY;
+			int32				fLayoutedExtent;
 			rgb_color			fColor;
+
+	mutable	BlurResultCache		fResultCache;
 };
 
 #endif // FILTER_DROP_SHADOW_SNAPSHOT_H
@@ -13,6 +13,7 @@
 #include "support.h"
 
 #include "FilterSaturation.h"
+#include "PixelKernels.h"
 #include "RenderBuffer.h"
 
 
@@ -66,27 +67,15 @@ FilterSaturationSnapshot::Render(RenderEngine& engine,
 	const int right = (int)area.right;
 
 	uint8* bits = bitmap->Bits();
-	bits += top * bitmap->BytesPerRow();
-	bits += left * 8;
+	bits += (top - bitmap->Top()) * bitmap->BytesPerRow();
+	bits += (left - bitmap->Left()) * 8;
 
 	if (fSaturation < 1.0f) {
 		const int coeff = (int)(std::max(0.0f, fSaturation) * 256.0);
-		const int oneMinusCoeff = 256 - coeff;
 
 		for (int y = top; y <= bottom; y++) {
-			uint16* p = (uint16*)bits;
-			for (int x = left; x <= right; x++) {
-				int lum = 28 * p[0];	// B
-				lum += 151 * p[1];		// G
-				lum += 77 * p[2];		// R
-				lum = lum >> 8;
-
-				p[0] = (p[0] * coeff + lum * oneMinusCoeff) >> 8;
-				p[1] = (p[1] * coeff + lum * oneMinusCoeff) >> 8;
-				p[2] = (p[2] * coeff + lum * oneMinusCoeff) >> 8;
-
-				p += 4;
-			}
+			PixelKernels::DesaturateRow((uint16*)bits, right - left + 1,
+				coeff);
 			bits += bitmap->BytesPerRow();
 		}
 	} else {
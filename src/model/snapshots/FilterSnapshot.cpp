@@ -11,15 +11,10 @@
 
 #include <Bitmap.h>
 
-#include <agg_blur.h>
-#include <agg_pixfmt_rgba.h>
-#include <agg_rendering_buffer.h>
-
+#include "BoxBlurFilter.h"
 #include "Filter.h"
-#include "GaussFilter.h"
 #include "LayoutContext.h"
 #include "RenderBuffer.h"
-#include "StackBlurFilter.h"
 
 
 // constructor
@@ -28,6 +23,8 @@ FilterSnapshot::FilterSnapshot(const Filter* filter)
 	, fOriginal(filter)
 	, fFilterRadius(filter->FilterRadius())
 	, fLayoutedFilterRadius(fFilterRadius)
+	, fLayoutedExtent(0)
+	, fResultCache()
 {
 }
 
@@ -62,6 +59,17 @@ FilterSnapshot::Layout(LayoutContext& context, uint32 flags)
 {
 	ObjectSnapshot::Layout(context, flags);
 	fLayoutedFilterRadius = fFilterRadius * LayoutedState().Matrix.Scale();
+	// A preview gets away with a smaller radius, which also shrinks the
+	// area rebuilt around dirty areas.
+	if (context.IsPreview())
+		fLayoutedFilterRadius /= 2;
+
+	BoxBlurFilter filter(
+		BoxBlurFilter::SigmaForStackBlurRadius(fLayoutedFilterRadius));
+	fLayoutedExtent = filter.Extent();
+
+	// The pixels below the filter may have changed.
+	fResultCache.MakeEmpty();
 }
 
 // Render
@@ -69,42 +77,33 @@ void
 FilterSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
 	BRect area) const
 {
-	float extend = ceilf(fLayoutedFilterRadius) + 3;
-	BRect source = area;
-	source.InsetBy(-extend, -extend);
+	BoxBlurFilter filter(
+		BoxBlurFilter::SigmaForStackBlurRadius(fLayoutedFilterRadius));
+	if (filter.Extent() == 0)
+		return;
+
+	area = area & bitmap->Bounds();
+
+	// The render jobs of neighbouring areas may already have blurred parts
+	// of the area when it includes the halo of filters above this one.
+	BRect missing = fResultCache.MissingArea(area);
+	if (!missing.IsValid()) {
+		fResultCache.CopyTo(bitmap, area);
+		return;
+	}
+
+	BRect source = missing;
+	source.InsetBy(-filter.Extent(), -filter.Extent());
 
 	RenderBuffer buffer(bitmap, source, false);
+	if (!buffer.IsValid())
+		return;
+
+	filter.FilterRGBA64(&buffer);
 
-// TODO: GaussFilter is broken! Using only the StackBlurFilter here means that
-// radius is clamped to 254.
-//	if (fLayoutedFilterRadius < 254) {
-		// stack blur is really fast and independent
-		// of the filter radius, but limited to 254
-		// filter radius maximum
-//		StackBlurFilter filter;
-//		filter.FilterRGBA64(&buffer, fLayoutedFilterRadius);
-//	} else {
-//		// gauss filter supports any radius and is
-//		// independent of the radius as well, but
-//		// uses floating point math/conversion, so
-//		// it is slower
-//		GaussFilter filter;
-//		filter.FilterRGBA64(&buffer, fLayoutedFilterRadius);
-//	}
-
-	agg::rendering_buffer aggBuffer;
-	aggBuffer.attach(buffer.Bits(), buffer.Width(), buffer.Height(),
-		buffer.BytesPerRow());
-	agg::pixfmt_bgra64_pre pixelFormat(aggBuffer);
-	
-	agg::stack_blur<agg::rgba16, agg::stack_blur_calc_rgba<> > stackBlur;
-	stackBlur.blur(pixelFormat, agg::uround(fLayoutedFilterRadius));
-
-//	agg::recursive_blur<agg::rgba16, agg::recursive_blur_calc_rgba<> > recursiveBlur;
-//	recursiveBlur.blur(pixelFormat, fLayoutedFilterRadius);
-
-	source.InsetBy(extend, extend);
-	buffer.CopyTo(bitmap, source);
+	fResultCache.CopyTo(bitmap, area);
+	buffer.CopyTo(bitmap, missing);
+	fResultCache.Store(&buffer, missing);
 }
 
 // RebuildAreaForDirtyArea
@@ -118,8 +117,6 @@ FilterSnapshot::RebuildAreaForDirtyArea(BRect& area) const
 	// are required by this object to render the given area
 	// correctly.
 
-	float extend = ceilf(fLayoutedFilterRadius) + 3;
-		// + 3 to account for the required 3 edge pixles
-	area.InsetBy(-extend, -extend);
+	area.InsetBy(-fLayoutedExtent, -fLayoutedExtent);
 }
 
@@ -8,6 +8,7 @@
 #ifndef FILTER_CLONE_H
 #define FILTER_CLONE_H
 
+#include "BlurResultCache.h"
 #include "ObjectSnapshot.h"
 
 class Filter;
@@ -30,6 +31,9 @@ class FilterSnapshot : public ObjectSnapshot {
 			const Filter*		fOriginal;
 			float				fFilterRadius;
 			float				fLayoutedFilterRadius;
+			int32				fLayoutedExtent;
+
+	mutable	BlurResultCache		fResultCache;
 };
 
 #endif // FILTER_CLONE_H
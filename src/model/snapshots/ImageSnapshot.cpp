@@ -4,9 +4,13 @@
  */
 #include "ImageSnapshot.h"
 
+#include <new>
+
 #include <stdio.h>
 
+#include "AutoLocker.h"
 #include "Image.h"
+#include "Interpolation.h"
 #include "RenderBuffer.h"
 #include "RenderEngine.h"
 
@@ -14,9 +18,20 @@
 ImageSnapshot::ImageSnapshot(const Image* image)
 	: BoundedObjectSnapshot(image)
 	, fOriginal(image)
-	, fBuffer(image->Buffer())
+	, fBuffer(NULL)
+	, fLazyBuffer(image->GetLazyBuffer())
 	, fInterpolation(image->Interpolation())
+	, fLayoutedInterpolation(fInterpolation)
+	, fPyramidLock("image pyramid")
+	, fPyramidBuffer()
+	, fPyramid()
 {
+	// Lazily loaded pixels are only read once the image is rendered.
+	if (fLazyBuffer != NULL)
+		fLazyBuffer->AddReference();
+	else
+		fBuffer = image->Buffer();
+
 	if (fBuffer != NULL)
 		fBuffer->AddReference();
 }
@@ -26,6 +41,8 @@ ImageSnapshot::~ImageSnapshot()
 {
 	if (fBuffer != NULL)
 		fBuffer->RemoveReference();
+	if (fLazyBuffer != NULL)
+		fLazyBuffer->RemoveReference();
 }
 
 // #pragma mark -
@@ -48,15 +65,59 @@ ImageSnapshot::Sync()
 	return false;
 }
 
+// Layout
+void
+ImageSnapshot::Layout(LayoutContext& context, uint32 flags)
+{
+	BoundedObjectSnapshot::Layout(context, flags);
+
+	// Sampling the nearest pixel is much cheaper than resampling.
+	if (context.IsPreview())
+		fLayoutedInterpolation = INTERPOLATION_NEAREST_NEIGHBOR;
+	else
+		fLayoutedInterpolation = fInterpolation;
+}
+
 // Render
 void
 ImageSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
 	BRect area) const
 {
-	if (fBuffer != NULL) {
+	RenderBufferRef buffer(fBuffer);
+	if (buffer.Get() == NULL && fLazyBuffer != NULL)
+		buffer = fLazyBuffer->Buffer();
+
+	if (buffer.Get() != NULL) {
+		MipPyramidRef pyramid;
+		if (fLayoutedInterpolation != INTERPOLATION_NEAREST_NEIGHBOR)
+			pyramid = _PyramidFor(buffer.Get());
+
 		engine.SetTransformation(LayoutedState().Matrix);
-		engine.DrawImage(fBuffer, area, fInterpolation, Opacity());
+		engine.DrawImage(buffer.Get(), area, fLayoutedInterpolation,
+			Opacity(), pyramid.Get());
 	}
 }
 
+// #pragma mark -
+
+// _PyramidFor
+/*!	Returns the MipPyramid for drawing the pixels scaled down. The pixels of
+	an Image never change, it gets a new buffer instead. The pyramid is
+	therefore valid for as long as it belongs to the same buffer, which it
+	keeps alive. Pixels which were read again by a LazyBuffer are a new
+	buffer and get a new pyramid.
+*/
+MipPyramidRef
+ImageSnapshot::_PyramidFor(RenderBuffer* buffer) const
+{
+	AutoLocker<BLocker> locker(fPyramidLock);
+
+	if (fPyramid.Get() == NULL || fPyramidBuffer.Get() != buffer) {
+		fPyramid.SetTo(new(std::nothrow) MipPyramid(buffer), true);
+		fPyramidBuffer.SetTo(fPyramid.Get() != NULL ? buffer : NULL);
+	}
+
+	return fPyramid;
+}
+
 
@@ -6,10 +6,13 @@
 #define IMAGE_SNAPSHOT_H
 
 #include <GraphicsDefs.h>
+#include <Locker.h>
 
 #include "BoundedObjectSnapshot.h"
+#include "MipPyramid.h"
 
 class Image;
+class LazyBuffer;
 
 class ImageSnapshot : public BoundedObjectSnapshot {
 public:
@@ -19,13 +22,24 @@ public:
 	virtual	const Object*		Original() const;
 	virtual	bool				Sync();
 
+	virtual	void				Layout(LayoutContext& context, uint32 flags);
+
 	virtual	void				Render(RenderEngine& engine,
 									RenderBuffer* bitmap, BRect area) const;
 
+private:
+			MipPyramidRef		_PyramidFor(RenderBuffer* buffer) const;
+
 private:
 			const Image*		fOriginal;
 			RenderBuffer*		fBuffer;
+			LazyBuffer*			fLazyBuffer;
 			uint32				fInterpolation;
+			uint32				fLayoutedInterpolation;
+
+	mutable	BLocker				fPyramidLock;
+	mutable	RenderBufferRef		fPyramidBuffer;
+	mutable	MipPyramidRef		fPyramid;
 };
 
 #endif // IMAGE_SNAPSHOT_H
@@ -9,23 +9,80 @@
 #include <stdio.h>
 #include <string.h>
 
-#include <Region.h>
-
+#include "AutoLocker.h"
+#include "HashMapHugo.h"
 #include "Layer.h"
 #include "LayoutContext.h"
 #include "Object.h"
 #include "RenderBuffer.h"
 #include "RenderEngine.h"
+#include "RenderTrace.h"
+#include "ShapeSnapshot.h"
+#include "TiledRenderBuffer.h"
 
 using std::nothrow;
 
+enum {
+	NOTHING_CHANGED = LONG_MAX
+};
+
+// A single shape has no neighbors to share its edge pixels with.
+static const int32 kMinCompoundRunLength = 2;
+
+// compound_shape
+static ShapeSnapshot*
+compound_shape(ObjectSnapshot* object)
+{
+	if (!object->IsVisible())
+		return NULL;
+	ShapeSnapshot* shape = dynamic_cast<ShapeSnapshot*>(object);
+	if (shape == NULL || !shape->CanRenderCompound())
+		return NULL;
+	return shape;
+}
+
+// equal_layout_states
+static bool
+equal_layout_states(const LayoutState& a, const LayoutState& b)
+{
+	if (a.Opacity != b.Opacity || a.FillPaint() != b.FillPaint()
+		|| a.StrokePaint() != b.StrokePaint()
+		|| a.StrokeProperties() != b.StrokeProperties()) {
+		return false;
+	}
+
+	double matrixA[Transformable::MatrixSize];
+	double matrixB[Transformable::MatrixSize];
+	a.Matrix.StoreTo(matrixA);
+	b.Matrix.StoreTo(matrixB);
+	for (int32 i = 0; i < Transformable::MatrixSize; i++) {
+		if (matrixA[i] != matrixB[i])
+			return false;
+	}
+	return true;
+}
+
+// SnapshotMap
+class LayerSnapshot::SnapshotMap
+	: public HashMap<HashKey32<const Object*>, ObjectSnapshot*> {
+};
+
 // constructor
 LayerSnapshot::LayerSnapshot(const ::Layer* layer)
 	: ObjectSnapshot(layer)
 	, fOriginal(layer)
 	, fObjects(20)
+	, fSpatialIndex()
 	, fBounds()
-	, fBitmap(NULL)
+	, fTiles(new(nothrow) TiledRenderBuffer())
+	, fCacheTiles(new(nothrow) TiledRenderBuffer())
+	, fCacheLevel(0)
+	, fLowestChangedIndex(0)
+	, fCacheLayoutState()
+	, fCacheZoomLevel(0.0)
+	, fCachePreview(false)
+	, fCacheLock("layer cache lock")
+	, fValidCacheRegion()
 	, fGlobalAlpha(255)
 	, fBlendingMode(CompOpSrcOver)
 {
@@ -36,7 +93,8 @@ LayerSnapshot::LayerSnapshot(const ::Layer* layer)
 LayerSnapshot::~LayerSnapshot()
 {
 	_MakeEmpty();
-	delete fBitmap;
+	delete fTiles;
+	delete fCacheTiles;
 }
 
 // #pragma mark -
@@ -52,10 +110,18 @@ LayerSnapshot::Original() const
 bool
 LayerSnapshot::Sync()
 {
+	uint32 changeCounter = ChangeCounter();
 	if (!ObjectSnapshot::Sync())
 		return false;
 
-	_Sync();
+	TRACE_SPAN("sync layer");
+
+	// Usually, only a few objects changed since the last time, which the
+	// layer still knows about. Otherwise compare all objects.
+	if (!fOriginal->HasChangesSince(changeCounter)
+		|| !_SyncChanges(changeCounter)) {
+		_Sync();
+	}
 
 	return true;
 }
@@ -67,23 +133,42 @@ void
 LayerSnapshot::Layout(LayoutContext& context, uint32 flags)
 {
 //printf("%p->LayerSnapshot::Layout()\n", Original());
-	// Allocate or resize bitmap for caching layer contents
+	// Resize the tiled bitmap for caching layer contents. This drops all
+	// tiles if the size changed. The RenderManager allocates the tiles for
+	// the areas that are about to be rendered.
+	if (fTiles == NULL)
+		return;
+
+	TRACE_SPAN("layout layer");
+
 	BRect zoomedBounds(fBounds);
 	zoomedBounds.left = floorf(zoomedBounds.left * context.ZoomLevel());
 	zoomedBounds.top = floorf(zoomedBounds.top * context.ZoomLevel());
 	zoomedBounds.right = ceilf(zoomedBounds.right * context.ZoomLevel());
 	zoomedBounds.bottom = ceilf(zoomedBounds.bottom * context.ZoomLevel());
-	if (fBitmap == NULL || zoomedBounds != fBitmap->Bounds()) {
-//printf("  resizing bitmap\n");
-		delete fBitmap;
-		fBitmap = new (nothrow) RenderBuffer(zoomedBounds);
-		if (!fBitmap->IsValid())
-			return;
-		fBitmap->Clear(zoomedBounds, (rgb_color){ 0, 0, 0, 0 });
-	}
+	fTiles->SetBounds(zoomedBounds);
 
 	ObjectSnapshot::Layout(context, flags);
 
+	// The cached composite depends on everything the objects inherit from
+	// the layer. If any of that changed, the cache is useless. The objects
+	// render with less quality in preview mode, that composite must not be
+	// used once the preview is refined, nor the other way around.
+	if (context.ZoomLevel() != fCacheZoomLevel
+		|| context.IsPreview() != fCachePreview
+		|| !equal_layout_states(LayoutedState(), fCacheLayoutState)) {
+		fLowestChangedIndex = 0;
+		fValidCacheRegion.MakeEmpty();
+		fCacheZoomLevel = context.ZoomLevel();
+		fCachePreview = context.IsPreview();
+		fCacheLayoutState = LayoutedState();
+		fCacheLayoutState.Opacity = LayoutedState().Opacity;
+	}
+	if (fCacheTiles != NULL && fCacheTiles->Bounds() != zoomedBounds) {
+		fCacheTiles->SetBounds(zoomedBounds);
+		fValidCacheRegion.MakeEmpty();
+	}
+
 	int32 count = CountObjects();
 	for (int32 i = 0; i < count; i++) {
 		ObjectSnapshot* snapshot = ObjectAtFast(i);
@@ -95,6 +180,9 @@ LayerSnapshot::Layout(LayoutContext& context, uint32 flags)
 
 		context.PopState();
 	}
+
+	_UpdateSpatialIndex();
+	_UpdateCompoundRuns();
 }
 
 // Render
@@ -105,11 +193,11 @@ LayerSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
 //printf("%p->LayerSnapshot::Render(BRect(%.1f, %.1f, %.1f, %.1f))\n", fOriginal,
 //area.left, area.top, area.right, area.bottom);
 	area = area & bitmap->Bounds();
-	if (fBitmap == NULL)
+	if (fTiles == NULL)
 		debugger("Layer bitmap not allocated!");
-	if (fBitmap->Bounds() != bitmap->Bounds())
-		debugger("Layer bitmap has wrong size!");
-	engine.BlendArea(fBitmap, area, fGlobalAlpha, fBlendingMode);
+
+	TRACE_SPAN_AREA("blend layer", TraceName(), area);
+	fTiles->BlendTo(engine, area, fGlobalAlpha, fBlendingMode);
 }
 
 // #pragma mark -
@@ -123,81 +211,152 @@ LayerSnapshot::Bounds() const
 
 // Render
 BRect
-LayerSnapshot::Render(RenderEngine& engine, BRect area, RenderBuffer* bitmap,
-	RenderBuffer* cacheBitmap, BRegion& validCacheRegion,
-	int32& cacheLevel) const
+LayerSnapshot::Render(RenderEngine& engine, BRect area,
+	RenderBuffer* bitmap) const
 {
 //printf("%p->LayerSnapshot::Render(BRect(%.1f, %.1f, %.1f, %.1f)) objects\n",
 //fOriginal, area.left, area.top, area.right, area.bottom);
-	area = area & bitmap->Bounds();
+	if (fTiles == NULL) {
+		printf("Layer bitmap is not allocated!\n");
+		return BRect();
+	}
+
+	area = area & fTiles->Bounds();
 	if (!area.IsValid())
 		return area;
 
-	// Check bitmap size matches (for debugging purposes)
-	if (fBitmap == NULL || bitmap->Bounds() != fBitmap->Bounds()) {
-		printf("Layer bitmap has wrong size or is not allocated!");
-		bitmap->Bounds().PrintToStream();
-		fBitmap->Bounds().PrintToStream();
-	}
-
-	// first pass, give every object snapshot a chance to
-	// extend the visually changed area, start with the lowest
-	// changed object
-	int32 count = CountObjects();
+	TRACE_SPAN_AREA("render layer", TraceName(), area);
 
+	// Only the objects which intersect the area take part in rendering it.
+	// Unbounded objects, like filters, always do, and only they extend the
+	// area that needs to be rebuilt below them. So once the complete
+	// rebuild area is known, the objects within it are all that is needed.
 	BRect visuallyChangedArea = area;
 
+	IndexList objects;
+	_QueryObjects(visuallyChangedArea, objects);
+	BRect rebuildArea = _RebuildArea(objects, visuallyChangedArea, NULL);
+	if (rebuildArea != visuallyChangedArea)
+		_QueryObjects(rebuildArea, objects);
+
 	// calculate the required *rebuild area* at each object
 	// index, from the top object to the lowest object
+	int32 count = objects.CountItems();
 	BRect dirtyAreas[count];
-	BRect rebuildArea = visuallyChangedArea;
-	for (int32 i = count - 1; i >= 0; i--) {
-		dirtyAreas[i] = rebuildArea;
-		ObjectSnapshot* object = ObjectAtFast(i);
-		if (object->IsVisible())
-			object->RebuildAreaForDirtyArea(rebuildArea);
-	}
+	rebuildArea = _RebuildArea(objects, visuallyChangedArea, dirtyAreas);
 
 	// begin rendering
 
-	rebuildArea = rebuildArea & bitmap->Bounds();
-
-	// start clean
-	uint8* bits = (uint8*)bitmap->Bits();
-	uint32 bytes = (rebuildArea.IntegerWidth() + 1) * 8;
-	uint32 height = rebuildArea.IntegerHeight() + 1;
-	uint32 bpr = bitmap->BytesPerRow();
+	rebuildArea = rebuildArea & fTiles->Bounds();
+
+	// The bitmap is only scratch space, it needs to hold just the area that
+	// is rebuilt.
+	if (bitmap->SetBounds(rebuildArea) != B_OK)
+		return BRect();
+
+	// The objects above the cache level need the composite of all objects
+	// below it within the area that the lowest of them is rebuilding.
+	int32 cacheLevel = min_c(fCacheLevel, CountObjects());
+	BRect cachedArea;
+	if (cacheLevel > 0) {
+		cachedArea = rebuildArea;
+		for (int32 i = count - 1; i >= 0; i--) {
+			if (objects.ItemAtFast(i) < cacheLevel) {
+				cachedArea = dirtyAreas[i] & bitmap->Bounds();
+				break;
+			}
+		}
+	}
 
-	bits += (int32)rebuildArea.top * bpr;
-	bits += (int32)rebuildArea.left * 8;
+	engine.AttachTo(bitmap);
 
-	// clean out bitmap
-	for (uint32 y = 0; y < height; y++) {
-		memset(bits, 0, bytes);
-		bits += bpr;
+	int32 firstObject = 0;
+	if (cacheLevel > 0 && _IsCached(cachedArea)) {
+		fCacheTiles->CopyTo(bitmap, cachedArea);
+		firstObject = cacheLevel;
+	} else {
+		// start clean
+		memset(bitmap->Bits(), 0, bitmap->BitsLength());
+
+		if (cacheLevel > 0) {
+			_RenderObjects(engine, bitmap, objects, dirtyAreas, 0,
+				cacheLevel - 1);
+			TRACE_SPAN_AREA("store layer cache", TraceName(), cachedArea);
+			_StoreCache(bitmap, cachedArea, area);
+			firstObject = cacheLevel;
+		}
 	}
 
 	// render objects
-	BRect layerBounds = bitmap->Bounds();
+	_RenderObjects(engine, bitmap, objects, dirtyAreas, firstObject,
+		CountObjects() - 1);
 
-	engine.AttachTo(bitmap);
+	// return the final visually changed area
+//printf("transfer: "); largestDirtyArea.PrintToStream();
+	fTiles->CopyFrom(bitmap, visuallyChangedArea);
+	return visuallyChangedArea;
+}
 
-	for (int32 i = 0; i < count; i++) {
-		ObjectSnapshot* object = ObjectAtFast(i);
-		if (!object->IsVisible())
-			continue;
-		object->PrepareRendering(layerBounds);
+// PrepareCache
+//
+// Called by the RenderManager after Sync() and Layout(), before the render
+// threads render the given region. Decides which objects are cached and
+// allocates the cache tiles for the region.
+void
+LayerSnapshot::PrepareCache(const BRegion& dirtyRegion, const BRect& cacheArea)
+{
+	if (fCacheTiles == NULL)
+		return;
+
+	if (fLowestChangedIndex != NOTHING_CHANGED) {
+		// Assume the same objects will keep changing, that's the case while
+		// the user is editing them. Everything below can be cached.
+		int32 cacheLevel = min_c(fLowestChangedIndex, CountObjects());
+		if (cacheLevel != fCacheLevel) {
+			fCacheTiles->MakeEmpty();
+			fValidCacheRegion.MakeEmpty();
+			fCacheLevel = cacheLevel;
+		}
+		fLowestChangedIndex = NOTHING_CHANGED;
+	}
 
-		engine.SetClipping(dirtyAreas[i]);
+	// Only keep the cache where the layer itself keeps tiles.
+	FreeCacheTiles(fCacheTiles->Bounds(), cacheArea);
 
-		object->Render(engine, bitmap, dirtyAreas[i]);
+	if (fCacheLevel == 0)
+		return;
+
+	int32 count = dirtyRegion.CountRects();
+	for (int32 i = 0; i < count; i++) {
+		if (fCacheTiles->AllocateTiles(dirtyRegion.RectAt(i)) != B_OK)
+			break;
 	}
+}
 
-	// return the final visually changed area
-	visuallyChangedArea = visuallyChangedArea & bitmap->Bounds();
-//printf("transfer: "); largestDirtyArea.PrintToStream();
-	bitmap->CopyTo(fBitmap, visuallyChangedArea);
-	return visuallyChangedArea;
+// FreeCacheTiles
+size_t
+LayerSnapshot::FreeCacheTiles(const BRect& area, const BRect& keepArea)
+{
+	if (fCacheTiles == NULL)
+		return 0;
+
+	// The keep area is the tile aligned cache area, so exactly the tiles
+	// outside of it are freed.
+	BRegion freedRegion(area);
+	if (keepArea.IsValid())
+		freedRegion.Exclude(keepArea);
+	fValidCacheRegion.Exclude(&freedRegion);
+
+	return fCacheTiles->FreeTiles(area, keepArea);
+}
+
+// CacheMemoryUsage
+size_t
+LayerSnapshot::CacheMemoryUsage() const
+{
+	if (fCacheTiles == NULL)
+		return 0;
+	return fCacheTiles->MemoryUsage();
 }
 
 // #pragma mark -
@@ -230,7 +389,7 @@ void
 LayerSnapshot::_Sync()
 {
 //printf("%p->LayerSnapshot::_Sync()\n", Original());
-	BList removedSnapshots;
+	SnapshotMap removedSnapshots;
 
 	int32 count = fOriginal->CountObjects();
 	int32 i = 0;
@@ -242,34 +401,29 @@ LayerSnapshot::_Sync()
 			if (snapshot->Original() == object) {
 				// correct snapshot already at index
 //printf("%p - [%ld] syncing %p\n", Original(), i, snapshot);
-				snapshot->Sync();
+				if (snapshot->Sync())
+					fLowestChangedIndex = min_c(fLowestChangedIndex, i);
 				break;
 			}
 			// delete all snapshots until they match again
 //printf("%p - [%ld] removing %p\n", Original(), i, snapshot);
 			fObjects.RemoveItem(i);
-			removedSnapshots.AddItem(snapshot);
+			if (removedSnapshots.Put(snapshot->Original(), snapshot) != B_OK)
+				delete snapshot;
 			snapshot = ObjectAt(i);
 		}
 
 		if (snapshot == NULL) {
+			fLowestChangedIndex = min_c(fLowestChangedIndex, i);
+
 			// create new snapshot of object at index
-			bool foundRemoved = false;
-			int32 removedCount = removedSnapshots.CountItems();
-			for (int32 j = 0; j < removedCount; j++) {
-				ObjectSnapshot* removedSnapshot
-					= reinterpret_cast<ObjectSnapshot*>(
-						removedSnapshots.ItemAtFast(j));
-				if (removedSnapshot->Original() == object) {
-					removedSnapshots.RemoveItem(j);
-					fObjects.AddItem(removedSnapshot);
+			ObjectSnapshot* removedSnapshot = removedSnapshots.Get(object);
+			if (removedSnapshot != NULL) {
+				removedSnapshots.RemoveKey(object);
+				fObjects.AddItem(removedSnapshot);
 //printf("%p - [%ld] syncing %p (removed)\n", Original(), i, removedSnapshot);
-					removedSnapshot->Sync();
-					foundRemoved = true;
-					break;
-				}
-			}
-			if (!foundRemoved) {
+				removedSnapshot->Sync();
+			} else {
 				snapshot = object->Snapshot();
 //printf("%p - [%ld] cloning %p\n", Original(), i, snapshot);
 				fObjects.AddItem(snapshot);
@@ -280,6 +434,8 @@ LayerSnapshot::_Sync()
 	// In case all object snapshots matched, we still need to remove
 	// any additional snapshots at the end.
 	count = CountObjects();
+	if (i < count)
+		fLowestChangedIndex = min_c(fLowestChangedIndex, i);
 	for (; i < count; i++) {
 		ObjectSnapshot* snapshot = reinterpret_cast<ObjectSnapshot*>(
 			fObjects.RemoveItem(i));
@@ -288,17 +444,115 @@ LayerSnapshot::_Sync()
 	}
 
 	// Delete the old snapshots we no longer needed
-	for (int32 i = removedSnapshots.CountItems() - 1; i >= 0; i--) {
-		ObjectSnapshot* snapshot = reinterpret_cast<ObjectSnapshot*>(
-			removedSnapshots.ItemAtFast(i));
+	SnapshotMap::Iterator iterator = removedSnapshots.GetIterator();
+	while (iterator.HasNext()) {
+		ObjectSnapshot* snapshot = iterator.Next()->Value;
 //printf("%p - deleting removed %p\n", Original(), snapshot);
 		delete snapshot;
 	}
 
+	_SyncProperties();
+//printf("%p->LayerSnapshot::_Sync() - done\n", Original());
+}
+
+// _SyncChanges
+//
+// Applies the changes journaled by the layer since it had the given change
+// counter, in the order in which they happened. Returns false if the object
+// list didn't end up matching the layer, in which case _Sync() needs to
+// compare all objects.
+bool
+LayerSnapshot::_SyncChanges(uint32 changeCounter)
+{
+	SnapshotMap removedSnapshots;
+	bool consistent = true;
+
+	int32 count = fOriginal->CountChanges();
+	for (int32 i = 0; i < count && consistent; i++) {
+		const ::Layer::Change& change = fOriginal->ChangeAt(i);
+		if (change.changeCounter <= changeCounter)
+			continue;
+
+		if (change.type == ::Layer::OBJECT_ADDED) {
+			// The object may have been removed again in the meantime, so it
+			// is not safe to access it. The snapshot is created from the
+			// objects in the layer once all changes have been applied.
+			consistent = fObjects.AddItem(NULL, change.index);
+		} else {
+			if (change.index < 0 || change.index >= CountObjects()) {
+				consistent = false;
+				break;
+			}
+			ObjectSnapshot* snapshot = ObjectAtFast(change.index);
+			if (snapshot != NULL && snapshot->Original() != change.object) {
+				consistent = false;
+				break;
+			}
+
+			if (change.type == ::Layer::OBJECT_REMOVED) {
+				fObjects.RemoveItem(change.index);
+				if (snapshot != NULL
+					&& removedSnapshots.Put(change.object, snapshot) != B_OK) {
+					delete snapshot;
+				}
+			} else if (snapshot == NULL || !snapshot->Sync()) {
+				// Either added since the last sync, or already synced
+				continue;
+			}
+		}
+
+		fLowestChangedIndex = min_c(fLowestChangedIndex, change.index);
+	}
+
+	count = CountObjects();
+	if (consistent && count != fOriginal->CountObjects())
+		consistent = false;
+
+	for (int32 i = count - 1; i >= 0; i--) {
+		if (ObjectAtFast(i) != NULL)
+			continue;
+
+		if (!consistent) {
+			fObjects.RemoveItem(i);
+			continue;
+		}
+
+		Object* object = fOriginal->ObjectAtFast(i);
+		ObjectSnapshot* snapshot = removedSnapshots.Get(object);
+		if (snapshot != NULL) {
+			removedSnapshots.RemoveKey(object);
+			snapshot->Sync();
+		} else
+			snapshot = object->Snapshot();
+
+		if (snapshot == NULL) {
+			fObjects.RemoveItem(i);
+			consistent = false;
+			continue;
+		}
+		fObjects.ReplaceItem(i, snapshot);
+	}
+
+	SnapshotMap::Iterator iterator = removedSnapshots.GetIterator();
+	while (iterator.HasNext())
+		delete iterator.Next()->Value;
+
+	if (!consistent) {
+		fLowestChangedIndex = 0;
+		return false;
+	}
+
+	_SyncProperties();
+	return true;
+}
+
+// _SyncProperties
+void
+LayerSnapshot::_SyncProperties()
+{
 	fBounds = fOriginal->Bounds();
 	fGlobalAlpha = fOriginal->GlobalAlpha();
 	fBlendingMode = fOriginal->BlendingMode();
-//printf("%p->LayerSnapshot::_Sync() - done\n", Original());
 }
 
 // _MakeEmpty
@@ -311,3 +565,283 @@ LayerSnapshot::_MakeEmpty()
 	fObjects.MakeEmpty();
 }
 
+// _UpdateSpatialIndex
+void
+LayerSnapshot::_UpdateSpatialIndex()
+{
+	int32 count = CountObjects();
+	while (fSpatialIndex.CountItems() > count)
+		fSpatialIndex.Remove(fSpatialIndex.CountItems() - 1);
+
+	for (int32 i = 0; i < count; i++) {
+		BRect bounds = ObjectAtFast(i)->LayoutedBounds();
+		status_t ret;
+		if (i < fSpatialIndex.CountItems())
+			ret = fSpatialIndex.Update(i, bounds);
+		else
+			ret = fSpatialIndex.Insert(i, bounds);
+		if (ret != B_OK) {
+			// _QueryObjects() falls back to using all objects.
+			fSpatialIndex.MakeEmpty();
+			break;
+		}
+	}
+}
+
+// _QueryObjects
+void
+LayerSnapshot::_QueryObjects(const BRect& area, IndexList& objects) const
+{
+	if (fSpatialIndex.CountItems() == CountObjects()
+		&& fSpatialIndex.Query(area, objects) == B_OK) {
+		return;
+	}
+
+	objects.Clear();
+	int32 count = CountObjects();
+	for (int32 i = 0; i < count; i++) {
+		if (!objects.Add(i))
+			break;
+	}
+}
+
+// _RebuildArea
+//
+// Gives every object, starting with the top one, a chance to extend the
+// area that needs to be rebuilt. Returns the area for the lowest object and
+// stores the area for each object in dirtyAreas, if given.
+BRect
+LayerSnapshot::_RebuildArea(const IndexList& objects, BRect area,
+	BRect* dirtyAreas) const
+{
+	for (int32 i = objects.CountItems() - 1; i >= 0; i--) {
+		if (dirtyAreas != NULL)
+			dirtyAreas[i] = area;
+		ObjectSnapshot* object = ObjectAtFast(objects.ItemAtFast(i));
+		if (object->IsVisible())
+			object->RebuildAreaForDirtyArea(area);
+	}
+	return area;
+}
+
+// _RenderObjects
+void
+LayerSnapshot::_RenderObjects(RenderEngine& engine, RenderBuffer* bitmap,
+	const IndexList& objects, const BRect* dirtyAreas, int32 first,
+	int32 last) const
+{
+	BRect layerBounds = fTiles->Bounds();
+
+	int32 count = objects.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		ObjectSnapshot* object = _ObjectToRender(objects, dirtyAreas, i,
+			first, last);
+		if (object == NULL)
+			continue;
+
+		if (_CompoundRun(objects.ItemAtFast(i)) >= 0) {
+			i = _RenderCompoundRun(engine, layerBounds, objects, dirtyAreas,
+				i, first, last);
+			continue;
+		}
+
+		object->PrepareRendering(layerBounds);
+
+		TRACE_SPAN_AREA("render object", object->TraceName(), dirtyAreas[i]);
+
+		engine.SetClipping(dirtyAreas[i]);
+
+		object->Render(engine, bitmap, dirtyAreas[i]);
+	}
+}
+
+// _ObjectToRender
+/*!	Returns the object at the given position of the query result, or
+	\c NULL if it is outside the range of objects to render, or does not
+	draw anything in its dirty area.
+*/
+ObjectSnapshot*
+LayerSnapshot::_ObjectToRender(const IndexList& objects,
+	const BRect* dirtyAreas, int32 i, int32 first, int32 last) const
+{
+	int32 index = objects.ItemAtFast(i);
+	if (index < first || index > last)
+		return NULL;
+
+	ObjectSnapshot* object = ObjectAtFast(index);
+	if (!object->IsVisible())
+		return NULL;
+
+	BRect bounds = object->LayoutedBounds();
+	if (bounds.IsValid() && !bounds.Intersects(dirtyAreas[i]))
+		return NULL;
+
+	return object;
+}
+
+// _UpdateCompoundRuns
+/*!	Finds the runs of shapes which are drawn together by
+	RenderEngine::RenderCompound(). Each object of a run gets the index of
+	the first object of the run, all other objects get -1. The runs only
+	depend on the objects, not on the area which is rendered, so the edges
+	of the shapes look the same in every tile. Invisible objects don't end
+	a run. The dirty areas of all shapes in a run are the same, since only
+	filters extend them and filters end a run.
+*/
+void
+LayerSnapshot::_UpdateCompoundRuns()
+{
+	fCompoundRuns.Clear();
+
+	int32 count = CountObjects();
+	for (int32 i = 0; i < count; i++) {
+		if (!fCompoundRuns.Add(-1)) {
+			fCompoundRuns.Clear();
+			return;
+		}
+	}
+
+	int32 start = 0;
+	while (start < count) {
+		if (compound_shape(ObjectAtFast(start)) == NULL) {
+			start++;
+			continue;
+		}
+
+		int32 shapeCount = 0;
+		int32 end = start;
+		for (int32 i = start; i < count; i++) {
+			ObjectSnapshot* object = ObjectAtFast(i);
+			if (!object->IsVisible())
+				continue;
+			if (compound_shape(object) == NULL)
+				break;
+			shapeCount++;
+			end = i;
+		}
+
+		if (shapeCount >= kMinCompoundRunLength) {
+			for (int32 i = start; i <= end; i++)
+				fCompoundRuns.Replace(i, start);
+		}
+
+		start = end + 1;
+	}
+}
+
+// _CompoundRun
+int32
+LayerSnapshot::_CompoundRun(int32 index) const
+{
+	if (index < 0 || index >= fCompoundRuns.CountItems())
+		return -1;
+	return fCompoundRuns.ItemAtFast(index);
+}
+
+// _RenderCompoundRun
+/*!	Draws the shapes of the compound run which starts at the given position
+	of the query result, one scanline block at a time. The shapes keep the
+	scanlines of their blocks, so they are not rasterized again. Returns the
+	position of the last object of the run.
+*/
+int32
+LayerSnapshot::_RenderCompoundRun(RenderEngine& engine,
+	const BRect& layerBounds, const IndexList& objects,
+	const BRect* dirtyAreas, int32 start, int32 first, int32 last) const
+{
+	int32 run = _CompoundRun(objects.ItemAtFast(start));
+
+	BList shapes;
+	int32 end = start;
+	int32 count = objects.CountItems();
+	for (int32 i = start; i < count; i++) {
+		if (_CompoundRun(objects.ItemAtFast(i)) != run)
+			break;
+		end = i;
+
+		ObjectSnapshot* object = _ObjectToRender(objects, dirtyAreas, i,
+			first, last);
+		if (object == NULL)
+			continue;
+
+		object->PrepareRendering(layerBounds);
+		if (!shapes.AddItem(object))
+			return end;
+	}
+
+	const BRect& area = dirtyAreas[start];
+
+	TRACE_SPAN_AREA("render compound", TraceName(), area);
+
+	engine.SetClipping(area);
+
+	int32 firstColumn = (int32)floorf(area.left / ShapeSnapshot::BLOCK_SIZE);
+	int32 lastColumn = (int32)floorf(area.right / ShapeSnapshot::BLOCK_SIZE);
+	int32 firstRow = (int32)floorf(area.top / ShapeSnapshot::BLOCK_SIZE);
+	int32 lastRow = (int32)floorf(area.bottom / ShapeSnapshot::BLOCK_SIZE);
+
+	int32 shapeCount = shapes.CountItems();
+	List<Reference<Referenceable>, false> blocks;
+
+	for (int32 row = firstRow; row <= lastRow; row++) {
+		for (int32 column = firstColumn; column <= lastColumn; column++) {
+			engine.ResetCompound();
+			// The blocks need to stay alive until the scanlines are
+			// rendered, another thread could drop them from the shape.
+			for (int32 i = 0; i < shapeCount; i++) {
+				ShapeSnapshot* shape
+					= static_cast<ShapeSnapshot*>(shapes.ItemAtFast(i));
+				blocks.Add(shape->AddToCompound(engine, column, row));
+			}
+			engine.RenderCompound();
+			blocks.Clear();
+		}
+	}
+
+	return end;
+}
+
+// _IsCached
+bool
+LayerSnapshot::_IsCached(const BRect& area) const
+{
+	AutoLocker<BLocker> locker(fCacheLock);
+	if (!locker.IsLocked())
+		return false;
+
+	BRegion missingRegion(area);
+	missingRegion.Exclude(&fValidCacheRegion);
+	return missingRegion.CountRects() == 0;
+}
+
+// _StoreCache
+//
+// Copies the area of the bitmap, which contains the composite of the
+// objects below the cache level, into the cache tiles.
+void
+LayerSnapshot::_StoreCache(const RenderBuffer* bitmap, const BRect& area,
+	const BRect& jobArea) const
+{
+	// Other render threads may be rendering neighboring tiles of this layer
+	// at the same time. Only the tiles of this job are written, and only
+	// where they are not yet valid, since others may be reading those parts.
+	BRegion storeRegion(area & TiledRenderBuffer::AlignToTiles(jobArea));
+	if (!storeRegion.Frame().IsValid()
+		|| !fCacheTiles->HasTiles(storeRegion.Frame())) {
+		return;
+	}
+
+	if (!fCacheLock.Lock())
+		return;
+	storeRegion.Exclude(&fValidCacheRegion);
+	fCacheLock.Unlock();
+
+	int32 count = storeRegion.CountRects();
+	for (int32 i = 0; i < count; i++)
+		fCacheTiles->CopyFrom(bitmap, storeRegion.RectAt(i));
+
+	if (!fCacheLock.Lock())
+		return;
+	fValidCacheRegion.Include(&storeRegion);
+	fCacheLock.Unlock();
+}
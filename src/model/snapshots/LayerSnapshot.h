@@ -6,14 +6,17 @@
 #define LAYER_SNAPSHOT_H
 
 #include <List.h>
+#include <Locker.h>
+#include <Region.h>
 
 #include "BlendingMode.h"
 #include "ObjectSnapshot.h"
+#include "SpatialIndex.h"
 
 class RenderBuffer;
-class BRegion;
 class Layer;
 class ObjectSnapshot;
+class TiledRenderBuffer;
 
 class LayerSnapshot : public ObjectSnapshot {
 public:
@@ -33,27 +36,83 @@ public:
 	inline	const ::Layer*		Layer() const
 									{ return fOriginal; }
 
-			RenderBuffer*		Bitmap() const	 { return fBitmap; }
+			TiledRenderBuffer*	Tiles() const	 { return fTiles; }
 			BRect				Bounds() const;
 
+			// Renders the objects within the area into the tiles of the
+			// layer. The bitmap is scratch space, it is moved to the area
+			// that needs to be rebuilt and may have any bounds before.
 			BRect				Render(RenderEngine& engine, BRect area,
-									RenderBuffer* bitmap,
-									RenderBuffer* cacheBitmap,
-									BRegion& validCacheRegion,
-									int32& cacheLevel) const;
+									RenderBuffer* bitmap) const;
+
+			// The layer caches the composite of all objects below the
+			// lowest object that changed, so that rendering can start from
+			// the cache while objects on top are being edited. The cache
+			// tiles may only be prepared or freed while no render thread
+			// is running.
+			void				PrepareCache(const BRegion& dirtyRegion,
+									const BRect& cacheArea);
+			size_t				FreeCacheTiles(const BRect& area,
+									const BRect& keepArea);
+			size_t				CacheMemoryUsage() const;
+			int32				CacheLevel() const
+									{ return fCacheLevel; }
 
 			ObjectSnapshot*		ObjectAt(int32 index) const;
 			ObjectSnapshot*		ObjectAtFast(int32 index) const;
 			int32				CountObjects() const;
 
  private:
+			class SnapshotMap;
+
 			void				_Sync();
+			bool				_SyncChanges(uint32 changeCounter);
+			void				_SyncProperties();
 			void				_MakeEmpty();
 
+			void				_UpdateSpatialIndex();
+			void				_QueryObjects(const BRect& area,
+									IndexList& objects) const;
+			BRect				_RebuildArea(const IndexList& objects,
+									BRect area, BRect* dirtyAreas) const;
+
+			void				_RenderObjects(RenderEngine& engine,
+									RenderBuffer* bitmap,
+									const IndexList& objects,
+									const BRect* dirtyAreas, int32 first,
+									int32 last) const;
+			ObjectSnapshot*		_ObjectToRender(const IndexList& objects,
+									const BRect* dirtyAreas, int32 i,
+									int32 first, int32 last) const;
+			void				_UpdateCompoundRuns();
+			int32				_CompoundRun(int32 index) const;
+			int32				_RenderCompoundRun(RenderEngine& engine,
+									const BRect& layerBounds,
+									const IndexList& objects,
+									const BRect* dirtyAreas, int32 start,
+									int32 first, int32 last) const;
+			bool				_IsCached(const BRect& area) const;
+			void				_StoreCache(const RenderBuffer* bitmap,
+									const BRect& area,
+									const BRect& jobArea) const;
+
 			const ::Layer*		fOriginal;
 			BList				fObjects;
+			SpatialIndex		fSpatialIndex;
+			// For each object the index of the first object of its
+			// compound run, or -1.
+			IndexList			fCompoundRuns;
 			BRect				fBounds;
-			RenderBuffer*		fBitmap;
+			TiledRenderBuffer*	fTiles;
+
+			TiledRenderBuffer*	fCacheTiles;
+			int32				fCacheLevel;
+			int32				fLowestChangedIndex;
+			LayoutState			fCacheLayoutState;
+			double				fCacheZoomLevel;
+			bool				fCachePreview;
+	mutable	BLocker				fCacheLock;
+	mutable	BRegion				fValidCacheRegion;
 			uint8				fGlobalAlpha;
 			::BlendingMode		fBlendingMode;
 };
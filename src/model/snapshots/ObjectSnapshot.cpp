@@ -5,12 +5,14 @@
 #include "ObjectSnapshot.h"
 
 #include "Object.h"
+#include "RenderTrace.h"
 
 // constructor
 ObjectSnapshot::ObjectSnapshot(const Object* object)
 	: Transformable(object->LocalTransformation())
 	, fChangeCounter(object->ChangeCounter())
 	, fIsVisible(object->IsVisible())
+	, fTraceName(object->Name())
 {
 }
 
@@ -31,6 +33,8 @@ ObjectSnapshot::Sync()
 	SetTransformable(Original()->LocalTransformation());
 	fChangeCounter = Original()->ChangeCounter();
 	fIsVisible = Original()->IsVisible();
+	if (RenderTrace::IsEnabled())
+		fTraceName = Original()->Name();
 	return true;
 }
 
@@ -88,4 +92,9 @@ ObjectSnapshot::RebuildAreaForDirtyArea(BRect& area) const
 	// outside that area, to be valid.
 }
 
-
+// LayoutedBounds
+BRect
+ObjectSnapshot::LayoutedBounds() const
+{
+	return BRect();
+}
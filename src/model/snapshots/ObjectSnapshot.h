@@ -6,6 +6,7 @@
 #define OBJECT_SNAPSHOT_H
 
 #include <Rect.h>
+#include <String.h>
 
 #include "LayoutContext.h"
 #include "LayoutState.h"
@@ -38,16 +39,30 @@ public:
 	virtual	void				RebuildAreaForDirtyArea(BRect& area) const;
 									// TODO: could be BRegions...
 
+	// The area in the layer bitmap that the object may render to, as of the
+	// last Layout(). An invalid rect means the object may affect any pixel.
+	virtual	BRect				LayoutedBounds() const;
+
 	inline	const LayoutState&	LayoutedState() const
 									{ return fLayoutedState; }
 
 	inline	bool				IsVisible() const
 									{ return fIsVisible; }
 
+	// The name of the object for the render traces. Render threads must
+	// not access the original object for it.
+	inline	const char*			TraceName() const
+									{ return fTraceName.String(); }
+
+protected:
+	inline	uint32				ChangeCounter() const
+									{ return fChangeCounter; }
+
 private:
 			uint32				fChangeCounter;
 			LayoutState			fLayoutedState;
 			bool				fIsVisible;
+			BString				fTraceName;
 };
 
 #endif // OBJECT_SNAPSHOT_H
@@ -5,38 +5,65 @@
 
 #include "ShapeSnapshot.h"
 
+#include <math.h>
+#include <new>
 #include <stdio.h>
 
 #include <agg_conv_contour.h>
 
 #include "AutoLocker.h"
+#include "RenderTrace.h"
 #include "Shape.h"
 
+// Enough blocks to cover a large screen with a margin around it.
+static const int32 kMaxBlockCount = 64;
+
+struct ShapeSnapshot::ScanlineBlock : public Referenceable {
+	ScanlineBlock(int32 column, int32 row)
+		: lock("scanline block")
+		, column(column)
+		, row(row)
+		, rasterized(false)
+		, lastUsage(0)
+	{
+	}
+
+	// Protects rasterizing the block, which happens outside the lock of the
+	// snapshot.
+	BLocker				lock;
+	int32				column;
+	int32				row;
+	bool				rasterized;
+	int32				lastUsage;
+
+	ScanlineContainer	fillScanlines;
+	ScanlineContainer	strokeScanlines;
+
+	CoverAllocator		coverAllocator;
+	SpanAllocator		spanAllocator;
+};
+
 // constructor
 ShapeSnapshot::ShapeSnapshot(const Shape* shape)
 	: StyleableSnapshot(shape)
 	, fOriginal(shape)
-	, fPathStorage()
+	, fPaths()
+	, fPathsChanged(true)
+	, fToleranceBucket(0)
+	, fFillingRule((agg::filling_rule_e)shape->FillMode())
 
 	, fRasterizerLock("shape lock")
 	, fNeedsRasterizing(1)
+	, fDocumentBounds()
 
-	, fRasterizer()
-
-	, fFillScanlines()
-	, fStrokeScanlines()
-
-	, fCoverAllocator()
-	, fSpanAllocator()
+	, fBlocks()
+	, fBlockUsage(0)
 {
-	shape->GetPath(fPathStorage);
-	fRasterizer.filling_rule((agg::filling_rule_e)shape->FillMode());
 }
 
 // destructor
 ShapeSnapshot::~ShapeSnapshot()
 {
-	_ClearScanlines();
 }
 
 // #pragma mark -
@@ -53,9 +80,8 @@ bool
 ShapeSnapshot::Sync()
 {
 	if (StyleableSnapshot::Sync()) {
-		fPathStorage.remove_all();
-		fOriginal->GetPath(fPathStorage);
-		fRasterizer.filling_rule((agg::filling_rule_e)fOriginal->FillMode());
+		fPathsChanged = true;
+		fFillingRule = (agg::filling_rule_e)fOriginal->FillMode();
 
 		atomic_set(&fNeedsRasterizing, 1);
 		return true;
@@ -71,9 +97,23 @@ ShapeSnapshot::Layout(LayoutContext& context, uint32 flags)
 	StyleableSnapshot::Layout(context, flags);
 	if (previous != LayoutedState().Matrix)
 		atomic_set(&fNeedsRasterizing, 1);
-}
 
-#define PRINT_TIMING 0
+	// Get the paths again if they changed or the curves need to be
+	// flattened with a different precision for the new scale. The
+	// Paths keep them, so this is cheap unless someone edited them.
+	double scaleX;
+	double scaleY;
+	LayoutedState().Matrix.GetScale(&scaleX, &scaleY);
+	double scale = max_c(scaleX, scaleY);
+	int32 toleranceBucket = FlattenedPath::ToleranceBucketFor(scale);
+	if (fPathsChanged || toleranceBucket != fToleranceBucket) {
+		fPaths.Clear();
+		fOriginal->GetFlattenedPaths(scale, fPaths);
+		fPathsChanged = false;
+		fToleranceBucket = toleranceBucket;
+		atomic_set(&fNeedsRasterizing, 1);
+	}
+}
 
 // PrepareRendering
 void
@@ -86,22 +126,14 @@ ShapeSnapshot::PrepareRendering(BRect documentBounds)
 	if (!lock.IsLocked())
 		return;
 
-	if (atomic_get(&fNeedsRasterizing) == 0) {
-#if PRINT_TIMING
-printf("PrepareRendering(): already prepared\n");
-#endif
+	if (atomic_get(&fNeedsRasterizing) == 0)
 		return;
-	}
-
-#if PRINT_TIMING
-bigtime_t now = system_time();
-#endif
 
-	_RasterizeShape(fRasterizer, documentBounds);
-
-#if PRINT_TIMING
-printf("PrepareRendering(): %lld\n", system_time() - now);
-#endif
+	// Forget the scanlines, the blocks are rasterized again when they are
+	// rendered. Blocks still in use by other threads are deleted after they
+	// are done with them.
+	fDocumentBounds = documentBounds;
+	fBlocks.Clear();
 
 	atomic_set(&fNeedsRasterizing, 0);
 }
@@ -111,91 +143,276 @@ void
 ShapeSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
 	BRect area) const
 {
+	area = area & fDocumentBounds;
+	BRect bounds = LayoutedBounds();
+	if (bounds.IsValid())
+		area = area & bounds;
+	if (!area.IsValid())
+		return;
+
 	PrepareRenderEngine(engine);
 	engine.SetTransformation(LayoutedState().Matrix);
 
-	engine.RenderScanlines(fFillScanlines, true);
-	engine.RenderScanlines(fStrokeScanlines, false);
+	int32 firstColumn = (int32)floorf(area.left / BLOCK_SIZE);
+	int32 lastColumn = (int32)floorf(area.right / BLOCK_SIZE);
+	int32 firstRow = (int32)floorf(area.top / BLOCK_SIZE);
+	int32 lastRow = (int32)floorf(area.bottom / BLOCK_SIZE);
+
+	for (int32 row = firstRow; row <= lastRow; row++) {
+		for (int32 column = firstColumn; column <= lastColumn; column++) {
+			ScanlineBlockRef block = _BlockAt(column, row);
+			if (block.Get() == NULL)
+				continue;
+			// The blocks don't overlap, the stroke of each block is only
+			// drawn on top of the fill of the same block.
+			engine.RenderScanlines(block->fillScanlines, true);
+			engine.RenderScanlines(block->strokeScanlines, false);
+		}
+	}
+}
+
+// CanRenderCompound
+/*!	Returns whether the shape can be drawn together with other shapes by
+	RenderEngine::RenderCompound(). That only works for opaque colors and
+	gradients, since each pixel is resolved by the front most style there.
+*/
+bool
+ShapeSnapshot::CanRenderCompound() const
+{
+	if (Opacity() != 255)
+		return false;
+	if (!_IsOpaque(FillPaint()))
+		return false;
+	if (StrokeProperties() != NULL && !_IsOpaque(StrokePaint()))
+		return false;
+	return true;
+}
+
+// AddToCompound
+/*!	Adds the scanlines of the fill and the stroke in the given block to the
+	compound of the engine. The stroke is added last, so it is in front of
+	the fill. Returns the block, which the caller needs to keep until the
+	compound is rendered.
+*/
+Reference<Referenceable>
+ShapeSnapshot::AddToCompound(RenderEngine& engine, int32 column,
+	int32 row) const
+{
+	BRect blockBounds(column * BLOCK_SIZE, row * BLOCK_SIZE,
+		(column + 1) * BLOCK_SIZE - 1, (row + 1) * BLOCK_SIZE - 1);
+	BRect bounds = LayoutedBounds();
+	if (bounds.IsValid() && !bounds.Intersects(blockBounds))
+		return Reference<Referenceable>();
+
+	ScanlineBlockRef block = _BlockAt(column, row);
+	if (block.Get() == NULL)
+		return Reference<Referenceable>();
+
+	if (_HasPaint(FillPaint())) {
+		engine.AddCompoundScanlines(block->fillScanlines, FillPaint(),
+			LayoutedState().Matrix);
+	}
+	if (_HasPaint(StrokePaint()) && StrokeProperties() != NULL) {
+		engine.AddCompoundScanlines(block->strokeScanlines, StrokePaint(),
+			LayoutedState().Matrix);
+	}
+
+	return Reference<Referenceable>(block.Get());
+}
+
+// #pragma mark -
+
+// _BlockAt
+/*!	Returns the block with the given grid position, rasterizing it if that
+	did not happen yet. The least recently used block is dropped when there
+	are too many. The block is added to the list right away, but rasterized
+	without holding the lock of the snapshot, so that other threads can get
+	their blocks in the meantime. Threads asking for the same block wait
+	until it is ready.
+*/
+ShapeSnapshot::ScanlineBlockRef
+ShapeSnapshot::_BlockAt(int32 column, int32 row) const
+{
+	ScanlineBlockRef block;
+
+	{
+		AutoLocker<BLocker> lock(fRasterizerLock);
+		if (!lock.IsLocked())
+			return ScanlineBlockRef();
+
+		int32 count = fBlocks.CountItems();
+		for (int32 i = 0; i < count; i++) {
+			const ScanlineBlockRef& candidate = fBlocks.ItemAtFast(i);
+			if (candidate->column == column && candidate->row == row) {
+				block = candidate;
+				break;
+			}
+		}
+
+		if (block.Get() == NULL) {
+			block.SetTo(new(std::nothrow) ScanlineBlock(column, row), true);
+			if (block.Get() == NULL || !fBlocks.Add(block))
+				return ScanlineBlockRef();
+			// The new block is the most recently used one, it is never
+			// dropped right away.
+			block->lastUsage = ++fBlockUsage;
+			_DropOldestBlock(fBlocks.CountItems() - 1);
+		} else
+			block->lastUsage = ++fBlockUsage;
+	}
+
+	AutoLocker<BLocker> lock(block->lock);
+	if (!lock.IsLocked())
+		return ScanlineBlockRef();
+
+	if (!block->rasterized) {
+		TRACE_SPAN_AREA("rasterize shape", TraceName(),
+			BRect(column * BLOCK_SIZE, row * BLOCK_SIZE,
+				(column + 1) * BLOCK_SIZE - 1, (row + 1) * BLOCK_SIZE - 1));
+
+		_RasterizeBlock(block.Get());
+		block->rasterized = true;
+	}
+
+	return block;
 }
 
-// _RasterizeShape
+// _DropOldestBlock
+/*!	Drops the least recently used block, if there are too many, but never
+	the one at the given index. Threads which still use the dropped block
+	keep it alive until they are done. The rasterizer lock needs to be held.
+*/
 void
-ShapeSnapshot::_RasterizeShape(Rasterizer& rasterizer, BRect bounds)
+ShapeSnapshot::_DropOldestBlock(int32 keepIndex) const
 {
-	_ClearScanlines();
+	int32 count = fBlocks.CountItems();
+	if (count <= kMaxBlockCount)
+		return;
 
-	rasterizer.clip_box(bounds.left, bounds.top, bounds.right + 1,
-		bounds.bottom + 1);
+	int32 oldestIndex = -1;
+	for (int32 i = 0; i < count; i++) {
+		if (i == keepIndex)
+			continue;
+		const ScanlineBlockRef& candidate = fBlocks.ItemAtFast(i);
+		if (oldestIndex < 0 || candidate->lastUsage
+				< fBlocks.ItemAtFast(oldestIndex)->lastUsage) {
+			oldestIndex = i;
+		}
+	}
+	if (oldestIndex >= 0)
+		fBlocks.Remove(oldestIndex);
+}
 
-	if (FillPaint() != NULL && FillPaint()->Type() != Paint::NONE) {
-		TransformedPath transformedPath(fPathStorage, LayoutedState().Matrix);
-		CurvedPath curvedPath(transformedPath);
-	
-		rasterizer.add_path(curvedPath);
-		_StoreScanlines(rasterizer, fFillScanlines);
-		rasterizer.reset();
+// _HasPaint
+/*static*/ bool
+ShapeSnapshot::_HasPaint(const Paint* paint)
+{
+	return paint != NULL && paint->Type() != Paint::NONE;
+}
+
+// _IsOpaque
+/*static*/ bool
+ShapeSnapshot::_IsOpaque(const Paint* paint)
+{
+	if (!_HasPaint(paint))
+		return true;
+	return (paint->Type() == Paint::COLOR || paint->Type() == Paint::GRADIENT)
+		&& !paint->HasTransparency();
+}
+
+// _AddFillPaths
+void
+ShapeSnapshot::_AddFillPaths(Rasterizer& rasterizer) const
+{
+	int32 count = fPaths.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		FlattenedPath::Iterator path(fPaths.ItemAtFast(i).Get());
+		agg::conv_transform<FlattenedPath::Iterator, Transformation>
+			transformedPath(path, LayoutedState().Matrix);
+
+		rasterizer.add_path(transformedPath);
 	}
-	if (StrokePaint() != NULL
-		&& StrokePaint()->Type() != Paint::NONE
-		&& StrokeProperties() != NULL) {
-		if (StrokeProperties()->StrokePosition() == CenterStroke) {
-			agg::conv_curve<PathStorage> curvedPath(fPathStorage);
+}
 
-			agg::conv_stroke<agg::conv_curve<PathStorage> > strokedPath(
-				curvedPath);
+// _AddStrokePaths
+void
+ShapeSnapshot::_AddStrokePaths(Rasterizer& rasterizer) const
+{
+	double scale = FlattenedPath::ScaleFor(fToleranceBucket);
+	int32 count = fPaths.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		FlattenedPath::Iterator path(fPaths.ItemAtFast(i).Get());
+		if (StrokeProperties()->StrokePosition() == CenterStroke) {
+			agg::conv_stroke<FlattenedPath::Iterator> strokedPath(path);
 			StrokeProperties()->SetupAggConverter(strokedPath);
-	
-			agg::conv_transform<agg::conv_stroke<agg::conv_curve<PathStorage> >,
+			strokedPath.approximation_scale(scale);
+
+			agg::conv_transform<agg::conv_stroke<FlattenedPath::Iterator>,
 				Transformation>
 				transformedPath(strokedPath, LayoutedState().Matrix);
-	
+
 			rasterizer.add_path(transformedPath);
 		} else {
-			agg::conv_curve<PathStorage> curvedPath(fPathStorage);
-
-			agg::conv_contour<agg::conv_curve<PathStorage> > offsetPath(
-				curvedPath);
+			agg::conv_contour<FlattenedPath::Iterator> offsetPath(path);
 			if (StrokeProperties()->StrokePosition() == InsideStroke)
 				offsetPath.width(-StrokeProperties()->Width());
 			else
 				offsetPath.width(StrokeProperties()->Width());
 			offsetPath.auto_detect_orientation(true);
+			offsetPath.approximation_scale(scale);
 
-			agg::conv_stroke<agg::conv_contour<agg::conv_curve<PathStorage> > >
+			agg::conv_stroke<agg::conv_contour<FlattenedPath::Iterator> >
 				strokedPath(offsetPath);
 			StrokeProperties()->SetupAggConverter(strokedPath);
+			strokedPath.approximation_scale(scale);
 //			strokedPath.inner_join(agg::inner_miter);
-	
+
 			agg::conv_transform<
 				agg::conv_stroke<agg::conv_contour<
-				agg::conv_curve<PathStorage> > >,
+				FlattenedPath::Iterator> >,
 				Transformation>
 				transformedPath(strokedPath, LayoutedState().Matrix);
-	
+
 			rasterizer.add_path(transformedPath);
 		}
-		_StoreScanlines(rasterizer, fStrokeScanlines);
-		rasterizer.reset();
 	}
-
-	_ValidateScanlines(fFillScanlines);
-	_ValidateScanlines(fStrokeScanlines);
 }
 
-// _ClearScanlines
+// _RasterizeBlock
 void
-ShapeSnapshot::_ClearScanlines()
+ShapeSnapshot::_RasterizeBlock(ScanlineBlock* block) const
 {
-	fCoverAllocator.Clear();
-	fSpanAllocator.Clear();
-	fFillScanlines.Clear();
-	fStrokeScanlines.Clear();
+	BRect bounds(block->column * BLOCK_SIZE, block->row * BLOCK_SIZE,
+		(block->column + 1) * BLOCK_SIZE - 1,
+		(block->row + 1) * BLOCK_SIZE - 1);
+	bounds = bounds & fDocumentBounds;
+	if (!bounds.IsValid())
+		return;
+
+	Rasterizer rasterizer;
+	rasterizer.filling_rule(fFillingRule);
+	rasterizer.clip_box(bounds.left, bounds.top, bounds.right + 1,
+		bounds.bottom + 1);
+
+	if (_HasPaint(FillPaint())) {
+		_AddFillPaths(rasterizer);
+		_StoreScanlines(rasterizer, block, block->fillScanlines);
+		rasterizer.reset();
+	}
+	if (_HasPaint(StrokePaint()) && StrokeProperties() != NULL) {
+		_AddStrokePaths(rasterizer);
+		_StoreScanlines(rasterizer, block, block->strokeScanlines);
+		rasterizer.reset();
+	}
+
+	_ValidateScanlines(block->fillScanlines);
+	_ValidateScanlines(block->strokeScanlines);
 }
 
 // _StoreScanlines
 void
-ShapeSnapshot::_StoreScanlines(Rasterizer& rasterizer,
-	ScanlineContainer& container)
+ShapeSnapshot::_StoreScanlines(Rasterizer& rasterizer, ScanlineBlock* block,
+	ScanlineContainer& container) const
 {
 	// generate scanlines
 	if (!rasterizer.rewind_scanlines())
@@ -206,7 +423,7 @@ ShapeSnapshot::_StoreScanlines(Rasterizer& rasterizer,
 		scanline = container.AppendObject();
 		if (scanline == NULL)
 			return;
-		scanline->SetAllocators(&fCoverAllocator, &fSpanAllocator);
+		scanline->SetAllocators(&block->coverAllocator, &block->spanAllocator);
 		scanline->reset(rasterizer.min_x(), rasterizer.max_x());
 	} while (rasterizer.sweep_scanline(*scanline));
 
@@ -217,7 +434,7 @@ ShapeSnapshot::_StoreScanlines(Rasterizer& rasterizer,
 
 // _ValidateScanlines
 void
-ShapeSnapshot::_ValidateScanlines(ScanlineContainer& container)
+ShapeSnapshot::_ValidateScanlines(ScanlineContainer& container) const
 {
 	// Validate the data to avoid stale pointers after relocation of
 	// memory buffers.
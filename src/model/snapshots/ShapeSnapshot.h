@@ -11,15 +11,24 @@
 #include <Locker.h>
 #include <Rect.h>
 
+#include "FlattenedPath.h"
+#include "List.h"
 #include "Referenceable.h"
 #include "RenderEngine.h"
 #include "StyleableSnapshot.h"
+#include "TiledRenderBuffer.h"
 
 class Shape;
 
 
 class ShapeSnapshot : public StyleableSnapshot {
 public:
+	enum {
+		// The scanlines are kept in blocks which are aligned with the
+		// tiles of the layer bitmaps.
+		BLOCK_SIZE = 2 * TiledRenderBuffer::TILE_SIZE
+	};
+
 								ShapeSnapshot(const Shape* shape);
 	virtual						~ShapeSnapshot();
 
@@ -32,29 +41,48 @@ public:
 	virtual	void				Render(RenderEngine& engine,
 									RenderBuffer* bitmap, BRect area) const;
 
+			bool				CanRenderCompound() const;
+			Reference<Referenceable> AddToCompound(RenderEngine& engine,
+									int32 column, int32 row) const;
+
 private:
-			void				_RasterizeShape(Rasterizer& rasterizer,
-									BRect documentBounds);
-			void				_ClearScanlines();
+			struct ScanlineBlock;
+			typedef Reference<ScanlineBlock> ScanlineBlockRef;
+			typedef List<ScanlineBlockRef, false> BlockList;
+
+			ScanlineBlockRef	_BlockAt(int32 column, int32 row) const;
+			void				_DropOldestBlock(int32 keepIndex) const;
+			void				_RasterizeBlock(ScanlineBlock* block) const;
 			void				_StoreScanlines(Rasterizer& rasterizer,
-									ScanlineContainer& container);
+									ScanlineBlock* block,
+									ScanlineContainer& container) const;
 			void				_ValidateScanlines(
-									ScanlineContainer& container);
+									ScanlineContainer& container) const;
+
+	static	bool				_HasPaint(const Paint* paint);
+	static	bool				_IsOpaque(const Paint* paint);
+
+			void				_AddFillPaths(Rasterizer& rasterizer) const;
+			void				_AddStrokePaths(
+									Rasterizer& rasterizer) const;
 
 private:
 			const Shape*		fOriginal;
-			PathStorage			fPathStorage;
-
-			BLocker				fRasterizerLock;
+			// The paths flattened for the scale of the layout, shared with
+			// the Paths of the Shape.
+			FlattenedPathList	fPaths;
+			bool				fPathsChanged;
+			int32				fToleranceBucket;
+			agg::filling_rule_e	fFillingRule;
+
+	mutable	BLocker				fRasterizerLock;
 			int32				fNeedsRasterizing;
+			BRect				fDocumentBounds;
 
-			Rasterizer			fRasterizer;
-
-			ScanlineContainer	fFillScanlines;
-			ScanlineContainer	fStrokeScanlines;
-
-			CoverAllocator		fCoverAllocator;
-			SpanAllocator		fSpanAllocator;
+			// The scanlines of the shape, rasterized in square blocks when
+			// they are first rendered. Only recently used blocks are kept.
+	mutable	BlockList			fBlocks;
+	mutable	int32				fBlockUsage;
 };
 
 #endif // SHAPE_SNAPSHOT_H
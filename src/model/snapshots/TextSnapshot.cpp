@@ -4,27 +4,66 @@
  */
 #include "TextSnapshot.h"
 
+#include <new>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "support.h"
 
+#include "AutoLocker.h"
 #include "FontCache.h"
+#include "HashMapHugo.h"
 #include "RenderBuffer.h"
 #include "RenderEngine.h"
+#include "RenderTrace.h"
 #include "Text.h"
 #include "TextRenderer.h"
 
+struct TextSnapshot::ColorRun {
+	TextRenderer::Color	color;
+	ScanlineContainer	scanlines;
+};
+
+// same_color
+static inline bool
+same_color(const TextRenderer::Color& a, const TextRenderer::Color& b)
+{
+	return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
 // constructor
 TextSnapshot::TextSnapshot(const Text* text)
 	: StyleableSnapshot(text)
 	, fOriginal(text)
 	, fTextLayout(text->getTextLayout())
+
+	, fGlyphs()
+	, fGlyphData(NULL)
+	, fGlyphDataSize(0)
+	, fHasDecorations(false)
+
+	, fRasterizerLock("text lock")
+	, fNeedsRasterizing(1)
+
+	, fRasterizer()
+
+	, fColorRuns()
+
+	, fCoverAllocator()
+	, fSpanAllocator()
 {
+	// Same gamma as the TextRenderer
+	fRasterizer.gamma(agg::gamma_power(1.0 / 2.2));
+
+	_CopyGlyphs();
 }
 
 // destructor
 TextSnapshot::~TextSnapshot()
 {
+	_ClearScanlines();
+	free(fGlyphData);
 }
 
 // #pragma mark -
@@ -42,25 +81,284 @@ TextSnapshot::Sync()
 {
 	if (StyleableSnapshot::Sync()) {
 		fTextLayout = fOriginal->getTextLayout();
+		_CopyGlyphs();
+
+		atomic_set(&fNeedsRasterizing, 1);
 		return true;
 	}
 	return false;
 }
 
+// Layout
+void
+TextSnapshot::Layout(LayoutContext& context, uint32 flags)
+{
+	Transformable previous = LayoutedState().Matrix;
+	StyleableSnapshot::Layout(context, flags);
+	if (previous != LayoutedState().Matrix)
+		atomic_set(&fNeedsRasterizing, 1);
+}
+
+// PrepareRendering
+void
+TextSnapshot::PrepareRendering(BRect documentBounds)
+{
+	if (fHasDecorations || atomic_get(&fNeedsRasterizing) == 0)
+		return;
+
+	AutoLocker<BLocker> lock(fRasterizerLock);
+	if (!lock.IsLocked())
+		return;
+
+	if (atomic_get(&fNeedsRasterizing) == 0)
+		return;
+
+	TRACE_SPAN_AREA("rasterize text", TraceName(), LayoutedBounds());
+
+	_RasterizeGlyphs(documentBounds);
+
+	atomic_set(&fNeedsRasterizing, 0);
+}
+
 // Render
 void
 TextSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
 	BRect area) const
 {
+	if (fHasDecorations) {
+		_RenderDecoratedText(bitmap);
+		return;
+	}
+
 	PrepareRenderEngine(engine);
 
+	int32 count = fColorRuns.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		const ColorRun* run = fColorRuns.ItemAtFast(i);
+		engine.RenderScanlines(run->scanlines, run->color);
+	}
+}
+
+// #pragma mark -
+
+// _CopyGlyphs
+/*!	Copies the outlines of all glyphs in the layout. The TextLayout only
+	references the glyphs in the FontCache, which may drop them at any time
+	after the read lock is released, and reading the outlines with the
+	adaptors of the FontEngine is not safe from multiple threads.
+*/
+void
+TextSnapshot::_CopyGlyphs()
+{
+	fGlyphs.Clear();
+	fGlyphDataSize = 0;
+	fHasDecorations = false;
+
+	// Usually the Text has already layouted the text, in which case the
+	// buffers of the layout are still shared with it.
+	fTextLayout.validateLayout();
+
+	FontCache* fontCache = FontCache::getInstance();
+	if (!fontCache->ReadLock())
+		return;
+
+	// Glyphs which occur more than once are only copied once.
+	HashMap<HashKey64<uint64>, size_t> dataOffsets;
+
+	int count = fTextLayout.getGlyphCount();
+	for (int index = 0; index < count; index++) {
+		const agg::glyph_cache* glyph;
+		double x;
+		double y;
+		double height;
+		double fauxWeight = 0.0;
+		double fauxItalic = 0.0;
+		TextRenderer::Color fg(0, 0, 0, (255 << 8) | 255);
+		bool strikeOut = false;
+		TextRenderer::Color strikeColor(fg);
+		bool underline = false;
+		unsigned underlineStyle = 0;
+		TextRenderer::Color underlineColor(fg);
+
+		fTextLayout.getInfo(index, &glyph, &x, &y, &height, &fauxWeight,
+			&fauxItalic, fg, strikeOut, strikeColor, underline,
+			underlineStyle, underlineColor);
+
+		if (strikeOut || underline)
+			fHasDecorations = true;
+
+		if (glyph == NULL || glyph->data_type != agg::glyph_data_outline)
+			continue;
+
+		HashKey64<uint64> key((uint64)(addr_t)glyph);
+		size_t dataOffset;
+		if (dataOffsets.ContainsKey(key)) {
+			dataOffset = dataOffsets.Get(key);
+		} else {
+			dataOffset = fGlyphDataSize;
+			uint8* data = (uint8*)realloc(fGlyphData,
+				fGlyphDataSize + glyph->data_size);
+			if (data == NULL || dataOffsets.Put(key, dataOffset) != B_OK) {
+				if (data != NULL)
+					fGlyphData = data;
+				break;
+			}
+			fGlyphData = data;
+			memcpy(fGlyphData + dataOffset, glyph->data, glyph->data_size);
+			fGlyphDataSize += glyph->data_size;
+		}
+
+		GlyphInfo info;
+		info.dataOffset = dataOffset;
+		info.dataSize = glyph->data_size;
+		info.x = x;
+		info.y = y;
+		info.height = glyph->height;
+		info.fauxWeight = fauxWeight;
+		info.fauxItalic = fauxItalic;
+		info.color = fg;
+		if (!fGlyphs.Add(info))
+			break;
+	}
+
+	fontCache->ReadUnlock();
+}
+
+// _RasterizeGlyphs
+/*!	Transforms the glyphs in the same way as the TextRenderer does, but
+	rasterizes all glyphs of one color at once into a ScanlineContainer.
+*/
+void
+TextSnapshot::_RasterizeGlyphs(BRect bounds)
+{
+	_ClearScanlines();
+
+	fRasterizer.reset();
+	fRasterizer.clip_box(bounds.left, bounds.top, bounds.right + 1,
+		bounds.bottom + 1);
+
+	Transformation baseMatrix = LayoutedState().Matrix;
+	Transformation matrix;
+
+	TextRenderer::PathAdaptor pathAdaptor;
+	TextRenderer::Glyph glyph(pathAdaptor);
+	TextRenderer::TransformedGlyph transformedGlyph(glyph, matrix);
+	TextRenderer::FauxWeightGlyph fauxWeightGlyph(transformedGlyph);
+
+	glyph.approximation_scale(baseMatrix.scale());
+
+	const double scaleX = TextRenderer::AUTO_HINT_SCALE;
+
+	ColorRun* run = NULL;
+
+	int32 count = fGlyphs.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		const GlyphInfo& info = fGlyphs.ItemAtFast(i);
+
+		if (run == NULL || !same_color(run->color, info.color)) {
+			if (run != NULL) {
+				_StoreScanlines(fRasterizer, run->scanlines);
+				fRasterizer.reset();
+			}
+			run = new(std::nothrow) ColorRun;
+			if (run == NULL || !fColorRuns.Add(run)) {
+				delete run;
+				return;
+			}
+			run->color = info.color;
+		}
+
+		pathAdaptor.init(fGlyphData + info.dataOffset, info.dataSize, 0, 0);
+
+		// The TextRenderer uses hinting, which rounds the baseline.
+		double ty = floor(info.y + 0.5);
+
+		matrix.reset();
+		matrix *= agg::trans_affine_scaling(1.0 / scaleX, 1);
+		matrix *= agg::trans_affine_skewing(info.fauxItalic / 3, 0);
+		matrix *= agg::trans_affine_translation(info.x / scaleX, ty);
+		matrix *= baseMatrix;
+
+		if (fabs(info.fauxWeight) < 0.05) {
+			fRasterizer.add_path(transformedGlyph);
+		} else {
+			fauxWeightGlyph.weight(-info.fauxWeight * info.height / 15);
+			fRasterizer.add_path(fauxWeightGlyph);
+		}
+	}
+
+	if (run != NULL) {
+		_StoreScanlines(fRasterizer, run->scanlines);
+		fRasterizer.reset();
+	}
+
+	// Validate the data to avoid stale pointers after relocation of
+	// memory buffers.
+	for (int32 i = 0; i < fColorRuns.CountItems(); i++) {
+		ScanlineContainer& scanlines = fColorRuns.ItemAtFast(i)->scanlines;
+		uint32 scanlineCount = scanlines.CountObjects();
+		for (uint32 j = 0; j < scanlineCount; j++)
+			scanlines.ObjectAtFast(j)->Validate();
+	}
+}
+
+// _ClearScanlines
+void
+TextSnapshot::_ClearScanlines()
+{
+	for (int32 i = 0; i < fColorRuns.CountItems(); i++)
+		delete fColorRuns.ItemAtFast(i);
+	fColorRuns.Clear();
+
+	fCoverAllocator.Clear();
+	fSpanAllocator.Clear();
+}
+
+// _StoreScanlines
+void
+TextSnapshot::_StoreScanlines(Rasterizer& rasterizer,
+	ScanlineContainer& container)
+{
+	// generate scanlines
+	if (!rasterizer.rewind_scanlines())
+		return;
+
+	Scanline* scanline;
+	do {
+		scanline = container.AppendObject();
+		if (scanline == NULL)
+			return;
+		scanline->SetAllocators(&fCoverAllocator, &fSpanAllocator);
+		scanline->reset(rasterizer.min_x(), rasterizer.max_x());
+	} while (rasterizer.sweep_scanline(*scanline));
+
+	// The last added scanline was not used anymore, so just remove it
+	// again.
+	container.RemoveObject();
+}
+
+// _RenderDecoratedText
+/*!	Strike-out and underline bars are drawn by the TextRenderer, which
+	needs the glyphs from the FontCache.
+*/
+void
+TextSnapshot::_RenderDecoratedText(RenderBuffer* bitmap) const
+{
+	// The bitmap may not start at 0, 0, it is attached like the RenderEngine
+	// does it and clipped to its pixels.
+	if (bitmap->Left() < 0 || bitmap->Top() < 0)
+		return;
+
 	TextRenderer renderer(FontCache::getInstance());
 	renderer.attachToBuffer(
-		bitmap->Bits(),
-		bitmap->Width(),
-		bitmap->Height(),
+		bitmap->Bits() - bitmap->Top() * bitmap->BytesPerRow()
+			- bitmap->Left() * 8,
+		bitmap->Left() + bitmap->Width(),
+		bitmap->Top() + bitmap->Height(),
 		bitmap->BytesPerRow()
 	);
+	renderer.setClipping(bitmap->Left(), bitmap->Top(),
+		bitmap->Width() - 1, bitmap->Height() - 1);
 	renderer.setTransformation(LayoutedState().Matrix);
 	renderer.setGrayScale(true);
 
@@ -75,5 +373,3 @@ TextSnapshot::Render(RenderEngine& engine, RenderBuffer* bitmap,
 		FontCache::getInstance()->ReadUnlock();
 	}
 }
-
-
@@ -6,7 +6,10 @@
 #define TEXT_SNAPSHOT_H
 
 #include <GraphicsDefs.h>
+#include <Locker.h>
 
+#include "List.h"
+#include "RenderEngine.h"
 #include "StyleableSnapshot.h"
 #include "TextLayout.h"
 
@@ -20,12 +23,60 @@ public:
 	virtual	const Object*		Original() const;
 	virtual	bool				Sync();
 
+	virtual	void				Layout(LayoutContext& context, uint32 flags);
+
+	virtual	void				PrepareRendering(BRect documentBounds);
 	virtual	void				Render(RenderEngine& engine,
 									RenderBuffer* bitmap, BRect area) const;
 
+private:
+			// A glyph of the layout which has an outline to draw.
+			struct GlyphInfo {
+				size_t			dataOffset;
+				unsigned		dataSize;
+				double			x;
+				double			y;
+				double			height;
+				double			fauxWeight;
+				double			fauxItalic;
+				agg::rgba16		color;
+			};
+
+			struct ColorRun;
+
+			typedef List<GlyphInfo, true>	GlyphList;
+			typedef List<ColorRun*, true>	ColorRunList;
+
+			void				_CopyGlyphs();
+			void				_RasterizeGlyphs(BRect documentBounds);
+			void				_ClearScanlines();
+			void				_StoreScanlines(Rasterizer& rasterizer,
+									ScanlineContainer& container);
+			void				_RenderDecoratedText(
+									RenderBuffer* bitmap) const;
+
 private:
 			const Text*			fOriginal;
 			TextLayout			fTextLayout;
+
+			// Copies of the glyph outlines used by the layout, so that
+			// rasterizing does not depend on the FontCache.
+			GlyphList			fGlyphs;
+			uint8*				fGlyphData;
+			size_t				fGlyphDataSize;
+			bool				fHasDecorations;
+
+			BLocker				fRasterizerLock;
+			int32				fNeedsRasterizing;
+
+			Rasterizer			fRasterizer;
+
+			// The coverage of the glyphs for each run of glyphs with the
+			// same color, built in PrepareRendering().
+			ColorRunList		fColorRuns;
+
+			CoverAllocator		fCoverAllocator;
+			SpanAllocator		fSpanAllocator;
 };
 
 #endif // TEXT_SNAPSHOT_H
@@ -0,0 +1,60 @@
+#include "BBitmapStream.h"
+
+#include "BBitmap.h"
+
+
+BBitmapStream::BBitmapStream(BBitmap* bitmap)
+	:
+	fBitmap(bitmap),
+	fDetached(false)
+{
+}
+
+
+BBitmapStream::~BBitmapStream()
+{
+	if (!fDetached)
+		delete fBitmap;
+}
+
+
+ssize_t
+BBitmapStream::ReadAt(off_t position, void* buffer, size_t size)
+{
+	return B_NOT_SUPPORTED;
+}
+
+
+ssize_t
+BBitmapStream::WriteAt(off_t position, const void* buffer, size_t size)
+{
+	return B_NOT_SUPPORTED;
+}
+
+
+off_t
+BBitmapStream::Seek(off_t position, uint32 seekMode)
+{
+	return B_NOT_SUPPORTED;
+}
+
+
+off_t
+BBitmapStream::Position() const
+{
+	return 0;
+}
+
+
+status_t
+BBitmapStream::DetachBitmap(BBitmap** _bitmap)
+{
+	if (_bitmap == NULL)
+		return B_BAD_VALUE;
+	if (fBitmap == NULL || fDetached)
+		return B_ERROR;
+
+	fDetached = true;
+	*_bitmap = fBitmap;
+	return B_OK;
+}
@@ -0,0 +1,38 @@
+#ifndef PLATFORM_QT_B_BITMAP_STREAM_H
+#define PLATFORM_QT_B_BITMAP_STREAM_H
+
+
+#include <DataIO.h>
+
+
+class BBitmap;
+
+
+// Unlike the Haiku version, the stream doesn't provide the bitmap in the
+// translator bitmap format, it only carries the bitmap to
+// BTranslatorRoster::Translate().
+class BBitmapStream : public BPositionIO {
+public:
+								BBitmapStream(BBitmap* bitmap = NULL);
+	virtual						~BBitmapStream();
+
+	virtual	ssize_t				ReadAt(off_t position, void* buffer,
+									size_t size);
+	virtual	ssize_t				WriteAt(off_t position, const void* buffer,
+									size_t size);
+
+	virtual	off_t				Seek(off_t position, uint32 seekMode);
+	virtual	off_t				Position() const;
+
+			status_t			DetachBitmap(BBitmap** _bitmap);
+
+			const BBitmap*		Bitmap() const
+									{ return fBitmap; }
+
+private:
+			BBitmap*			fBitmap;
+			bool				fDetached;
+};
+
+
+#endif // PLATFORM_QT_B_BITMAP_STREAM_H
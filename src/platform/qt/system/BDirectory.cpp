@@ -152,3 +152,16 @@ BDirectory::_InitError(status_t error)
 	Unset();
 	return fInitStatus = error;
 }
+
+
+// #pragma mark -
+
+
+status_t
+create_directory(const char* path, mode_t /*mode*/)
+{
+	if (path == NULL)
+		return B_BAD_VALUE;
+
+	return QDir().mkpath(QString::fromUtf8(path)) ? B_OK : B_ERROR;
+}
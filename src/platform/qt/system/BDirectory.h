@@ -80,4 +80,7 @@ private:
 };
 
 
+status_t create_directory(const char* path, mode_t mode);
+
+
 #endif // PLATFORM_QT_B_DIRECTORY_H
@@ -3,9 +3,94 @@
 #include "BDirectory.h"
 #include "BPath.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <QFileInfo>
 
 
+entry_ref::entry_ref()
+	:
+	directory(NULL),
+	name(NULL)
+{
+}
+
+
+entry_ref::entry_ref(const char* directory, const char* name)
+	:
+	directory(directory != NULL ? strdup(directory) : NULL),
+	name(NULL)
+{
+	set_name(name);
+}
+
+
+entry_ref::entry_ref(const entry_ref& other)
+	:
+	directory(other.directory != NULL ? strdup(other.directory) : NULL),
+	name(NULL)
+{
+	set_name(other.name);
+}
+
+
+entry_ref::~entry_ref()
+{
+	free(directory);
+	free(name);
+}
+
+
+status_t
+entry_ref::set_name(const char* newName)
+{
+	free(name);
+	name = NULL;
+
+	if (newName == NULL)
+		return B_OK;
+
+	name = strdup(newName);
+	return name != NULL ? B_OK : B_NO_MEMORY;
+}
+
+
+bool
+entry_ref::operator==(const entry_ref& other) const
+{
+	return ((directory == NULL && other.directory == NULL)
+			|| (directory != NULL && other.directory != NULL
+				&& strcmp(directory, other.directory) == 0))
+		&& ((name == NULL && other.name == NULL)
+			|| (name != NULL && other.name != NULL
+				&& strcmp(name, other.name) == 0));
+}
+
+
+bool
+entry_ref::operator!=(const entry_ref& other) const
+{
+	return !(*this == other);
+}
+
+
+entry_ref&
+entry_ref::operator=(const entry_ref& other)
+{
+	if (this == &other)
+		return *this;
+
+	free(directory);
+	directory = other.directory != NULL ? strdup(other.directory) : NULL;
+	set_name(other.name);
+	return *this;
+}
+
+
+// #pragma mark -
+
+
 BEntry::BEntry()
 	:
 	fDirectory(NULL),
@@ -15,6 +100,16 @@ BEntry::BEntry()
 }
 
 
+BEntry::BEntry(const entry_ref* ref, bool traverse)
+	:
+	fDirectory(NULL),
+	fFileName(),
+	fInitStatus(B_NO_INIT)
+{
+	SetTo(ref, traverse);
+}
+
+
 BEntry::~BEntry()
 {
 	Unset();
@@ -88,6 +183,22 @@ BEntry::SetTo(const char* path, bool traverse)
 }
 
 
+status_t
+BEntry::SetTo(const entry_ref* ref, bool traverse)
+{
+	if (ref == NULL || ref->directory == NULL || ref->name == NULL)
+		return _InitError(B_BAD_VALUE);
+
+	BDirectory directory;
+	status_t error = directory.SetTo(ref->directory);
+	if (error != B_OK)
+		return _InitError(error);
+
+	return _SetTo(*directory.fDirectory, QString::fromUtf8(ref->name),
+		traverse);
+}
+
+
 void
 BEntry::Unset()
 {
@@ -98,6 +209,25 @@ BEntry::Unset()
 }
 
 
+status_t
+BEntry::GetRef(entry_ref* ref) const
+{
+	if (ref == NULL)
+		return B_BAD_VALUE;
+
+	if (fDirectory == NULL)
+		return B_NO_INIT;
+
+	entry_ref result(fDirectory->path().toUtf8().data(),
+		fFileName.toUtf8().data());
+	if (result.directory == NULL || result.name == NULL)
+		return B_NO_MEMORY;
+
+	*ref = result;
+	return B_OK;
+}
+
+
 status_t
 BEntry::GetPath(BPath* path) const
 {
@@ -15,12 +15,33 @@ class BDirectory;
 class BPath;
 
 
+// On this platform, an entry_ref refers to the directory by its path.
+struct entry_ref {
+								entry_ref();
+								entry_ref(const char* directory,
+									const char* name);
+								entry_ref(const entry_ref& other);
+								~entry_ref();
+
+			status_t			set_name(const char* name);
+
+			bool				operator==(const entry_ref& other) const;
+			bool				operator!=(const entry_ref& other) const;
+			entry_ref&			operator=(const entry_ref& other);
+
+			char*				directory;
+			char*				name;
+};
+
+
 class BEntry {
 public:
 								BEntry();
 								BEntry(const BDirectory* dir, const char* path,
 									bool traverse = false);
 								BEntry(const char* path, bool traverse = false);
+								BEntry(const entry_ref* ref,
+									bool traverse = false);
 								BEntry(const BEntry& entry);
 								~BEntry();
 
@@ -36,8 +57,11 @@ public:
 			status_t			SetTo(const BDirectory* dir, const char* path,
 								   bool traverse = false);
 			status_t			SetTo(const char* path, bool traverse = false);
+			status_t			SetTo(const entry_ref* ref,
+									bool traverse = false);
 			void				Unset();
 
+			status_t			GetRef(entry_ref* ref) const;
 			status_t			GetPath(BPath* path) const;
 			status_t			GetParent(BEntry* entry) const;
 			status_t			GetParent(BDirectory* dir) const;
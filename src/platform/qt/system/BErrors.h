@@ -26,6 +26,7 @@
 #define B_PERMISSION_DENIED	_WONDERBRUSH_TO_NEGATIVE_ERROR(EACCES)
 #define B_IO_ERROR			_WONDERBRUSH_TO_NEGATIVE_ERROR(EIO)
 #define B_NAME_TOO_LONG		_WONDERBRUSH_TO_NEGATIVE_ERROR(ENAMETOOLONG)
+#define B_NOT_SUPPORTED		_WONDERBRUSH_TO_NEGATIVE_ERROR(EOPNOTSUPP)
 
 
 // TODO: Find better mappings for the following error codes.
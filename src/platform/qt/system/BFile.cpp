@@ -2,6 +2,8 @@
 
 #include <unistd.h>
 
+#include <Entry.h>
+
 
 BFile::BFile()
 	:
@@ -20,6 +22,15 @@ BFile::BFile(const char* path, uint32 openMode)
 }
 
 
+BFile::BFile(const entry_ref* ref, uint32 openMode)
+	:
+	fFile(NULL),
+	fInitStatus(B_NO_INIT)
+{
+	SetTo(ref, openMode);
+}
+
+
 BFile::~BFile()
 {
 	Unset();
@@ -77,6 +88,19 @@ BFile::SetTo(const QString& path, uint32 openMode)
 }
 
 
+status_t
+BFile::SetTo(const entry_ref* ref, uint32 openMode)
+{
+	Unset();
+
+	BEntry entry(ref);
+	if (entry.InitCheck() != B_OK)
+		return fInitStatus = entry.InitCheck();
+
+	return SetTo(entry.PathString(), openMode);
+}
+
+
 void
 BFile::Unset()
 {
@@ -8,10 +8,13 @@
 #include <QFile>
 
 
+struct entry_ref;
+
 class BFile : public BPositionIO {
 public:
 								BFile();
 								BFile(const char* path, uint32 openMode);
+								BFile(const entry_ref* ref, uint32 openMode);
 	virtual						~BFile();
 
 			status_t			InitCheck() const
@@ -19,6 +22,7 @@ public:
 
 			status_t			SetTo(const char* path, uint32 openMode);
 			status_t			SetTo(const QString& path, uint32 openMode);
+			status_t			SetTo(const entry_ref* ref, uint32 openMode);
 			void				Unset();
 
 	virtual	ssize_t				Read(void* buffer, size_t size);
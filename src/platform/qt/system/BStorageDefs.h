@@ -23,6 +23,7 @@
 #define B_OPEN_AT_END	   	O_APPEND	// point to the end of the data
 
 
+#define B_FILE_NAME_LENGTH	(NAME_MAX + 1)
 #define B_PATH_NAME_LENGTH	(PATH_MAX)
 
 
@@ -0,0 +1,35 @@
+#ifndef PLATFORM_QT_B_TRANSLATION_DEFS_H
+#define PLATFORM_QT_B_TRANSLATION_DEFS_H
+
+
+#include <SupportDefs.h>
+
+
+typedef int32 translator_id;
+
+
+#define B_NO_TRANSLATOR		B_ERROR
+
+
+struct translation_format {
+	uint32		type;
+	uint32		group;
+	float		quality;
+	float		capability;
+	char		MIME[251];
+	char		name[251];
+};
+
+
+struct translator_info {
+	uint32			type;
+	translator_id	translator;
+	uint32			group;
+	float			quality;
+	float			capability;
+	char			name[251];
+	char			MIME[251];
+};
+
+
+#endif // PLATFORM_QT_B_TRANSLATION_DEFS_H
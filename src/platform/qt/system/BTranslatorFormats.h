@@ -0,0 +1,23 @@
+#ifndef PLATFORM_QT_B_TRANSLATOR_FORMATS_H
+#define PLATFORM_QT_B_TRANSLATOR_FORMATS_H
+
+
+// format groups
+enum {
+	B_TRANSLATOR_BITMAP	= 'bits'
+};
+
+
+// bitmap formats
+enum {
+	B_GIF_FORMAT		= 'GIF ',
+	B_JPEG_FORMAT		= 'JPEG',
+	B_PNG_FORMAT		= 'PNG ',
+	B_PPM_FORMAT		= 'PPM ',
+	B_TGA_FORMAT		= 'TGA ',
+	B_BMP_FORMAT		= 'BMP ',
+	B_TIFF_FORMAT		= 'TIFF'
+};
+
+
+#endif // PLATFORM_QT_B_TRANSLATOR_FORMATS_H
@@ -0,0 +1,144 @@
+#include "BTranslatorRoster.h"
+
+#include <new>
+#include <stdio.h>
+
+#include <QBuffer>
+#include <QImageWriter>
+
+#include "BBitmap.h"
+#include "BBitmapStream.h"
+#include "BTranslatorFormats.h"
+
+
+struct format_info {
+	uint32		type;
+	const char*	writerFormat;
+	const char*	mimeType;
+	const char*	name;
+};
+
+
+static const format_info kFormats[] = {
+	{ B_PNG_FORMAT, "png", "image/png", "PNG image" },
+	{ B_JPEG_FORMAT, "jpeg", "image/jpeg", "JPEG image" },
+	{ B_BMP_FORMAT, "bmp", "image/bmp", "BMP image" },
+	{ B_TIFF_FORMAT, "tiff", "image/tiff", "TIFF image" },
+	{ B_PPM_FORMAT, "ppm", "image/x-portable-pixmap", "PPM image" },
+	{ B_GIF_FORMAT, "gif", "image/gif", "GIF image" },
+	{ B_TGA_FORMAT, "tga", "image/x-targa", "Targa image" }
+};
+
+
+/*static*/ BTranslatorRoster*
+BTranslatorRoster::Default()
+{
+	static BTranslatorRoster roster;
+	return &roster;
+}
+
+
+status_t
+BTranslatorRoster::GetAllTranslators(translator_id** _list, int32* _count)
+{
+	if (_list == NULL || _count == NULL)
+		return B_BAD_VALUE;
+
+	*_list = new(std::nothrow) translator_id[fFormatCount];
+	if (*_list == NULL)
+		return B_NO_MEMORY;
+
+	for (int32 i = 0; i < fFormatCount; i++)
+		(*_list)[i] = i + 1;
+	*_count = fFormatCount;
+
+	return B_OK;
+}
+
+
+status_t
+BTranslatorRoster::GetOutputFormats(translator_id translator,
+	const translation_format** _formats, int32* _numFormats)
+{
+	if (_formats == NULL || _numFormats == NULL)
+		return B_BAD_VALUE;
+	if (translator < 1 || translator > fFormatCount)
+		return B_NO_TRANSLATOR;
+
+	*_formats = &fFormats[translator - 1];
+	*_numFormats = 1;
+
+	return B_OK;
+}
+
+
+status_t
+BTranslatorRoster::Translate(BPositionIO* source, const translator_info* info,
+	BMessage* /*ioExtension*/, BPositionIO* destination, uint32 wantOutType,
+	uint32 /*hintType*/, const char* /*hintMIME*/)
+{
+	BBitmapStream* bitmapStream = dynamic_cast<BBitmapStream*>(source);
+	if (bitmapStream == NULL || bitmapStream->Bitmap() == NULL
+		|| bitmapStream->Bitmap()->GetQImage() == NULL
+		|| destination == NULL) {
+		return B_BAD_VALUE;
+	}
+
+	int32 index = _IndexOf(wantOutType);
+	if (index < 0 || (info != NULL && info->translator != 0
+			&& info->translator != index + 1)) {
+		return B_NO_TRANSLATOR;
+	}
+
+	QBuffer buffer;
+	if (!buffer.open(QIODevice::WriteOnly))
+		return B_NO_MEMORY;
+
+	QImageWriter writer(&buffer, fWriterFormats[index]);
+	if (!writer.write(*bitmapStream->Bitmap()->GetQImage()))
+		return B_ERROR;
+
+	const QByteArray& data = buffer.data();
+	ssize_t written = destination->Write(data.constData(), data.size());
+	if (written < 0)
+		return written;
+
+	return written == data.size() ? B_OK : B_IO_ERROR;
+}
+
+
+BTranslatorRoster::BTranslatorRoster()
+	:
+	fFormatCount(0)
+{
+	QList<QByteArray> supportedFormats = QImageWriter::supportedImageFormats();
+
+	int32 count = sizeof(kFormats) / sizeof(kFormats[0]);
+	for (int32 i = 0; i < count; i++) {
+		if (!supportedFormats.contains(kFormats[i].writerFormat))
+			continue;
+
+		translation_format& format = fFormats[fFormatCount];
+		format.type = kFormats[i].type;
+		format.group = B_TRANSLATOR_BITMAP;
+		format.quality = 0.5f;
+		format.capability = 0.5f;
+		snprintf(format.MIME, sizeof(format.MIME), "%s",
+			kFormats[i].mimeType);
+		snprintf(format.name, sizeof(format.name), "%s", kFormats[i].name);
+
+		fWriterFormats[fFormatCount] = kFormats[i].writerFormat;
+		fFormatCount++;
+	}
+}
+
+
+int32
+BTranslatorRoster::_IndexOf(uint32 type) const
+{
+	for (int32 i = 0; i < fFormatCount; i++) {
+		if (fFormats[i].type == type)
+			return i;
+	}
+	return -1;
+}
@@ -0,0 +1,43 @@
+#ifndef PLATFORM_QT_B_TRANSLATOR_ROSTER_H
+#define PLATFORM_QT_B_TRANSLATOR_ROSTER_H
+
+
+#include <TranslationDefs.h>
+
+
+class BMessage;
+class BPositionIO;
+
+
+// Provides one translator for each bitmap format that QImageWriter supports.
+// Only translating a BBitmapStream into one of these formats is supported.
+class BTranslatorRoster {
+public:
+	static	BTranslatorRoster*	Default();
+
+			status_t			GetAllTranslators(translator_id** _list,
+									int32* _count);
+			status_t			GetOutputFormats(translator_id translator,
+									const translation_format** _formats,
+									int32* _numFormats);
+
+			status_t			Translate(BPositionIO* source,
+									const translator_info* info,
+									BMessage* ioExtension,
+									BPositionIO* destination,
+									uint32 wantOutType, uint32 hintType = 0,
+									const char* hintMIME = NULL);
+
+private:
+								BTranslatorRoster();
+
+			int32				_IndexOf(uint32 type) const;
+
+private:
+			translation_format	fFormats[8];
+			const char*			fWriterFormats[8];
+			int32				fFormatCount;
+};
+
+
+#endif // PLATFORM_QT_B_TRANSLATOR_ROSTER_H
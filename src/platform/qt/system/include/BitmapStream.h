@@ -0,0 +1 @@
+#include "BBitmapStream.h"
@@ -0,0 +1 @@
+#include "BTranslationDefs.h"
@@ -0,0 +1 @@
+#include "BTranslatorFormats.h"
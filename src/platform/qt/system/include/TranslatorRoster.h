@@ -0,0 +1 @@
+#include "BTranslatorRoster.h"
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "BlurResultCache.h"
+
+#include <math.h>
+#include <new>
+#include <string.h>
+
+#include "AutoLocker.h"
+#include "HashMapHugo.h"
+#include "PixelBuffer.h"
+
+enum {
+	BLOCK_SIZE				= 64,
+	DEFAULT_MEMORY_BUDGET	= 32 * 1024 * 1024
+};
+
+struct BlurResultCache::Block {
+	BRect	valid;
+	uint32	bytesPerPixel;
+	uint8*	bits;
+};
+
+// BlockMap
+class BlurResultCache::BlockMap : public HashMap<HashKey64<uint64>, Block*> {
+};
+
+// block_key
+static inline uint64
+block_key(int32 x, int32 y)
+{
+	return (uint64)(uint32)x << 32 | (uint32)y;
+}
+
+// block_frame
+static inline BRect
+block_frame(int32 x, int32 y)
+{
+	return BRect(x * BLOCK_SIZE, y * BLOCK_SIZE,
+		x * BLOCK_SIZE + BLOCK_SIZE - 1, y * BLOCK_SIZE + BLOCK_SIZE - 1);
+}
+
+// get_block_range
+static inline void
+get_block_range(const BRect& area, int32& left, int32& top, int32& right,
+	int32& bottom)
+{
+	left = (int32)floorf(area.left / BLOCK_SIZE);
+	top = (int32)floorf(area.top / BLOCK_SIZE);
+	right = (int32)floorf(area.right / BLOCK_SIZE);
+	bottom = (int32)floorf(area.bottom / BLOCK_SIZE);
+}
+
+// copy_pixels
+static void
+copy_pixels(uint8* dst, uint32 dstBPR, const uint8* src, uint32 srcBPR,
+	uint32 bytesPerPixel, const BRect& area)
+{
+	uint32 width = (area.IntegerWidth() + 1) * bytesPerPixel;
+	for (int32 y = (int32)area.top; y <= (int32)area.bottom; y++) {
+		memcpy(dst, src, width);
+		dst += dstBPR;
+		src += srcBPR;
+	}
+}
+
+// constructor
+BlurResultCache::BlurResultCache()
+	: fLock("blur result cache")
+	, fBlocks(new(std::nothrow) BlockMap())
+	, fMemoryUsage(0)
+	, fMemoryBudget(DEFAULT_MEMORY_BUDGET)
+{
+}
+
+// destructor
+BlurResultCache::~BlurResultCache()
+{
+	MakeEmpty();
+	delete fBlocks;
+}
+
+// MakeEmpty
+void
+BlurResultCache::MakeEmpty()
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	if (fBlocks == NULL)
+		return;
+
+	BlockMap::Iterator iterator = fBlocks->GetIterator();
+	while (iterator.HasNext()) {
+		Block* block = iterator.Next()->Value;
+		delete[] block->bits;
+		delete block;
+	}
+	fBlocks->Clear();
+	fMemoryUsage = 0;
+}
+
+// MissingArea
+/*!	Returns the part of the area which is not in the cache. The returned
+	rect is invalid if the entire area is cached.
+*/
+BRect
+BlurResultCache::MissingArea(const BRect& area) const
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	if (fBlocks == NULL || !area.IsValid())
+		return area;
+
+	int32 left;
+	int32 top;
+	int32 right;
+	int32 bottom;
+	get_block_range(area, left, top, right, bottom);
+
+	BRect missing;
+	for (int32 y = top; y <= bottom; y++) {
+		for (int32 x = left; x <= right; x++) {
+			BRect needed = block_frame(x, y) & area;
+			Block* block = fBlocks->Get(block_key(x, y));
+			if (block == NULL || !block->valid.Contains(needed))
+				missing = missing.IsValid() ? missing | needed : needed;
+		}
+	}
+	return missing;
+}
+
+// CopyTo
+/*!	Copies all cached pixels within the area into the buffer.
+*/
+void
+BlurResultCache::CopyTo(PixelBuffer* buffer, const BRect& area) const
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	BRect clipped = area & buffer->Bounds();
+	if (fBlocks == NULL || !clipped.IsValid())
+		return;
+
+	int32 left;
+	int32 top;
+	int32 right;
+	int32 bottom;
+	get_block_range(clipped, left, top, right, bottom);
+
+	uint32 bytesPerPixel = buffer->BytesPerPixel();
+	uint32 blockBPR = BLOCK_SIZE * bytesPerPixel;
+
+	for (int32 y = top; y <= bottom; y++) {
+		for (int32 x = left; x <= right; x++) {
+			Block* block = fBlocks->Get(block_key(x, y));
+			if (block == NULL || block->bytesPerPixel != bytesPerPixel)
+				continue;
+
+			BRect copyArea = block->valid & clipped;
+			if (!copyArea.IsValid())
+				continue;
+
+			int32 copyLeft = (int32)copyArea.left;
+			int32 copyTop = (int32)copyArea.top;
+			const uint8* src = block->bits
+				+ (copyTop - y * BLOCK_SIZE) * blockBPR
+				+ (copyLeft - x * BLOCK_SIZE) * bytesPerPixel;
+			uint8* dst = buffer->Bits()
+				+ (copyTop - buffer->Top()) * buffer->BytesPerRow()
+				+ (copyLeft - buffer->Left()) * bytesPerPixel;
+			copy_pixels(dst, buffer->BytesPerRow(), src, blockBPR,
+				bytesPerPixel, copyArea);
+		}
+	}
+}
+
+// Store
+/*!	Stores the pixels within the area of the buffer, which need to be
+	completely blurred. Blocks already holding a larger part of the area are
+	not changed.
+*/
+void
+BlurResultCache::Store(const PixelBuffer* buffer, const BRect& area)
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	BRect clipped = area & buffer->Bounds();
+	if (fBlocks == NULL || !clipped.IsValid())
+		return;
+
+	int32 left;
+	int32 top;
+	int32 right;
+	int32 bottom;
+	get_block_range(clipped, left, top, right, bottom);
+
+	uint32 bytesPerPixel = buffer->BytesPerPixel();
+	uint32 blockBPR = BLOCK_SIZE * bytesPerPixel;
+	size_t blockSize = BLOCK_SIZE * blockBPR;
+
+	for (int32 y = top; y <= bottom; y++) {
+		for (int32 x = left; x <= right; x++) {
+			BRect storeArea = block_frame(x, y) & clipped;
+
+			uint64 key = block_key(x, y);
+			Block* block = fBlocks->Get(key);
+			if (block != NULL) {
+				if (block->bytesPerPixel != bytesPerPixel
+					|| block->valid.Contains(storeArea)
+					|| !storeArea.Contains(block->valid)) {
+					continue;
+				}
+			} else {
+				if (fMemoryUsage + blockSize > fMemoryBudget)
+					return;
+
+				block = new(std::nothrow) Block;
+				if (block == NULL)
+					return;
+				block->bits = new(std::nothrow) uint8[blockSize];
+				if (block->bits == NULL || fBlocks->Put(key, block) != B_OK) {
+					delete[] block->bits;
+					delete block;
+					return;
+				}
+				block->bytesPerPixel = bytesPerPixel;
+				fMemoryUsage += blockSize;
+			}
+
+			int32 storeLeft = (int32)storeArea.left;
+			int32 storeTop = (int32)storeArea.top;
+			uint8* dst = block->bits
+				+ (storeTop - y * BLOCK_SIZE) * blockBPR
+				+ (storeLeft - x * BLOCK_SIZE) * bytesPerPixel;
+			const uint8* src = buffer->Bits()
+				+ (storeTop - buffer->Top()) * buffer->BytesPerRow()
+				+ (storeLeft - buffer->Left()) * bytesPerPixel;
+			copy_pixels(dst, blockBPR, src, buffer->BytesPerRow(),
+				bytesPerPixel, storeArea);
+			block->valid = storeArea;
+		}
+	}
+}
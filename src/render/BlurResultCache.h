@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef BLUR_RESULT_CACHE_H
+#define BLUR_RESULT_CACHE_H
+
+#include <Locker.h>
+#include <Rect.h>
+
+class PixelBuffer;
+
+// The BlurResultCache keeps the pixels a filter has already blurred during
+// one render pass, so that the render jobs for neighbouring areas don't blur
+// the overlapping parts again. The pixels are kept in blocks of a fixed
+// grid, each block remembers which part of it is valid. All methods are
+// thread safe. The owner needs to empty the cache whenever the pixels
+// below the filter may have changed, usually in Layout(). Once the memory
+// budget is used up, nothing more is stored until the cache is emptied.
+
+class BlurResultCache {
+public:
+								BlurResultCache();
+	virtual						~BlurResultCache();
+
+			void				MakeEmpty();
+
+			BRect				MissingArea(const BRect& area) const;
+			void				CopyTo(PixelBuffer* buffer,
+									const BRect& area) const;
+			void				Store(const PixelBuffer* buffer,
+									const BRect& area);
+
+private:
+			struct Block;
+			class BlockMap;
+
+			mutable BLocker		fLock;
+			BlockMap*			fBlocks;
+			size_t				fMemoryUsage;
+			size_t				fMemoryBudget;
+};
+
+#endif // BLUR_RESULT_CACHE_H
@@ -0,0 +1,396 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "BoxBlurFilter.h"
+
+#include <algorithm>
+#include <math.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+#include <Bitmap.h>
+#include <OS.h>
+
+#include "AlphaBuffer.h"
+#include "RenderBuffer.h"
+#include "support.h"
+
+enum {
+	// The number of neighbouring columns blurred at once in the vertical
+	// pass, so that the rows are read in whole cache lines.
+	COLUMN_GROUP			= 16,
+
+	// Buffers with fewer pixels per thread are not worth spawning threads.
+	MIN_PIXELS_PER_THREAD	= 256 * 256
+};
+
+struct BoxBlurFilter::Job {
+	const BoxBlurFilter*	filter;
+	uint8*					bits;
+	uint32					width;
+	uint32					height;
+	uint32					bytesPerRow;
+	pixel_format			format;
+	bool					columns;
+	int32					first;
+	int32					last;
+};
+
+// box_line
+/*!	Blurs count samples of lanes values each with a box of the given radius.
+	The source contains the samples with radius replicated edge samples on
+	both sides, the samples in dst are spaced dstStride values apart.
+*/
+template<typename ChannelType>
+static void
+box_line(ChannelType* dst, int32 dstStride, const ChannelType* src,
+	int32 lanes, int32 count, int32 radius, uint64* sums)
+{
+	int32 size = 2 * radius + 1;
+	uint64 scale = ((uint64)1 << 32) / size;
+
+	for (int32 i = 0; i < lanes; i++)
+		sums[i] = 0;
+	for (int32 s = 0; s < size - 1; s++) {
+		for (int32 i = 0; i < lanes; i++)
+			sums[i] += *src++;
+	}
+
+	const ChannelType* sub = src - (size - 1) * lanes;
+	for (int32 s = 0; s < count; s++) {
+		for (int32 i = 0; i < lanes; i++) {
+			sums[i] += src[i];
+			dst[i] = (ChannelType)((sums[i] * scale + 0x80000000) >> 32);
+			sums[i] -= sub[i];
+		}
+		src += lanes;
+		sub += lanes;
+		dst += dstStride;
+	}
+}
+
+// blur_rows
+template<typename ChannelType, int32 kChannels>
+static void
+blur_rows(uint8* bits, uint32 width, uint32 bytesPerRow, int32 firstRow,
+	int32 lastRow, const int32* radii, ChannelType* line, uint64* sums)
+{
+	size_t rowSize = width * kChannels * sizeof(ChannelType);
+
+	for (int32 y = firstRow; y <= lastRow; y++) {
+		ChannelType* row = (ChannelType*)(bits + y * bytesPerRow);
+		const ChannelType* lastPixel = row + (width - 1) * kChannels;
+
+		for (int32 b = 0; b < BoxBlurFilter::BOX_COUNT; b++) {
+			int32 radius = radii[b];
+			if (radius == 0)
+				continue;
+
+			ChannelType* p = line;
+			for (int32 i = 0; i < radius; i++, p += kChannels)
+				memcpy(p, row, kChannels * sizeof(ChannelType));
+			memcpy(p, row, rowSize);
+			p += width * kChannels;
+			for (int32 i = 0; i < radius; i++, p += kChannels)
+				memcpy(p, lastPixel, kChannels * sizeof(ChannelType));
+
+			box_line<ChannelType>(row, kChannels, line, kChannels, width,
+				radius, sums);
+		}
+	}
+}
+
+// blur_columns
+template<typename ChannelType, int32 kChannels>
+static void
+blur_columns(uint8* bits, uint32 width, uint32 height, uint32 bytesPerRow,
+	int32 firstGroup, int32 lastGroup, const int32* radii, ChannelType* block,
+	uint64* sums)
+{
+	int32 stride = bytesPerRow / sizeof(ChannelType);
+
+	for (int32 group = firstGroup; group <= lastGroup; group++) {
+		int32 left = group * COLUMN_GROUP;
+		int32 columns = std::min((int32)width - left, (int32)COLUMN_GROUP);
+		int32 lanes = columns * kChannels;
+		size_t segmentSize = lanes * sizeof(ChannelType);
+		ChannelType* column = (ChannelType*)bits + left * kChannels;
+
+		for (int32 b = 0; b < BoxBlurFilter::BOX_COUNT; b++) {
+			int32 radius = radii[b];
+			if (radius == 0)
+				continue;
+
+			ChannelType* p = block;
+			for (int32 y = -radius; y < (int32)height + radius; y++) {
+				int32 sourceY = std::max((int32)0,
+					std::min(y, (int32)height - 1));
+				memcpy(p, column + sourceY * stride, segmentSize);
+				p += lanes;
+			}
+
+			box_line<ChannelType>(column, stride, block, lanes, height,
+				radius, sums);
+		}
+	}
+}
+
+// filter_range
+template<typename ChannelType, int32 kChannels>
+static void
+filter_range(uint8* bits, uint32 width, uint32 height, uint32 bytesPerRow,
+	bool columns, int32 first, int32 last, const int32* radii)
+{
+	int32 maxRadius = *std::max_element(radii,
+		radii + BoxBlurFilter::BOX_COUNT);
+	size_t count;
+	if (columns)
+		count = (size_t)(height + 2 * maxRadius) * COLUMN_GROUP * kChannels;
+	else
+		count = (size_t)(width + 2 * maxRadius) * kChannels;
+
+	ChannelType* temp = new(std::nothrow) ChannelType[count];
+	if (temp == NULL) {
+		printf("BoxBlurFilter - out of memory!\n");
+		return;
+	}
+	uint64 sums[COLUMN_GROUP * kChannels];
+
+	if (columns) {
+		blur_columns<ChannelType, kChannels>(bits, width, height,
+			bytesPerRow, first, last, radii, temp, sums);
+	} else {
+		blur_rows<ChannelType, kChannels>(bits, width, bytesPerRow, first,
+			last, radii, temp, sums);
+	}
+
+	delete[] temp;
+}
+
+// #pragma mark -
+
+// constructor
+BoxBlurFilter::BoxBlurFilter(double sigma)
+	: fThreadCount(1)
+{
+	// Choose the box widths so that the variance of the three boxes adds up
+	// to the variance of the gaussian. The widths need to be odd, so two
+	// neighbouring widths are mixed.
+	double variance = sigma > 0.0 ? sigma * sigma : 0.0;
+	double idealWidth = sqrt(12.0 * variance / BOX_COUNT + 1.0);
+	int32 lowerWidth = (int32)floor(idealWidth);
+	if (lowerWidth % 2 == 0)
+		lowerWidth--;
+	double idealLowerCount = (12.0 * variance
+		- BOX_COUNT * lowerWidth * lowerWidth - 4.0 * BOX_COUNT * lowerWidth
+		- 3.0 * BOX_COUNT) / (-4.0 * lowerWidth - 4.0);
+	int32 lowerCount = std::max((int32)0,
+		std::min((int32)BOX_COUNT, (int32)floor(idealLowerCount + 0.5)));
+
+	for (int32 i = 0; i < BOX_COUNT; i++) {
+		int32 width = i < lowerCount ? lowerWidth : lowerWidth + 2;
+		fRadius[i] = (width - 1) / 2;
+	}
+}
+
+// destructor
+BoxBlurFilter::~BoxBlurFilter()
+{
+}
+
+// SigmaForStackBlurRadius
+/*!	Returns the sigma of the gaussian which has the same variance as the
+	triangular kernel of a stack blur with the given radius.
+*/
+/*static*/ double
+BoxBlurFilter::SigmaForStackBlurRadius(double radius)
+{
+	if (radius <= 0.0)
+		return 0.0;
+	return sqrt(radius * (radius + 2.0) / 6.0);
+}
+
+// Extent
+/*!	Returns how many pixels in each direction contribute to a blurred pixel.
+*/
+int32
+BoxBlurFilter::Extent() const
+{
+	int32 extent = 0;
+	for (int32 i = 0; i < BOX_COUNT; i++)
+		extent += fRadius[i];
+	return extent;
+}
+
+// SetThreadCount
+void
+BoxBlurFilter::SetThreadCount(int32 count)
+{
+	fThreadCount = std::max((int32)1, count);
+}
+
+// FilterRGBA64
+void
+BoxBlurFilter::FilterRGBA64(RenderBuffer* buffer) const
+{
+	Filter(buffer->Bits(), buffer->Width(), buffer->Height(),
+		buffer->BytesPerRow(), RGBA64);
+}
+
+// FilterRGBA32
+void
+BoxBlurFilter::FilterRGBA32(RenderBuffer* buffer) const
+{
+	Filter(buffer->Bits(), buffer->Width(), buffer->Height(),
+		buffer->BytesPerRow(), RGBA32);
+}
+
+// FilterGray16
+void
+BoxBlurFilter::FilterGray16(AlphaBuffer* buffer) const
+{
+	Filter(buffer->Bits(), buffer->Width(), buffer->Height(),
+		buffer->BytesPerRow(), GRAY16);
+}
+
+// Filter
+void
+BoxBlurFilter::Filter(BBitmap* bitmap) const
+{
+	uint32 width = bitmap->Bounds().IntegerWidth() + 1;
+	uint32 height = bitmap->Bounds().IntegerHeight() + 1;
+	uint8* bits = (uint8*)bitmap->Bits();
+
+	if (bitmap->ColorSpace() == B_RGBA32 || bitmap->ColorSpace() == B_RGB32)
+		Filter(bits, width, height, bitmap->BytesPerRow(), RGBA32);
+	else if (bitmap->ColorSpace() == B_GRAY8)
+		Filter(bits, width, height, bitmap->BytesPerRow(), GRAY8);
+	else
+		printf("BoxBlurFilter::Filter() - unsupported color space\n");
+}
+
+// Filter
+void
+BoxBlurFilter::Filter(uint8* bits, uint32 width, uint32 height,
+	uint32 bytesPerRow, pixel_format format) const
+{
+	if (bits == NULL || width == 0 || height == 0 || Extent() == 0)
+		return;
+
+	int32 count = (int32)std::min((uint64)fThreadCount,
+		(uint64)width * height / MIN_PIXELS_PER_THREAD);
+	count = std::max((int32)1, count);
+
+	Job job;
+	job.filter = this;
+	job.bits = bits;
+	job.width = width;
+	job.height = height;
+	job.bytesPerRow = bytesPerRow;
+	job.format = format;
+
+	// The rows are independent of each other, so are the columns. All rows
+	// need to be finished before the columns are blurred, though.
+	job.columns = false;
+	job.first = 0;
+	job.last = height - 1;
+	_RunJobs(job, count);
+
+	job.columns = true;
+	job.first = 0;
+	job.last = (width + COLUMN_GROUP - 1) / COLUMN_GROUP - 1;
+	_RunJobs(job, count);
+}
+
+// #pragma mark -
+
+// _JobEntry
+/*static*/ status_t
+BoxBlurFilter::_JobEntry(void* data)
+{
+	Job* job = static_cast<Job*>(data);
+	job->filter->_FilterRange(*job);
+	return B_OK;
+}
+
+// _RunJobs
+/*!	Splits the range of the job into count parts. All but the last part are
+	filtered by spawned threads, the last one by the calling thread. Parts
+	for which no thread could be spawned are filtered by the calling thread,
+	too.
+*/
+void
+BoxBlurFilter::_RunJobs(Job& job, int32 count) const
+{
+	int32 total = job.last - job.first + 1;
+	count = std::max((int32)1, std::min(count, total));
+	if (count == 1) {
+		_FilterRange(job);
+		return;
+	}
+
+	Job* jobs = new(std::nothrow) Job[count];
+	thread_id* threads = new(std::nothrow) thread_id[count];
+	if (jobs == NULL || threads == NULL) {
+		delete[] jobs;
+		delete[] threads;
+		_FilterRange(job);
+		return;
+	}
+
+	int32 first = job.first;
+	for (int32 i = 0; i < count; i++) {
+		jobs[i] = job;
+		jobs[i].first = first;
+		jobs[i].last = job.first + (int32)((int64)total * (i + 1) / count) - 1;
+		first = jobs[i].last + 1;
+	}
+
+	for (int32 i = 0; i < count - 1; i++) {
+		threads[i] = spawn_thread(_JobEntry, "box blur", B_NORMAL_PRIORITY,
+			&jobs[i]);
+		if (threads[i] < 0 || resume_thread(threads[i]) != B_OK) {
+			threads[i] = B_ERROR;
+			_FilterRange(jobs[i]);
+		}
+	}
+
+	_FilterRange(jobs[count - 1]);
+
+	for (int32 i = 0; i < count - 1; i++) {
+		if (threads[i] >= 0) {
+			status_t ret;
+			wait_for_thread(threads[i], &ret);
+		}
+	}
+
+	delete[] jobs;
+	delete[] threads;
+}
+
+// _FilterRange
+void
+BoxBlurFilter::_FilterRange(const Job& job) const
+{
+	switch (job.format) {
+		case GRAY8:
+			filter_range<uint8, 1>(job.bits, job.width, job.height,
+				job.bytesPerRow, job.columns, job.first, job.last, fRadius);
+			break;
+		case GRAY16:
+			filter_range<uint16, 1>(job.bits, job.width, job.height,
+				job.bytesPerRow, job.columns, job.first, job.last, fRadius);
+			break;
+		case RGBA32:
+			filter_range<uint8, 4>(job.bits, job.width, job.height,
+				job.bytesPerRow, job.columns, job.first, job.last, fRadius);
+			break;
+		case RGBA64:
+			filter_range<uint16, 4>(job.bits, job.width, job.height,
+				job.bytesPerRow, job.columns, job.first, job.last, fRadius);
+			break;
+	}
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef BOX_BLUR_FILTER_H
+#define BOX_BLUR_FILTER_H
+
+#include <SupportDefs.h>
+
+class AlphaBuffer;
+class BBitmap;
+class RenderBuffer;
+
+// The BoxBlurFilter approximates a gaussian blur by three successive box
+// blurs in each direction. Each box is computed with a running sum, so the
+// cost per pixel does not depend on the radius. Pixels outside the buffer
+// are taken from the nearest edge pixel. The filter runs on the calling
+// thread by default, since the filters of a document are applied by the
+// render threads, which already keep every core busy. Callers outside the
+// render threads can have large buffers split into bands of rows and columns
+// with SetThreadCount(), which are then filtered by several threads.
+
+class BoxBlurFilter {
+public:
+	enum {
+		BOX_COUNT = 3
+	};
+
+	enum pixel_format {
+		GRAY8,
+		GRAY16,
+		RGBA32,
+		RGBA64
+	};
+
+								BoxBlurFilter(double sigma);
+								~BoxBlurFilter();
+
+	static	double				SigmaForStackBlurRadius(double radius);
+
+			int32				Extent() const;
+
+			void				SetThreadCount(int32 count);
+			int32				ThreadCount() const
+									{ return fThreadCount; }
+
+			void				FilterRGBA64(RenderBuffer* buffer) const;
+			void				FilterRGBA32(RenderBuffer* buffer) const;
+			void				FilterGray16(AlphaBuffer* buffer) const;
+			void				Filter(BBitmap* bitmap) const;
+
+			void				Filter(uint8* bits, uint32 width,
+									uint32 height, uint32 bytesPerRow,
+									pixel_format format) const;
+
+private:
+			struct Job;
+
+	static	status_t			_JobEntry(void* data);
+			void				_RunJobs(Job& job, int32 count) const;
+			void				_FilterRange(const Job& job) const;
+
+private:
+			int32				fRadius[BOX_COUNT];
+			int32				fThreadCount;
+};
+
+#endif // BOX_BLUR_FILTER_H
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "BrushStampCache.h"
+
+#include <new>
+#include <string.h>
+
+#include "HashMapHugo.h"
+
+enum {
+	DEFAULT_MEMORY_BUDGET	= 16 * 1024 * 1024
+};
+
+// StampMap
+class BrushStampCache::StampMap : public HashMap<BrushStampKey, BrushStamp*> {
+};
+
+// constructor
+BrushStampCache::BrushStampCache()
+	: fStamps(new (std::nothrow) StampMap())
+	, fMemoryUsage(0)
+	, fMemoryBudget(DEFAULT_MEMORY_BUDGET)
+{
+}
+
+// destructor
+BrushStampCache::~BrushStampCache()
+{
+	MakeEmpty();
+	delete fStamps;
+}
+
+// Get
+const BrushStamp*
+BrushStampCache::Get(const BrushStampKey& key) const
+{
+	if (fStamps == NULL)
+		return NULL;
+	return fStamps->Get(key);
+}
+
+// Create
+/*!	Adds a new stamp with cleared bits for the given key, which must not be
+	in the cache yet. Returns NULL if there is not enough memory. Any stamp
+	previously returned by Get() may become invalid.
+*/
+BrushStamp*
+BrushStampCache::Create(const BrushStampKey& key, int32 left, int32 top,
+	int32 width, int32 height)
+{
+	if (fStamps == NULL || width <= 0 || height <= 0)
+		return NULL;
+
+	size_t size = (size_t)width * height;
+	if (fMemoryUsage + size > fMemoryBudget)
+		MakeEmpty();
+
+	BrushStamp* stamp = new(std::nothrow) BrushStamp;
+	if (stamp == NULL)
+		return NULL;
+
+	stamp->bits = new(std::nothrow) uint8[size];
+	if (stamp->bits == NULL || fStamps->Put(key, stamp) != B_OK) {
+		delete[] stamp->bits;
+		delete stamp;
+		return NULL;
+	}
+
+	memset(stamp->bits, 0, size);
+	stamp->left = left;
+	stamp->top = top;
+	stamp->width = width;
+	stamp->height = height;
+
+	fMemoryUsage += size;
+
+	return stamp;
+}
+
+// MakeEmpty
+void
+BrushStampCache::MakeEmpty()
+{
+	if (fStamps == NULL)
+		return;
+
+	StampMap::Iterator iterator = fStamps->GetIterator();
+	while (iterator.HasNext()) {
+		BrushStamp* stamp = iterator.Next()->Value;
+		delete[] stamp->bits;
+		delete stamp;
+	}
+	fStamps->Clear();
+	fMemoryUsage = 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef BRUSH_STAMP_CACHE_H
+#define BRUSH_STAMP_CACHE_H
+
+#include <SupportDefs.h>
+
+// The quantized parameters which determine the coverage of a brush dab in
+// device space. Dabs with the same key produce the same stamp.
+struct BrushStampKey {
+	BrushStampKey()
+		: radius(0)
+		, radiusExponent(0)
+		, matrixExponent(0)
+		, hardness(0)
+		, subpixelX(0)
+		, subpixelY(0)
+	{
+		matrix[0] = matrix[1] = matrix[2] = matrix[3] = 0;
+	}
+
+	bool operator==(const BrushStampKey& other) const
+	{
+		return radius == other.radius
+			&& radiusExponent == other.radiusExponent
+			&& matrix[0] == other.matrix[0] && matrix[1] == other.matrix[1]
+			&& matrix[2] == other.matrix[2] && matrix[3] == other.matrix[3]
+			&& matrixExponent == other.matrixExponent
+			&& hardness == other.hardness
+			&& subpixelX == other.subpixelX
+			&& subpixelY == other.subpixelY;
+	}
+
+	size_t HashKey() const
+	{
+		uint32 hash = (uint32)radius * 73856093
+			^ (uint32)radiusExponent * 19349663
+			^ (uint32)hardness * 83492791
+			^ (uint32)(subpixelX | subpixelY << 8) * 2654435761U;
+		for (int32 i = 0; i < 4; i++)
+			hash = hash * 31 + (uint32)matrix[i];
+		return (size_t)(hash ^ (uint32)matrixExponent);
+	}
+
+	int32	radius;
+	int32	radiusExponent;
+	int32	matrix[4];
+	int32	matrixExponent;
+	int32	hardness;
+	int32	subpixelX;
+	int32	subpixelY;
+};
+
+// A pre-rendered dab. The coverage does not include the opacity of the
+// dab, which is applied when the stamp is blended. The stamp is positioned
+// relative to the pixel containing the dab center.
+struct BrushStamp {
+	int32	left;
+	int32	top;
+	int32	width;
+	int32	height;
+	uint8*	bits;
+};
+
+// The BrushStampCache keeps the stamps of recently drawn dabs. It is not
+// thread safe, each RenderEngine has its own cache. When the memory budget
+// is exceeded, all stamps are dropped at once, which is cheap and good
+// enough, since the stamps of a stroke are usually reused within a short
+// time.
+
+class BrushStampCache {
+public:
+								BrushStampCache();
+	virtual						~BrushStampCache();
+
+			const BrushStamp*	Get(const BrushStampKey& key) const;
+			BrushStamp*			Create(const BrushStampKey& key,
+									int32 left, int32 top,
+									int32 width, int32 height);
+
+			void				MakeEmpty();
+
+			size_t				MemoryUsage() const
+									{ return fMemoryUsage; }
+
+private:
+			class StampMap;
+
+			StampMap*			fStamps;
+			size_t				fMemoryUsage;
+			size_t				fMemoryBudget;
+};
+
+#endif // BRUSH_STAMP_CACHE_H
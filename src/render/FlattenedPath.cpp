@@ -0,0 +1,172 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "FlattenedPath.h"
+
+#include <math.h>
+#include <new>
+
+#include <agg_conv_curve.h>
+
+#include "AutoLocker.h"
+
+// Two buckets per doubling of the scale. The curves of a bucket are
+// flattened for its largest scale, so they are never too coarse.
+static const double kBucketsPerOctave = 2.0;
+static const int32 kMinToleranceBucket = -16;
+static const int32 kMaxToleranceBucket = 16;
+
+// Enough for a few zoom levels being rendered at the same time, like the
+// canvas and the navigator.
+static const int32 kMaxCachedPathCount = 4;
+
+// constructor
+FlattenedPath::FlattenedPath(const Path* path, int32 toleranceBucket)
+	: Referenceable()
+	, fToleranceBucket(toleranceBucket)
+	, fVertices()
+{
+	agg::path_storage storage;
+	if (!path->GetAGGPathStorage(storage))
+		return;
+
+	agg::conv_curve<agg::path_storage> curvedPath(storage);
+	curvedPath.approximation_scale(Scale());
+	fVertices.concat_path(curvedPath);
+}
+
+// destructor
+FlattenedPath::~FlattenedPath()
+{
+}
+
+// Scale
+double
+FlattenedPath::Scale() const
+{
+	return ScaleFor(fToleranceBucket);
+}
+
+// ToleranceBucketFor
+int32
+FlattenedPath::ToleranceBucketFor(double scale)
+{
+	if (scale <= 0.0)
+		return kMinToleranceBucket;
+
+	int32 bucket = (int32)ceil(log2(scale) * kBucketsPerOctave);
+	return max_c(kMinToleranceBucket, min_c(kMaxToleranceBucket, bucket));
+}
+
+// ScaleFor
+double
+FlattenedPath::ScaleFor(int32 toleranceBucket)
+{
+	return pow(2.0, toleranceBucket / kBucketsPerOctave);
+}
+
+// #pragma mark -
+
+// constructor
+FlattenedPathCache::FlattenedPathCache(const Path* path)
+	: Path::Listener()
+	, fLock("flattened path cache")
+	, fPath(path)
+	, fPaths()
+{
+}
+
+// destructor
+FlattenedPathCache::~FlattenedPathCache()
+{
+}
+
+// Get
+/*!	Returns the path flattened for the tolerance bucket of the given scale,
+	flattening it if it is not in the cache yet. An empty reference is
+	returned if there is not enough memory.
+*/
+FlattenedPathRef
+FlattenedPathCache::Get(double scale)
+{
+	int32 bucket = FlattenedPath::ToleranceBucketFor(scale);
+
+	AutoLocker<BLocker> locker(fLock);
+
+	int32 count = fPaths.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		FlattenedPathRef path = fPaths.ItemAtFast(i);
+		if (path->ToleranceBucket() == bucket) {
+			if (i < count - 1) {
+				fPaths.Remove(i);
+				fPaths.Add(path);
+			}
+			return path;
+		}
+	}
+
+	FlattenedPathRef path(new(std::nothrow) FlattenedPath(fPath, bucket),
+		true);
+	if (path.Get() == NULL)
+		return path;
+
+	// If it cannot be cached, it is still good for the caller.
+	if (fPaths.Add(path) && fPaths.CountItems() > kMaxCachedPathCount)
+		fPaths.Remove(0);
+
+	return path;
+}
+
+// Clear
+void
+FlattenedPathCache::Clear()
+{
+	AutoLocker<BLocker> locker(fLock);
+	fPaths.Clear();
+}
+
+// #pragma mark -
+
+// PointAdded
+void
+FlattenedPathCache::PointAdded(const Path* path, int32 index)
+{
+	Clear();
+}
+
+// PointRemoved
+void
+FlattenedPathCache::PointRemoved(const Path* path, int32 index)
+{
+	Clear();
+}
+
+// PointChanged
+void
+FlattenedPathCache::PointChanged(const Path* path, int32 index)
+{
+	Clear();
+}
+
+// PathChanged
+void
+FlattenedPathCache::PathChanged(const Path* path)
+{
+	Clear();
+}
+
+// PathClosedChanged
+void
+FlattenedPathCache::PathClosedChanged(const Path* path)
+{
+	Clear();
+}
+
+// PathReversed
+void
+FlattenedPathCache::PathReversed(const Path* path)
+{
+	Clear();
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef FLATTENED_PATH_H
+#define FLATTENED_PATH_H
+
+#include <Locker.h>
+
+#include <agg_path_storage.h>
+
+#include "List.h"
+#include "Path.h"
+
+// A FlattenedPath holds the curves of a Path approximated by straight lines,
+// precise enough for drawing the path at up to the scale it was made for.
+// It never changes once it is created, so it can be used from multiple
+// threads at once through an Iterator.
+class FlattenedPath : public Referenceable {
+public:
+								FlattenedPath(const Path* path,
+									int32 toleranceBucket);
+	virtual						~FlattenedPath();
+
+			int32				ToleranceBucket() const
+									{ return fToleranceBucket; }
+			double				Scale() const;
+
+	static	int32				ToleranceBucketFor(double scale);
+	static	double				ScaleFor(int32 toleranceBucket);
+
+	// An AGG vertex source for the lines. Each Iterator has its own position
+	// in the shared vertices.
+	class Iterator {
+	public:
+								Iterator(const FlattenedPath* path)
+									: fVertices(path->fVertices)
+									, fIndex(0)
+								{
+								}
+
+			void				rewind(unsigned pathID)
+									{ fIndex = 0; }
+			unsigned			vertex(double* x, double* y)
+								{
+									if (fIndex >= fVertices.total_vertices())
+										return agg::path_cmd_stop;
+									return fVertices.vertex(fIndex++, x, y);
+								}
+
+	private:
+			const agg::path_storage& fVertices;
+			unsigned			fIndex;
+	};
+
+private:
+			int32				fToleranceBucket;
+			agg::path_storage	fVertices;
+};
+
+typedef Reference<FlattenedPath> FlattenedPathRef;
+typedef List<FlattenedPathRef, false> FlattenedPathList;
+
+
+// The FlattenedPathCache keeps the FlattenedPaths of one Path for the few
+// most recently used tolerance buckets. It listens to the Path and forgets
+// them all when the Path changes.
+class FlattenedPathCache : public Path::Listener {
+public:
+								FlattenedPathCache(const Path* path);
+	virtual						~FlattenedPathCache();
+
+			FlattenedPathRef	Get(double scale);
+			void				Clear();
+
+	// Path::Listener interface
+	virtual	void				PointAdded(const Path* path, int32 index);
+	virtual	void				PointRemoved(const Path* path, int32 index);
+	virtual	void				PointChanged(const Path* path, int32 index);
+	virtual	void				PathChanged(const Path* path);
+	virtual	void				PathClosedChanged(const Path* path);
+	virtual	void				PathReversed(const Path* path);
+
+private:
+			BLocker				fLock;
+			const Path*			fPath;
+			// The most recently used path is the last one.
+			FlattenedPathList	fPaths;
+};
+
+#endif // FLATTENED_PATH_H
@@ -15,6 +15,7 @@ using std::nothrow;
 LayoutContext::LayoutContext(LayoutState* initialState)
 	: fCurrentState(initialState)
 	, fZoomLevel(1.0)
+	, fPreview(false)
 {
 }
 
@@ -35,6 +36,13 @@ LayoutContext::Init(double zoomLevel)
 	fCurrentState->Matrix.ScaleBy(B_ORIGIN, fZoomLevel, fZoomLevel);
 }
 
+// SetPreview
+void
+LayoutContext::SetPreview(bool preview)
+{
+	fPreview = preview;
+}
+
 // PushState
 void
 LayoutContext::PushState(LayoutState* state)
@@ -19,6 +19,13 @@ public:
 
 			void				Init(double zoomLevel);
 
+			// While the user is interacting with the canvas, objects may
+			// trade quality for speed, the RenderManager refines the
+			// preview afterwards.
+			void				SetPreview(bool preview);
+	inline	bool				IsPreview() const
+									{ return fPreview; }
+
 			void				PushState(LayoutState* state);
 			void				PopState();
 
@@ -34,6 +41,7 @@ public:
 private:
 			LayoutState*		fCurrentState;
 			double				fZoomLevel;
+			bool				fPreview;
 };
 
 #endif // LAYOUT_CONTEXT_H
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "MipPyramid.h"
+
+#include <new>
+
+#include "AutoLocker.h"
+
+// halve_buffer
+/*!	Averages each 2x2 block of source pixels into one pixel. For an odd
+	width or height, the last column or row is used twice.
+*/
+static void
+halve_buffer(const RenderBuffer* src, RenderBuffer* dst)
+{
+	uint32 srcWidth = src->Width();
+	uint32 srcHeight = src->Height();
+	uint32 width = dst->Width();
+	uint32 height = dst->Height();
+
+	for (uint32 y = 0; y < height; y++) {
+		uint32 y0 = y * 2;
+		uint32 y1 = min_c(y0 + 1, srcHeight - 1);
+		const uint16* row0 = (const uint16*)(src->Bits()
+			+ y0 * src->BytesPerRow());
+		const uint16* row1 = (const uint16*)(src->Bits()
+			+ y1 * src->BytesPerRow());
+		uint16* d = (uint16*)(dst->Bits() + y * dst->BytesPerRow());
+
+		for (uint32 x = 0; x < width; x++) {
+			uint32 x0 = x * 8;
+			uint32 x1 = min_c(x * 2 + 1, srcWidth - 1) * 4;
+			for (uint32 c = 0; c < 4; c++) {
+				d[c] = (uint16)(((uint32)row0[x0 + c] + row0[x1 + c]
+					+ row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+			}
+			d += 4;
+		}
+	}
+}
+
+// #pragma mark -
+
+// constructor
+MipPyramid::MipPyramid(const RenderBuffer* buffer)
+	: Referenceable()
+	, fLock("mip pyramid")
+	, fBuffer(buffer)
+	, fLevels()
+{
+}
+
+// destructor
+MipPyramid::~MipPyramid()
+{
+}
+
+// CountLevels
+int32
+MipPyramid::CountLevels() const
+{
+	uint32 width = fBuffer->Width();
+	uint32 height = fBuffer->Height();
+	int32 count = 1;
+	while (width > 1 || height > 1) {
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+		count++;
+	}
+	return count;
+}
+
+// LevelAt
+/*!	Returns the pixels of the given level, computing them and all levels
+	above them if needed. An empty reference is returned if the level does
+	not exist or there is not enough memory.
+*/
+RenderBufferRef
+MipPyramid::LevelAt(int32 level)
+{
+	// The owner of the pyramid keeps the buffer alive.
+	if (level == 0)
+		return RenderBufferRef(const_cast<RenderBuffer*>(fBuffer));
+	if (level < 0 || level >= CountLevels())
+		return RenderBufferRef();
+
+	AutoLocker<BLocker> locker(fLock);
+
+	while (fLevels.CountItems() < level) {
+		const RenderBuffer* previous = fLevels.CountItems() > 0
+			? fLevels.LastItem().Get() : fBuffer;
+
+		uint32 width = (previous->Width() + 1) / 2;
+		uint32 height = (previous->Height() + 1) / 2;
+		RenderBufferRef next(new(std::nothrow) RenderBuffer(width, height),
+			true);
+		if (next.Get() == NULL || !next->IsValid())
+			return RenderBufferRef();
+
+		halve_buffer(previous, next.Get());
+		if (!fLevels.Add(next))
+			return RenderBufferRef();
+	}
+
+	return fLevels.ItemAt(level - 1);
+}
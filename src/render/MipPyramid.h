@@ -0,0 +1,41 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef MIP_PYRAMID_H
+#define MIP_PYRAMID_H
+
+#include <Locker.h>
+
+#include "List.h"
+#include "RenderBuffer.h"
+
+// The MipPyramid holds successively halved versions of the pixels of a
+// RenderBuffer, which make drawing it scaled down cheap. Level 0 is the
+// buffer itself, the other levels are computed when they are first needed,
+// in the same premultiplied linear format. Each level starts at 0, 0. The
+// pyramid does not keep the buffer alive, and it doesn't notice when the
+// pixels change. The owner of a pyramid, like the ImageSnapshot, therefore
+// only creates one for pixels which are never written again, and keeps the
+// buffer for as long as the pyramid. LevelAt() may be called from multiple
+// threads at once.
+
+class MipPyramid : public Referenceable {
+public:
+								MipPyramid(const RenderBuffer* buffer);
+	virtual						~MipPyramid();
+
+			int32				CountLevels() const;
+			RenderBufferRef		LevelAt(int32 level);
+
+private:
+			typedef List<RenderBufferRef, false> LevelList;
+
+			BLocker				fLock;
+			const RenderBuffer*	fBuffer;
+			LevelList			fLevels;
+};
+
+typedef Reference<MipPyramid> MipPyramidRef;
+
+#endif // MIP_PYRAMID_H
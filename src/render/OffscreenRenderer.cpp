@@ -0,0 +1,395 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "OffscreenRenderer.h"
+
+#include <new>
+#include <math.h>
+#include <string.h>
+
+#include <Bitmap.h>
+
+#include "Document.h"
+#include "Layer.h"
+#include "LayerSnapshot.h"
+#include "RenderBuffer.h"
+#include "RenderEngine.h"
+#include "RenderTrace.h"
+#include "TiledRenderBuffer.h"
+
+using std::nothrow;
+
+// The size of the blocks the document is rendered in, in tiles per side.
+static const int32 kBlockTiles = 4;
+
+struct OffscreenRenderer::Worker {
+	Worker()
+		: renderer(NULL)
+		, engine()
+		, scratchBitmap(NULL)
+		, status(B_OK)
+	{
+	}
+
+	~Worker()
+	{
+		delete scratchBitmap;
+	}
+
+	OffscreenRenderer*	renderer;
+	RenderEngine		engine;
+	// The layer moves the scratch bitmap to the area it rebuilds.
+	RenderBuffer*		scratchBitmap;
+	status_t			status;
+};
+
+// constructor
+OffscreenRenderer::OffscreenRenderer(Document* document)
+	: fDocument(document)
+	, fDocumentBounds()
+	, fSnapshot(NULL)
+	, fInitialLayoutState()
+	, fLayoutContext(&fInitialLayoutState)
+	, fWorkers(NULL)
+	, fWorkerCount(0)
+	, fKeepTiles(false)
+	, fLayer(NULL)
+	, fLayerArea()
+	, fFirstColumn(0)
+	, fFirstRow(0)
+	, fBlockColumns(0)
+	, fBlockCount(0)
+	, fNextBlock(0)
+{
+	memset(&fTiming, 0, sizeof(fTiming));
+	SetThreadCount(1);
+}
+
+// destructor
+OffscreenRenderer::~OffscreenRenderer()
+{
+	delete fSnapshot;
+	delete[] fWorkers;
+}
+
+// SetThreadCount
+/*!	Sets the number of threads which render each layer, including the
+	calling thread.
+*/
+status_t
+OffscreenRenderer::SetThreadCount(int32 count)
+{
+	if (count < 1)
+		return B_BAD_VALUE;
+	if (count == fWorkerCount)
+		return B_OK;
+
+	Worker* workers = new(nothrow) Worker[count];
+	if (workers == NULL)
+		return B_NO_MEMORY;
+
+	for (int32 i = 0; i < count; i++)
+		workers[i].renderer = this;
+
+	delete[] fWorkers;
+	fWorkers = workers;
+	fWorkerCount = count;
+	return B_OK;
+}
+
+// SetKeepTiles
+/*!	By default, the rendered pixels of the layers are freed after each
+	render. When they are kept, the next render of the same area does not
+	need to allocate them again, at the cost of the memory.
+*/
+void
+OffscreenRenderer::SetKeepTiles(bool keep)
+{
+	fKeepTiles = keep;
+	if (!keep && fSnapshot != NULL)
+		_FreeTiles(fSnapshot);
+}
+
+// Render
+/*!	Renders the part of the document covered by the bounds of the buffer
+	at the given zoom level and returns when done. Areas of the buffer
+	outside of the zoomed document bounds are cleared to white.
+*/
+status_t
+OffscreenRenderer::Render(RenderBuffer* buffer, double zoomLevel)
+{
+	if (buffer == NULL || !buffer->IsValid() || zoomLevel <= 0.0)
+		return B_BAD_VALUE;
+
+	TRACE_SPAN_AREA("offscreen render", NULL, buffer->Bounds());
+
+	memset(&fTiming, 0, sizeof(fTiming));
+	bigtime_t startTime = system_time();
+
+	status_t ret = _Sync();
+	if (ret != B_OK)
+		return ret;
+
+	bigtime_t now = system_time();
+	fTiming.sync = now - startTime;
+	startTime = now;
+
+	// do a layout pass (will always push at least one more LayoutState,
+	// so the zoom level in the initial state is preserved)
+	fLayoutContext.Init(zoomLevel);
+
+	LayoutState rootLayerState(fLayoutContext.State());
+	fLayoutContext.PushState(&rootLayerState);
+
+	fSnapshot->Layout(fLayoutContext, 0);
+
+	fLayoutContext.PopState();
+
+	now = system_time();
+	fTiming.layout = now - startTime;
+	startTime = now;
+
+	buffer->Clear(buffer->Bounds(), (rgb_color){ 255, 255, 255, 255 });
+
+	BRect area = buffer->Bounds() & ZoomedBounds(fDocumentBounds, zoomLevel);
+	if (area.IsValid()) {
+		// The sub-layers need to be complete before the layers containing
+		// them are rendered, so the threads work on one layer at a time.
+		LayerJobList jobs;
+		ret = _CollectLayers(fSnapshot, area, jobs);
+		for (int32 i = 0; ret == B_OK && i < jobs.CountItems(); i++) {
+			const LayerJob& job = jobs.ItemAtFast(i);
+			ret = _RenderLayer(job.layer, job.area);
+		}
+
+		now = system_time();
+		fTiming.render = now - startTime;
+		startTime = now;
+
+		if (ret == B_OK)
+			fSnapshot->Tiles()->BlendTo(buffer, area);
+	}
+
+	// The snapshot is kept to sync only the changes for the next render,
+	// the rendered pixels only if asked to.
+	if (!fKeepTiles || ret != B_OK)
+		_FreeTiles(fSnapshot);
+
+	fTiming.blend = system_time() - startTime;
+
+	return ret;
+}
+
+// Render
+status_t
+OffscreenRenderer::Render(BBitmap* bitmap, double zoomLevel)
+{
+	if (bitmap == NULL || !bitmap->IsValid())
+		return B_BAD_VALUE;
+
+	RenderBuffer buffer(bitmap->Bounds());
+	if (!buffer.IsValid())
+		return B_NO_MEMORY;
+
+	status_t ret = Render(&buffer, zoomLevel);
+	if (ret == B_OK)
+		buffer.CopyTo(bitmap, bitmap->Bounds());
+
+	return ret;
+}
+
+// ZoomedBounds
+BRect
+OffscreenRenderer::ZoomedBounds(const BRect& bounds, double zoomLevel)
+{
+	BRect zoomedBounds(bounds);
+	zoomedBounds.left = floorf(zoomedBounds.left * zoomLevel);
+	zoomedBounds.top = floorf(zoomedBounds.top * zoomLevel);
+	zoomedBounds.right = ceilf(zoomedBounds.right * zoomLevel);
+	zoomedBounds.bottom = ceilf(zoomedBounds.bottom * zoomLevel);
+	return zoomedBounds;
+}
+
+// #pragma mark -
+
+// _Sync
+status_t
+OffscreenRenderer::_Sync()
+{
+	if (fDocument == NULL)
+		return B_NO_INIT;
+
+	AutoReadLocker locker(fDocument);
+	if (!locker.IsLocked())
+		return B_ERROR;
+
+	fDocumentBounds = fDocument->Bounds();
+
+	if (fSnapshot == NULL) {
+		fSnapshot = new(nothrow) LayerSnapshot(fDocument->RootLayer());
+		if (fSnapshot == NULL)
+			return B_NO_MEMORY;
+	} else
+		fSnapshot->Sync();
+
+	return fSnapshot->Tiles() != NULL ? B_OK : B_NO_MEMORY;
+}
+
+// _CollectLayers
+/*!	Adds the sub-layers of the layer, and then the layer itself, to the
+	jobs, each with the area it needs to render. Objects may need more than
+	the area of the objects below them to rebuild the area, for example a
+	blur filter, so each sub-layer is rendered for the area that the layer
+	needs from it.
+*/
+status_t
+OffscreenRenderer::_CollectLayers(LayerSnapshot* layer, BRect area,
+	LayerJobList& jobs)
+{
+	TiledRenderBuffer* tiles = layer->Tiles();
+	if (tiles == NULL)
+		return B_NO_MEMORY;
+
+	area = area & tiles->Bounds();
+	if (!area.IsValid())
+		return B_OK;
+
+	BRect rebuildArea = area;
+	for (int32 i = layer->CountObjects() - 1; i >= 0; i--) {
+		ObjectSnapshot* object = layer->ObjectAtFast(i);
+		if (!object->IsVisible())
+			continue;
+
+		LayerSnapshot* subLayer = dynamic_cast<LayerSnapshot*>(object);
+		if (subLayer != NULL) {
+			status_t ret = _CollectLayers(subLayer, rebuildArea, jobs);
+			if (ret != B_OK)
+				return ret;
+		}
+
+		object->RebuildAreaForDirtyArea(rebuildArea);
+	}
+
+	LayerJob job;
+	job.layer = layer;
+	job.area = area;
+	return jobs.Add(job) ? B_OK : B_NO_MEMORY;
+}
+
+// _RenderLayer
+/*!	Renders the area of the layer in blocks of tiles, like the render
+	threads do, so that each scratch bitmap only needs to hold one block.
+	The blocks are disjoint and handed out to the threads as they become
+	idle.
+*/
+status_t
+OffscreenRenderer::_RenderLayer(LayerSnapshot* layer, BRect area)
+{
+	status_t ret = layer->Tiles()->AllocateTiles(area);
+	if (ret != B_OK)
+		return ret;
+
+	int32 lastColumn;
+	int32 lastRow;
+	TiledRenderBuffer::GetTileRange(area, fFirstColumn, fFirstRow,
+		lastColumn, lastRow);
+
+	fLayer = layer;
+	fLayerArea = area;
+	fBlockColumns = (lastColumn - fFirstColumn) / kBlockTiles + 1;
+	fBlockCount = fBlockColumns * ((lastRow - fFirstRow) / kBlockTiles + 1);
+	fNextBlock = 0;
+
+	int32 workerCount = min_c(fWorkerCount, fBlockCount);
+	thread_id* threads = NULL;
+	if (workerCount > 1)
+		threads = new(nothrow) thread_id[workerCount - 1];
+	int32 threadCount = 0;
+	for (int32 i = 0; threads != NULL && i < workerCount - 1; i++) {
+		thread_id thread = spawn_thread(_WorkerEntry, "offscreen renderer",
+			B_NORMAL_PRIORITY, &fWorkers[i]);
+		if (thread < 0 || resume_thread(thread) != B_OK)
+			break;
+		threads[threadCount++] = thread;
+	}
+
+	// The calling thread renders as well, and takes over all remaining
+	// blocks if no thread could be spawned.
+	Worker& worker = fWorkers[fWorkerCount - 1];
+	_Work(worker);
+	ret = worker.status;
+
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t threadRet;
+		wait_for_thread(threads[i], &threadRet);
+		if (ret == B_OK)
+			ret = fWorkers[i].status;
+	}
+	delete[] threads;
+
+	fLayer = NULL;
+
+	return ret;
+}
+
+// _WorkerEntry
+status_t
+OffscreenRenderer::_WorkerEntry(void* cookie)
+{
+	Worker* worker = (Worker*)cookie;
+	worker->renderer->_Work(*worker);
+	return B_OK;
+}
+
+// _Work
+void
+OffscreenRenderer::_Work(Worker& worker)
+{
+	worker.status = B_OK;
+
+	while (true) {
+		int32 block = atomic_add(&fNextBlock, 1);
+		if (block >= fBlockCount)
+			break;
+
+		int32 column = fFirstColumn + block % fBlockColumns * kBlockTiles;
+		int32 row = fFirstRow + block / fBlockColumns * kBlockTiles;
+		BRect area = (TiledRenderBuffer::TileFrame(column, row)
+			| TiledRenderBuffer::TileFrame(column + kBlockTiles - 1,
+				row + kBlockTiles - 1)) & fLayerArea;
+		if (!area.IsValid())
+			continue;
+
+		if (worker.scratchBitmap == NULL) {
+			worker.scratchBitmap = new(nothrow) RenderBuffer(area);
+			if (worker.scratchBitmap == NULL) {
+				worker.status = B_NO_MEMORY;
+				break;
+			}
+		}
+
+		if (!fLayer->Render(worker.engine, area,
+				worker.scratchBitmap).IsValid()) {
+			worker.status = B_NO_MEMORY;
+			break;
+		}
+	}
+}
+
+// _FreeTiles
+void
+OffscreenRenderer::_FreeTiles(LayerSnapshot* layer)
+{
+	int32 count = layer->CountObjects();
+	for (int32 i = 0; i < count; i++) {
+		LayerSnapshot* subLayer = dynamic_cast<LayerSnapshot*>(
+			layer->ObjectAtFast(i));
+		if (subLayer != NULL)
+			_FreeTiles(subLayer);
+	}
+
+	if (layer->Tiles() != NULL)
+		layer->Tiles()->MakeEmpty();
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef OFFSCREEN_RENDERER_H
+#define OFFSCREEN_RENDERER_H
+
+#include <OS.h>
+#include <Rect.h>
+
+#include "LayoutContext.h"
+#include "LayoutState.h"
+#include "List.h"
+
+class BBitmap;
+class Document;
+class LayerSnapshot;
+class RenderBuffer;
+
+// The OffscreenRenderer renders a Document synchronously, without a
+// RenderManager, display bitmaps or listeners. The target buffer is in the
+// coordinate system of the document scaled by the zoom level, its Bounds()
+// select which part of the document is rendered. With more than one
+// thread, all threads share the snapshot of the document and render
+// disjoint blocks of tiles of one layer at a time. An OffscreenRenderer
+// may only be used by one thread at a time, but any number of them may
+// render (different or the same) documents in parallel.
+
+// The time spent in each stage of the last call to Render().
+struct render_timing {
+	bigtime_t	sync;
+	bigtime_t	layout;
+	bigtime_t	render;
+	bigtime_t	blend;
+};
+
+class OffscreenRenderer {
+public:
+								OffscreenRenderer(Document* document);
+	virtual						~OffscreenRenderer();
+
+			status_t			SetThreadCount(int32 count);
+			int32				ThreadCount() const
+									{ return fWorkerCount; }
+
+			void				SetKeepTiles(bool keep);
+
+			status_t			Render(RenderBuffer* buffer,
+									double zoomLevel);
+			status_t			Render(BBitmap* bitmap, double zoomLevel);
+
+			const render_timing& LastTiming() const
+									{ return fTiming; }
+
+	static	BRect				ZoomedBounds(const BRect& bounds,
+									double zoomLevel);
+
+private:
+			struct Worker;
+			struct LayerJob {
+				LayerSnapshot*	layer;
+				BRect			area;
+			};
+			typedef List<LayerJob, true> LayerJobList;
+
+			status_t			_Sync();
+			status_t			_CollectLayers(LayerSnapshot* layer,
+									BRect area, LayerJobList& jobs);
+			status_t			_RenderLayer(LayerSnapshot* layer,
+									BRect area);
+	static	status_t			_WorkerEntry(void* cookie);
+			void				_Work(Worker& worker);
+			void				_FreeTiles(LayerSnapshot* layer);
+
+private:
+			Document*			fDocument;
+			BRect				fDocumentBounds;
+			LayerSnapshot*		fSnapshot;
+
+			LayoutState			fInitialLayoutState;
+			LayoutContext		fLayoutContext;
+
+			Worker*				fWorkers;
+			int32				fWorkerCount;
+			bool				fKeepTiles;
+
+			// The layer which the workers currently render.
+			LayerSnapshot*		fLayer;
+			BRect				fLayerArea;
+			int32				fFirstColumn;
+			int32				fFirstRow;
+			int32				fBlockColumns;
+			int32				fBlockCount;
+			vint32				fNextBlock;
+
+			render_timing		fTiming;
+};
+
+#endif // OFFSCREEN_RENDERER_H
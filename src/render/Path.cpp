@@ -27,6 +27,7 @@
 #include "support.h"
 
 #include "CommonPropertyIDs.h"
+#include "FlattenedPath.h"
 #include "IconProperty.h"
 #include "PathPropertyIcon.h"
 #include "Property.h"
@@ -58,8 +59,10 @@ Path::Path()
 	fClosed(false),
 	fPointCount(0),
 	fAllocCount(0),
-	fCachedBounds(0.0, 0.0, -1.0, -1.0)
+	fCachedBounds(0.0, 0.0, -1.0, -1.0),
+	fFlattenedPathCache(new(std::nothrow) FlattenedPathCache(this))
 {
+	AddListener(fFlattenedPathCache);
 }
 
 // constructor
@@ -76,8 +79,10 @@ Path::Path(const Path& other)
 	fClosed(false),
 	fPointCount(0),
 	fAllocCount(0),
-	fCachedBounds(0.0, 0.0, -1.0, -1.0)
+	fCachedBounds(0.0, 0.0, -1.0, -1.0),
+	fFlattenedPathCache(new(std::nothrow) FlattenedPathCache(this))
 {
+	AddListener(fFlattenedPathCache);
 	*this = other;
 }
 
@@ -95,8 +100,10 @@ Path::Path(const BMessage* archive)
 	fClosed(false),
 	fPointCount(0),
 	fAllocCount(0),
-	fCachedBounds(0.0, 0.0, -1.0, -1.0)
+	fCachedBounds(0.0, 0.0, -1.0, -1.0),
+	fFlattenedPathCache(new(std::nothrow) FlattenedPathCache(this))
 {
+	AddListener(fFlattenedPathCache);
 	if (!archive)
 		return;
 
@@ -137,6 +144,9 @@ Path::~Path()
 	if (fPath)
 		obj_free(fPath);
 
+	RemoveListener(fFlattenedPathCache);
+	delete fFlattenedPathCache;
+
 	if (fListeners.CountItems() > 0) {
 		Listener* listener = (Listener*)fListeners.ItemAt(0);
 		char message[512];
@@ -270,6 +280,9 @@ Path::operator=(const Path& other)
 		fPointCount = 0;
 		fCachedBounds.Set(0.0, 0.0, -1.0, -1.0);
 	}
+	// The listeners are not notified of this change.
+	if (fFlattenedPathCache != NULL)
+		fFlattenedPathCache->Clear();
 	Notify();
 
 	return *this;
@@ -301,6 +314,8 @@ void
 Path::MakeEmpty()
 {
 	_SetPointCount(0);
+	if (fFlattenedPathCache != NULL)
+		fFlattenedPathCache->Clear();
 }
 
 // #pragma mark -
@@ -954,6 +969,23 @@ Path::GetAGGPathStorage(agg::path_storage& path) const
 	return _GetAGGPathStorage(path, fPath, fPointCount, fClosed);
 }
 
+// GetFlattenedPath
+/*!	Returns the path flattened for the given scale. The result is shared
+	with everyone else drawing the path at a similar scale. It is only
+	computed again after the path changed.
+*/
+FlattenedPathRef
+Path::GetFlattenedPath(double scale) const
+{
+	// While notifications are suspended, the cache would not learn about
+	// changes.
+	if (fFlattenedPathCache == NULL || fNotificationsSuspended > 0) {
+		return FlattenedPathRef(new(std::nothrow) FlattenedPath(this,
+			FlattenedPath::ToleranceBucketFor(scale)), true);
+	}
+	return fFlattenedPathCache->Get(scale);
+}
+
 // #pragma mark -
 
 // AddListener
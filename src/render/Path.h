@@ -18,6 +18,8 @@
 #include "Transformable.h"
 
 class BMessage;
+class FlattenedPath;
+class FlattenedPathCache;
 
 
 class Path : public BArchivable, public BaseObject {
@@ -138,6 +140,9 @@ public:
 
 			bool				GetAGGPathStorage(
 									agg::path_storage& path) const;
+								// the curves approximated by lines, precise
+								// enough for drawing at the given scale
+			Reference<FlattenedPath> GetFlattenedPath(double scale) const;
 
 			bool				AddListener(Listener* listener);
 			bool				RemoveListener(Listener* listener);
@@ -186,6 +191,7 @@ private:
 			int32				fAllocCount;
 
 	mutable	BRect				fCachedBounds;
+			FlattenedPathCache*	fFlattenedPathCache;
 };
 
 typedef Reference<Path>	PathRef;
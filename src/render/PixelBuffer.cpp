@@ -23,6 +23,7 @@ PixelBuffer::PixelBuffer(const BRect& bounds, uint32 bytesPerPixel)
 	, fLeft(static_cast<int32>(bounds.left))
 	, fTop(static_cast<int32>(bounds.top))
 	, fAdopted(false)
+	, fAllocatedLength(fBits != NULL ? fBytesPerRow * fHeight : 0)
 {
 }
 
@@ -36,6 +37,7 @@ PixelBuffer::PixelBuffer(uint32 width, uint32 height, uint32 bytesPerPixel)
 	, fLeft(0)
 	, fTop(0)
 	, fAdopted(false)
+	, fAllocatedLength(fBits != NULL ? fBytesPerRow * fHeight : 0)
 {
 }
 
@@ -49,6 +51,7 @@ PixelBuffer::PixelBuffer(PixelBuffer* bitmap, BRect area, bool adopt)
 	, fLeft(0)
 	, fTop(0)
 	, fAdopted(false)
+	, fAllocatedLength(0)
 {
 	area = area & bitmap->Bounds();
 
@@ -58,8 +61,8 @@ PixelBuffer::PixelBuffer(PixelBuffer* bitmap, BRect area, bool adopt)
 	uint32 bytesPerRow = bitmap->BytesPerRow();
 	uint32 bytesPerPixel = bitmap->BytesPerPixel();
 
-	buffer += (int32)area.left * bytesPerPixel;
-	buffer += (int32)area.top * bytesPerRow;
+	buffer += ((int32)area.left - bitmap->Left()) * bytesPerPixel;
+	buffer += ((int32)area.top - bitmap->Top()) * bytesPerRow;
 
 	_Attach(buffer, width, height, bytesPerPixel, bytesPerRow, adopt);
 
@@ -78,6 +81,7 @@ PixelBuffer::PixelBuffer(uint8* buffer, uint32 width, uint32 height,
 	, fLeft(0)
 	, fTop(0)
 	, fAdopted(false)
+	, fAllocatedLength(0)
 {
 	_Attach(buffer, width, height, bytesPerPixel, bytesPerRow, adopt);
 }
@@ -161,6 +165,42 @@ PixelBuffer::CopyTo(PixelBuffer* buffer, BRect area) const
 //	}
 //}
 //
+// SetBounds
+/*!	Moves the buffer to the given bounds, which may have a different size.
+	The pixels are undefined afterwards. The allocated memory is reused if it
+	is large enough, so a buffer used as scratch space for areas of changing
+	sizes only grows to the largest of them. Buffers which don't own their
+	pixels cannot be changed.
+*/
+status_t
+PixelBuffer::SetBounds(const BRect& bounds)
+{
+	if (fAdopted)
+		return B_NOT_ALLOWED;
+	if (!bounds.IsValid())
+		return B_BAD_VALUE;
+
+	uint32 width = bounds.IntegerWidth() + 1;
+	uint32 height = bounds.IntegerHeight() + 1;
+	uint32 length = width * fBytesPerPixel * height;
+	if (length > fAllocatedLength) {
+		uint8* bits = new(std::nothrow) uint8[length];
+		if (bits == NULL)
+			return B_NO_MEMORY;
+		delete[] fBits;
+		fBits = bits;
+		fAllocatedLength = length;
+	}
+
+	fWidth = width;
+	fHeight = height;
+	fBytesPerRow = width * fBytesPerPixel;
+	fLeft = (int32)bounds.left;
+	fTop = (int32)bounds.top;
+
+	return B_OK;
+}
+
 // #pragma mark -
 
 // _Attach
@@ -177,12 +217,14 @@ PixelBuffer::_Attach(uint8* buffer, uint32 width, uint32 height,
 	fBytesPerPixel = bytesPerPixel;
 	if (adopt) {
 		fBits = buffer;
+		fAllocatedLength = 0;
 		fBytesPerRow = bytesPerRow;
 		if (fBytesPerRow < width * fBytesPerPixel)
 			debugger("Buffer size insufficient for given width.");
 	} else {
 		fBytesPerRow = width * fBytesPerPixel;
 		fBits = new uint8[fBytesPerRow * height];
+		fAllocatedLength = fBytesPerRow * height;
 		uint8* dst = fBits;
 		for (uint32 y = 0; y < height; y++) {
 			memcpy(dst, buffer, fBytesPerRow);
@@ -46,6 +46,8 @@ public:
 
 			void				CopyTo(PixelBuffer* buffer, BRect area) const;
 
+			status_t			SetBounds(const BRect& bounds);
+
 protected:
 			void				_Attach(uint8* buffer,
 									uint32 width, uint32 height,
@@ -66,6 +68,7 @@ protected:
 			int32				fLeft;
 			int32				fTop;
 			bool				fAdopted;
+			uint32				fAllocatedLength;
 };
 
 #endif // PIXEL_BUFFER_H
@@ -0,0 +1,618 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "PixelKernels.h"
+
+#include <string.h>
+
+#include <agg_color_rgba.h>
+
+#include "RenderEngine.h"
+#include "support.h"
+
+#if defined(__x86_64__) && (defined(__clang__) || __GNUC__ >= 5)
+#	define USE_X86_KERNELS 1
+#	include <immintrin.h>
+#else
+#	define USE_X86_KERNELS 0
+#endif
+
+// The SIMD versions need to compute the same results as the C versions
+// bit by bit. Integer divisions by 65535 are exact with
+// (x + 1 + (x >> 16)) >> 16 for all products of two 16 bit values, and the
+// agg::rgba16 premultiplication is the same as int_mult() for all alpha
+// values. The float kernels assume that multiplications and additions are
+// not contracted into fused multiply-adds, which is the case unless
+// compiling for FMA capable CPUs explicitly.
+
+
+// #pragma mark - C
+
+
+// fill_row_c
+static void
+fill_row_c(uint16* dst, const uint16 color[4], int32 count)
+{
+	for (int32 x = 0; x < count; x++) {
+		dst[0] = color[0];
+		dst[1] = color[1];
+		dst[2] = color[2];
+		dst[3] = color[3];
+		dst += 4;
+	}
+}
+
+// blend_row_c
+static void
+blend_row_c(uint16* d, const uint16* s, int32 count)
+{
+	for (int32 x = 0; x < count; x++) {
+		uint16 alpha = 65535 - s[3];
+		d[0] = (uint16)((((uint32)d[0] * alpha) / 65535) + s[0]);
+		d[1] = (uint16)((((uint32)d[1] * alpha) / 65535) + s[1]);
+		d[2] = (uint16)((((uint32)d[2] * alpha) / 65535) + s[2]);
+		d[3] = (uint16)(65535 - (((uint32)alpha * (65535 - d[3])) / 65535));
+		d += 4;
+		s += 4;
+	}
+}
+
+// linear_to_gamma_row_c
+static void
+linear_to_gamma_row_c(uint8* d, const uint16* s, int32 count)
+{
+	for (int32 x = 0; x < count; x++) {
+		// TODO: Right now the bitmap is solid, i.e. no transparency.
+		// If there were transparency, we would have to demultiply before
+		// applying inverse gamma.
+		d[0] = RenderEngine::LinearToGamma(s[0]);
+		d[1] = RenderEngine::LinearToGamma(s[1]);
+		d[2] = RenderEngine::LinearToGamma(s[2]);
+		d[3] = s[3] >> 8;
+		d += 4;
+		s += 4;
+	}
+}
+
+// gamma_to_linear_row_c
+static void
+gamma_to_linear_row_c(uint16* d, const uint8* s, int32 count, bool hasAlpha)
+{
+	for (int32 x = 0; x < count; x++) {
+		agg::rgba16 color(
+			RenderEngine::GammaToLinear(s[2]),
+			RenderEngine::GammaToLinear(s[1]),
+			RenderEngine::GammaToLinear(s[0]),
+			hasAlpha ? ((uint16)s[3] << 8) | s[3] : 65535);
+		if (hasAlpha)
+			color.premultiply();
+		d[0] = color.b;
+		d[1] = color.g;
+		d[2] = color.r;
+		d[3] = color.a;
+		d += 4;
+		s += 4;
+	}
+}
+
+// contrast_row_c
+static void
+contrast_row_c(uint16* p, int32 count, float center, float contrast)
+{
+	for (int32 x = 0; x < count; x++) {
+		float b = p[0] / 256.0f;
+		float g = p[1] / 256.0f;
+		float r = p[2] / 256.0f;
+
+		b = center + (b - center) * contrast;
+		g = center + (g - center) * contrast;
+		r = center + (r - center) * contrast;
+
+		p[0] = constrain_int32_0_65535((int32)(b * 256.0f));
+		p[1] = constrain_int32_0_65535((int32)(g * 256.0f));
+		p[2] = constrain_int32_0_65535((int32)(r * 256.0f));
+
+		// TODO: Confirm/improve this code which is supposed
+		// to implement the pre-multiplication of the alpha-channel
+		// (which results in the restriction that no color-channel
+		// has a higher value than the alpha-channel).
+		if (p[0] > p[3])
+			p[0] = p[3];
+		if (p[1] > p[3])
+			p[1] = p[3];
+		if (p[2] > p[3])
+			p[2] = p[3];
+
+		p += 4;
+	}
+}
+
+// desaturate_row_c
+static void
+desaturate_row_c(uint16* p, int32 count, int32 coeff)
+{
+	const int32 oneMinusCoeff = 256 - coeff;
+
+	for (int32 x = 0; x < count; x++) {
+		int32 lum = 28 * p[0];	// B
+		lum += 151 * p[1];		// G
+		lum += 77 * p[2];		// R
+		lum = lum >> 8;
+
+		p[0] = (p[0] * coeff + lum * oneMinusCoeff) >> 8;
+		p[1] = (p[1] * coeff + lum * oneMinusCoeff) >> 8;
+		p[2] = (p[2] * coeff + lum * oneMinusCoeff) >> 8;
+
+		p += 4;
+	}
+}
+
+// extract_alpha_row_c
+static void
+extract_alpha_row_c(uint16* d, const uint16* s, int32 count, uint16 opacity)
+{
+	for (int32 x = 0; x < count; x++) {
+		d[0] = (uint16)((uint32)s[3] * opacity / 65535);
+		d += 1;
+		s += 4;
+	}
+}
+
+// shadow_row_c
+static void
+shadow_row_c(uint16* d, const uint16* s, int32 count, const uint16 color[3])
+{
+	for (int32 x = 0; x < count; x++) {
+		agg::rgba16 shadowColor(color[2], color[1], color[0], s[0]);
+		shadowColor.premultiply();
+
+		uint16 alpha = 65535 - d[3];
+
+		d[0] = (uint16)((((uint32)shadowColor.b * alpha) / 65535) + d[0]);
+		d[1] = (uint16)((((uint32)shadowColor.g * alpha) / 65535) + d[1]);
+		d[2] = (uint16)((((uint32)shadowColor.r * alpha) / 65535) + d[2]);
+		d[3] = (uint16)(65535 - (((uint32)alpha * (65535 - s[0])) / 65535));
+
+		d += 4;
+		s += 1;
+	}
+}
+
+
+#if USE_X86_KERNELS
+
+// #pragma mark - SSE4.1
+
+
+#define SSE41 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+
+// div_65535_sse41
+static inline SSE41 __m128i
+div_65535_sse41(__m128i x)
+{
+	__m128i t = _mm_add_epi32(x, _mm_srli_epi32(x, 16));
+	return _mm_srli_epi32(_mm_add_epi32(t, _mm_set1_epi32(1)), 16);
+}
+
+// int_mult_sse41
+static inline SSE41 __m128i
+int_mult_sse41(__m128i a, __m128i b)
+{
+	__m128i t = _mm_add_epi32(_mm_mullo_epi32(a, b), _mm_set1_epi32(32768));
+	return _mm_srli_epi32(_mm_add_epi32(_mm_srli_epi32(t, 16), t), 16);
+}
+
+// compose_sse41
+//
+// Composes one pixel per vector of 32 bit channels "s" over "d", where
+// "alpha" holds 65535 minus the coverage of "s" in all channels.
+static inline SSE41 __m128i
+compose_sse41(__m128i d, __m128i s, __m128i alpha)
+{
+	const __m128i alphaChannel = _mm_set_epi32(0xffff, 0, 0, 0);
+	const __m128i colorChannels = _mm_set_epi32(0, -1, -1, -1);
+
+	// In the alpha channel, this computes 65535 - x as x ^ 0xffff.
+	__m128i result = div_65535_sse41(
+		_mm_mullo_epi32(_mm_xor_si128(d, alphaChannel), alpha));
+	result = _mm_add_epi32(result, _mm_and_si128(s, colorChannels));
+	result = _mm_xor_si128(result, alphaChannel);
+	return _mm_and_si128(result, _mm_set1_epi32(0xffff));
+}
+
+// fill_row_sse41
+static SSE41 void
+fill_row_sse41(uint16* dst, const uint16 color[4], int32 count)
+{
+	uint64 pixel;
+	memcpy(&pixel, color, sizeof(pixel));
+	__m128i pixels = _mm_set1_epi64x(pixel);
+
+	int32 x = 0;
+	for (; x + 2 <= count; x += 2) {
+		_mm_storeu_si128((__m128i*)dst, pixels);
+		dst += 8;
+	}
+	fill_row_c(dst, color, count - x);
+}
+
+// blend_row_sse41
+static SSE41 void
+blend_row_sse41(uint16* d, const uint16* s, int32 count)
+{
+	const __m128i max = _mm_set1_epi32(65535);
+
+	int32 x = 0;
+	for (; x + 2 <= count; x += 2) {
+		__m128i source = _mm_loadu_si128((const __m128i*)s);
+		__m128i dest = _mm_loadu_si128((const __m128i*)d);
+
+		__m128i s0 = _mm_cvtepu16_epi32(source);
+		__m128i s1 = _mm_cvtepu16_epi32(_mm_srli_si128(source, 8));
+		__m128i d0 = _mm_cvtepu16_epi32(dest);
+		__m128i d1 = _mm_cvtepu16_epi32(_mm_srli_si128(dest, 8));
+
+		__m128i a0 = _mm_sub_epi32(max, _mm_shuffle_epi32(s0, 0xff));
+		__m128i a1 = _mm_sub_epi32(max, _mm_shuffle_epi32(s1, 0xff));
+
+		_mm_storeu_si128((__m128i*)d, _mm_packus_epi32(
+			compose_sse41(d0, s0, a0), compose_sse41(d1, s1, a1)));
+
+		d += 8;
+		s += 8;
+	}
+	blend_row_c(d, s, count - x);
+}
+
+// contrast_row_sse41
+static SSE41 void
+contrast_row_sse41(uint16* p, int32 count, float center, float contrast)
+{
+	const __m128 centers = _mm_set1_ps(center);
+	const __m128 contrasts = _mm_set1_ps(contrast);
+	const __m128 scale = _mm_set1_ps(256.0f);
+	const __m128i max = _mm_set1_epi32(65535);
+	const __m128i min = _mm_setzero_si128();
+
+	for (int32 x = 0; x < count; x++) {
+		__m128i pixel = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i*)p));
+
+		__m128 values = _mm_div_ps(_mm_cvtepi32_ps(pixel), scale);
+		values = _mm_add_ps(centers,
+			_mm_mul_ps(_mm_sub_ps(values, centers), contrasts));
+
+		__m128i result = _mm_cvttps_epi32(_mm_mul_ps(values, scale));
+		result = _mm_max_epi32(_mm_min_epi32(result, max), min);
+		result = _mm_min_epi32(result, _mm_shuffle_epi32(pixel, 0xff));
+		result = _mm_blend_epi16(result, pixel, 0xc0);
+
+		_mm_storel_epi64((__m128i*)p, _mm_packus_epi32(result, result));
+		p += 4;
+	}
+}
+
+// desaturate_row_sse41
+static SSE41 void
+desaturate_row_sse41(uint16* p, int32 count, int32 coeff)
+{
+	const __m128i weights = _mm_set_epi32(0, 77, 151, 28);
+	const __m128i coeffs = _mm_set1_epi32(coeff);
+	const __m128i oneMinusCoeffs = _mm_set1_epi32(256 - coeff);
+
+	for (int32 x = 0; x < count; x++) {
+		__m128i pixel = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i*)p));
+
+		__m128i lum = _mm_mullo_epi32(pixel, weights);
+		lum = _mm_hadd_epi32(lum, lum);
+		lum = _mm_srli_epi32(_mm_hadd_epi32(lum, lum), 8);
+
+		__m128i result = _mm_add_epi32(_mm_mullo_epi32(pixel, coeffs),
+			_mm_mullo_epi32(lum, oneMinusCoeffs));
+		result = _mm_and_si128(_mm_srli_epi32(result, 8),
+			_mm_set1_epi32(0xffff));
+		result = _mm_blend_epi16(result, pixel, 0xc0);
+
+		_mm_storel_epi64((__m128i*)p, _mm_packus_epi32(result, result));
+		p += 4;
+	}
+}
+
+// extract_alpha_row_sse41
+static SSE41 void
+extract_alpha_row_sse41(uint16* d, const uint16* s, int32 count,
+	uint16 opacity)
+{
+	const __m128i opacities = _mm_set1_epi32(opacity);
+
+	int32 x = 0;
+	for (; x + 4 <= count; x += 4) {
+		// Move the alpha channel of each pixel into the low word
+		__m128i alpha01 = _mm_srli_epi64(
+			_mm_loadu_si128((const __m128i*)s), 48);
+		__m128i alpha23 = _mm_srli_epi64(
+			_mm_loadu_si128((const __m128i*)(s + 8)), 48);
+		__m128i alpha = _mm_unpacklo_epi64(
+			_mm_shuffle_epi32(alpha01, _MM_SHUFFLE(3, 1, 2, 0)),
+			_mm_shuffle_epi32(alpha23, _MM_SHUFFLE(3, 1, 2, 0)));
+
+		alpha = div_65535_sse41(_mm_mullo_epi32(alpha, opacities));
+
+		_mm_storel_epi64((__m128i*)d, _mm_packus_epi32(alpha, alpha));
+		d += 4;
+		s += 16;
+	}
+	extract_alpha_row_c(d, s, count - x, opacity);
+}
+
+// shadow_row_sse41
+static SSE41 void
+shadow_row_sse41(uint16* d, const uint16* s, int32 count,
+	const uint16 color[3])
+{
+	const __m128i max = _mm_set1_epi32(65535);
+	const __m128i colors = _mm_set_epi32(0, color[2], color[1], color[0]);
+
+	for (int32 x = 0; x < count; x++) {
+		__m128i coverage = _mm_set1_epi32(s[0]);
+		__m128i dest = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i*)d));
+
+		// The shadow is composed behind the pixel, which is the same as
+		// composing the pixel over the shadow, except for the order of the
+		// arguments in the color channels.
+		__m128i shadow = _mm_blend_epi16(int_mult_sse41(colors, coverage),
+			coverage, 0xc0);
+		__m128i alpha = _mm_sub_epi32(max, _mm_shuffle_epi32(dest, 0xff));
+		__m128i result = compose_sse41(shadow, dest, alpha);
+
+		_mm_storel_epi64((__m128i*)d, _mm_packus_epi32(result, result));
+		d += 4;
+		s += 1;
+	}
+}
+
+
+// #pragma mark - AVX2
+
+
+// div_65535_avx2
+static inline AVX2 __m256i
+div_65535_avx2(__m256i x)
+{
+	__m256i t = _mm256_add_epi32(x, _mm256_srli_epi32(x, 16));
+	return _mm256_srli_epi32(_mm256_add_epi32(t, _mm256_set1_epi32(1)), 16);
+}
+
+// int_mult_avx2
+static inline AVX2 __m256i
+int_mult_avx2(__m256i a, __m256i b)
+{
+	__m256i t = _mm256_add_epi32(_mm256_mullo_epi32(a, b),
+		_mm256_set1_epi32(32768));
+	return _mm256_srli_epi32(_mm256_add_epi32(_mm256_srli_epi32(t, 16), t),
+		16);
+}
+
+// compose_avx2
+static inline AVX2 __m256i
+compose_avx2(__m256i d, __m256i s, __m256i alpha)
+{
+	const __m256i alphaChannel = _mm256_set_epi32(0xffff, 0, 0, 0,
+		0xffff, 0, 0, 0);
+	const __m256i colorChannels = _mm256_set_epi32(0, -1, -1, -1,
+		0, -1, -1, -1);
+
+	__m256i result = div_65535_avx2(
+		_mm256_mullo_epi32(_mm256_xor_si256(d, alphaChannel), alpha));
+	result = _mm256_add_epi32(result, _mm256_and_si256(s, colorChannels));
+	result = _mm256_xor_si256(result, alphaChannel);
+	return _mm256_and_si256(result, _mm256_set1_epi32(0xffff));
+}
+
+// blend_row_avx2
+static AVX2 void
+blend_row_avx2(uint16* d, const uint16* s, int32 count)
+{
+	const __m256i max = _mm256_set1_epi32(65535);
+
+	int32 x = 0;
+	for (; x + 4 <= count; x += 4) {
+		// Two pixels per vector, one in each 128 bit lane
+		__m256i s0 = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128((const __m128i*)s));
+		__m256i s1 = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128((const __m128i*)(s + 8)));
+		__m256i d0 = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128((const __m128i*)d));
+		__m256i d1 = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128((const __m128i*)(d + 8)));
+
+		__m256i a0 = _mm256_sub_epi32(max, _mm256_shuffle_epi32(s0, 0xff));
+		__m256i a1 = _mm256_sub_epi32(max, _mm256_shuffle_epi32(s1, 0xff));
+
+		// Packing works within the lanes, which leaves the pixels in the
+		// order 0, 2, 1, 3.
+		__m256i result = _mm256_packus_epi32(compose_avx2(d0, s0, a0),
+			compose_avx2(d1, s1, a1));
+		result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)d, result);
+
+		d += 16;
+		s += 16;
+	}
+	blend_row_sse41(d, s, count - x);
+}
+
+// linear_to_gamma_row_avx2
+static AVX2 void
+linear_to_gamma_row_avx2(uint8* d, const uint16* s, int32 count)
+{
+	const int* table = (const int*)RenderEngine::LinearToGammaTable();
+	const __m256i lowByte = _mm256_set1_epi32(0xff);
+	const __m256i order = _mm256_set_epi32(0, 0, 0, 0, 5, 1, 4, 0);
+
+	int32 x = 0;
+	for (; x + 4 <= count; x += 4) {
+		__m256i p01 = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128((const __m128i*)s));
+		__m256i p23 = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128((const __m128i*)(s + 8)));
+
+		// The gathers read 32 bits at each byte index, the table is padded
+		// accordingly.
+		__m256i g01 = _mm256_and_si256(
+			_mm256_i32gather_epi32(table, p01, 1), lowByte);
+		__m256i g23 = _mm256_and_si256(
+			_mm256_i32gather_epi32(table, p23, 1), lowByte);
+		g01 = _mm256_blend_epi32(g01, _mm256_srli_epi32(p01, 8), 0x88);
+		g23 = _mm256_blend_epi32(g23, _mm256_srli_epi32(p23, 8), 0x88);
+
+		// Pixels end up in the order 0, 2, 0, 2, 1, 3, 1, 3
+		__m256i result = _mm256_packus_epi32(g01, g23);
+		result = _mm256_packus_epi16(result, result);
+		result = _mm256_permutevar8x32_epi32(result, order);
+		_mm_storeu_si128((__m128i*)d, _mm256_castsi256_si128(result));
+
+		d += 16;
+		s += 16;
+	}
+	linear_to_gamma_row_c(d, s, count - x);
+}
+
+// gamma_to_linear_row_avx2
+static AVX2 void
+gamma_to_linear_row_avx2(uint16* d, const uint8* s, int32 count,
+	bool hasAlpha)
+{
+	const int* table = (const int*)RenderEngine::GammaToLinearTable();
+	const __m256i lowWord = _mm256_set1_epi32(0xffff);
+	const __m256i max = _mm256_set1_epi32(65535);
+
+	int32 x = 0;
+	for (; x + 2 <= count; x += 2) {
+		__m256i pixels = _mm256_cvtepu8_epi32(
+			_mm_loadl_epi64((const __m128i*)s));
+
+		// The gather reads 32 bits at each 16 bit index, the table is
+		// padded accordingly.
+		__m256i linear = _mm256_and_si256(
+			_mm256_i32gather_epi32(table, pixels, 2), lowWord);
+
+		__m256i alpha = max;
+		if (hasAlpha) {
+			alpha = _mm256_mullo_epi32(_mm256_shuffle_epi32(pixels, 0xff),
+				_mm256_set1_epi32(257));
+			linear = int_mult_avx2(linear, alpha);
+		}
+		linear = _mm256_blend_epi32(linear, alpha, 0x88);
+
+		__m256i result = _mm256_packus_epi32(linear, linear);
+		result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i*)d, _mm256_castsi256_si128(result));
+
+		d += 8;
+		s += 8;
+	}
+	gamma_to_linear_row_c(d, s, count - x, hasAlpha);
+}
+
+#endif // USE_X86_KERNELS
+
+
+// #pragma mark - PixelKernels
+
+
+PixelKernels::FillRowFunc PixelKernels::FillRow = fill_row_c;
+PixelKernels::BlendRowFunc PixelKernels::BlendRow = blend_row_c;
+PixelKernels::LinearToGammaRowFunc PixelKernels::LinearToGammaRow
+	= linear_to_gamma_row_c;
+PixelKernels::GammaToLinearRowFunc PixelKernels::GammaToLinearRow
+	= gamma_to_linear_row_c;
+PixelKernels::ContrastRowFunc PixelKernels::ContrastRow = contrast_row_c;
+PixelKernels::DesaturateRowFunc PixelKernels::DesaturateRow
+	= desaturate_row_c;
+PixelKernels::ExtractAlphaRowFunc PixelKernels::ExtractAlphaRow
+	= extract_alpha_row_c;
+PixelKernels::ShadowRowFunc PixelKernels::ShadowRow = shadow_row_c;
+
+static const char* sName = "C";
+
+static bool sInitialized = PixelKernels::Init();
+
+// Init
+bool
+PixelKernels::Init()
+{
+	if (IsSupported(AVX2_KERNELS))
+		return Select(AVX2_KERNELS);
+	if (IsSupported(SSE41_KERNELS))
+		return Select(SSE41_KERNELS);
+	return Select(C_KERNELS);
+}
+
+// Select
+bool
+PixelKernels::Select(int32 level)
+{
+	if (!IsSupported(level))
+		return false;
+
+	FillRow = fill_row_c;
+	BlendRow = blend_row_c;
+	LinearToGammaRow = linear_to_gamma_row_c;
+	GammaToLinearRow = gamma_to_linear_row_c;
+	ContrastRow = contrast_row_c;
+	DesaturateRow = desaturate_row_c;
+	ExtractAlphaRow = extract_alpha_row_c;
+	ShadowRow = shadow_row_c;
+	sName = "C";
+
+#if USE_X86_KERNELS
+	if (level >= SSE41_KERNELS) {
+		FillRow = fill_row_sse41;
+		BlendRow = blend_row_sse41;
+		ContrastRow = contrast_row_sse41;
+		DesaturateRow = desaturate_row_sse41;
+		ExtractAlphaRow = extract_alpha_row_sse41;
+		ShadowRow = shadow_row_sse41;
+		sName = "SSE4.1";
+	}
+
+	if (level >= AVX2_KERNELS) {
+		BlendRow = blend_row_avx2;
+		LinearToGammaRow = linear_to_gamma_row_avx2;
+		GammaToLinearRow = gamma_to_linear_row_avx2;
+		sName = "AVX2";
+	}
+#endif
+	return true;
+}
+
+// IsSupported
+bool
+PixelKernels::IsSupported(int32 level)
+{
+	switch (level) {
+		case C_KERNELS:
+			return true;
+#if USE_X86_KERNELS
+		case SSE41_KERNELS:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse4.1");
+		case AVX2_KERNELS:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return false;
+	}
+}
+
+// Name
+const char*
+PixelKernels::Name()
+{
+	return sName;
+}
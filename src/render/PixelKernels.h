@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include <SupportDefs.h>
+
+// PixelKernels contains the inner row loops for the 16 bit per channel,
+// premultiplied, linear BGRA pixels of RenderBuffers. Init() selects the
+// fastest implementation the CPU supports (SSE4.1 or AVX2 on x86_64). All
+// implementations produce exactly the same pixels as the plain C versions,
+// Select() allows the tests to compare them. Init() runs during static
+// initialization, before that the C versions are used.
+
+class PixelKernels {
+public:
+	enum {
+		C_KERNELS		= 0,
+		SSE41_KERNELS	= 1,
+		AVX2_KERNELS	= 2
+	};
+
+	typedef void (*FillRowFunc)(uint16* dst, const uint16 color[4],
+		int32 count);
+	typedef void (*BlendRowFunc)(uint16* dst, const uint16* src,
+		int32 count);
+	typedef void (*LinearToGammaRowFunc)(uint8* dst, const uint16* src,
+		int32 count);
+	typedef void (*GammaToLinearRowFunc)(uint16* dst, const uint8* src,
+		int32 count, bool hasAlpha);
+	typedef void (*ContrastRowFunc)(uint16* pixels, int32 count,
+		float center, float contrast);
+	typedef void (*DesaturateRowFunc)(uint16* pixels, int32 count,
+		int32 coeff);
+	typedef void (*ExtractAlphaRowFunc)(uint16* dst, const uint16* src,
+		int32 count, uint16 opacity);
+	typedef void (*ShadowRowFunc)(uint16* dst, const uint16* alpha,
+		int32 count, const uint16 color[3]);
+
+	static	bool				Init();
+	// Selects the kernels of the given level, and those of the lower
+	// levels where there is no version for it. Returns false if the CPU
+	// does not support the level.
+	static	bool				Select(int32 level);
+	static	bool				IsSupported(int32 level);
+	static	const char*			Name();
+
+	// Fills count pixels with the given (premultiplied) color.
+	static	FillRowFunc			FillRow;
+	// Composes the source pixels over the destination pixels.
+	static	BlendRowFunc		BlendRow;
+	// Converts to 8 bit BGRA with gamma, the color is not demultiplied.
+	static	LinearToGammaRowFunc LinearToGammaRow;
+	// Converts 8 bit BGRA/BGRX with gamma to linear and premultiplies.
+	static	GammaToLinearRowFunc GammaToLinearRow;
+	// The FilterContrast pixel function.
+	static	ContrastRowFunc		ContrastRow;
+	// The FilterSaturation pixel function for saturations below 1.0,
+	// coeff is the saturation in the range 0...256.
+	static	DesaturateRowFunc	DesaturateRow;
+	// Copies the alpha channel of the pixels into a 16 bit gray row,
+	// multiplied by opacity.
+	static	ExtractAlphaRowFunc	ExtractAlphaRow;
+	// Composes the linear color, with the coverage given by the alpha row,
+	// behind the destination pixels.
+	static	ShadowRowFunc		ShadowRow;
+};
+
+#endif // PIXEL_KERNELS_H
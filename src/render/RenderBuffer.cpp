@@ -13,6 +13,7 @@
 #include <Bitmap.h>
 #include <debugger.h>
 
+#include "PixelKernels.h"
 #include "RenderEngine.h"
 
 // constructor
@@ -38,39 +39,13 @@ RenderBuffer::RenderBuffer(const BBitmap* bitmap)
 	uint8* src = reinterpret_cast<uint8*>(bitmap->Bits());
 	uint32 srcBPR = bitmap->BytesPerRow();
 
+	color_space colorSpace = bitmap->ColorSpace();
+	if (colorSpace != B_RGBA32 && colorSpace != B_RGB32)
+		return;
+
 	for (uint32 y = 0; y < fHeight; y++) {
-		uint16* d = reinterpret_cast<uint16*>(dst);
-		uint8* s = src;
-		if (bitmap->ColorSpace() == B_RGBA32) {
-			for (uint32 x = 0; x < fWidth; x++) {
-				agg::rgba16 color(
-					RenderEngine::GammaToLinear(s[2]),
-					RenderEngine::GammaToLinear(s[1]),
-					RenderEngine::GammaToLinear(s[0]),
-					((uint16)s[3] << 8) | s[3]);
-				color.premultiply();
-				d[0] = color.b;
-				d[1] = color.g;
-				d[2] = color.r;
-				d[3] = color.a;
-				d += 4;
-				s += 4;
-			}
-		} else if (bitmap->ColorSpace() == B_RGB32) {
-			for (uint32 x = 0; x < fWidth; x++) {
-				agg::rgba16 color(
-					RenderEngine::GammaToLinear(s[2]),
-					RenderEngine::GammaToLinear(s[1]),
-					RenderEngine::GammaToLinear(s[0]),
-					65535);
-				d[0] = color.b;
-				d[1] = color.g;
-				d[2] = color.r;
-				d[3] = color.a;
-				d += 4;
-				s += 4;
-			}
-		}
+		PixelKernels::GammaToLinearRow(reinterpret_cast<uint16*>(dst), src,
+			fWidth, colorSpace == B_RGBA32);
 		src += srcBPR;
 		dst += fBytesPerRow;
 	}
@@ -119,15 +94,13 @@ RenderBuffer::Clear(BRect area, const rgb_color& color)
 		color.alpha * 256 + color.alpha);
 	linearColor.premultiply();
 
+	const uint16 pixel[4] = {
+		linearColor.b, linearColor.g, linearColor.r, linearColor.a
+	};
+
 	for (int32 y = 0; y < height; y++) {
-		uint16* d = reinterpret_cast<uint16*>(dst);
-		for (int32 x = left; x <= right; x++) {
-			d[0] = linearColor.b;
-			d[1] = linearColor.g;
-			d[2] = linearColor.r;
-			d[3] = linearColor.a;
-			d += 4;
-		}
+		PixelKernels::FillRow(reinterpret_cast<uint16*>(dst), pixel,
+			right - left + 1);
 		dst += fBytesPerRow;
 	}
 }
@@ -161,19 +134,8 @@ RenderBuffer::CopyTo(BBitmap* bitmap, BRect area) const
 	src += (top - fTop) * fBytesPerRow;
 
 	for (int32 y = 0; y < height; y++) {
-		uint8* d = dst;
-		uint16* s = reinterpret_cast<uint16*>(src);
-		for (int32 x = left; x <= right; x++) {
-			// TODO: Right now the bitmap is solid, i.e. no transparency.
-			// If there were transparency, we would have to demultiply before
-			// applying inverse gamma.
-			d[0] = RenderEngine::LinearToGamma(s[0]);
-			d[1] = RenderEngine::LinearToGamma(s[1]);
-			d[2] = RenderEngine::LinearToGamma(s[2]);
-			d[3] = s[3] >> 8;
-			d += 4;
-			s += 4;
-		}
+		PixelKernels::LinearToGammaRow(dst,
+			reinterpret_cast<uint16*>(src), right - left + 1);
 		src += fBytesPerRow;
 		dst += dstBPR;
 	}
@@ -208,26 +170,8 @@ RenderBuffer::BlendTo(RenderBuffer* buffer, BRect area) const
 	int32 height = area.IntegerHeight() + 1;
 
 	for (int32 y = 0; y < height; y++) {
-		uint16* d = reinterpret_cast<uint16*>(dst);
-		uint16* s = reinterpret_cast<uint16*>(src);
-		for (int32 x = left; x <= right; x++) {
-
-			uint16 alpha = 65535 - s[3];
-#if 0
-			d[0] = (uint16)((((uint32)d[0] * alpha) >> 16) + s[0]);
-			d[1] = (uint16)((((uint32)d[1] * alpha) >> 16) + s[1]);
-			d[2] = (uint16)((((uint32)d[2] * alpha) >> 16) + s[2]);
-			d[3] = (uint16)(65535 - (((uint32)alpha * (65535 - d[3])) >> 16));
-#else
-			d[0] = (uint16)((((uint32)d[0] * alpha) / 65535) + s[0]);
-			d[1] = (uint16)((((uint32)d[1] * alpha) / 65535) + s[1]);
-			d[2] = (uint16)((((uint32)d[2] * alpha) / 65535) + s[2]);
-			d[3] = (uint16)(65535 - (((uint32)alpha * (65535 - d[3])) / 65535));
-#endif
-
-			d += 4;
-			s += 4;
-		}
+		PixelKernels::BlendRow(reinterpret_cast<uint16*>(dst),
+			reinterpret_cast<uint16*>(src), right - left + 1);
 		src += fBytesPerRow;
 		dst += dstBPR;
 	}
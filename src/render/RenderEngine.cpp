@@ -4,7 +4,10 @@
  */
 #include "RenderEngine.h"
 
+#include <math.h>
 #include <new>
+#include <stdlib.h>
+#include <string.h>
 
 #include <agg_conv_contour.h>
 #include <agg_image_accessors.h>
@@ -19,17 +22,265 @@
 
 #include <CImg.h>
 
+#include "BrushStampCache.h"
 #include "Gradient.h"
 #include "Interpolation.h"
+#include "MipPyramid.h"
 #include "RenderBuffer.h"
+#include "RenderTrace.h"
 #include "SetProperty.h"
 
 using std::nothrow;
 
+// The weights of the resampling filter only depend on the kernel, so they
+// are computed once for all RenderEngines. Hanning is almost as fast as
+// bilinear, but slightly crisper. Blackman(3.0) is much crisper, but 6.81
+// times slower.
+static const agg::image_filter_lut sResampleFilter(
+	agg::image_filter_hanning(), true);
+
+
+// Blends the spans of two span generators, which sample neighbouring levels
+// of a MipPyramid. The weight of the coarse level is in the range 0...256.
+template<class SpanGenerator>
+class TrilinearSpanGenerator {
+public:
+	typedef typename SpanGenerator::color_type	color_type;
+
+	TrilinearSpanGenerator(SpanGenerator& fine, SpanGenerator& coarse,
+			uint32 coarseWeight)
+		: fFine(fine)
+		, fCoarse(coarse)
+		, fCoarseWeight(coarseWeight)
+	{
+	}
+
+	void prepare()
+	{
+		fFine.prepare();
+		fCoarse.prepare();
+	}
+
+	void generate(color_type* span, int x, int y, unsigned length)
+	{
+		fFine.generate(span, x, y, length);
+		color_type* coarse = fAllocator.allocate(length);
+		fCoarse.generate(coarse, x, y, length);
+
+		int32 weight = fCoarseWeight;
+		for (unsigned i = 0; i < length; i++, span++, coarse++) {
+			span->r += ((int32)coarse->r - span->r) * weight >> 8;
+			span->g += ((int32)coarse->g - span->g) * weight >> 8;
+			span->b += ((int32)coarse->b - span->b) * weight >> 8;
+			span->a += ((int32)coarse->a - span->a) * weight >> 8;
+		}
+	}
+
+private:
+	SpanGenerator&						fFine;
+	SpanGenerator&						fCoarse;
+	uint32								fCoarseWeight;
+	agg::span_allocator<color_type>		fAllocator;
+};
+
+
+// level_matrix
+/*!	Returns the transformation from the image space of the pyramid level into
+	the space of the image at full size.
+*/
+static agg::trans_affine
+level_matrix(const RenderBuffer* buffer, const RenderBuffer* level)
+{
+	return agg::trans_affine_scaling(
+		(double)buffer->Width() / level->Width(),
+		(double)buffer->Height() / level->Height());
+}
+
+
+// #pragma mark - StyleHandler
+
+// Provides the colors of the scanlines which are rendered together by
+// RenderEngine::RenderCompound(), like the StyleHandler of the IconRenderer.
+// Each style keeps its scanlines and the position of the next row to mix.
+class RenderEngine::StyleHandler {
+public:
+	StyleHandler()
+		: fStyles(20)
+		, fStyleCount(0)
+		, fTransparent(0, 0, 0, 0)
+	{
+	}
+
+	~StyleHandler()
+	{
+		int32 count = fStyles.CountItems();
+		for (int32 i = 0; i < count; i++)
+			delete (StyleItem*)fStyles.ItemAtFast(i);
+	}
+
+	void MakeEmpty()
+	{
+		// The items are kept for the next run of paths.
+		fStyleCount = 0;
+	}
+
+	int32 CountStyles() const
+	{
+		return fStyleCount;
+	}
+
+	int32 AddStyle(const Paint* paint, const Transformable& transformation,
+		const ScanlineContainer& scanlines)
+	{
+		StyleItem* item = NULL;
+		if (fStyleCount < fStyles.CountItems()) {
+			item = (StyleItem*)fStyles.ItemAtFast(fStyleCount);
+		} else {
+			item = new(nothrow) StyleItem;
+			if (item == NULL || !fStyles.AddItem(item)) {
+				delete item;
+				return -1;
+			}
+		}
+
+		item->paint = paint;
+		item->scanlines = &scanlines;
+		item->next = 0;
+		if (paint->Type() == Paint::GRADIENT) {
+			const GradientRef& gradient = paint->Gradient();
+			item->transformation = *gradient.Get();
+			if (gradient->InheritTransformation())
+				item->transformation.Multiply(transformation);
+			if (!item->transformation.IsValid())
+				return -1;
+			item->transformation.invert();
+		} else {
+			rgb_color c = paint->Color();
+			item->color = agg::rgba16(
+				RenderEngine::GammaToLinear(c.red),
+				RenderEngine::GammaToLinear(c.green),
+				RenderEngine::GammaToLinear(c.blue),
+				(c.alpha << 8) | c.alpha);
+			item->color.premultiply();
+		}
+
+		return fStyleCount++;
+	}
+
+	const Scanline* ScanlineAt(unsigned styleIndex) const
+	{
+		const StyleItem* item = _ItemAt(styleIndex);
+		if (item == NULL || item->next >= item->scanlines->CountObjects())
+			return NULL;
+		return item->scanlines->ObjectAtFast(item->next);
+	}
+
+	void SkipScanline(unsigned styleIndex)
+	{
+		StyleItem* item = _ItemAt(styleIndex);
+		if (item != NULL)
+			item->next++;
+	}
+
+	bool is_solid(unsigned styleIndex) const
+	{
+		const StyleItem* item = _ItemAt(styleIndex);
+		return item == NULL || item->paint->Type() != Paint::GRADIENT;
+	}
+
+	const agg::rgba16& color(unsigned styleIndex) const
+	{
+		const StyleItem* item = _ItemAt(styleIndex);
+		if (item == NULL)
+			return fTransparent;
+		return item->color;
+	}
+
+	void generate_span(agg::rgba16* span, int x, int y, unsigned length,
+		unsigned styleIndex)
+	{
+		StyleItem* item = _ItemAt(styleIndex);
+		if (item == NULL)
+			return;
+
+		switch (item->paint->Gradient()->GetType()) {
+			case Gradient::CIRCULAR:
+				_GenerateGradient(span, x, y, length,
+					agg::gradient_radial(), item);
+				break;
+			case Gradient::DIAMOND:
+				_GenerateGradient(span, x, y, length,
+					agg::gradient_diamond(), item);
+				break;
+			case Gradient::CONIC:
+				_GenerateGradient(span, x, y, length,
+					agg::gradient_conic(), item);
+				break;
+			case Gradient::XY:
+				_GenerateGradient(span, x, y, length,
+					agg::gradient_xy(), item);
+				break;
+			case Gradient::SQRT_XY:
+				_GenerateGradient(span, x, y, length,
+					agg::gradient_sqrt_xy(), item);
+				break;
+			case Gradient::LINEAR:
+			default:
+				_GenerateGradient(span, x, y, length,
+					agg::gradient_x(), item);
+				break;
+		}
+	}
+
+private:
+	struct StyleItem {
+		const Paint*	paint;
+		agg::rgba16		color;
+		Transformable	transformation;
+		const ScanlineContainer* scanlines;
+		uint32			next;
+	};
+
+	StyleItem* _ItemAt(unsigned styleIndex) const
+	{
+		if (styleIndex >= (unsigned)fStyleCount)
+			return NULL;
+		return (StyleItem*)fStyles.ItemAtFast(styleIndex);
+	}
+
+	template<class GradientFunction>
+	void _GenerateGradient(agg::rgba16* span, int x, int y, unsigned length,
+		GradientFunction function, StyleItem* item)
+	{
+		typedef agg::span_interpolator_trans<Transformable> InterpolatorType;
+		typedef agg::pod_array_adaptor<agg::rgba16> ColorArrayType;
+		typedef agg::span_gradient<agg::rgba16, InterpolatorType,
+			GradientFunction, ColorArrayType> SpanGradientType;
+
+		InterpolatorType interpolator(item->transformation);
+		// The adaptor only reads the colors.
+		ColorArrayType array(const_cast<agg::rgba16*>(item->paint->Colors()),
+			kGradientArraySize);
+		// The same range as in RenderEngine::_RenderScanlines().
+		SpanGradientType gradientGenerator(interpolator, function, array,
+			0.0, 200.0);
+
+		gradientGenerator.generate(span, x, y, length);
+	}
+
+private:
+	BList				fStyles;
+	int32				fStyleCount;
+	agg::rgba16			fTransparent;
+};
+
+// #pragma mark -
+
 // constructor
 RenderEngine::RenderEngine()
 	: fState()
 
+	, fBounds()
 	, fRenderingBuffer()
 
 	, fAlphaBufferMemory(NULL)
@@ -45,6 +296,11 @@ RenderEngine::RenderEngine()
 	, fSpanAllocator()
 
 	, fRasterizer()
+
+	, fCompoundCovers()
+	, fStyleHandler(new(nothrow) StyleHandler())
+
+	, fBrushStamps(new(nothrow) BrushStampCache())
 {
 }
 
@@ -52,6 +308,7 @@ RenderEngine::RenderEngine()
 RenderEngine::RenderEngine(const Transformable& transformation)
 	: fState()
 
+	, fBounds()
 	, fRenderingBuffer()
 
 	, fAlphaBufferMemory(NULL)
@@ -67,6 +324,11 @@ RenderEngine::RenderEngine(const Transformable& transformation)
 	, fSpanAllocator()
 
 	, fRasterizer()
+
+	, fCompoundCovers()
+	, fStyleHandler(new(nothrow) StyleHandler())
+
+	, fBrushStamps(new(nothrow) BrushStampCache())
 {
 	SetTransformation(transformation);
 }
@@ -75,6 +337,8 @@ RenderEngine::RenderEngine(const Transformable& transformation)
 RenderEngine::~RenderEngine()
 {
 	free(fAlphaBufferMemory);
+	delete fStyleHandler;
+	delete fBrushStamps;
 }
 
 // SetState
@@ -112,23 +376,36 @@ RenderEngine::SetStrokeProperties(StrokeProperties* properties)
 }
 
 // AttachTo
+/*!	Attaches the engine to the bitmap. All drawing uses the coordinate
+	system of the bitmap, which does not need to start at 0, 0. The bitmap
+	may only cover the area that is being rendered, like a scratch bitmap
+	for one tile. Negative coordinates are not supported.
+*/
 void
 RenderEngine::AttachTo(RenderBuffer* bitmap)
 {
-	if (bitmap == NULL) {
+	if (bitmap == NULL || bitmap->Left() < 0 || bitmap->Top() < 0) {
+		fBounds = BRect();
 		fRenderingBuffer.attach(NULL, 0, 0, 0);
 		fBaseRenderer.clip_box(0, 0, 0, 0);
 		fCompOpBaseRenderer.clip_box(0, 0, 0, 0);
 		return;
 	}
 
-	// attach rendering buffer to bitmap
-	fRenderingBuffer.attach((uint8*)bitmap->Bits(),
-		bitmap->Width(), bitmap->Height(), bitmap->BytesPerRow());
+	fBounds = bitmap->Bounds();
 
-	fBaseRenderer.clip_box(0, 0, bitmap->Width() - 1, bitmap->Height() - 1);
-	fCompOpBaseRenderer.clip_box(0, 0, bitmap->Width() - 1,
-		bitmap->Height() - 1);
+	// Attach the rendering buffer as if the bitmap started at 0, 0. The
+	// clipping keeps the renderers within the pixels of the bitmap.
+	uint32 bpr = bitmap->BytesPerRow();
+	uint8* bits = (uint8*)bitmap->Bits() - bitmap->Top() * bpr
+		- bitmap->Left() * 8;
+	fRenderingBuffer.attach(bits, bitmap->Left() + bitmap->Width(),
+		bitmap->Top() + bitmap->Height(), bpr);
+
+	fBaseRenderer.clip_box((int32)fBounds.left, (int32)fBounds.top,
+		(int32)fBounds.right, (int32)fBounds.bottom);
+	fCompOpBaseRenderer.clip_box((int32)fBounds.left, (int32)fBounds.top,
+		(int32)fBounds.right, (int32)fBounds.bottom);
 
 	_ResizeAlphaBuffer();
 }
@@ -137,10 +414,11 @@ RenderEngine::AttachTo(RenderBuffer* bitmap)
 void
 RenderEngine::SetClipping(BRect area)
 {
-	BRect clipping(0, 0,
-		fRenderingBuffer.width() - 1, fRenderingBuffer.height() - 1);
-
-	clipping = area & clipping;
+	BRect clipping = area & fBounds;
+	if (!clipping.IsValid()) {
+		// Clip everything, the renderers don't accept an empty box.
+		clipping.Set(-1, -1, -1, -1);
+	}
 
 	fBaseRenderer.clip_box(
 		(int32)clipping.left, (int32)clipping.top,
@@ -186,12 +464,15 @@ RenderEngine::BlendArea(const RenderBuffer* source, BRect area, uint8 opacity,
 	if (!area.IsValid())
 		return;
 
+	TRACE_SPAN_AREA("blend area", NULL, area);
+
 	uint8* src = (uint8*)source->Bits();
 	uint32 bpr = source->BytesPerRow();
 	int32 left = (int32)area.left;
 	int32 top = (int32)area.top;
 
-	src += top * bpr + left * 8;
+	// The source buffer may be a tile, i.e. not start at the origin
+	src += (top - source->Top()) * bpr + (left - source->Left()) * 8;
 
 	RenderingBuffer sourceBuffer;
 	sourceBuffer.attach(src, area.IntegerWidth() + 1,
@@ -285,9 +566,14 @@ RenderEngine::DrawImage(const RenderBuffer* buffer, BRect area)
 }
 
 // DrawImage
+/*!	Draws the image with the current transformation. When it is scaled down
+	and a MipPyramid of the buffer is given, bilinear and resampling
+	interpolation read from the pyramid levels instead of the full size
+	pixels.
+*/
 void
 RenderEngine::DrawImage(const RenderBuffer* buffer, BRect area,
-	uint32 interpolation, uint8 opacity)
+	uint32 interpolation, uint8 opacity, MipPyramid* pyramid)
 {
 	if (!fState.Matrix.TransformBounds(buffer->Bounds())
 			.Intersects(area)) {
@@ -318,17 +604,29 @@ RenderEngine::DrawImage(const RenderBuffer* buffer, BRect area,
 
 	fRasterizer.add_path(transformedRoundRect);
 
-//bigtime_t now = system_time();
-	
+	TRACE_SPAN_AREA("draw image", NULL, area);
+
+	// Nearest neighbor sampling is meant to be cheap and keeps using the
+	// full size pixels.
+	bool filtered = interpolation == INTERPOLATION_BILINEAR
+		|| interpolation == INTERPOLATION_RESAMPLE;
+	if (pyramid != NULL && filtered && !fState.Matrix.IsPerspective()) {
+		double xScale;
+		double yScale;
+		fState.Matrix.GetScale(&xScale, &yScale);
+		double scale = max_c(xScale, yScale);
+		if (scale < 1.0 && _DrawImageMipMapped(buffer, pyramid,
+				interpolation, scale, opacity)) {
+			return;
+		}
+	}
+
 	if (interpolation == INTERPOLATION_NEAREST_NEIGHBOR)
 		_DrawImageNearestNeighbor(srcPixelFormat, imgMatrix, opacity);
 	else if (interpolation == INTERPOLATION_BILINEAR)
 		_DrawImageBilinear(srcPixelFormat, imgMatrix, opacity);
 	else
 		_DrawImageResample(srcPixelFormat, imgMatrix, opacity);
-	
-//printf("DrawImage(%u, %u): %lldµs\n", fRenderingBuffer.width(),
-//	fRenderingBuffer.height(), system_time() - now);
 }
 
 // RenderScanlines
@@ -339,6 +637,141 @@ RenderEngine::RenderScanlines(const ScanlineContainer& scanlines,
 	_RenderScanlines(fillPaint, &scanlines);
 }
 
+// RenderScanlines
+/*!	Renders the scanlines in the given premultiplied color, ignoring the
+	paints and the opacity of the current state.
+*/
+void
+RenderEngine::RenderScanlines(const ScanlineContainer& scanlines,
+	const agg::rgba16& color)
+{
+	_RenderScanlines(color, fBaseRenderer, &scanlines);
+}
+
+// ResetCompound
+void
+RenderEngine::ResetCompound()
+{
+	if (fStyleHandler != NULL)
+		fStyleHandler->MakeEmpty();
+}
+
+// AddCompoundScanlines
+/*!	Adds the given scanlines with the paint as their style. The scanlines
+	added later are in front. Only colors and gradients are supported. The
+	transformation is used for gradients which inherit it. The scanlines need
+	to stay valid until RenderCompound() has been called.
+*/
+bool
+RenderEngine::AddCompoundScanlines(const ScanlineContainer& scanlines,
+	const Paint* paint, const Transformable& transformation)
+{
+	if (fStyleHandler == NULL || paint == NULL
+		|| (paint->Type() != Paint::COLOR
+			&& paint->Type() != Paint::GRADIENT)) {
+		return false;
+	}
+
+	if (scanlines.CountObjects() == 0)
+		return true;
+
+	return fStyleHandler->AddStyle(paint, transformation, scanlines) >= 0;
+}
+
+// RenderCompound
+/*!	Mixes the rows of all added scanlines front to back, like
+	agg::render_scanlines_compound_layered() does, and blends each row only
+	once. The coverage of a pixel is used up by the styles in front, so the
+	edges shared by two shapes don't let the background shine through.
+*/
+void
+RenderEngine::RenderCompound()
+{
+	if (fStyleHandler == NULL)
+		return;
+
+	int32 styleCount = fStyleHandler->CountStyles();
+	if (styleCount == 0)
+		return;
+
+	while (true) {
+		// The next row is the topmost one which any style has left, the
+		// scanlines of each style are sorted by y.
+		bool found = false;
+		int y = 0;
+		int minX = 0;
+		int maxX = 0;
+		for (int32 style = 0; style < styleCount; style++) {
+			const Scanline* scanline = fStyleHandler->ScanlineAt(style);
+			if (scanline == NULL)
+				continue;
+			const Span& first = *scanline->begin();
+			const Span& last = *(scanline->begin() + scanline->num_spans() - 1);
+			int left = first.x;
+			int right = last.x + abs(last.len) - 1;
+			if (!found || scanline->y() < y) {
+				found = true;
+				y = scanline->y();
+				minX = left;
+				maxX = right;
+			} else if (scanline->y() == y) {
+				minX = min_c(minX, left);
+				maxX = max_c(maxX, right);
+			}
+		}
+		if (!found)
+			break;
+
+		unsigned length = maxX - minX + 1;
+		agg::rgba16* colors = fSpanAllocator.allocate(length * 2);
+		agg::rgba16* mix = colors + length;
+		memset(mix, 0, length * sizeof(agg::rgba16));
+		if (fCompoundCovers.size() < length)
+			fCompoundCovers.resize(length);
+		agg::cover_type* mixCovers = &fCompoundCovers[0];
+		memset(mixCovers, 0, length * sizeof(agg::cover_type));
+
+		for (int32 style = styleCount - 1; style >= 0; style--) {
+			const Scanline* scanline = fStyleHandler->ScanlineAt(style);
+			if (scanline == NULL || scanline->y() != y)
+				continue;
+			fStyleHandler->SkipScanline(style);
+
+			bool solidStyle = fStyleHandler->is_solid(style);
+			const agg::rgba16& color = fStyleHandler->color(style);
+
+			const Span* span = scanline->begin();
+			for (unsigned count = scanline->num_spans(); count > 0;
+					count--, span++) {
+				int len = span->len;
+				bool solidSpan = len < 0;
+				if (solidSpan)
+					len = -len;
+
+				agg::rgba16* dst = mix + span->x - minX;
+				agg::cover_type* dstCovers = mixCovers + span->x - minX;
+				if (!solidStyle)
+					fStyleHandler->generate_span(colors, span->x, y, len,
+						style);
+
+				for (int i = 0; i < len; i++) {
+					unsigned cover = solidSpan ? *span->covers
+						: span->covers[i];
+					if (dstCovers[i] + cover > agg::cover_full)
+						cover = agg::cover_full - dstCovers[i];
+					if (cover == 0)
+						continue;
+					dst[i].add(solidStyle ? color : colors[i], cover);
+					dstCovers[i] += cover;
+				}
+			}
+		}
+
+		fBaseRenderer.blend_color_hspan(minX, y, length, mix, NULL,
+			agg::cover_full);
+	}
+}
+
 // ClearAlphaBufferScanlines
 void
 RenderEngine::ClearAlphaBufferScanlines()
@@ -368,9 +801,11 @@ RenderEngine::RenderAlphaBufferScanlines()
 static const double kGamma = 2.2;
 static const double kInverseGamma = 1.0 / kGamma;
 
-static uint16 sGammaToLinear[256];
+// The tables are padded for the PixelKernels, which read 32 bits at each
+// index.
+static uint16 sGammaToLinear[256 + 1];
 //static uint8 sLinearToGamma[16384];
-static uint8 sLinearToGamma[65536];
+static uint8 sLinearToGamma[65536 + 3];
 
 static bool dummy = RenderEngine::InitGammaTables();
 
@@ -427,6 +862,20 @@ RenderEngine::LinearToGamma(uint16 value)
 	return sLinearToGamma[value];
 }
 
+// GammaToLinearTable
+const uint16*
+RenderEngine::GammaToLinearTable()
+{
+	return sGammaToLinear;
+}
+
+// LinearToGammaTable
+const uint8*
+RenderEngine::LinearToGammaTable()
+{
+	return sLinearToGamma;
+}
+
 // #pragma mark - hit testing
 
 bool
@@ -522,8 +971,6 @@ RenderEngine::Denoise(const RenderBuffer* buffer,
 
 // #pragma mark -
 
-#define PRINT_TIMING 0
-
 // _RenderScanlines
 void
 RenderEngine::_RenderScanlines(bool fillPaint,
@@ -807,16 +1254,20 @@ RenderEngine::_HitTest(const BPoint& point)
 void
 RenderEngine::_ResizeAlphaBuffer()
 {
-	// Pixels are uint8 values
-	size_t size = fRenderingBuffer.width() * fRenderingBuffer.height();
+	// Pixels are uint8 values. The alpha buffer covers the same pixels as
+	// the bitmap and is attached the same way.
+	uint32 width = fBounds.IntegerWidth() + 1;
+	uint32 height = fBounds.IntegerHeight() + 1;
+	size_t size = width * height;
 	void* newAlphaBuffer = realloc(fAlphaBufferMemory, size);
 	if (newAlphaBuffer != NULL) {
 		fAlphaBufferMemory = newAlphaBuffer;
 		memset(fAlphaBufferMemory, 0, size);
-		fAlphaBuffer.attach(static_cast<unsigned char*>(fAlphaBufferMemory),
-			fRenderingBuffer.width(),
-			fRenderingBuffer.height(),
-			fRenderingBuffer.width());
+		int32 left = (int32)fBounds.left;
+		int32 top = (int32)fBounds.top;
+		fAlphaBuffer.attach(static_cast<unsigned char*>(fAlphaBufferMemory)
+				- top * width - left,
+			left + width, top + height, width);
 	}
 }
 
@@ -936,11 +1387,9 @@ RenderEngine::_DrawImageResample(PixelFormat srcPixelFormat,
 	
 		typedef agg::span_image_resample_rgba<ImageAccessor,
 			SubdivAdaptor> SpanGenerator;
-		
-		agg::image_filter_hanning filterKernel;
-		agg::image_filter_lut filter(filterKernel, true);
 	
-		SpanGenerator spanGenerator(imageAccessor, subdivAdaptor, filter);
+		SpanGenerator spanGenerator(imageAccessor, subdivAdaptor,
+			sResampleFilter);
 //		spanGenerator.set_opacity(opacity);
 //		spanGenerator.blur(...);
 	
@@ -985,14 +1434,8 @@ RenderEngine::_DrawImageResample(PixelFormat srcPixelFormat,
 			typedef agg::span_image_resample_rgba_affine<ImageAccessor>
 				SpanGenerator;
 
-//			agg::image_filter_bilinear filterKernel;
-			agg::image_filter_hanning filterKernel;
-				// almost as fast as bilinear, but slightly crisper
-//			agg::image_filter_blackman filterKernel(3.0);
-				// 6.81 times slower than hanning, much crisper
-			agg::image_filter_lut filter(filterKernel, true);
-
-			SpanGenerator spanGenerator(imageAccessor, interpolator, filter);
+			SpanGenerator spanGenerator(imageAccessor, interpolator,
+				sResampleFilter);
 //			spanGenerator.set_opacity(opacity);
 //			spanGenerator.blur(...);
 
@@ -1001,3 +1444,92 @@ RenderEngine::_DrawImageResample(PixelFormat srcPixelFormat,
 		}
 	}
 }
+
+// _DrawImageMipMapped
+/*!	Draws the scaled down image from the levels of its MipPyramid, which
+	costs about the same for each destination pixel, regardless of the
+	scale. For resampling, the filter runs on the level which is at most
+	twice as large as needed. Otherwise, the two nearest levels are sampled
+	bilinearly and blended. The rasterizer needs to contain the outline of
+	the image already. Returns false if a level could not be computed.
+*/
+bool
+RenderEngine::_DrawImageMipMapped(const RenderBuffer* buffer,
+	MipPyramid* pyramid, uint32 interpolation, double scale, uint8 opacity)
+{
+	double levelOfDetail = log(1.0 / scale) / log(2.0);
+	int32 level = min_c((int32)floor(levelOfDetail),
+		pyramid->CountLevels() - 1);
+
+	RenderBufferRef fine = pyramid->LevelAt(level);
+	if (fine.Get() == NULL)
+		return false;
+
+	agg::trans_affine imgMatrix(
+		fState.Matrix.sx,
+		fState.Matrix.shy,
+		fState.Matrix.shx,
+		fState.Matrix.sy,
+		fState.Matrix.tx,
+		fState.Matrix.ty);
+
+	agg::rendering_buffer fineBuffer(fine->Bits(), fine->Width(),
+		fine->Height(), fine->BytesPerRow());
+	PixelFormat finePixelFormat(fineBuffer);
+
+	agg::trans_affine fineMatrix = level_matrix(buffer, fine.Get());
+	fineMatrix *= imgMatrix;
+	fineMatrix.invert();
+
+	typedef agg::span_interpolator_linear<agg::trans_affine> Interpolator;
+	Interpolator fineInterpolator(fineMatrix);
+
+	if (interpolation == INTERPOLATION_RESAMPLE) {
+		typedef agg::image_accessor_clone<PixelFormat> ImageAccessor;
+		ImageAccessor imageAccessor(finePixelFormat);
+
+		typedef agg::span_image_resample_rgba_affine<ImageAccessor>
+			SpanGenerator;
+		SpanGenerator spanGenerator(imageAccessor, fineInterpolator,
+			sResampleFilter);
+
+		agg::render_scanlines_aa(fRasterizer, fScanline, fBaseRenderer,
+			fSpanAllocator, spanGenerator);
+		return true;
+	}
+
+	typedef agg::span_image_filter_rgba_bilinear_clip<PixelFormat,
+		Interpolator> SpanGenerator;
+	SpanGenerator fineGenerator(finePixelFormat, agg::rgba_pre(0, 0, 0, 0),
+		fineInterpolator);
+
+	uint32 coarseWeight = (uint32)((levelOfDetail - level) * 256);
+	RenderBufferRef coarse;
+	if (coarseWeight > 0)
+		coarse = pyramid->LevelAt(level + 1);
+
+	if (coarse.Get() == NULL) {
+		agg::render_scanlines_aa(fRasterizer, fScanline, fBaseRenderer,
+			fSpanAllocator, fineGenerator);
+		return true;
+	}
+
+	agg::rendering_buffer coarseBuffer(coarse->Bits(), coarse->Width(),
+		coarse->Height(), coarse->BytesPerRow());
+	PixelFormat coarsePixelFormat(coarseBuffer);
+
+	agg::trans_affine coarseMatrix = level_matrix(buffer, coarse.Get());
+	coarseMatrix *= imgMatrix;
+	coarseMatrix.invert();
+	Interpolator coarseInterpolator(coarseMatrix);
+
+	SpanGenerator coarseGenerator(coarsePixelFormat,
+		agg::rgba_pre(0, 0, 0, 0), coarseInterpolator);
+
+	TrilinearSpanGenerator<SpanGenerator> spanGenerator(fineGenerator,
+		coarseGenerator, coarseWeight);
+
+	agg::render_scanlines_aa(fRasterizer, fScanline, fBaseRenderer,
+		fSpanAllocator, spanGenerator);
+	return true;
+}
@@ -11,12 +11,12 @@
 #include <agg_gamma_lut.h>
 #include <agg_path_storage.h>
 #include <agg_pixfmt_rgba.h>
-#include <agg_rasterizer_compound_aa.h>
 #include <agg_rasterizer_scanline_aa.h>
 #include <agg_rendering_buffer.h>
 #include <agg_renderer_scanline.h>
 #include <agg_scanline_bin.h>
 #include <agg_scanline_p.h>
+#include <agg_scanline_u.h>
 #include <agg_span_allocator.h>
 #include <agg_trans_perspective.h>
 
@@ -26,6 +26,8 @@
 #include "Scanline.h"
 
 class BRect;
+class BrushStampCache;
+class MipPyramid;
 class RenderBuffer;
 
 typedef agg::gamma_lut
@@ -42,11 +44,10 @@ typedef agg::renderer_base<CompOpPixelFormat>
 											CompOpBaseRenderer;
 
 typedef agg::scanline_p8					ScanlinePacked;
+typedef agg::scanline_u8					ScanlineUnpacked;
 typedef agg::scanline_bin					ScanlineBinary;
 typedef agg::span_allocator<agg::rgba16>	SpanColorAllocator;
 
-typedef agg::rasterizer_compound_aa
-			<agg::rasterizer_sl_clip_dbl>	CompoundRasterizer;
 typedef agg::rasterizer_scanline_aa
 			<agg::rasterizer_sl_clip_int>	Rasterizer;
 typedef agg::path_storage					PathStorage;
@@ -88,6 +89,8 @@ public:
 
 			const RenderingBuffer& AlphaBuffer() const
 									{ return fAlphaBuffer; }
+			BrushStampCache*	BrushStamps() const
+									{ return fBrushStamps; }
 
 			void				SetTransformation(
 									const Transformable& transformation);
@@ -106,18 +109,36 @@ public:
 									BRect area);
 			void				DrawImage(const RenderBuffer* buffer,
 									BRect area, uint32 interpolation,
-									uint8 opacity);
+									uint8 opacity,
+									MipPyramid* pyramid = NULL);
 
 			void				RenderScanlines(
 									const ScanlineContainer& scanlines,
 									bool fillPaint);
+			void				RenderScanlines(
+									const ScanlineContainer& scanlines,
+									const agg::rgba16& color);
 
 			void				ClearAlphaBufferScanlines();
 			void				RenderAlphaBufferScanlines();
 
+			// Compound rendering resolves each pixel only once for all the
+			// scanlines added since ResetCompound(). The scanlines added
+			// later are in front. This is only correct if the paints are
+			// opaque, since the coverage of the scanlines in front hides
+			// the ones behind them completely.
+			void				ResetCompound();
+			bool				AddCompoundScanlines(
+									const ScanlineContainer& scanlines,
+									const Paint* paint,
+									const Transformable& transformation);
+			void				RenderCompound();
+
 	static	bool				InitGammaTables();
 	static	uint16				GammaToLinear(uint8 value);
 	static	uint8				LinearToGamma(uint16 value);
+	static	const uint16*		GammaToLinearTable();
+	static	const uint8*		LinearToGammaTable();
 
 			bool				HitTest(BRect rect, BPoint point);
 			bool				HitTest(PathStorage& path, BPoint point);
@@ -134,6 +155,8 @@ public:
 	static	const int32			kGradientArraySize = 1024;
 
 private:
+			class StyleHandler;
+
 			// Rendering rasterizer contents or cached scanlines
 			void				_RenderScanlines(bool fillPaint,
 									const ScanlineContainer* scanlines = NULL);
@@ -174,10 +197,17 @@ private:
 									Transformable imgMatrix, uint8 opacity);
 			void				_DrawImageResample(PixelFormat srcPixelFormat,
 									Transformable imgMatrix, uint8 opacity);
+			bool				_DrawImageMipMapped(
+									const RenderBuffer* buffer,
+									MipPyramid* pyramid,
+									uint32 interpolation, double scale,
+									uint8 opacity);
 
 private:
 			LayoutState			fState;
 
+			// The bounds of the attached bitmap.
+			BRect				fBounds;
 			RenderingBuffer		fRenderingBuffer;
 
 			void*				fAlphaBufferMemory;
@@ -193,6 +223,11 @@ private:
 			SpanColorAllocator	fSpanAllocator;
 
 			Rasterizer			fRasterizer;
+
+			agg::pod_array<agg::cover_type> fCompoundCovers;
+			StyleHandler*		fStyleHandler;
+
+			BrushStampCache*	fBrushStamps;
 };
 
 #endif // RENDER_ENGINE_H
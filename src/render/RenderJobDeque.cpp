@@ -0,0 +1,122 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "RenderJobDeque.h"
+
+#include <new>
+
+#include <OS.h>
+
+// The atomic functions imply full memory barriers, which is what makes the
+// unsynchronized accesses to the job array safe: A job is written before
+// fBottom is published and read before fTop is claimed.
+
+// constructor
+RenderJobDeque::RenderJobDeque()
+	: fJobs(NULL)
+	, fCapacity(0)
+	, fTop(0)
+	, fBottom(0)
+{
+}
+
+// destructor
+RenderJobDeque::~RenderJobDeque()
+{
+	delete[] fJobs;
+}
+
+// SetCapacity
+status_t
+RenderJobDeque::SetCapacity(int32 capacity)
+{
+	// use a power of two, so indices can wrap by masking
+	int32 newCapacity = 16;
+	while (newCapacity < capacity)
+		newCapacity *= 2;
+
+	MakeEmpty();
+
+	if (newCapacity <= fCapacity)
+		return B_OK;
+
+	RenderJob* jobs = new(std::nothrow) RenderJob[newCapacity];
+	if (jobs == NULL)
+		return B_NO_MEMORY;
+
+	delete[] fJobs;
+	fJobs = jobs;
+	fCapacity = newCapacity;
+
+	return B_OK;
+}
+
+// MakeEmpty
+void
+RenderJobDeque::MakeEmpty()
+{
+	atomic_set(&fTop, 0);
+	atomic_set(&fBottom, 0);
+}
+
+// Push
+bool
+RenderJobDeque::Push(const RenderJob& job)
+{
+	int32 bottom = fBottom;
+	int32 top = atomic_get(&fTop);
+	if (bottom - top >= fCapacity)
+		return false;
+
+	fJobs[bottom & (fCapacity - 1)] = job;
+	atomic_set(&fBottom, bottom + 1);
+	return true;
+}
+
+// Pop
+bool
+RenderJobDeque::Pop(RenderJob& job)
+{
+	int32 bottom = fBottom - 1;
+	atomic_set(&fBottom, bottom);
+	int32 top = atomic_get(&fTop);
+
+	if (top > bottom) {
+		// empty
+		atomic_set(&fBottom, bottom + 1);
+		return false;
+	}
+
+	job = fJobs[bottom & (fCapacity - 1)];
+	if (top < bottom)
+		return true;
+
+	// This was the last job, we are racing against stealing threads for it
+	bool won = atomic_test_and_set(&fTop, top + 1, top) == top;
+	atomic_set(&fBottom, top + 1);
+	return won;
+}
+
+// Steal
+bool
+RenderJobDeque::Steal(RenderJob& job)
+{
+	int32 top = atomic_get(&fTop);
+	int32 bottom = atomic_get(&fBottom);
+	if (top >= bottom)
+		return false;
+
+	job = fJobs[top & (fCapacity - 1)];
+	return atomic_test_and_set(&fTop, top + 1, top) == top;
+}
+
+// IsEmpty
+bool
+RenderJobDeque::IsEmpty() const
+{
+	int32 top = atomic_get(const_cast<vint32*>(&fTop));
+	int32 bottom = atomic_get(const_cast<vint32*>(&fBottom));
+	return top >= bottom;
+}
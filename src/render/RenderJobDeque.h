@@ -0,0 +1,47 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef RENDER_JOB_DEQUE_H
+#define RENDER_JOB_DEQUE_H
+
+#include <Rect.h>
+
+// RenderJob
+//
+// Renders one tile sized area of the layer at the given render info index.
+struct RenderJob {
+	int32		renderInfo;
+	BRect		area;
+};
+
+// The RenderJobDeque is a fixed capacity, lock-free work-stealing deque
+// (after Chase and Lev). Only the thread owning the deque may Push() and
+// Pop() jobs at the bottom end, while any other thread may Steal() jobs from
+// the top end. SetCapacity() and MakeEmpty() may only be used while no
+// thread accesses the deque.
+
+class RenderJobDeque {
+public:
+								RenderJobDeque();
+	virtual						~RenderJobDeque();
+
+			status_t			SetCapacity(int32 capacity);
+			int32				Capacity() const
+									{ return fCapacity; }
+			void				MakeEmpty();
+
+			bool				Push(const RenderJob& job);
+			bool				Pop(RenderJob& job);
+			bool				Steal(RenderJob& job);
+
+			bool				IsEmpty() const;
+
+private:
+			RenderJob*			fJobs;
+			int32				fCapacity;
+			vint32				fTop;
+			vint32				fBottom;
+};
+
+#endif // RENDER_JOB_DEQUE_H
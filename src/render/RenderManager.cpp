@@ -14,32 +14,75 @@
 #include <Bitmap.h>
 #include <Message.h>
 #include <Messenger.h>
+#include <Region.h>
 
 #include "bitmap_support.h"
 #include "LayerSnapshot.h"
 #include "RenderBuffer.h"
 #include "RenderThread.h"
+#include "RenderTrace.h"
 #include "support.h"
+#include "TileCache.h"
+#include "TiledRenderBuffer.h"
 
 
 using std::nothrow;
 
 
 enum {
-	MIN_AREA_PER_THREAD = 2000
+	// When a layer's dirty region consists of more rects than this, it is
+	// collapsed into its bounding box.
+	MAX_DIRTY_RECTS = 16
 };
 
+// While in preview mode, a new zoom level is first rendered at this fraction
+// of it and the canvas enlarges the pixels.
+static const double kPreviewZoomScale = 0.5;
+
+
+// job_area
+//
+// Returns the bounding box of the part of the region within the given tile
+// frame.
+static BRect
+job_area(const BRegion& region, const BRect& tileFrame)
+{
+	BRect area(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
+	int32 count = region.CountRects();
+	for (int32 i = 0; i < count; i++) {
+		BRect rect = region.RectAt(i) & tileFrame;
+		if (rect.IsValid())
+			area = area | rect;
+	}
+	return area;
+}
+
+
+// document_area
+//
+// Converts an area at the given zoom level back to document space.
+static BRect
+document_area(BRect area, double zoomLevel)
+{
+	if (zoomLevel > 0.0) {
+		area.left = floorf(area.left / zoomLevel);
+		area.top = floorf(area.top / zoomLevel);
+		area.right = ceilf(area.right / zoomLevel);
+		area.bottom = ceilf(area.bottom / zoomLevel);
+	}
+	return area;
+}
+
 
 // RenderInfo
 struct RenderManager::RenderInfo {
 	LayerSnapshot*		layer;
 	int32				parent;
-	BRect*				dirtyArea;
-	int32				dirtySubLayers;
-	int32				splitCount;
-	int32				splitCountStarted;
-	int32				splitCountDone;
-	bool				splitHorizontally;
+	BRegion				dirtyRegion;
+	BRect				staleArea;
+	vint32				dirtySubLayers;
+	int32				jobCount;
+	vint32				pendingJobs;
 };
 
 
@@ -68,27 +111,6 @@ public:
 	{
 		RenderInfo& info = fManager->fRenderInfos[index];
 		info.layer = layer;
-		info.dirtyArea = fManager->fSnapshotDirtyMap->Get(layer->Layer());
-		if (info.dirtyArea) {
-			// determine split strategy
-			int32 width = info.dirtyArea->IntegerWidth() + 1;
-			int32 height = info.dirtyArea->IntegerHeight() + 1;
-			int64 area = int64(width) * height;
-			int64 splitCount = area / MIN_AREA_PER_THREAD;
-			splitCount = min_c(splitCount, fManager->fRenderThreadCount);
-
-			if (splitCount > 1)
-				info.splitCount = splitCount;
-			else
-				info.splitCount = 1;
-
-			info.splitCountStarted = 0;
-			info.splitCountDone = 0;
-			info.splitHorizontally = (width > height);
-		} else {
-			info.dirtySubLayers = 0;
-			info.splitCount = 0;
-		}
 
 		// We initialize info.parent with the index of our previous sibling,
 		// thus building a linked list of siblings. The Visit() for our parent
@@ -98,18 +120,49 @@ public:
 		// set to and remain -1.
 		info.parent = previousSiblingIndex;
 
-		// count the dirty child layers and update their info.parent
+		// count the dirty child layers and update their info.parent, collect
+		// the areas in which child layers changed
+		BRegion childDirtyRegion;
+		BRect childStaleArea(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
 		int32 dirtyChildCount = 0;
 		int32 childIndex = lastChildIndex;
 		while (childIndex >= 0) {
 			RenderInfo& childInfo = fManager->fRenderInfos[childIndex];
 			childIndex = childInfo.parent;
 			childInfo.parent = index;
-			if (childInfo.dirtyArea)
+			if (childInfo.dirtyRegion.CountRects() > 0) {
+				childDirtyRegion.Include(&childInfo.dirtyRegion);
 				dirtyChildCount++;
+			}
+			childStaleArea = childStaleArea | childInfo.staleArea;
 		}
 
 		info.dirtySubLayers = dirtyChildCount;
+
+		fManager->_PrepareTiles(layer, childDirtyRegion, childStaleArea,
+			info.dirtyRegion, info.staleArea);
+
+		// The dirty region is rendered in jobs of one tile each, so that idle
+		// render threads can steal work in small portions. Tiles which the
+		// region doesn't cover are skipped.
+		int32 firstColumn;
+		int32 firstRow;
+		int32 lastColumn;
+		int32 lastRow;
+		TiledRenderBuffer::GetTileRange(info.dirtyRegion.Frame(), firstColumn,
+			firstRow, lastColumn, lastRow);
+		info.jobCount = 0;
+		for (int32 row = firstRow; row <= lastRow; row++) {
+			for (int32 column = firstColumn; column <= lastColumn; column++) {
+				BRect tileFrame = TiledRenderBuffer::TileFrame(column, row);
+				if (job_area(info.dirtyRegion, tileFrame).IsValid())
+					info.jobCount++;
+			}
+		}
+		info.pendingJobs = info.jobCount;
+
+		if (info.jobCount == 0)
+			info.dirtySubLayers = 0;
 	}
 
 private:
@@ -135,6 +188,75 @@ private:
 	BRect			fBounds;
 };
 
+class RenderManager::QueueMissingTilesVisitor : public LayerSnapshotVisitor {
+public:
+	QueueMissingTilesVisitor(RenderManager* manager, const BRect& area)
+		: fManager(manager)
+		, fArea(area)
+	{
+	}
+
+	virtual void Visit(LayerSnapshot* layer, int32 index,
+		int32 lastChildIndex, int32 previousSiblingIndex)
+	{
+		TiledRenderBuffer* tiles = layer->Tiles();
+		if (tiles == NULL)
+			return;
+
+		BRect missingArea = tiles->MissingArea(fArea);
+		if (!missingArea.IsValid())
+			return;
+
+		// Convert back to document space. The parent layers are taken care
+		// of when preparing the tiles for rendering.
+		fManager->_IncludeDirtyArea(layer->Layer(),
+			document_area(missingArea, fManager->fZoomLevel));
+	}
+
+private:
+	RenderManager*	fManager;
+	BRect			fArea;
+};
+
+class RenderManager::FreeTilesVisitor : public LayerSnapshotVisitor {
+public:
+	FreeTilesVisitor(const BRect& area, const BRect& keepArea)
+		: fArea(area)
+		, fKeepArea(keepArea)
+		, fFreedMemory(0)
+		, fMemoryUsage(0)
+	{
+	}
+
+	virtual void Visit(LayerSnapshot* layer, int32 index,
+		int32 lastChildIndex, int32 previousSiblingIndex)
+	{
+		TiledRenderBuffer* tiles = layer->Tiles();
+		if (tiles == NULL)
+			return;
+
+		fFreedMemory += tiles->FreeTiles(fArea, fKeepArea);
+		fFreedMemory += layer->FreeCacheTiles(fArea, fKeepArea);
+		fMemoryUsage += tiles->MemoryUsage() + layer->CacheMemoryUsage();
+	}
+
+	size_t FreedMemory() const
+	{
+		return fFreedMemory;
+	}
+
+	size_t MemoryUsage() const
+	{
+		return fMemoryUsage;
+	}
+
+private:
+	BRect			fArea;
+	BRect			fKeepArea;
+	size_t			fFreedMemory;
+	size_t			fMemoryUsage;
+};
+
 // #pragma mark -
 
 // constructor
@@ -145,9 +267,20 @@ RenderManager::RenderManager(Document* document)
 	, fRenderBuffer(NULL)
 
 	, fZoomLevel(1.0)
+	, fViewZoomLevel(1.0)
 	, fScrollingDelayed(false)
+
+	, fTargetZoomLevel(1.0)
+	, fPreviewMode(false)
+	, fRenderingPreview(false)
+	, fPreviewArea(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN)
+	, fRenderingSuspended(false)
+	, fCancelRendering(0)
+
 	, fCleanArea(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN)
 
+	, fTileCache(NULL)
+
 	, fDocumentDirtyMap(NULL)
 	, fSnapshotDirtyMap(NULL)
 
@@ -164,7 +297,7 @@ RenderManager::RenderManager(Document* document)
 	, fRenderInfos(NULL)
 	, fRenderInfoCount(0)
 	, fRenderInfoCapacity(0)
-	, fCurrentRenderInfo(0)
+	, fPendingJobs(0)
 
 	, fWaitingRenderThreadsSem(-1)
 	, fWaitingRenderThreadCount(0)
@@ -174,6 +307,7 @@ RenderManager::RenderManager(Document* document)
 	, fBitmapListeners(2)
 
 	, fLastRenderStartTime(-1)
+	, fRenderPassEndTime(-1)
 {
 }
 
@@ -189,15 +323,13 @@ RenderManager::Init()
 
 	fSnapshot = new(std::nothrow) LayerSnapshot(fDocument->RootLayer());
 
+	fTileCache = new(std::nothrow) TileCache();
+
 	if (fDocumentDirtyMap == NULL || fSnapshotDirtyMap == NULL
-		|| fSnapshot == NULL) {
+		|| fSnapshot == NULL || fTileCache == NULL) {
 		return B_NO_MEMORY;
 	}
 
-	status_t ret = _CreateDisplayBitmaps(fZoomLevel);
-	if (ret != B_OK)
-		return ret;
-
 #if !USE_OPEN_TRACKER_HASH_MAP
 	if (fDocumentDirtyMap->Init() != B_OK || fSnapshotDirtyMap->Init() != B_OK)
 		return B_NO_MEMORY;
@@ -220,15 +352,23 @@ RenderManager::Init()
 	memset(fRenderThreads, 0, sizeof(RenderThread*) * fRenderThreadCount);
 
 	for (int32 i = 0; i < fRenderThreadCount; i++) {
-		fRenderThreads[i] = new(std::nothrow) RenderThread(this);
+		fRenderThreads[i] = new(std::nothrow) RenderThread(this, i);
 		if (fRenderThreads[i] == NULL || fRenderThreads[i]->Init() != B_OK) {
 			delete fRenderThreads[i];
 			fRenderThreads[i] = NULL;
 			return B_NO_MEMORY;
 		}
-		fRenderThreads[i]->Run();
 	}
 
+	// Only run the threads once all of them exist, since they access each
+	// other's job deques.
+	for (int32 i = 0; i < fRenderThreadCount; i++)
+		fRenderThreads[i]->Run();
+
+	status_t ret = _CreateDisplayBitmaps(fZoomLevel);
+	if (ret != B_OK)
+		return ret;
+
 	Layer::AddListenerRecursive(fDocument->RootLayer(), this);
 
 	fDocument->AddListener(this);
@@ -242,6 +382,12 @@ RenderManager::~RenderManager()
 	// this will unblock any waiting render threads
 	delete_sem(fWaitingRenderThreadsSem);
 
+	// wait for all threads before deleting any, since they may still try
+	// to steal jobs from each other
+	for (int32 i = 0; i < fRenderThreadCount; i++) {
+		if (fRenderThreads[i] != NULL)
+			fRenderThreads[i]->WaitForThread();
+	}
 	for (int32 i = 0; i < fRenderThreadCount; i++)
 		delete fRenderThreads[i];
 	delete[] fRenderThreads;
@@ -249,6 +395,7 @@ RenderManager::~RenderManager()
 	_DestroyDisplayBitmaps();
 
 	delete fSnapshot;
+	delete fTileCache;
 
 	for (int32 i = fBitmapListeners.CountItems() - 1; i >= 0; i--) {
 		BMessenger* listener = static_cast<BMessenger*>(
@@ -340,9 +487,41 @@ RenderManager::BoundsChanged(const Document* document)
 void
 RenderManager::SetZoomLevel(double zoomLevel)
 {
-	if (fZoomLevel == zoomLevel)
+	SetZoomLevel(zoomLevel, zoomLevel);
+}
+
+// SetZoomLevel
+//
+// The view zoom level is the zoom level of the canvas coordinate system
+// which SetCanvasLayout() uses. It may differ from the render zoom level,
+// for example when the canvas enlarges pixels rather than rendering at the
+// higher zoom level.
+void
+RenderManager::SetZoomLevel(double zoomLevel, double viewZoomLevel)
+{
+	AutoLocker<BLocker> locker(fRenderQueueLock);
+
+	fTargetZoomLevel = zoomLevel;
+
+	// Everything needs to be rendered again at a new zoom level. While the
+	// user is interacting, that is done at a reduced resolution first.
+	if (fPreviewMode && zoomLevel != fZoomLevel)
+		zoomLevel *= kPreviewZoomScale;
+
+	if (fZoomLevel == zoomLevel) {
+		if (fViewZoomLevel != viewZoomLevel) {
+			fViewZoomLevel = viewZoomLevel;
+			if (_UpdateCacheArea())
+				_QueueMissingTiles();
+		}
 		return;
+	}
+
+	fViewZoomLevel = viewZoomLevel;
 
+	// _CreateDisplayBitmaps() needs to unlock while waiting for the render
+	// threads.
+	locker.Unlock();
 	_CreateDisplayBitmaps(zoomLevel);
 }
 
@@ -353,6 +532,58 @@ RenderManager::ZoomLevel() const
 	return fZoomLevel;
 }
 
+// SetPreviewMode
+//
+// While in preview mode, the document is rendered with reduced quality, so
+// that the canvas keeps up with the user. Leaving preview mode renders
+// everything that was rendered in preview mode again at full quality.
+// Entering it again cancels such a refinement while it is in progress.
+void
+RenderManager::SetPreviewMode(bool preview)
+{
+	AutoLocker<BLocker> locker(fRenderQueueLock);
+	if (fPreviewMode == preview)
+		return;
+
+	fPreviewMode = preview;
+
+	if (preview) {
+		// The areas of cancelled jobs are queued again, the next pass
+		// renders them in preview mode.
+		if (!fRenderingPreview
+			&& fWaitingRenderThreadCount < fRenderThreadCount) {
+			atomic_set(&fCancelRendering, 1);
+		}
+		return;
+	}
+
+	if (fZoomLevel != fTargetZoomLevel) {
+		double zoomLevel = fTargetZoomLevel;
+		locker.Unlock();
+		_CreateDisplayBitmaps(zoomLevel);
+		return;
+	}
+
+	if (fPreviewArea.IsValid()) {
+		_QueueRedrawAllLayers(document_area(fPreviewArea, fZoomLevel));
+		fPreviewArea.Set(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
+		_TriggerRenderIfNotBusy();
+	}
+}
+
+// SetTileCacheBudget
+//
+// Sets the maximum amount of memory in bytes used by the layer tiles. Tiles
+// within the cache area around the visible rect are never evicted, so the
+// actual memory usage may be higher.
+void
+RenderManager::SetTileCacheBudget(size_t bytes)
+{
+	AutoLocker<BLocker> locker(fRenderQueueLock);
+	if (fTileCache != NULL)
+		fTileCache->SetMemoryBudget(bytes);
+}
+
 // ScrollBy
 bool
 RenderManager::ScrollBy(const BPoint& offset)
@@ -360,6 +591,12 @@ RenderManager::ScrollBy(const BPoint& offset)
 	if (!fRenderQueueLock.Lock())
 		return false;
 
+	// Move the cache area along with the visible rect. Tiles which are
+	// still cached are reused, any missing tiles are rendered.
+	fVisibleRect.OffsetBy(offset);
+	if (_UpdateCacheArea())
+		_QueueMissingTiles();
+
 	if (fScrollingDelayed || fWaitingRenderThreadCount < fRenderThreadCount)
 		fScrollingDelayed = true;
 
@@ -372,11 +609,17 @@ RenderManager::ScrollBy(const BPoint& offset)
 void
 RenderManager::SetCanvasLayout(const BRect& dataRect, const BRect& visibleRect)
 {
-	// TODO: In the future, use this for implementing scrolling
-	// in the RenderManager and clipping the canvas to a slightly enlarged
-	// visible rect.
-	fDataRect = dataRect;
-	fVisibleRect = visibleRect;
+	if (fRenderQueueLock.Lock()) {
+		fDataRect = dataRect;
+		fVisibleRect = visibleRect;
+
+		// Only the layer tiles within the visible rect (plus a margin) are
+		// kept up-to-date.
+		if (_UpdateCacheArea())
+			_QueueMissingTiles();
+
+		fRenderQueueLock.Unlock();
+	}
 
 	int32 listenerCount = fBitmapListeners.CountItems();
 	if (listenerCount > 0) {
@@ -430,7 +673,8 @@ RenderManager::DisplayBitmap() const
 
 // TransferClean
 void
-RenderManager::TransferClean(const RenderBuffer* bitmap, const BRect& area)
+RenderManager::TransferClean(const TiledRenderBuffer* bitmap,
+	const BRect& area)
 {
 	// executed in a rendering thread
 	// it is ok to copy bitmap contents without holding the
@@ -444,11 +688,14 @@ RenderManager::TransferClean(const RenderBuffer* bitmap, const BRect& area)
 		return;
 	}
 
-	fRenderBuffer->Clear(area, (rgb_color){ 255, 255, 255, 255 });
-	bitmap->BlendTo(fRenderBuffer, area);
+	{
+		TRACE_SPAN_AREA("transfer clean", NULL, area);
+		fRenderBuffer->Clear(area, (rgb_color){ 255, 255, 255, 255 });
+		bitmap->BlendTo(fRenderBuffer, area);
+	}
 
 	// hold the lock in as short a time as possible
-	if (!fRenderQueueLock.Lock())
+	if (!_LockRenderQueue())
 		return;
 
 	fCleanArea = fCleanArea | area;
@@ -481,95 +728,54 @@ RenderManager::UnlockRenderInfo()
 }
 
 // DoNextRenderJob
+//
+// Called by the render threads in a loop. Returns false when the thread
+// is supposed to quit.
 bool
 RenderManager::DoNextRenderJob(RenderThread* thread)
 {
-	AutoLocker<BLocker> locker(fRenderQueueLock);
-//printf("RenderManager::DoNextRenderJob(%p)\n", thread);
-
-	// iterate through the render infos and find the next open task
-	while (fCurrentRenderInfo < fRenderInfoCount) {
-		RenderInfo& info = fRenderInfos[fCurrentRenderInfo];
-		if (info.dirtyArea && info.dirtySubLayers == 0
-			&& info.splitCountStarted < info.splitCount) {
-			// found one -- get the area to render
-			int32 index = info.splitCountStarted;
-			BRect dirtyArea = *info.dirtyArea;
-
-			// Convert the dirty area to the current zoom level
-			dirtyArea.left = floorf(dirtyArea.left * fZoomLevel);
-			dirtyArea.top = floorf(dirtyArea.top * fZoomLevel);
-			dirtyArea.right = ceilf(dirtyArea.right * fZoomLevel);
-			dirtyArea.bottom = ceilf(dirtyArea.bottom * fZoomLevel);
-			dirtyArea = dirtyArea & Bounds();
-
-			int32 width = dirtyArea.IntegerWidth() + 1;
-			int32 height = dirtyArea.IntegerHeight() + 1;
-
-			if (info.splitHorizontally) {
-				// split horizontally
-				dirtyArea.right = dirtyArea.left
-					+ (index + 1) * width / info.splitCount - 1;
-				dirtyArea.left = dirtyArea.left
-					+ index * width / info.splitCount;
-			} else {
-				// split vertically
-				dirtyArea.bottom = dirtyArea.top
-					+ (index + 1) * height / info.splitCount - 1;
-				dirtyArea.top = dirtyArea.top
-					+ index * height / info.splitCount;
-			}
-
-//printf("  -> rendering part %ld/%ld of render info %ld (/%ld)\n", index + 1,
-//info.splitCount, fCurrentRenderInfo, fRenderInfoCount);
-			info.splitCountStarted++;
-
-			// render
-			locker.Unlock();
-
-			thread->Render(info.layer, dirtyArea, fZoomLevel);
-
-			// If we rendered something for the root layer, we transfer it to
-			// the display bitmap.
-			if (info.layer == fSnapshot)
-				TransferClean(fSnapshot->Bitmap(), dirtyArea);
-
-			locker.Lock();
-
-			// post processing
-			info.splitCountDone++;
-			if (info.splitCountDone == info.splitCount) {
-				// We finished the last missing split area. This layer is clean,
-				// now. Update the parent.
-				if (info.parent >= 0) {
-					RenderInfo& parentInfo = fRenderInfos[info.parent];
-					parentInfo.dirtySubLayers--;
-					if (parentInfo.dirtySubLayers == 0) {
-						// The parent layer has got no more dirty sublayers. It
-						// can be rendered now.
-						if (fCurrentRenderInfo > info.parent)
-							fCurrentRenderInfo = info.parent;
-
-						// If any threads are waiting, they might find a task
-						// now.
-						WakeUpRenderThreads();
-					}
-				}
-			}
+	// Try our own jobs first, then try to steal from the other threads,
+	// starting with our neighbor
+	RenderJob job;
+	if (thread->Jobs().Pop(job)) {
+		_RenderJob(thread, job);
+		thread->JobDone(false);
+		return true;
+	}
 
-			// another job well done
+	int32 index = thread->Index();
+	for (int32 i = 1; i < fRenderThreadCount; i++) {
+		RenderThread* victim
+			= fRenderThreads[(index + i) % fRenderThreadCount];
+		if (victim->Jobs().Steal(job)) {
+			_RenderJob(thread, job);
+			thread->JobDone(true);
 			return true;
 		}
-
-		// no luck yet
-		fCurrentRenderInfo++;
 	}
 
 	// There's nothing we can do at the moment.
-	fWaitingRenderThreadCount++;
-	if (fWaitingRenderThreadCount == fRenderThreadCount) {
+	AutoLocker<BLocker> locker(fRenderQueueLock, _LockRenderQueue());
+
+	// Announce that we are going to wait before looking for jobs again.
+	// A thread which pushes jobs after we looked will see that we are
+	// waiting and wake us up (see _PushJobs()).
+	atomic_add(&fWaitingRenderThreadCount, 1);
+	if (_HasStealableJobs()) {
+		atomic_add(&fWaitingRenderThreadCount, -1);
+		return true;
+	}
+
+	bigtime_t waitStart = system_time();
+
+	bool allWaiting = fWaitingRenderThreadCount == fRenderThreadCount;
+	if (allWaiting) {
 		// All the other threads are waiting too, which means everything has
 		// been rendered.
+		if (atomic_get(&fPendingJobs) != 0) {
+			printf("RenderManager::DoNextRenderJob() - all threads waiting, "
+				"but %ld jobs pending!\n", atomic_get(&fPendingJobs));
+		}
 		_AllRenderThreadsDone();
 	}
 
@@ -582,6 +788,19 @@ RenderManager::DoNextRenderJob(RenderThread* thread)
 		error = acquire_sem(fWaitingRenderThreadsSem);
 	} while (error == B_INTERRUPTED);
 
+	// Only the time spent waiting for the other threads while jobs are
+	// pending counts as idle, not the time between render passes. The
+	// pass can only have ended while we were waiting, since we are woken
+	// up before the next one starts.
+	if (!allWaiting) {
+		bigtime_t idleEnd = system_time();
+		if (fRenderPassEndTime > waitStart)
+			idleEnd = fRenderPassEndTime;
+		thread->AddIdleTime(idleEnd - waitStart);
+		if (RenderTrace::IsEnabled())
+			RenderTrace::AddSpan("idle", NULL, BRect(), waitStart, idleEnd);
+	}
+
 	// If not OK, the semaphore has been destroyed. Our signal to quit.
 	return (error == B_OK);
 }
@@ -594,7 +813,7 @@ RenderManager::WakeUpRenderThreads()
 	if (fWaitingRenderThreadCount > 0) {
 		release_sem_etc(fWaitingRenderThreadsSem, fWaitingRenderThreadCount,
 			B_DO_NOT_RESCHEDULE);
-		fWaitingRenderThreadCount = 0;
+		atomic_set(&fWaitingRenderThreadCount, 0);
 	}
 }
 
@@ -606,9 +825,55 @@ RenderManager::RenderingDone()
 	return fWaitingRenderThreadCount == fRenderThreadCount;
 }
 
+// CountRenderThreads
+int32
+RenderManager::CountRenderThreads() const
+{
+	return fRenderThreadCount;
+}
+
+// GetRenderStatistics
+//
+// Retrieves the number of render jobs, the number of jobs stolen from other
+// threads and the time the given render thread spent waiting for the other
+// threads while jobs were pending.
+bool
+RenderManager::GetRenderStatistics(int32 threadIndex,
+	RenderStatistics& statistics) const
+{
+	if (threadIndex < 0 || threadIndex >= fRenderThreadCount
+		|| fRenderThreads[threadIndex] == NULL) {
+		return false;
+	}
+
+	statistics = fRenderThreads[threadIndex]->Statistics();
+	return true;
+}
+
+// ResetRenderStatistics
+void
+RenderManager::ResetRenderStatistics()
+{
+	for (int32 i = 0; i < fRenderThreadCount; i++) {
+		if (fRenderThreads[i] != NULL)
+			fRenderThreads[i]->ResetStatistics();
+	}
+}
+
 
 // #pragma mark -
 
+// _LockRenderQueue
+//
+// Locks fRenderQueueLock for the render threads, which records how long
+// they had to wait for it.
+bool
+RenderManager::_LockRenderQueue()
+{
+	TRACE_SPAN("lock render queue");
+	return fRenderQueueLock.Lock();
+}
+
 // _IncludeDirtyArea
 status_t
 RenderManager::_IncludeDirtyArea(const Layer* layer, BRect area)
@@ -624,9 +889,9 @@ RenderManager::_IncludeDirtyArea(const Layer* layer, BRect area)
 
 	// We do not need to use ContainsKey(), since Get() will return
 	// NULL if there is no key.
-	BRect* info = fDocumentDirtyMap->Get(layer);
+	BRegion* info = fDocumentDirtyMap->Get(layer);
 	if (info == NULL) {
-		info = new (nothrow) BRect(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
+		info = new (nothrow) BRegion();
 		if (!info || fDocumentDirtyMap->Put(layer, info) != B_OK) {
 			delete info;
 			printf("RenderManager::_IncludeDirtyArea() - out of memory!\n");
@@ -634,7 +899,12 @@ RenderManager::_IncludeDirtyArea(const Layer* layer, BRect area)
 		}
 	}
 
-	*info = *info | area;
+	info->Include(area);
+
+	// Keep the region simple, it is iterated for every tile when scheduling
+	// render jobs.
+	if (info->CountRects() > MAX_DIRTY_RECTS)
+		info->Set(info->Frame());
 
 	return B_OK;
 }
@@ -643,7 +913,7 @@ RenderManager::_IncludeDirtyArea(const Layer* layer, BRect area)
 void
 RenderManager::_QueueRedraw(const Layer* layer, BRect area)
 {
-	if (!fRenderQueueLock.Lock()) {
+	if (!_LockRenderQueue()) {
 		fprintf(stderr, "RenderManager::_QueueRedraw() - "
 			"locking fRenderQueueLock failed!\n");
 		return;
@@ -696,18 +966,31 @@ RenderManager::_TriggerRender()
 	PrepareDirtyInfosForNextRender();
 
 	// sync document and document clone
-	fSnapshot->Sync();
+	{
+		TRACE_SPAN("sync");
+		fSnapshot->Sync();
+	}
+
+	atomic_set(&fCancelRendering, 0);
+	fRenderingPreview = fPreviewMode;
 
 	// do a layout pass (will always push at least one more LayoutState,
 	// so the zoom level in the initial state is preserved)
 	fLayoutContext.Init(fZoomLevel);
+	fLayoutContext.SetPreview(fPreviewMode);
+
+	{
+		TRACE_SPAN("layout");
+
+		LayoutState rootLayerState(fLayoutContext.State());
+		fLayoutContext.PushState(&rootLayerState);
 
-	LayoutState rootLayerState(fLayoutContext.State());
-	fLayoutContext.PushState(&rootLayerState);
+		fSnapshot->Layout(fLayoutContext, fLayoutDirtyFlags);
 
-	fSnapshot->Layout(fLayoutContext, fLayoutDirtyFlags);
+		fLayoutContext.PopState();
+	}
 
-	fLayoutContext.PopState();
+	TRACE_SPAN("prepare render jobs");
 
 	// count sublayers
 	int32 count = 0;
@@ -715,11 +998,26 @@ RenderManager::_TriggerRender()
 
 	_ResizeRenderInfos(count);
 
-	// prepare render infos
+	// prepare render infos (this also allocates the layer tiles that are
+	// about to be rendered)
 	RenderInfoInitVisitor visitor(this);
 	count = 0;
 	_TraverseLayerSnapshots(&visitor, fSnapshot, count, -1);
-	fCurrentRenderInfo = 0;
+
+	// Remember what is rendered in preview mode, it is refined later.
+	if (fRenderingPreview) {
+		for (int32 i = 0; i < fRenderInfoCount; i++) {
+			const BRegion& dirtyRegion = fRenderInfos[i].dirtyRegion;
+			if (dirtyRegion.CountRects() > 0)
+				fPreviewArea = fPreviewArea | dirtyRegion.Frame();
+		}
+	}
+
+	_EvictTiles();
+
+	// distribute the jobs of all layers which don't need to wait for
+	// sub-layers
+	_ScheduleRenderJobs();
 
 	// and go
 	WakeUpRenderThreads();
@@ -730,19 +1028,15 @@ void
 RenderManager::_BackToDisplay(BRect area)
 {
 	// done while holding the queue lock
+	TRACE_SPAN_AREA("back to display", NULL, area);
+
 	fRenderBuffer->CopyTo(fDisplayBitmap, area);
 
 	int32 listenerCount = fBitmapListeners.CountItems();
 	if (listenerCount > 0) {
 		BMessage message(MSG_BITMAP_CLEAN);
-		if (fZoomLevel > 0.0) {
-			// Convert clean area back to document space
-			area.left = floorf(area.left / fZoomLevel);
-			area.top = floorf(area.top / fZoomLevel);
-			area.right = ceilf(area.right / fZoomLevel);
-			area.bottom = ceilf(area.bottom / fZoomLevel);
-		}
-		message.AddRect("area", area);
+		// Convert clean area back to document space
+		message.AddRect("area", document_area(area, fZoomLevel));
 		if (fScrollingDelayed) {
 			message.AddBool("scrolling delayed", true);
 			fScrollingDelayed = false;
@@ -755,6 +1049,289 @@ RenderManager::_BackToDisplay(BRect area)
 	}
 }
 
+// _QueueRedrawAllLayers
+//
+// fRenderQueueLock must be locked. Queues the given area of all layers for
+// rendering.
+void
+RenderManager::_QueueRedrawAllLayers(const BRect& area)
+{
+	QueueRedrawVisitor visitor(this, area);
+	int32 count = 0;
+	_TraverseLayerSnapshots(&visitor, fSnapshot, count, -1);
+}
+
+// _ScheduleRenderJobs
+//
+// Called from _TriggerRender() while all render threads are waiting, which
+// makes it safe to push jobs into their deques.
+void
+RenderManager::_ScheduleRenderJobs()
+{
+	int32 jobCount = 0;
+	for (int32 i = 0; i < fRenderInfoCount; i++)
+		jobCount += fRenderInfos[i].jobCount;
+
+	// Every deque can hold all jobs, so pushing jobs never fails
+	for (int32 i = 0; i < fRenderThreadCount; i++) {
+		if (fRenderThreads[i]->Jobs().SetCapacity(jobCount) != B_OK) {
+			printf("RenderManager::_ScheduleRenderJobs() - out of memory!\n");
+			return;
+		}
+	}
+
+	atomic_set(&fPendingJobs, jobCount);
+
+	int32 nextThread = 0;
+	for (int32 i = 0; i < fRenderInfoCount; i++) {
+		RenderInfo& info = fRenderInfos[i];
+		if (info.jobCount > 0 && info.dirtySubLayers == 0)
+			_PushJobs(i, NULL, nextThread);
+	}
+}
+
+// _PushJobs
+//
+// Pushes the jobs for rendering the layer at the given render info index.
+// If thread is NULL, the jobs are distributed round-robin, starting at
+// nextThread, which may only be done while all render threads are waiting.
+// Otherwise, the jobs are pushed to the deque of the given thread (which must
+// be the calling thread) and waiting threads are woken up to steal some.
+void
+RenderManager::_PushJobs(int32 renderInfo, RenderThread* thread,
+	int32& nextThread)
+{
+	RenderInfo& info = fRenderInfos[renderInfo];
+
+	int32 firstColumn;
+	int32 firstRow;
+	int32 lastColumn;
+	int32 lastRow;
+	TiledRenderBuffer::GetTileRange(info.dirtyRegion.Frame(), firstColumn,
+		firstRow, lastColumn, lastRow);
+
+	RenderJob job;
+	job.renderInfo = renderInfo;
+
+	for (int32 row = firstRow; row <= lastRow; row++) {
+		for (int32 column = firstColumn; column <= lastColumn; column++) {
+			job.area = job_area(info.dirtyRegion,
+				TiledRenderBuffer::TileFrame(column, row));
+			if (!job.area.IsValid())
+				continue;
+
+			if (thread == NULL) {
+				fRenderThreads[nextThread]->Jobs().Push(job);
+				nextThread = (nextThread + 1) % fRenderThreadCount;
+			} else if (!thread->Jobs().Push(job)) {
+				// Should not happen, since the deques can hold all jobs
+				_RenderJob(thread, job);
+				thread->JobDone(false);
+			}
+		}
+	}
+
+	if (thread != NULL && atomic_get(&fWaitingRenderThreadCount) > 0)
+		WakeUpRenderThreads();
+}
+
+// _RenderJob
+//
+// Executed in a render thread without holding any lock.
+void
+RenderManager::_RenderJob(RenderThread* thread, const RenderJob& job)
+{
+	RenderInfo& info = fRenderInfos[job.renderInfo];
+
+	if (atomic_get(&fCancelRendering) != 0) {
+		// The render pass has been cancelled. The jobs are still accounted
+		// for as usual, but the area is left to the next pass.
+		_QueueRedraw(info.layer->Layer(),
+			document_area(job.area, fZoomLevel));
+	} else {
+		TRACE_SPAN_AREA("render job", info.layer->TraceName(), job.area);
+		thread->Render(info.layer, job.area);
+
+		// If we rendered something for the root layer, we transfer it to
+		// the display bitmap.
+		if (info.layer == fSnapshot)
+			TransferClean(fSnapshot->Tiles(), job.area);
+	}
+
+	if (atomic_add(&info.pendingJobs, -1) == 1) {
+		// We finished the last missing job. This layer is clean, now.
+		// Update the parent.
+		if (info.parent >= 0) {
+			RenderInfo& parentInfo = fRenderInfos[info.parent];
+			if (atomic_add(&parentInfo.dirtySubLayers, -1) == 1) {
+				// The parent layer has got no more dirty sublayers. It
+				// can be rendered now.
+				int32 dummy = 0;
+				_PushJobs(info.parent, thread, dummy);
+			}
+		}
+	}
+
+	// Only decrement after the parent jobs have been pushed, the pending
+	// job count includes them.
+	atomic_add(&fPendingJobs, -1);
+}
+
+// _HasStealableJobs
+bool
+RenderManager::_HasStealableJobs() const
+{
+	for (int32 i = 0; i < fRenderThreadCount; i++) {
+		if (!fRenderThreads[i]->Jobs().IsEmpty())
+			return true;
+	}
+	return false;
+}
+
+// _UpdateCacheArea
+//
+// fRenderQueueLock must be locked. Returns whether the cache area changed.
+bool
+RenderManager::_UpdateCacheArea()
+{
+	if (fTileCache == NULL)
+		return false;
+
+	// The visible rect is in the coordinate space of the canvas, which may
+	// use a different zoom level than the layer tiles.
+	BRect visibleArea = fVisibleRect;
+	if (visibleArea.IsValid() && fViewZoomLevel > 0.0) {
+		double scale = fZoomLevel / fViewZoomLevel;
+		visibleArea.left = floorf(visibleArea.left * scale);
+		visibleArea.top = floorf(visibleArea.top * scale);
+		visibleArea.right = ceilf(visibleArea.right * scale);
+		visibleArea.bottom = ceilf(visibleArea.bottom * scale);
+	}
+
+	return fTileCache->SetVisibleArea(visibleArea);
+}
+
+// _QueueMissingTiles
+//
+// fRenderQueueLock must be locked. Queues the tiles within the cache area
+// which are missing in any layer for rendering.
+void
+RenderManager::_QueueMissingTiles()
+{
+	if (fTileCache == NULL || fSnapshot == NULL)
+		return;
+
+	QueueMissingTilesVisitor visitor(this, fTileCache->CacheArea());
+	int32 count = 0;
+	_TraverseLayerSnapshots(&visitor, fSnapshot, count, -1);
+
+	if (_HasDirtyLayers() && UpdatesEnabled())
+		_TriggerRenderIfNotBusy();
+}
+
+// _PrepareTiles
+//
+// Called for each layer from _TriggerRender() (via the RenderInfoInitVisitor)
+// while no render thread is running, since it allocates and frees tiles.
+// Computes the region of the layer to render at the current zoom level and
+// the area in which the cached tiles outside the cache area are stale.
+void
+RenderManager::_PrepareTiles(LayerSnapshot* layer,
+	const BRegion& childDirtyRegion, const BRect& childStaleArea,
+	BRegion& dirtyRegion, BRect& staleArea)
+{
+	dirtyRegion = childDirtyRegion;
+
+	BRegion* documentDirtyRegion = fSnapshotDirtyMap->Get(layer->Layer());
+	if (documentDirtyRegion != NULL) {
+		// Convert the dirty region to the current zoom level
+		BRect bounds = Bounds();
+		int32 count = documentDirtyRegion->CountRects();
+		for (int32 i = 0; i < count; i++) {
+			BRect dirtyArea = documentDirtyRegion->RectAt(i);
+			dirtyArea.left = floorf(dirtyArea.left * fZoomLevel);
+			dirtyArea.top = floorf(dirtyArea.top * fZoomLevel);
+			dirtyArea.right = ceilf(dirtyArea.right * fZoomLevel);
+			dirtyArea.bottom = ceilf(dirtyArea.bottom * fZoomLevel);
+			dirtyArea = dirtyArea & bounds;
+			if (dirtyArea.IsValid())
+				dirtyRegion.Include(dirtyArea);
+		}
+	}
+
+	// Tiles outside the cache area are not rendered. Where this layer or
+	// any of its sub-layers changed, they would become stale, so they are
+	// dropped instead.
+	staleArea = childStaleArea;
+	if (dirtyRegion.CountRects() > 0)
+		staleArea = staleArea | dirtyRegion.Frame();
+
+	TiledRenderBuffer* tiles = layer->Tiles();
+	if (tiles == NULL) {
+		dirtyRegion.MakeEmpty();
+		return;
+	}
+
+	const BRect& cacheArea = fTileCache->CacheArea();
+
+	if (staleArea.IsValid())
+		tiles->FreeTiles(staleArea, cacheArea);
+
+	// Render the dirty part of the cache area, including where sub-layers
+	// changed and where tiles are still missing.
+	BRect missingArea = tiles->MissingArea(cacheArea);
+	if (missingArea.IsValid())
+		dirtyRegion.Include(missingArea);
+
+	BRegion cacheRegion(cacheArea);
+	dirtyRegion.IntersectWith(&cacheRegion);
+
+	int32 count = dirtyRegion.CountRects();
+	for (int32 i = 0; i < count; i++) {
+		if (tiles->AllocateTiles(dirtyRegion.RectAt(i)) != B_OK) {
+			printf("RenderManager::_PrepareTiles() - out of memory!\n");
+			break;
+		}
+	}
+
+	layer->PrepareCache(dirtyRegion, cacheArea);
+}
+
+// _EvictTiles
+//
+// Called from _TriggerRender() while no render thread is running. Frees
+// the least recently visible tiles of all layers until the memory budget
+// is met again.
+void
+RenderManager::_EvictTiles()
+{
+	BRect invalidArea(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
+	FreeTilesVisitor memoryUsageVisitor(invalidArea, invalidArea);
+	int32 count = 0;
+	_TraverseLayerSnapshots(&memoryUsageVisitor, fSnapshot, count, -1);
+
+	size_t memoryUsage = memoryUsageVisitor.MemoryUsage();
+	size_t memoryBudget = fTileCache->MemoryBudget();
+
+	BRect frame;
+	while (memoryUsage > memoryBudget) {
+		if (!fTileCache->EvictOldestTile(frame)) {
+			// None of the remaining tiles outside the cache area are known
+			// to the cache, drop all of them.
+			FreeTilesVisitor visitor(fTileCache->Bounds(),
+				fTileCache->CacheArea());
+			count = 0;
+			_TraverseLayerSnapshots(&visitor, fSnapshot, count, -1);
+			break;
+		}
+
+		FreeTilesVisitor visitor(frame, invalidArea);
+		count = 0;
+		_TraverseLayerSnapshots(&visitor, fSnapshot, count, -1);
+		memoryUsage -= min_c(memoryUsage, visitor.FreedMemory());
+	}
+}
+
 // _ClearDirtyMap
 void
 RenderManager::_ClearDirtyMap(DirtyMap* map)
@@ -827,19 +1404,21 @@ RenderManager::_TraverseLayerSnapshots(LayerSnapshotVisitor* visitor,
 void
 RenderManager::_AllRenderThreadsDone()
 {
-//bool scrollingDelayed = fScrollingDelayed;
 	// executed in a rendering thread
+	fRenderPassEndTime = system_time();
+
 	if (fCleanArea.IsValid()) {
 		_BackToDisplay(fCleanArea);
 		fCleanArea.Set(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
 	}
 
-//	if (fLastRenderStartTime > 0) {
-//		printf("render pass: %lld (%d)\n",
-//			system_time() - fLastRenderStartTime, scrollingDelayed);
-//	}
+	if (fLastRenderStartTime > 0 && RenderTrace::IsEnabled()) {
+		RenderTrace::AddSpan(fRenderingPreview ? "render pass (preview)"
+			: "render pass", NULL, fRenderBuffer->Bounds(),
+			fLastRenderStartTime, fRenderPassEndTime);
+	}
 
-	if (_HasDirtyLayers())
+	if (_HasDirtyLayers() && !fRenderingSuspended)
 		_TriggerRender();
 }
 
@@ -849,8 +1428,13 @@ RenderManager::_AllRenderThreadsDone()
 status_t
 RenderManager::_CreateDisplayBitmaps(double zoomLevel)
 {
-	// Wait for all rendering to finish first.
+	// Wait for all rendering to finish first. Everything is rendered again
+	// at the new zoom level anyways, so the jobs still in progress are
+	// cancelled, and no new pass is started in the meantime.
 	AutoLocker<BLocker> locker(fRenderQueueLock);
+	if (fWaitingRenderThreadCount < fRenderThreadCount)
+		atomic_set(&fCancelRendering, 1);
+	fRenderingSuspended = true;
 	while (fWaitingRenderThreadCount < fRenderThreadCount) {
 		locker.Unlock();
 		// This should switch to the blocked thread...
@@ -859,6 +1443,7 @@ RenderManager::_CreateDisplayBitmaps(double zoomLevel)
 		snooze(1000);
 		locker.Lock();
 	}
+	fRenderingSuspended = false;
 
 	BBitmap* oldDisplayBitmap = fDisplayBitmap;
 	delete fRenderBuffer;
@@ -886,14 +1471,20 @@ RenderManager::_CreateDisplayBitmaps(double zoomLevel)
 		return B_NO_MEMORY;
 	}
 
+	// The tiles of all layers are dropped when the layers are resized to the
+	// new zoom level. Adjust the cache area accordingly.
+	if (fTileCache != NULL) {
+		fTileCache->SetBounds(bounds);
+		_UpdateCacheArea();
+	}
+
 	// clear new bitmap, if there wasn't an old one
 	if (oldDisplayBitmap == NULL)
 		memset(fDisplayBitmap->Bits(), 0, fDisplayBitmap->BitsLength());
 
 	// Every layer needs to be rerendered
-	QueueRedrawVisitor queueRedrawVisitor(this, fDocument->Bounds());
-	int32 count = 0;
-	_TraverseLayerSnapshots(&queueRedrawVisitor, fSnapshot, count, -1);
+	fPreviewArea.Set(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
+	_QueueRedrawAllLayers(fDocument->Bounds());
 	_TriggerRender();
 
 	return B_OK;
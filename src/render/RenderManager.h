@@ -30,10 +30,15 @@
 
 class BBitmap;
 class BMessenger;
+class BRegion;
 class Document;
 class LayerSnapshot;
 class RenderBuffer;
 class RenderThread;
+class TileCache;
+class TiledRenderBuffer;
+struct RenderJob;
+struct RenderStatistics;
 
 enum {
 	MSG_BITMAP_CLEAN	= 'bcln',
@@ -71,8 +76,16 @@ public:
 			BRect				Bounds() const;
 
 			void				SetZoomLevel(double zoomLevel);
+			void				SetZoomLevel(double zoomLevel,
+									double viewZoomLevel);
 			double				ZoomLevel() const;
 
+			void				SetPreviewMode(bool preview);
+			bool				IsPreviewMode() const
+									{ return fPreviewMode; }
+
+			void				SetTileCacheBudget(size_t bytes);
+
 			bool				ScrollBy(const BPoint& offset);
 			void				SetCanvasLayout(const BRect& dataRect,
 									const BRect& visibleRect);
@@ -87,7 +100,7 @@ public:
 			void				UnlockDisplay();
 			const BBitmap*		DisplayBitmap() const;
 
-			void				TransferClean(const RenderBuffer* bitmap,
+			void				TransferClean(const TiledRenderBuffer* bitmap,
 									const BRect& area);
 
 			void				PrepareDirtyInfosForNextRender();
@@ -99,16 +112,25 @@ public:
 			void				WakeUpRenderThreads();
 			bool				RenderingDone();
 
+			int32				CountRenderThreads() const;
+			bool				GetRenderStatistics(int32 threadIndex,
+									RenderStatistics& statistics) const;
+			void				ResetRenderStatistics();
+
 private:
-			typedef HashMap<HashKey32<const Layer*>, BRect*> DirtyMap;
+			typedef HashMap<HashKey32<const Layer*>, BRegion*> DirtyMap;
 			struct RenderInfo;
 			class LayerSnapshotVisitor;
 			class RenderInfoInitVisitor;
 			class QueueRedrawVisitor;
+			class QueueMissingTilesVisitor;
+			class FreeTilesVisitor;
 
 			friend class RenderInfoInitVisitor;
 			friend class QueueRedrawVisitor;
+			friend class QueueMissingTilesVisitor;
 
+			bool				_LockRenderQueue();
 			status_t			_IncludeDirtyArea(const Layer* layer,
 									BRect area);
 			void				_QueueRedraw(const Layer* layer, BRect area);
@@ -116,6 +138,22 @@ private:
 			void				_TriggerRenderIfNotBusy();
 			void				_TriggerRender();
 			void				_BackToDisplay(BRect area);
+			void				_QueueRedrawAllLayers(const BRect& area);
+
+			void				_ScheduleRenderJobs();
+			void				_PushJobs(int32 renderInfo,
+									RenderThread* thread, int32& nextThread);
+			void				_RenderJob(RenderThread* thread,
+									const RenderJob& job);
+			bool				_HasStealableJobs() const;
+
+			bool				_UpdateCacheArea();
+			void				_QueueMissingTiles();
+			void				_PrepareTiles(LayerSnapshot* layer,
+									const BRegion& childDirtyRegion,
+									const BRect& childStaleArea,
+									BRegion& dirtyRegion, BRect& staleArea);
+			void				_EvictTiles();
 
 			void				_ClearDirtyMap(DirtyMap* map);
 
@@ -137,10 +175,25 @@ private:
 			BRect				fDataRect;
 			BRect				fVisibleRect;
 			double				fZoomLevel;
+			double				fViewZoomLevel;
 			bool				fScrollingDelayed;
 
+			// The zoom level requested by the canvas, which is only rendered
+			// at a lower zoom level while in preview mode.
+			double				fTargetZoomLevel;
+			bool				fPreviewMode;
+			bool				fRenderingPreview;
+			bool				fRenderingSuspended;
+			vint32				fCancelRendering;
+
+			// The area rendered in preview mode at the current zoom level,
+			// which still needs to be rendered at full quality.
+			BRect				fPreviewArea;
+
 			BRect				fCleanArea;
 
+			TileCache*			fTileCache;
+
 			DirtyMap*			fDocumentDirtyMap;
 			DirtyMap*			fSnapshotDirtyMap;
 
@@ -157,16 +210,19 @@ private:
 			RenderInfo*			fRenderInfos;
 			int32				fRenderInfoCount;
 			int32				fRenderInfoCapacity;
-			int32				fCurrentRenderInfo;
+			vint32				fPendingJobs;
 
 			sem_id				fWaitingRenderThreadsSem;
-			int32				fWaitingRenderThreadCount;
+			vint32				fWaitingRenderThreadCount;
 
 			BLocker				fRenderQueueLock;
 
 			BList				fBitmapListeners;
 
 			bigtime_t			fLastRenderStartTime;
+			// Written by the last thread to finish a render pass, while
+			// holding fRenderQueueLock.
+			bigtime_t			fRenderPassEndTime;
 };
 
 // RenderInfoLocking
@@ -22,22 +22,28 @@
 #  include <Window.h>
 #endif
 
+#include "AutoLocker.h"
 #include "Layer.h"
 #include "LayerSnapshot.h"
 #include "ObjectSnapshot.h"
 #include "RenderBuffer.h"
 #include "RenderManager.h"
+#include "RenderTrace.h"
 
 
 using std::nothrow;
 
 // constructor
-RenderThread::RenderThread(RenderManager* manager)
+RenderThread::RenderThread(RenderManager* manager, int32 index)
 	: fThread(-1)
 	, fRenderManager(manager)
+	, fIndex(index)
 	, fEngine()
+	, fJobs()
+	, fStatisticsLock("render statistics")
 	, fScratchBitmap(NULL)
 {
+	ResetStatistics();
 }
 
 // destructor
@@ -84,32 +90,55 @@ RenderThread::WaitForThread()
 // Called by the RenderManager, but in our own thread
 // (_WorkerLoop() -> RenderManager::DoNextRenderJob() -> Render()).
 void
-RenderThread::Render(LayerSnapshot* layer, BRect area, double zoomLevel)
+RenderThread::Render(LayerSnapshot* layer, BRect area)
 {
 //printf("RenderThread::Render(%p, (%f, %f, %f, %f))\n", layer,
 //area.left, area.top, area.right, area.bottom);
-	// TODO: Move change of zoom elsewhere and check Resize() success
-	// there. Otherwise we may access an invalid RenderBuffer here the next
-	// time this method is called after resizing.
-	BRect zoomedBounds(layer->Bounds());
-	zoomedBounds.left = floorf(zoomedBounds.left * zoomLevel);
-	zoomedBounds.top = floorf(zoomedBounds.top * zoomLevel);
-	zoomedBounds.right = ceilf(zoomedBounds.right * zoomLevel);
-	zoomedBounds.bottom = ceilf(zoomedBounds.bottom * zoomLevel);
-	if (fScratchBitmap == NULL || fScratchBitmap->Bounds() != zoomedBounds) {
-		// Need to resize the bitmap and render everything
-//printf("  resizing scratch bitmap\n");
-		delete fScratchBitmap;
-		fScratchBitmap = new(std::nothrow) RenderBuffer(zoomedBounds);
-		if (fScratchBitmap == NULL || !fScratchBitmap->IsValid())
+	// The layer moves the scratch bitmap to the area it rebuilds for the
+	// job, so it only grows to the largest job, not to the document.
+	if (fScratchBitmap == NULL) {
+		fScratchBitmap = new(std::nothrow) RenderBuffer(area);
+		if (fScratchBitmap == NULL)
 			return;
-		area = zoomedBounds;
 	}
 
-	BRegion dummyRegion;
-	int32 dummyLevel;
-	layer->Render(fEngine, area, fScratchBitmap, NULL, dummyRegion,
-		dummyLevel);
+	layer->Render(fEngine, area, fScratchBitmap);
+}
+
+// Statistics
+RenderStatistics
+RenderThread::Statistics() const
+{
+	AutoLocker<BLocker> locker(fStatisticsLock);
+	return fStatistics;
+}
+
+// ResetStatistics
+void
+RenderThread::ResetStatistics()
+{
+	AutoLocker<BLocker> locker(fStatisticsLock);
+	fStatistics.jobs = 0;
+	fStatistics.steals = 0;
+	fStatistics.idleTime = 0;
+}
+
+// JobDone
+void
+RenderThread::JobDone(bool stolen)
+{
+	AutoLocker<BLocker> locker(fStatisticsLock);
+	fStatistics.jobs++;
+	if (stolen)
+		fStatistics.steals++;
+}
+
+// AddIdleTime
+void
+RenderThread::AddIdleTime(bigtime_t idleTime)
+{
+	AutoLocker<BLocker> locker(fStatisticsLock);
+	fStatistics.idleTime += idleTime;
 }
 
 // #pragma mark -
@@ -125,6 +154,10 @@ RenderThread::_WorkerLoopEntry(void* data)
 status_t
 RenderThread::_WorkerLoop()
 {
+	char name[32];
+	snprintf(name, sizeof(name), "render thread %ld", fIndex);
+	RenderTrace::SetThreadName(name);
+
 	while (fRenderManager->DoNextRenderJob(this));
 
 	fThread = B_BAD_THREAD_ID;
@@ -8,10 +8,12 @@
 #define RENDER_THREAD_H
 
 #include <List.h>
+#include <Locker.h>
 #include <OS.h>
 #include <Region.h>
 
 #include "RenderEngine.h"
+#include "RenderJobDeque.h"
 
 
 class Layer;
@@ -19,16 +21,35 @@ class LayerSnapshot;
 class RenderBuffer;
 class RenderManager;
 
+// RenderStatistics
+struct RenderStatistics {
+	int64				jobs;
+	int64				steals;
+	bigtime_t			idleTime;
+};
+
 class RenderThread {
 public:
-								RenderThread(RenderManager* manager);
+								RenderThread(RenderManager* manager,
+									int32 index);
 	virtual						~RenderThread();
 
 			status_t			Init();
 			thread_id			Run();
 			void				WaitForThread();
-			void				Render(LayerSnapshot* layer, BRect area,
-									double zoomLevel);
+			void				Render(LayerSnapshot* layer, BRect area);
+
+			int32				Index() const
+									{ return fIndex; }
+			RenderJobDeque&		Jobs()
+									{ return fJobs; }
+
+			// Statistics are updated by the thread itself, but may be read
+			// and reset from other threads at any time.
+			RenderStatistics	Statistics() const;
+			void				ResetStatistics();
+			void				JobDone(bool stolen);
+			void				AddIdleTime(bigtime_t idleTime);
 
 private:
 	static	status_t			_WorkerLoopEntry(void* data);
@@ -36,7 +57,11 @@ private:
 
 			thread_id			fThread;
 			RenderManager*		fRenderManager;
+			int32				fIndex;
 			RenderEngine		fEngine;
+			RenderJobDeque		fJobs;
+	mutable	BLocker				fStatisticsLock;
+			RenderStatistics	fStatistics;
 
 			RenderBuffer*		fScratchBitmap;
 };
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "RenderTrace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Locker.h>
+
+#include "AutoLocker.h"
+
+enum {
+	EVENTS_PER_THREAD	= 8192,
+	NAME_LENGTH			= 32
+};
+
+struct trace_event {
+	const char*	name;
+	bigtime_t	startTime;
+	bigtime_t	duration;
+	int32		thread;
+	int32		width;
+	int32		height;
+	char		object[NAME_LENGTH];
+};
+
+// Each buffer belongs to one thread at a time, which is the only one
+// writing events into it. When the thread exits, the buffer is handed to
+// the next new thread, which continues to write into the same ring. So
+// there are never more buffers than threads running at the same time, and
+// the spans of threads which exited are kept until they are overwritten.
+// Buffers are never freed, so that Dump() can walk the list without
+// locking out the threads recording spans.
+struct trace_buffer {
+	trace_buffer*	next;
+	bool			inUse;
+	int32			thread;
+	vint32			count;
+	trace_event*	events;
+	char			threadName[NAME_LENGTH];
+};
+
+vint32 RenderTrace::sEnabled = 0;
+
+static BLocker sBuffersLock("render trace buffers");
+static trace_buffer* sBuffers = NULL;
+
+static pthread_once_t sBufferKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t sBufferKey;
+
+// copy_name
+static inline void
+copy_name(char* target, const char* name)
+{
+	strncpy(target, name, NAME_LENGTH - 1);
+	target[NAME_LENGTH - 1] = '\0';
+}
+
+// release_buffer
+/*!	Called when a thread which recorded spans exits.
+*/
+static void
+release_buffer(void* data)
+{
+	trace_buffer* buffer = (trace_buffer*)data;
+
+	AutoLocker<BLocker> locker(sBuffersLock);
+	buffer->inUse = false;
+}
+
+// create_buffer_key
+static void
+create_buffer_key()
+{
+	pthread_key_create(&sBufferKey, release_buffer);
+}
+
+// first_buffer
+static trace_buffer*
+first_buffer()
+{
+	AutoLocker<BLocker> locker(sBuffersLock);
+	return sBuffers;
+}
+
+// buffer_for_current_thread
+static trace_buffer*
+buffer_for_current_thread()
+{
+	pthread_once(&sBufferKeyOnce, create_buffer_key);
+
+	trace_buffer* buffer = (trace_buffer*)pthread_getspecific(sBufferKey);
+	if (buffer != NULL)
+		return buffer;
+
+	AutoLocker<BLocker> locker(sBuffersLock);
+	if (!locker.IsLocked())
+		return NULL;
+
+	// Take over the buffer of a thread which exited, or add a new one.
+	buffer = sBuffers;
+	while (buffer != NULL && buffer->inUse)
+		buffer = buffer->next;
+
+	if (buffer == NULL) {
+		buffer = (trace_buffer*)calloc(1, sizeof(trace_buffer));
+		if (buffer == NULL)
+			return NULL;
+		buffer->next = sBuffers;
+		sBuffers = buffer;
+	}
+
+	buffer->inUse = true;
+	buffer->thread = (int32)find_thread(NULL);
+	buffer->threadName[0] = '\0';
+
+	if (pthread_setspecific(sBufferKey, buffer) != 0) {
+		buffer->inUse = false;
+		return NULL;
+	}
+
+	return buffer;
+}
+
+// #pragma mark -
+
+// SetEnabled
+void
+RenderTrace::SetEnabled(bool enabled)
+{
+	atomic_set(&sEnabled, enabled ? 1 : 0);
+}
+
+// SetThreadName
+void
+RenderTrace::SetThreadName(const char* name)
+{
+	trace_buffer* buffer = buffer_for_current_thread();
+	if (buffer != NULL)
+		copy_name(buffer->threadName, name);
+}
+
+// AddSpan
+void
+RenderTrace::AddSpan(const char* name, const char* object, const BRect& area,
+	bigtime_t startTime, bigtime_t endTime)
+{
+	trace_buffer* buffer = buffer_for_current_thread();
+	if (buffer == NULL)
+		return;
+
+	if (buffer->events == NULL) {
+		buffer->events = (trace_event*)calloc(EVENTS_PER_THREAD,
+			sizeof(trace_event));
+		if (buffer->events == NULL)
+			return;
+	}
+
+	// Only this thread writes into the buffer. The count is incremented
+	// after the event is complete, which tells Dump() which events it can
+	// rely on.
+	int32 count = buffer->count;
+	trace_event& event = buffer->events[count % EVENTS_PER_THREAD];
+	event.name = name;
+	event.startTime = startTime;
+	event.duration = endTime - startTime;
+	event.thread = buffer->thread;
+	if (area.IsValid()) {
+		event.width = area.IntegerWidth() + 1;
+		event.height = area.IntegerHeight() + 1;
+	} else {
+		event.width = 0;
+		event.height = 0;
+	}
+	if (object != NULL)
+		copy_name(event.object, object);
+	else
+		event.object[0] = '\0';
+
+	atomic_add(&buffer->count, 1);
+}
+
+// Clear
+/*!	Forgets all recorded spans. Must not be called while spans are being
+	recorded.
+*/
+void
+RenderTrace::Clear()
+{
+	for (trace_buffer* buffer = first_buffer(); buffer != NULL;
+			buffer = buffer->next) {
+		atomic_set(&buffer->count, 0);
+	}
+}
+
+// Dump
+/*!	Writes the recorded spans of all threads. This may be called while
+	other threads are recording, events which are overwritten while they
+	are copied are left out.
+*/
+status_t
+RenderTrace::Dump(FILE* file)
+{
+	trace_event* events = (trace_event*)malloc(
+		EVENTS_PER_THREAD * sizeof(trace_event));
+	if (events == NULL)
+		return B_NO_MEMORY;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+
+	for (trace_buffer* next = first_buffer(); next != NULL;
+			next = next->next) {
+		trace_buffer& buffer = *next;
+
+		if (buffer.threadName[0] != '\0') {
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\","
+				"\"pid\":1,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+				first ? "" : ",\n", (long)buffer.thread, buffer.threadName);
+			first = false;
+		}
+
+		int32 count = atomic_get(&buffer.count);
+		if (buffer.events == NULL)
+			count = 0;
+
+		int32 oldest = max_c(0, count - EVENTS_PER_THREAD);
+		for (int32 j = oldest; j < count; j++) {
+			int32 index = j % EVENTS_PER_THREAD;
+			events[index] = buffer.events[index];
+		}
+
+		// The thread may have overwritten the oldest events meanwhile,
+		// including the one it is writing right now.
+		int32 newCount = atomic_get(&buffer.count);
+		oldest = max_c(oldest, newCount + 1 - EVENTS_PER_THREAD);
+
+		for (int32 j = oldest; j < count; j++) {
+			const trace_event& event = events[j % EVENTS_PER_THREAD];
+			fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"render\","
+				"\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,"
+				"\"tid\":%ld,\"args\":{",
+				first ? "" : ",\n", event.name, (long long)event.startTime,
+				(long long)event.duration, (long)event.thread);
+			if (event.object[0] != '\0') {
+				fputs("\"object\":\"", file);
+				for (const char* c = event.object; *c != '\0'; c++) {
+					if (*c == '"' || *c == '\\')
+						fputc('\\', file);
+					if ((uint8)*c >= 0x20)
+						fputc(*c, file);
+				}
+				fputs("\",", file);
+			}
+			fprintf(file, "\"width\":%ld,\"height\":%ld,\"pixels\":%lld}}",
+				(long)event.width, (long)event.height,
+				(long long)event.width * event.height);
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	free(events);
+
+	return ferror(file) ? B_IO_ERROR : B_OK;
+}
+
+// Dump
+status_t
+RenderTrace::Dump(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return errno;
+
+	status_t ret = Dump(file);
+	if (fclose(file) != 0 && ret == B_OK)
+		ret = errno;
+	return ret;
+}
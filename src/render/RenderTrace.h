@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef RENDER_TRACE_H
+#define RENDER_TRACE_H
+
+#include <stdio.h>
+
+#include <OS.h>
+#include <Rect.h>
+
+// Tracing of the render passes. Each thread records spans (a name, the
+// object being worked on, the size of the area and the time) into its own
+// ring buffer, so recording needs no locks. When a thread exits, its ring
+// buffer is passed on to the next new thread. Only the most recent spans
+// of each ring are kept. Dump() writes them in the JSON format of the
+// Chrome trace viewer, which Perfetto can open as well.
+//
+// The spans are compiled in unless RENDER_TRACING is defined to 0. Even
+// then, nothing is recorded until tracing is enabled at runtime, and a span
+// costs only one check of a flag.
+
+#ifndef RENDER_TRACING
+#	define RENDER_TRACING 1
+#endif
+
+class RenderTrace {
+public:
+	static	void				SetEnabled(bool enabled);
+	static	inline bool			IsEnabled()
+									{ return sEnabled != 0; }
+
+	static	void				SetThreadName(const char* name);
+
+	static	void				AddSpan(const char* name,
+									const char* object, const BRect& area,
+									bigtime_t startTime, bigtime_t endTime);
+
+	static	void				Clear();
+	static	status_t			Dump(FILE* file);
+	static	status_t			Dump(const char* path);
+
+private:
+	static	vint32				sEnabled;
+};
+
+
+class TraceSpan {
+public:
+	inline						TraceSpan(const char* name,
+									const char* object = NULL,
+									const BRect& area = BRect())
+									: fName(RenderTrace::IsEnabled()
+										? name : NULL)
+								{
+									if (fName != NULL) {
+										fObject = object;
+										fArea = area;
+										fStartTime = system_time();
+									}
+								}
+
+	inline						~TraceSpan()
+								{
+									if (fName != NULL) {
+										RenderTrace::AddSpan(fName, fObject,
+											fArea, fStartTime,
+											system_time());
+									}
+								}
+
+private:
+			const char*			fName;
+			const char*			fObject;
+			BRect				fArea;
+			bigtime_t			fStartTime;
+};
+
+
+#if RENDER_TRACING
+#	define _TRACE_SPAN_VARIABLE2(line)	_traceSpan##line
+#	define _TRACE_SPAN_VARIABLE(line)	_TRACE_SPAN_VARIABLE2(line)
+#	define TRACE_SPAN(name) \
+		TraceSpan _TRACE_SPAN_VARIABLE(__LINE__)(name)
+#	define TRACE_SPAN_AREA(name, object, area) \
+		TraceSpan _TRACE_SPAN_VARIABLE(__LINE__)(name, object, area)
+#else
+#	define TRACE_SPAN(name)
+#	define TRACE_SPAN_AREA(name, object, area)
+#endif
+
+#endif // RENDER_TRACE_H
@@ -36,7 +36,9 @@
 #include "DataBlock.h"
 
 typedef uint8					CoverType;
-typedef int16					CoordType;
+// Spans are stored in layer pixels, which exceed the range of int16 when
+// zoomed in far enough.
+typedef int32					CoordType;
 
 struct Span {
 	CoordType			x;
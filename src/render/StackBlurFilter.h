@@ -7,6 +7,10 @@ class AlphaBuffer;
 class BBitmap;
 class RenderBuffer;
 
+// The StackBlurFilter blurs by the same amount as a stack blur of the given
+// radius did. It uses the BoxBlurFilter, which is not limited to a radius
+// of 254.
+
 class StackBlurFilter {
 public:
 								StackBlurFilter();
@@ -17,19 +21,6 @@ public:
 			void				FilterRGBA32(RenderBuffer* buffer, double radius);
 			void				FilterGray16(AlphaBuffer* buffer, double radius);
 			void				Filter(BBitmap* bitmap, double radius);
-
-private:
-			void				_Filter64(uint16* buffer,
-									unsigned width, unsigned height,
-									int32 bpr, unsigned rx, unsigned ry) const;
-			void				_Filter32(uint8* buffer,
-									unsigned width, unsigned height, int32 bpr,
-									unsigned rx, unsigned ry) const;
-
-			template<typename PixelType>
-			void				_FilterGray(PixelType* buffer,
-									unsigned width, unsigned height,
-									int32 bpr, unsigned rx, unsigned ry) const;
 };
 
 #endif // STACK_BLUR_FILTER
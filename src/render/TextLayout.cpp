@@ -10,9 +10,11 @@
 #include "TextLayout.h"
 
 #include <algorithm>
+#include <new>
 #include <string.h>
 
 #include "FontCache.h"
+#include "Referenceable.h"
 #include "UTF8Utils.h"
 
 
@@ -171,6 +173,8 @@ TextLayout::TextLayout(FontCache* fontCache)
 	fGlyphSpacing(0.0),			// -0.2-0.20, Default: 0.0
 	fLineSpacing(0.0),
 
+	fSharedBuffers(NULL),
+
 	fGlyphInfoBuffer(NULL),
 	fGlyphInfoBufferSize(0),
 	fGlyphInfoCount(0),
@@ -190,7 +194,11 @@ TextLayout::TextLayout(FontCache* fontCache)
 	fKerning(true),
 	fHinting(true),
 
-	fLayoutPerformed(false)
+	fLayoutPerformed(false),
+
+	fPartialLayout(false),
+	fDirtyStart(0),
+	fDirtyEnd(0)
 {
 }
 
@@ -198,10 +206,15 @@ TextLayout::TextLayout(FontCache* fontCache)
 TextLayout::TextLayout(const TextLayout& other)
 	:
 	fFont(other.fFont),
+	fSharedBuffers(NULL),
 	fGlyphInfoBuffer(NULL),
+	fGlyphInfoCount(0),
 	fLineInfoBuffer(NULL),
+	fLineInfoCount(0),
 	fStyleRunBuffer(NULL),
-	fTabBuffer(NULL)
+	fStyleRunCount(0),
+	fTabBuffer(NULL),
+	fTabCount(0)
 {
 	*this = other;
 }
@@ -210,6 +223,9 @@ TextLayout::TextLayout(const TextLayout& other)
 TextLayout&
 TextLayout::operator=(const TextLayout& other)
 {
+	if (this == &other)
+		return *this;
+
 	fFontCache = other.fFontCache;
 
 	fFont = other.fFont;
@@ -227,36 +243,35 @@ TextLayout::operator=(const TextLayout& other)
 	fGlyphSpacing = other.fGlyphSpacing;
 	fLineSpacing = other.fLineSpacing;
 
-	fGlyphInfoBuffer = (GlyphInfo*)realloc(fGlyphInfoBuffer,
-		other.fGlyphInfoBufferSize * sizeof(GlyphInfo));
+	// Share the buffers instead of copying them, they are copied once
+	// either layout is changed.
+	if (fSharedBuffers != other.fSharedBuffers) {
+		releaseBuffers();
+		fSharedBuffers = other.fSharedBuffers;
+		if (fSharedBuffers != NULL)
+			fSharedBuffers->AddReference();
+	}
+
+	fGlyphInfoBuffer = other.fGlyphInfoBuffer;
 	fGlyphInfoBufferSize = other.fGlyphInfoBufferSize;
 	fGlyphInfoCount = other.fGlyphInfoCount;
-	if (fGlyphInfoCount > 0) {
-		memcpy(fGlyphInfoBuffer, other.fGlyphInfoBuffer,
-			fGlyphInfoCount * sizeof(GlyphInfo));
-	}
 
-	fLineInfoBuffer = (LineInfo*)realloc(fLineInfoBuffer,
-		other.fLineInfoBufferSize * sizeof(LineInfo));
+	fLineInfoBuffer = other.fLineInfoBuffer;
 	fLineInfoBufferSize = other.fLineInfoBufferSize;
 	fLineInfoCount = other.fLineInfoCount;
-	if (fLineInfoCount > 0) {
-		memcpy(fLineInfoBuffer, other.fLineInfoBuffer,
-			fLineInfoCount * sizeof(LineInfo));
-	}
 
-	fStyleRunBuffer = (StyleRun*)realloc(fStyleRunBuffer,
-		other.fStyleRunBufferSize * sizeof(StyleRun));
+	fStyleRunBuffer = other.fStyleRunBuffer;
 	fStyleRunBufferSize = other.fStyleRunBufferSize;
 	fStyleRunCount = other.fStyleRunCount;
-	if (fStyleRunCount > 0) {
-		memcpy(fStyleRunBuffer, other.fStyleRunBuffer,
-			fStyleRunCount * sizeof(StyleRun));
-	}
 
-	fTabBuffer = (double*)realloc(fTabBuffer,
-		other.fTabCount * sizeof(double));;
-	fTabCount = other.fTabCount;
+	double* tabBuffer = (double*)realloc(fTabBuffer,
+		other.fTabCount * sizeof(double));
+	if (tabBuffer != NULL || other.fTabCount == 0) {
+		fTabBuffer = tabBuffer;
+		fTabCount = other.fTabCount;
+		if (fTabCount > 0)
+			memcpy(fTabBuffer, other.fTabBuffer, fTabCount * sizeof(double));
+	}
 
 	fSubpixelRendering = other.fSubpixelRendering;
 	fKerning = other.fKerning;
@@ -264,15 +279,17 @@ TextLayout::operator=(const TextLayout& other)
 
 	fLayoutPerformed = other.fLayoutPerformed;
 
+	fPartialLayout = other.fPartialLayout;
+	fDirtyStart = other.fDirtyStart;
+	fDirtyEnd = other.fDirtyEnd;
+
 	return *this;
 }
 
 
 TextLayout::~TextLayout()
 {
-	free(fGlyphInfoBuffer);
-	free(fLineInfoBuffer);
-	free(fStyleRunBuffer);
+	releaseBuffers();
 	free(fTabBuffer);
 }
 
@@ -288,6 +305,95 @@ TextLayout::setText(const char* text)
 }
 
 
+/*!	Sets the changed text, where insertedCount chars at offset replaced
+	removedCount chars of the previous text. The style runs need to be set
+	already. Only the glyphs of the inserted chars are looked up again, and
+	the next layout() only breaks the lines which can have changed.
+*/
+void
+TextLayout::replaceText(const char* text, unsigned offset,
+	unsigned removedCount, unsigned insertedCount)
+{
+	if (offset + removedCount > fGlyphInfoCount
+		|| fGlyphInfoCount - removedCount + insertedCount == 0) {
+		setText(text);
+		return;
+	}
+
+	if (!makeBuffersWritable())
+		return;
+
+	unsigned count = fGlyphInfoCount - removedCount + insertedCount;
+
+	// Enlarge buffer if necessary
+	if (count > fGlyphInfoBufferSize) {
+		unsigned size = count + 64;
+
+		GlyphInfo* buffer = (GlyphInfo*) realloc(fGlyphInfoBuffer,
+			size * sizeof(GlyphInfo));
+		if (buffer == NULL)
+			return;
+
+		fGlyphInfoBufferSize = size;
+		fGlyphInfoBuffer = buffer;
+	}
+
+	// Move the glyphs after the change to their new position, they keep
+	// their layout.
+	memmove(fGlyphInfoBuffer + offset + insertedCount,
+		fGlyphInfoBuffer + offset + removedCount,
+		(fGlyphInfoCount - offset - removedCount) * sizeof(GlyphInfo));
+	for (unsigned i = offset; i < offset + insertedCount; i++)
+		setGlyph(i, 0, NULL, NULL);
+	fGlyphInfoCount = count;
+
+	if (fLayoutPerformed || fPartialLayout) {
+		// Move the start offsets of the lines to the changed text. Lines
+		// starting within the removed chars are not valid anymore, they
+		// are kept starting at the change.
+		unsigned changeEnd = offset + insertedCount;
+		for (unsigned i = 0; i < fLineInfoCount; i++) {
+			unsigned start = fLineInfoBuffer[i].startOffset;
+			if (start >= offset + removedCount)
+				start = start - removedCount + insertedCount;
+			else if (start >= offset) {
+				start = offset;
+				changeEnd = offset + insertedCount + 1;
+			}
+			fLineInfoBuffer[i].startOffset = start;
+		}
+
+		if (fPartialLayout) {
+			// Merge with the previous change
+			unsigned dirtyStart = fDirtyStart;
+			if (dirtyStart > offset + removedCount)
+				dirtyStart = dirtyStart - removedCount + insertedCount;
+			else if (dirtyStart > offset)
+				dirtyStart = offset;
+			unsigned dirtyEnd = fDirtyEnd;
+			if (dirtyEnd >= offset + removedCount)
+				dirtyEnd = dirtyEnd - removedCount + insertedCount;
+			else if (dirtyEnd > offset)
+				dirtyEnd = offset + insertedCount;
+			fDirtyStart = std::min(dirtyStart, offset);
+			fDirtyEnd = std::max(dirtyEnd, changeEnd);
+		} else {
+			fDirtyStart = offset;
+			fDirtyEnd = changeEnd;
+		}
+		fPartialLayout = true;
+	}
+	fLayoutPerformed = false;
+
+	unsigned subpixelScale = fSubpixelRendering ? 3 : 1;
+	if (!init(text, fFontCache->getFontEngine(), fFontCache->getFontManager(),
+			fHinting, TextRenderer::AUTO_HINT_SCALE, subpixelScale, offset,
+			offset + insertedCount)) {
+		setText(text);
+	}
+}
+
+
 void
 TextLayout::setFont(const Font& font)
 {
@@ -398,6 +504,11 @@ TextLayout::setTabs(double* tabs, unsigned count)
 void
 TextLayout::clearStyleRuns()
 {
+	if (fStyleRunCount == 0 || !makeBuffersWritable())
+		return;
+
+	for (unsigned i = 0; i < fStyleRunCount; i++)
+		fStyleRunBuffer[i].font.~Font();
 	fStyleRunCount = 0;
 }
 
@@ -411,6 +522,9 @@ TextLayout::addStyleRun(int start, const Font& font,
 	bool underline, unsigned underlineStyle,
 	const TextRenderer::Color& underlineColor)
 {
+	if (!makeBuffersWritable())
+		return false;
+
 //printf("TextLayout::addStyleRun(%d, font('%s', %.1f, %u), "
 //	"color(%d, %d, %d)) (index: %u)\n",
 //	start, fontPath, fontSize, fontStyle, fgRed, fgGreen, fgBlue,
@@ -990,15 +1104,25 @@ TextLayout::getTextBounds(int textOffset, double& x1, double& y1,
 }
 
 
+/*!	Looks up the glyphs for the text. When only the chars from reshapeStart
+	to reshapeEnd have changed, the glyphs for the other chars are kept and
+	only assigned to the new style runs.
+*/
 bool
 TextLayout::init(const char* text, TextRenderer::FontEngine& fontEngine,
 	TextRenderer::FontManager& fontManager, bool hinting, double scaleX,
-	unsigned subpixelScale)
+	unsigned subpixelScale, unsigned reshapeStart, unsigned reshapeEnd)
 {
+	if (!makeBuffersWritable())
+		return false;
+
 	AutoWriteLocker _(FontCache::getInstance());
 
-	fGlyphInfoCount = 0;
-	fLineInfoCount = 0;
+	bool reshapeAll = reshapeStart == 0 && reshapeEnd == UINT_MAX;
+	if (reshapeAll) {
+		fGlyphInfoCount = 0;
+		fLineInfoCount = 0;
+	}
 
     double height = fFont.getSize();
 
@@ -1051,6 +1175,15 @@ TextLayout::init(const char* text, TextRenderer::FontEngine& fontEngine,
 		if (styleIndex >= 0 && styleIndex < (int) fStyleRunCount)
 			styleRun = &(fStyleRunBuffer[styleIndex]);
 
+		if (!reshapeAll && (offset < reshapeStart || offset >= reshapeEnd)
+			&& offset < fGlyphInfoCount
+			&& fGlyphInfoBuffer[offset].charCode == charCode) {
+			// The glyph and its layout are unchanged
+			fGlyphInfoBuffer[offset].styleRun = styleRun;
+			offset++;
+			continue;
+		}
+
 		const agg::glyph_cache* glyph = NULL;
 		if (charCode != '\n' && charCode != '\t') {
 			glyph = fontManager.glyph(charCode);
@@ -1063,13 +1196,24 @@ TextLayout::init(const char* text, TextRenderer::FontEngine& fontEngine,
 //			}
 		}
 
-		if (!appendGlyph(charCode, glyph, styleRun))
-			return false;
+		if (reshapeAll) {
+			if (!appendGlyph(charCode, glyph, styleRun))
+				return false;
+		} else {
+			if (offset >= fGlyphInfoCount)
+				return false;
+			if (offset < reshapeStart || offset >= reshapeEnd) {
+				// The text does not match the previous text where it
+				// should, the lines have to be broken again entirely.
+				fPartialLayout = false;
+			}
+			setGlyph(offset, charCode, glyph, styleRun);
+		}
 
 		offset++;
 	}
 
-	return true;
+	return offset == fGlyphInfoCount;
 }
 
 
@@ -1078,10 +1222,13 @@ TextLayout::layout(TextRenderer::FontEngine& fontEngine,
 	TextRenderer::FontManager& fontManager,
 	bool kerning, double scaleX, unsigned subpixelScale)
 {
-	fLineInfoCount = 0;
+	if (!makeBuffersWritable())
+		return;
 
-	if (fGlyphInfoCount == 0)
+	if (fGlyphInfoCount == 0) {
+		fLineInfoCount = 0;
 		return;
+	}
 
 	AutoWriteLocker _(FontCache::getInstance());
 
@@ -1093,9 +1240,47 @@ TextLayout::layout(TextRenderer::FontEngine& fontEngine,
 	unsigned lineIndex = 0;
 	unsigned lineStart = 0;
 
+	// When only a part of the text has changed, the lines before the
+	// changed paragraph are kept. The old lines starting after the change
+	// are remembered, once a new line starts at the same glyph as one of
+	// them, all following lines are the same as before.
+	LineInfo* oldLines = NULL;
+	unsigned oldLinesIndex = 0;
+	unsigned oldLinesCount = 0;
+
+	if (fPartialLayout && fLineInfoCount > 0) {
+		lineIndex = getRelayoutLine();
+		if (lineIndex > 0) {
+			x = fLineInset * scaleX * subpixelScale;
+			y = fLineInfoBuffer[lineIndex].y;
+			lineStart = fLineInfoBuffer[lineIndex].startOffset;
+		}
+
+		oldLinesIndex = lineIndex + 1;
+		while (oldLinesIndex < fLineInfoCount
+			&& fLineInfoBuffer[oldLinesIndex].startOffset < fDirtyEnd) {
+			oldLinesIndex++;
+		}
+		if (oldLinesIndex < fLineInfoCount) {
+			oldLinesCount = fLineInfoCount - oldLinesIndex;
+			oldLines = (LineInfo*) malloc(oldLinesCount * sizeof(LineInfo));
+			if (oldLines != NULL) {
+				memcpy(oldLines, fLineInfoBuffer + oldLinesIndex,
+					oldLinesCount * sizeof(LineInfo));
+			} else
+				oldLinesCount = 0;
+		}
+	}
+
+	fLineInfoCount = lineIndex;
+
+	const unsigned firstGlyph = lineStart;
+	unsigned unchangedGlyph = fGlyphInfoCount;
+	unsigned oldLine = 0;
+
 	StyleRun* lastLoadedStyleRun = NULL;
 
-	for (unsigned i = 0; i < fGlyphInfoCount; i++) {
+	for (unsigned i = lineStart; i < fGlyphInfoCount; i++) {
 		const agg::glyph_cache* glyph = fGlyphInfoBuffer[i].glyph;
 
 		unsigned charClassification = getCharClassification(
@@ -1259,6 +1444,19 @@ TextLayout::layout(TextRenderer::FontEngine& fontEngine,
 				lineStart = i;
 
 			lineIndex++;
+
+			// Glyphs after a soft line break have already been placed on
+			// the previous line, only the glyphs after a line break char
+			// are still as they were.
+			while (lineBreak && oldLine < oldLinesCount
+				&& oldLines[oldLine].startOffset < lineStart) {
+				oldLine++;
+			}
+			if (lineBreak && oldLine < oldLinesCount
+				&& oldLines[oldLine].startOffset == lineStart) {
+				unchangedGlyph = lineStart;
+				break;
+			}
 		} else {
 			if (i < fGlyphInfoCount && kerning && i > lineStart) {
 				if (glyph != NULL && fGlyphInfoBuffer[i - 1].glyph != NULL
@@ -1301,8 +1499,27 @@ TextLayout::layout(TextRenderer::FontEngine& fontEngine,
 		y += advanceY;
 	}
 
-	// The last line may not have been appended and initialized yet.
-	if (lineStart <= fGlyphInfoCount - 1) {
+	if (unchangedGlyph < fGlyphInfoCount) {
+		// Append the unchanged lines and move their glyphs to where the
+		// lines are now.
+		double offsetY = y - oldLines[oldLine].y;
+		int offsetIndex = (int) lineIndex - (int) (oldLinesIndex + oldLine);
+
+		for (unsigned j = oldLine; j < oldLinesCount; j++) {
+			if (!appendLine(oldLines[j].startOffset, oldLines[j].y + offsetY,
+					oldLines[j].height, oldLines[j].maxAscent,
+					oldLines[j].maxDescent)) {
+				free(oldLines);
+				return;
+			}
+		}
+
+		for (unsigned j = unchangedGlyph; j < fGlyphInfoCount; j++) {
+			fGlyphInfoBuffer[j].y += offsetY;
+			fGlyphInfoBuffer[j].lineIndex += offsetIndex;
+		}
+	} else if (lineStart <= fGlyphInfoCount - 1) {
+		// The last line may not have been appended and initialized yet.
 		double lineHeight = 0.0;
 		double maxAscent = 0.0;
 		double maxDescent = 0.0;
@@ -1350,19 +1567,53 @@ TextLayout::layout(TextRenderer::FontEngine& fontEngine,
 //	}
 //	fflush(stdout);
 
-	applyAlignment(width);
+	free(oldLines);
+
+	applyAlignment(width, firstGlyph, unchangedGlyph);
 
 	fLayoutPerformed = true;
+	fPartialLayout = false;
 }
 
 
+/*!	Returns the index of the first line which may be broken differently
+	since the last layout. That's the first line of the paragraph containing
+	the first changed glyph.
+*/
+unsigned
+TextLayout::getRelayoutLine() const
+{
+	// Lines starting at or after the first changed glyph may have been
+	// removed with the text.
+	unsigned lineIndex = 0;
+	while (lineIndex + 1 < fLineInfoCount
+		&& fLineInfoBuffer[lineIndex + 1].startOffset < fDirtyStart) {
+		lineIndex++;
+	}
+
+	while (lineIndex > 0) {
+		unsigned start = fLineInfoBuffer[lineIndex].startOffset;
+		if (start > 0 && start <= fGlyphInfoCount
+			&& fGlyphInfoBuffer[start - 1].charCode == '\n') {
+			break;
+		}
+		lineIndex--;
+	}
+
+	return lineIndex;
+}
+
+
+/*!	Aligns the lines of the glyphs from start to end, which need to be
+	complete lines.
+*/
 void
-TextLayout::applyAlignment(const double width)
+TextLayout::applyAlignment(const double width, unsigned start, unsigned end)
 {
 	if (fAlignment == ALIGNMENT_LEFT && !fJustify)
 		return;
 
-	if (fGlyphInfoCount == 0)
+	if (fGlyphInfoCount == 0 || start >= end)
 		return;
 
 	int lineIndex = -1;
@@ -1374,7 +1625,7 @@ TextLayout::applyAlignment(const double width)
 	// Iterate all glyphs backwards. On the last character of the next line,
 	// the position of the character determines the available space to be
 	// distributed (spaceLeft).
-	for (int i = fGlyphInfoCount - 1; i >= 0; i--) {
+	for (int i = end - 1; i >= (int) start; i--) {
 		if ((int) fGlyphInfoBuffer[i].lineIndex != lineIndex) {
 			bool lineBreak = fGlyphInfoBuffer[i].charCode == '\n'
 				|| i == (int) fGlyphInfoCount - 1;
@@ -1498,6 +1749,7 @@ void
 TextLayout::invalidateLayout()
 {
 	fLayoutPerformed = false;
+	fPartialLayout = false;
 }
 
 
@@ -1509,6 +1761,92 @@ TextLayout::validateLayout()
 }
 
 
+/*!	Makes sure the buffers are not shared with any other TextLayout, so
+	that they can be changed.
+*/
+bool
+TextLayout::makeBuffersWritable()
+{
+	if (fSharedBuffers != NULL && fSharedBuffers->CountReferences() == 1)
+		return true;
+
+	Referenceable* sharedBuffers = new(std::nothrow) Referenceable();
+	if (sharedBuffers == NULL)
+		return false;
+
+	if (fSharedBuffers == NULL) {
+		fSharedBuffers = sharedBuffers;
+		return true;
+	}
+
+	GlyphInfo* glyphInfoBuffer = (GlyphInfo*) malloc(
+		fGlyphInfoBufferSize * sizeof(GlyphInfo));
+	LineInfo* lineInfoBuffer = (LineInfo*) malloc(
+		fLineInfoBufferSize * sizeof(LineInfo));
+	StyleRun* styleRunBuffer = (StyleRun*) malloc(
+		fStyleRunBufferSize * sizeof(StyleRun));
+	if ((glyphInfoBuffer == NULL && fGlyphInfoBufferSize > 0)
+		|| (lineInfoBuffer == NULL && fLineInfoBufferSize > 0)
+		|| (styleRunBuffer == NULL && fStyleRunBufferSize > 0)) {
+		free(glyphInfoBuffer);
+		free(lineInfoBuffer);
+		free(styleRunBuffer);
+		delete sharedBuffers;
+		return false;
+	}
+
+	if (fGlyphInfoCount > 0) {
+		memcpy(glyphInfoBuffer, fGlyphInfoBuffer,
+			fGlyphInfoCount * sizeof(GlyphInfo));
+	}
+	if (fLineInfoCount > 0) {
+		memcpy(lineInfoBuffer, fLineInfoBuffer,
+			fLineInfoCount * sizeof(LineInfo));
+	}
+	for (unsigned i = 0; i < fStyleRunCount; i++)
+		new (&styleRunBuffer[i]) StyleRun(fStyleRunBuffer[i]);
+
+	// The glyphs need to point at the copied style runs
+	for (unsigned i = 0; i < fGlyphInfoCount; i++) {
+		StyleRun* styleRun = glyphInfoBuffer[i].styleRun;
+		if (styleRun != NULL) {
+			glyphInfoBuffer[i].styleRun
+				= styleRunBuffer + (styleRun - fStyleRunBuffer);
+		}
+	}
+
+	releaseBuffers();
+
+	fSharedBuffers = sharedBuffers;
+	fGlyphInfoBuffer = glyphInfoBuffer;
+	fLineInfoBuffer = lineInfoBuffer;
+	fStyleRunBuffer = styleRunBuffer;
+
+	return true;
+}
+
+
+/*!	Removes the reference to the buffers, and frees them if no other
+	TextLayout uses them anymore. The counts and sizes are kept.
+*/
+void
+TextLayout::releaseBuffers()
+{
+	if (fSharedBuffers != NULL && fSharedBuffers->RemoveReference()) {
+		for (unsigned i = 0; i < fStyleRunCount; i++)
+			fStyleRunBuffer[i].font.~Font();
+		free(fGlyphInfoBuffer);
+		free(fLineInfoBuffer);
+		free(fStyleRunBuffer);
+	}
+
+	fSharedBuffers = NULL;
+	fGlyphInfoBuffer = NULL;
+	fLineInfoBuffer = NULL;
+	fStyleRunBuffer = NULL;
+}
+
+
 bool
 TextLayout::appendGlyph(unsigned charCode, const agg::glyph_cache* glyph,
 	StyleRun* styleRun)
@@ -1526,16 +1864,7 @@ TextLayout::appendGlyph(unsigned charCode, const agg::glyph_cache* glyph,
 		fGlyphInfoBuffer = buffer;
 	}
 
-	// Store given information
-	fGlyphInfoBuffer[fGlyphInfoCount].charCode = charCode;
-	fGlyphInfoBuffer[fGlyphInfoCount].glyph = glyph;
-	fGlyphInfoBuffer[fGlyphInfoCount].x = 0;
-	fGlyphInfoBuffer[fGlyphInfoCount].y = 0;
-	fGlyphInfoBuffer[fGlyphInfoCount].advanceX = 0;
-	fGlyphInfoBuffer[fGlyphInfoCount].maxAscend = 0;
-	fGlyphInfoBuffer[fGlyphInfoCount].maxDescend = 0;
-	fGlyphInfoBuffer[fGlyphInfoCount].lineIndex = 0;
-	fGlyphInfoBuffer[fGlyphInfoCount].styleRun = styleRun;
+	setGlyph(fGlyphInfoCount, charCode, glyph, styleRun);
 
 	fGlyphInfoCount++;
 
@@ -1543,6 +1872,23 @@ TextLayout::appendGlyph(unsigned charCode, const agg::glyph_cache* glyph,
 }
 
 
+void
+TextLayout::setGlyph(unsigned index, unsigned charCode,
+	const agg::glyph_cache* glyph, StyleRun* styleRun)
+{
+	// Store given information
+	fGlyphInfoBuffer[index].charCode = charCode;
+	fGlyphInfoBuffer[index].glyph = glyph;
+	fGlyphInfoBuffer[index].x = 0;
+	fGlyphInfoBuffer[index].y = 0;
+	fGlyphInfoBuffer[index].advanceX = 0;
+	fGlyphInfoBuffer[index].maxAscend = 0;
+	fGlyphInfoBuffer[index].maxDescend = 0;
+	fGlyphInfoBuffer[index].lineIndex = 0;
+	fGlyphInfoBuffer[index].styleRun = styleRun;
+}
+
+
 bool
 TextLayout::appendLine(unsigned startOffset, double y, double lineHeight,
 	double maxAscent, double maxDescent)
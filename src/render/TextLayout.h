@@ -5,10 +5,13 @@
 #ifndef TEXT_LAYOUT_H
 #define TEXT_LAYOUT_H
 
+#include <limits.h>
+
 #include "TextRenderer.h"
 #include "Font.h"
 
 class FontCache;
+class Referenceable;
 
 static const unsigned MOVEMENT_CHAR				= 1 << 0;
 static const unsigned MOVEMENT_CLUSTER			= 1 << 1;
@@ -92,6 +95,8 @@ public:
 	TextLayout& operator=(const TextLayout& other);
 
 	void setText(const char* text);
+	void replaceText(const char* text, unsigned offset, unsigned removedCount,
+		unsigned insertedCount);
 	void setFont(const Font& font);
 	void setFirstLineInset(double inset);
 	void setLineInset(double inset);
@@ -132,6 +137,7 @@ public:
 		const TextRenderer::Color& underlineColor);
 
 	void layout();
+	void validateLayout();
 
 	inline unsigned getGlyphCount() const
 	{
@@ -291,18 +297,24 @@ public:
 private:
 	bool init(const char* text, TextRenderer::FontEngine& fontEngine,
 		TextRenderer::FontManager& fontManager, bool hinting, double scaleX,
-		unsigned subpixelScale);
+		unsigned subpixelScale, unsigned reshapeStart = 0,
+		unsigned reshapeEnd = UINT_MAX);
 
 	void layout(TextRenderer::FontEngine& fontEngine,
 		TextRenderer::FontManager& fontManager,
 		bool kerning, double scaleX, unsigned subpixelScale);
-	void applyAlignment(const double width);
+	unsigned getRelayoutLine() const;
+	void applyAlignment(const double width, unsigned start, unsigned end);
 
 	void invalidateLayout();
-	void validateLayout();
+
+	bool makeBuffersWritable();
+	void releaseBuffers();
 
 	bool appendGlyph(unsigned charCode, const agg::glyph_cache* glyph,
 		StyleRun* styleRun);
+	void setGlyph(unsigned index, unsigned charCode,
+		const agg::glyph_cache* glyph, StyleRun* styleRun);
 	bool appendLine(unsigned startOffset, double y, double lineHeight,
 		double maxAscent, double maxDescent);
 
@@ -326,6 +338,11 @@ private:
 	double				fGlyphSpacing;
 	double				fLineSpacing;
 
+	// The glyph, line and style run buffers are shared between copies of
+	// the layout until one of them changes. This is the reference count of
+	// the buffers, whoever removes the last reference frees them.
+	Referenceable*		fSharedBuffers;
+
 	GlyphInfo*			fGlyphInfoBuffer;
 	unsigned			fGlyphInfoBufferSize;
 	unsigned			fGlyphInfoCount;
@@ -346,6 +363,13 @@ private:
 	bool				fHinting;
 
 	bool				fLayoutPerformed;
+
+	// If the text was changed since the last layout, only the lines from
+	// the paragraph containing fDirtyStart need to be broken again, until
+	// a paragraph starts at the same glyph as before at or after fDirtyEnd.
+	bool				fPartialLayout;
+	unsigned			fDirtyStart;
+	unsigned			fDirtyEnd;
 };
 
 #endif // TEXT_LAYOUT_H
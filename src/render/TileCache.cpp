@@ -0,0 +1,166 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "TileCache.h"
+
+#include <new>
+
+#include "HashMapHugo.h"
+#include "TiledRenderBuffer.h"
+
+enum {
+	// The cache area extends beyond the visible area by this many pixels,
+	// so that small scrolling offsets don't expose missing tiles.
+	CACHE_AREA_MARGIN	= TiledRenderBuffer::TILE_SIZE / 2,
+
+	DEFAULT_MEMORY_BUDGET	= 256 * 1024 * 1024
+};
+
+// StampMap
+class TileCache::StampMap : public HashMap<TileKey, uint32> {
+};
+
+// constructor
+TileCache::TileCache()
+	: fStamps(new (std::nothrow) StampMap())
+	, fCurrentStamp(0)
+	, fBounds()
+	, fVisibleArea(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN)
+	, fCacheArea()
+	, fMemoryBudget(DEFAULT_MEMORY_BUDGET)
+{
+}
+
+// destructor
+TileCache::~TileCache()
+{
+	delete fStamps;
+}
+
+// SetBounds
+void
+TileCache::SetBounds(const BRect& bounds)
+{
+	if (fBounds == bounds)
+		return;
+
+	// Since the bounds change with the zoom level, tiles which have been
+	// used previously don't correspond to the new tiles.
+	if (fStamps != NULL)
+		fStamps->Clear();
+	fBounds = bounds;
+
+	_UpdateCacheArea();
+}
+
+// SetVisibleArea
+/*!	Sets the currently visible area in the same coordinate system as the
+	bounds. Passing an invalid rect makes the entire bounds the cache area.
+	Returns whether the cache area changed.
+*/
+bool
+TileCache::SetVisibleArea(const BRect& visibleArea)
+{
+	if (fVisibleArea == visibleArea)
+		return false;
+
+	fVisibleArea = visibleArea;
+
+	BRect previousCacheArea = fCacheArea;
+	_UpdateCacheArea();
+
+	return fCacheArea != previousCacheArea;
+}
+
+// SetMemoryBudget
+void
+TileCache::SetMemoryBudget(size_t budget)
+{
+	fMemoryBudget = budget;
+}
+
+// EvictOldestTile
+/*!	Finds the tile outside of the cache area which has been visible least
+	recently and forgets about it. The caller is expected to free the tile
+	at the returned \a frame in all TiledRenderBuffers. Returns \c false if
+	there is no tile that could be evicted.
+*/
+bool
+TileCache::EvictOldestTile(BRect& frame)
+{
+	if (fStamps == NULL)
+		return false;
+
+	TileKey oldestKey;
+	uint32 oldestStamp = 0;
+	bool found = false;
+
+	StampMap::Iterator iterator = fStamps->GetIterator();
+	while (iterator.HasNext()) {
+		StampMap::LinkType* link = iterator.Next();
+		BRect tileFrame = TiledRenderBuffer::TileFrame(link->Key.column,
+			link->Key.row) & fBounds;
+		if (fCacheArea.Contains(tileFrame))
+			continue;
+		// Stamps are compared relative to the current stamp, in case the
+		// counter wraps around.
+		uint32 age = fCurrentStamp - link->Value;
+		if (!found || age > fCurrentStamp - oldestStamp) {
+			oldestKey = link->Key;
+			oldestStamp = link->Value;
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	fStamps->RemoveKey(oldestKey);
+	frame = TiledRenderBuffer::TileFrame(oldestKey.column, oldestKey.row)
+		& fBounds;
+	return true;
+}
+
+// #pragma mark -
+
+// _UpdateCacheArea
+void
+TileCache::_UpdateCacheArea()
+{
+	if (!fVisibleArea.IsValid()) {
+		fCacheArea = fBounds;
+	} else {
+		BRect cacheArea = fVisibleArea;
+		cacheArea.InsetBy(-CACHE_AREA_MARGIN, -CACHE_AREA_MARGIN);
+		fCacheArea = TiledRenderBuffer::AlignToTiles(cacheArea) & fBounds;
+	}
+
+	// Without a visible area, there is nothing outside the cache area that
+	// could be evicted. Don't track all tiles of the bounds in this case,
+	// since they could be very many.
+	if (fStamps == NULL || !fVisibleArea.IsValid() || !fCacheArea.IsValid())
+		return;
+
+	// Mark all tiles within the cache area as recently used
+	fCurrentStamp++;
+
+	int32 firstColumn;
+	int32 firstRow;
+	int32 lastColumn;
+	int32 lastRow;
+	TiledRenderBuffer::GetTileRange(fCacheArea, firstColumn, firstRow,
+		lastColumn, lastRow);
+
+	for (int32 row = firstRow; row <= lastRow; row++) {
+		for (int32 column = firstColumn; column <= lastColumn; column++) {
+			TileKey key(column, row);
+			StampMap::LinkType* link = fStamps->Lookup(key);
+			if (link != NULL)
+				link->Value = fCurrentStamp;
+			else
+				fStamps->Put(key, fCurrentStamp);
+		}
+	}
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <Rect.h>
+
+// The TileCache decides which tiles of the TiledRenderBuffers of all layers
+// are kept up-to-date and which may be evicted. The cache area is the
+// visible area plus a margin, aligned to the tile grid. Tiles within the
+// cache area are never evicted. Tiles outside of it are evicted least
+// recently visible first, once the memory budget has been exceeded. If no
+// visible area is known, the cache area covers the complete bounds.
+
+class TileCache {
+public:
+								TileCache();
+	virtual						~TileCache();
+
+			void				SetBounds(const BRect& bounds);
+			const BRect&		Bounds() const
+									{ return fBounds; }
+
+			bool				SetVisibleArea(const BRect& visibleArea);
+			const BRect&		CacheArea() const
+									{ return fCacheArea; }
+
+			void				SetMemoryBudget(size_t budget);
+			size_t				MemoryBudget() const
+									{ return fMemoryBudget; }
+
+			bool				EvictOldestTile(BRect& frame);
+
+private:
+			class StampMap;
+
+			void				_UpdateCacheArea();
+
+private:
+			StampMap*			fStamps;
+			uint32				fCurrentStamp;
+
+			BRect				fBounds;
+			BRect				fVisibleArea;
+			BRect				fCacheArea;
+			size_t				fMemoryBudget;
+};
+
+#endif // TILE_CACHE_H
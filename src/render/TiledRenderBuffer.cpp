@@ -0,0 +1,336 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "TiledRenderBuffer.h"
+
+#include <new>
+
+#include <math.h>
+#include <stdio.h>
+
+#include <List.h>
+
+#include "HashMapHugo.h"
+#include "RenderBuffer.h"
+#include "RenderEngine.h"
+
+// TileMap
+class TiledRenderBuffer::TileMap : public HashMap<TileKey, RenderBuffer*> {
+};
+
+// #pragma mark -
+
+// constructor
+TiledRenderBuffer::TiledRenderBuffer()
+	: fTiles(new (std::nothrow) TileMap())
+	, fBounds()
+	, fTileCount(0)
+	, fMemoryUsage(0)
+{
+}
+
+// destructor
+TiledRenderBuffer::~TiledRenderBuffer()
+{
+	MakeEmpty();
+	delete fTiles;
+}
+
+// SetBounds
+void
+TiledRenderBuffer::SetBounds(const BRect& bounds)
+{
+	if (fBounds == bounds)
+		return;
+
+	// The tiles at the edges would have the wrong size and the contents
+	// of all tiles are most likely obsolete anyways.
+	MakeEmpty();
+	fBounds = bounds;
+}
+
+// AllocateTiles
+status_t
+TiledRenderBuffer::AllocateTiles(const BRect& area)
+{
+	if (fTiles == NULL)
+		return B_NO_MEMORY;
+
+	int32 firstColumn;
+	int32 firstRow;
+	int32 lastColumn;
+	int32 lastRow;
+	_GetTileRange(area, firstColumn, firstRow, lastColumn, lastRow);
+
+	for (int32 row = firstRow; row <= lastRow; row++) {
+		for (int32 column = firstColumn; column <= lastColumn; column++) {
+			if (_TileAt(column, row) != NULL)
+				continue;
+
+			BRect frame = TileFrame(column, row) & fBounds;
+			RenderBuffer* tile = new (std::nothrow) RenderBuffer(frame);
+			if (tile == NULL || !tile->IsValid()
+				|| fTiles->Put(TileKey(column, row), tile) != B_OK) {
+				delete tile;
+				return B_NO_MEMORY;
+			}
+			tile->Clear(frame, (rgb_color){ 0, 0, 0, 0 });
+			fTileCount++;
+			fMemoryUsage += tile->BitsLength();
+		}
+	}
+
+	return B_OK;
+}
+
+// FreeTiles
+size_t
+TiledRenderBuffer::FreeTiles(const BRect& area)
+{
+	return FreeTiles(area, BRect());
+}
+
+// FreeTiles
+/*!	Frees all tiles intersecting \a area, except for those tiles which are
+	completely contained in \a keepArea. Returns the amount of memory in bytes
+	that has been released.
+*/
+size_t
+TiledRenderBuffer::FreeTiles(const BRect& area, const BRect& keepArea)
+{
+	BList tiles(20);
+	_GetTiles(area, tiles);
+
+	size_t freed = 0;
+	for (int32 i = tiles.CountItems() - 1; i >= 0; i--) {
+		RenderBuffer* tile = (RenderBuffer*)tiles.ItemAtFast(i);
+		if (keepArea.IsValid() && keepArea.Contains(tile->Bounds()))
+			continue;
+		freed += _FreeTile(tile);
+	}
+	return freed;
+}
+
+// MakeEmpty
+void
+TiledRenderBuffer::MakeEmpty()
+{
+	if (fTiles == NULL)
+		return;
+
+	TileMap::Iterator iterator = fTiles->GetIterator();
+	while (iterator.HasNext())
+		delete iterator.Next()->Value;
+	fTiles->Clear();
+	fTileCount = 0;
+	fMemoryUsage = 0;
+}
+
+// HasTiles
+bool
+TiledRenderBuffer::HasTiles(const BRect& area) const
+{
+	return !MissingArea(area).IsValid();
+}
+
+// MissingArea
+/*!	Returns the bounding box of all tile frames within \a area for which no
+	tile has been allocated yet. The returned rect is invalid if all tiles
+	are present.
+*/
+BRect
+TiledRenderBuffer::MissingArea(const BRect& area) const
+{
+	BRect missingArea(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN);
+
+	int32 firstColumn;
+	int32 firstRow;
+	int32 lastColumn;
+	int32 lastRow;
+	_GetTileRange(area, firstColumn, firstRow, lastColumn, lastRow);
+
+	for (int32 row = firstRow; row <= lastRow; row++) {
+		for (int32 column = firstColumn; column <= lastColumn; column++) {
+			if (_TileAt(column, row) == NULL)
+				missingArea = missingArea | TileFrame(column, row);
+		}
+	}
+
+	return missingArea & fBounds;
+}
+
+// CopyFrom
+void
+TiledRenderBuffer::CopyFrom(const RenderBuffer* buffer, BRect area)
+{
+	area = area & buffer->Bounds();
+
+	BList tiles(20);
+	_GetTiles(area, tiles);
+
+	for (int32 i = tiles.CountItems() - 1; i >= 0; i--) {
+		RenderBuffer* tile = (RenderBuffer*)tiles.ItemAtFast(i);
+		buffer->CopyTo(tile, area);
+	}
+}
+
+// CopyTo
+void
+TiledRenderBuffer::CopyTo(RenderBuffer* buffer, BRect area) const
+{
+	area = area & buffer->Bounds();
+
+	BList tiles(20);
+	_GetTiles(area, tiles);
+
+	for (int32 i = tiles.CountItems() - 1; i >= 0; i--) {
+		RenderBuffer* tile = (RenderBuffer*)tiles.ItemAtFast(i);
+		tile->CopyTo(buffer, area);
+	}
+}
+
+// BlendTo
+void
+TiledRenderBuffer::BlendTo(RenderBuffer* buffer, BRect area) const
+{
+	area = area & buffer->Bounds();
+
+	BList tiles(20);
+	_GetTiles(area, tiles);
+
+	for (int32 i = tiles.CountItems() - 1; i >= 0; i--) {
+		RenderBuffer* tile = (RenderBuffer*)tiles.ItemAtFast(i);
+		tile->BlendTo(buffer, area);
+	}
+}
+
+// BlendTo
+void
+TiledRenderBuffer::BlendTo(RenderEngine& engine, BRect area, uint8 opacity,
+	BlendingMode blendingMode) const
+{
+	BList tiles(20);
+	_GetTiles(area, tiles);
+
+	for (int32 i = tiles.CountItems() - 1; i >= 0; i--) {
+		RenderBuffer* tile = (RenderBuffer*)tiles.ItemAtFast(i);
+		engine.BlendArea(tile, area, opacity, blendingMode);
+	}
+}
+
+// TileFrame
+BRect
+TiledRenderBuffer::TileFrame(int32 column, int32 row)
+{
+	return BRect(column * TILE_SIZE, row * TILE_SIZE,
+		(column + 1) * TILE_SIZE - 1, (row + 1) * TILE_SIZE - 1);
+}
+
+// AlignToTiles
+BRect
+TiledRenderBuffer::AlignToTiles(const BRect& area)
+{
+	if (!area.IsValid())
+		return area;
+
+	return BRect(
+		floorf(area.left / TILE_SIZE) * TILE_SIZE,
+		floorf(area.top / TILE_SIZE) * TILE_SIZE,
+		(floorf(area.right / TILE_SIZE) + 1) * TILE_SIZE - 1,
+		(floorf(area.bottom / TILE_SIZE) + 1) * TILE_SIZE - 1);
+}
+
+// GetTileRange
+void
+TiledRenderBuffer::GetTileRange(const BRect& area, int32& firstColumn,
+	int32& firstRow, int32& lastColumn, int32& lastRow)
+{
+	if (!area.IsValid()) {
+		// results in empty loops
+		firstColumn = 0;
+		firstRow = 0;
+		lastColumn = -1;
+		lastRow = -1;
+		return;
+	}
+
+	firstColumn = (int32)floorf(area.left / TILE_SIZE);
+	firstRow = (int32)floorf(area.top / TILE_SIZE);
+	lastColumn = (int32)floorf(area.right / TILE_SIZE);
+	lastRow = (int32)floorf(area.bottom / TILE_SIZE);
+}
+
+// #pragma mark -
+
+// _GetTileRange
+void
+TiledRenderBuffer::_GetTileRange(BRect area, int32& firstColumn,
+	int32& firstRow, int32& lastColumn, int32& lastRow) const
+{
+	GetTileRange(area & fBounds, firstColumn, firstRow, lastColumn, lastRow);
+}
+
+// _TileAt
+RenderBuffer*
+TiledRenderBuffer::_TileAt(int32 column, int32 row) const
+{
+	if (fTiles == NULL)
+		return NULL;
+	return fTiles->Get(TileKey(column, row));
+}
+
+// _GetTiles
+void
+TiledRenderBuffer::_GetTiles(const BRect& area, BList& tiles) const
+{
+	if (fTileCount == 0)
+		return;
+
+	int32 firstColumn;
+	int32 firstRow;
+	int32 lastColumn;
+	int32 lastRow;
+	_GetTileRange(area, firstColumn, firstRow, lastColumn, lastRow);
+
+	int64 cellCount = int64(lastColumn - firstColumn + 1)
+		* (lastRow - firstRow + 1);
+	if (cellCount <= 0)
+		return;
+
+	if (cellCount > fTileCount) {
+		// Cheaper to look at every existing tile than to look up every cell
+		TileMap::Iterator iterator = fTiles->GetIterator();
+		while (iterator.HasNext()) {
+			RenderBuffer* tile = iterator.Next()->Value;
+			if (tile->Bounds().Intersects(area))
+				tiles.AddItem(tile);
+		}
+		return;
+	}
+
+	for (int32 row = firstRow; row <= lastRow; row++) {
+		for (int32 column = firstColumn; column <= lastColumn; column++) {
+			RenderBuffer* tile = _TileAt(column, row);
+			if (tile != NULL)
+				tiles.AddItem(tile);
+		}
+	}
+}
+
+// _FreeTile
+size_t
+TiledRenderBuffer::_FreeTile(RenderBuffer* tile)
+{
+	int32 column = (int32)floorf((float)tile->Left() / TILE_SIZE);
+	int32 row = (int32)floorf((float)tile->Top() / TILE_SIZE);
+	if (!fTiles->RemoveKey(TileKey(column, row)))
+		return 0;
+
+	size_t size = tile->BitsLength();
+	delete tile;
+	fTileCount--;
+	fMemoryUsage -= size;
+	return size;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef TILED_RENDER_BUFFER_H
+#define TILED_RENDER_BUFFER_H
+
+#include <Rect.h>
+
+#include "BlendingMode.h"
+
+class BList;
+class RenderBuffer;
+class RenderEngine;
+
+// TileKey
+//
+// Identifies a tile within the global grid of TiledRenderBuffer::TILE_SIZE
+// tiles.
+struct TileKey {
+	TileKey()
+		: column(0)
+		, row(0)
+	{
+	}
+
+	TileKey(int32 column, int32 row)
+		: column(column)
+		, row(row)
+	{
+	}
+
+	bool operator==(const TileKey& other) const
+	{
+		return column == other.column && row == other.row;
+	}
+
+	size_t HashKey() const
+	{
+		return (size_t)((uint32)column * 73856093 ^ (uint32)row * 19349663);
+	}
+
+	int32	column;
+	int32	row;
+};
+
+// The TiledRenderBuffer stores the pixels of a possibly very large area
+// (typically the zoomed bounds of a layer) in fixed size RenderBuffer tiles,
+// which are allocated on demand. Tiles are aligned to a global grid of
+// TILE_SIZE pixels, so that the tiles of different TiledRenderBuffers cover
+// exactly the same areas. Only the parts of the Bounds() for which tiles
+// have been allocated hold any pixels, all other areas are considered
+// missing. Allocating and freeing tiles is not thread-safe, while copying
+// pixels into and out of existing tiles may be done concurrently for
+// non-overlapping areas.
+
+class TiledRenderBuffer {
+public:
+	enum {
+		TILE_SIZE = 256
+	};
+
+								TiledRenderBuffer();
+	virtual						~TiledRenderBuffer();
+
+			void				SetBounds(const BRect& bounds);
+			BRect				Bounds() const
+									{ return fBounds; }
+
+			status_t			AllocateTiles(const BRect& area);
+			size_t				FreeTiles(const BRect& area);
+			size_t				FreeTiles(const BRect& area,
+									const BRect& keepArea);
+			void				MakeEmpty();
+
+			bool				HasTiles(const BRect& area) const;
+			BRect				MissingArea(const BRect& area) const;
+
+			void				CopyFrom(const RenderBuffer* buffer,
+									BRect area);
+			void				CopyTo(RenderBuffer* buffer,
+									BRect area) const;
+			void				BlendTo(RenderBuffer* buffer,
+									BRect area) const;
+			void				BlendTo(RenderEngine& engine, BRect area,
+									uint8 opacity,
+									BlendingMode blendingMode) const;
+
+			int32				CountTiles() const
+									{ return fTileCount; }
+			size_t				MemoryUsage() const
+									{ return fMemoryUsage; }
+
+	static	BRect				TileFrame(int32 column, int32 row);
+	static	BRect				AlignToTiles(const BRect& area);
+	static	void				GetTileRange(const BRect& area,
+									int32& firstColumn, int32& firstRow,
+									int32& lastColumn, int32& lastRow);
+
+private:
+			class TileMap;
+
+			void				_GetTileRange(BRect area,
+									int32& firstColumn, int32& firstRow,
+									int32& lastColumn, int32& lastRow) const;
+			RenderBuffer*		_TileAt(int32 column, int32 row) const;
+			void				_GetTiles(const BRect& area,
+									BList& tiles) const;
+			size_t				_FreeTile(RenderBuffer* tile);
+
+private:
+			TileMap*			fTiles;
+			BRect				fBounds;
+			int32				fTileCount;
+			size_t				fMemoryUsage;
+};
+
+#endif // TILED_RENDER_BUFFER_H
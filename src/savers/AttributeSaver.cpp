@@ -5,7 +5,9 @@
 
 #include "AttributeSaver.h"
 
-#include <Node.h>
+#ifdef __HAIKU__
+#	include <Node.h>
+#endif
 
 #include "Document.h"
 
@@ -7,6 +7,8 @@
 
 #include <stdio.h>
 
+#include <StorageDefs.h>
+
 #include "BitmapExporter.h"
 
 // constructor
@@ -25,7 +27,7 @@ status_t
 BitmapSetSaver::Save(const DocumentRef& document)
 {
 	entry_ref actualRef(fRef);
-	char name[B_OS_NAME_LENGTH];
+	char name[B_FILE_NAME_LENGTH];
 
 	// 64x64
 	snprintf(name, sizeof(name), "%s_64.png", fRef.name);
@@ -37,6 +37,9 @@ QMAKE_CXXFLAGS += -iquote $$PWD/gui/scrollview/qt
 QMAKE_CXXFLAGS += -iquote $$PWD/gui/stateview
 QMAKE_CXXFLAGS += -iquote $$PWD/gui/tools
 QMAKE_CXXFLAGS += -iquote $$PWD/gui/tools/qt
+QMAKE_CXXFLAGS += -iquote $$PWD/import_export
+QMAKE_CXXFLAGS += -iquote $$PWD/import_export/bitmap
+QMAKE_CXXFLAGS += -iquote $$PWD/import_export/message
 QMAKE_CXXFLAGS += -iquote $$PWD/model
 QMAKE_CXXFLAGS += -iquote $$PWD/model/document
 QMAKE_CXXFLAGS += -iquote $$PWD/model/fills
@@ -47,6 +50,7 @@ QMAKE_CXXFLAGS += -iquote $$PWD/model/snapshots
 QMAKE_CXXFLAGS += -iquote $$PWD/model/text
 QMAKE_CXXFLAGS += -iquote $$PWD/render
 QMAKE_CXXFLAGS += -iquote $$PWD/render/text
+QMAKE_CXXFLAGS += -iquote $$PWD/savers
 QMAKE_CXXFLAGS += -iquote $$PWD/support
 QMAKE_CXXFLAGS += -iquote $$PWD/tools
 QMAKE_CXXFLAGS += -iquote $$PWD/tools/brush
@@ -56,7 +60,7 @@ QMAKE_CXXFLAGS += -iquote $$PWD/tools/transform
 QMAKE_CXXFLAGS += -iquote $$PWD/tools/transform/qt
 
 LIBS += -Lagg -lagg -Lgui/colorpicker -lcolorpicker \
-	-Lgui/scrollview -lscrollview -Licon -licon -ldl -lfreetype
+	-Lgui/scrollview -lscrollview -Licon -licon -ldl -lfreetype -lz
 
 # Weirdly we need to explicitly add libX11, since otherwise the linker complains
 # about symbol XGetWindowAttributes not being defined.
@@ -67,10 +71,12 @@ TARGETDEPS += agg/libagg.a gui/colorpicker/libcolorpicker.a icon/libicon.a \
 
 SOURCES += \
 	WonderBrush.cpp \
+        edits/CompactedBuffer.cpp \
         edits/MoveObjectsEdit.cpp \
         edits/base/CompoundEdit.cpp \
         edits/base/EditManager.cpp \
         edits/base/EditStack.cpp \
+        edits/base/SpillFile.cpp \
         edits/base/UndoableEdit.cpp \
         gui/CanvasView.cpp \
 	gui/ToolConfigView.cpp \
@@ -92,6 +98,13 @@ SOURCES += \
 	gui/tools/qt/BrushToolConfigView.cpp \
 	gui/tools/qt/TextToolConfigView.cpp \
 	gui/tools/qt/TransformToolConfigView.cpp \
+	import_export/Exporter.cpp \
+	import_export/bitmap/BitmapExporter.cpp \
+	import_export/message/ArchiveVisitor.cpp \
+	import_export/message/ChunkFile.cpp \
+	import_export/message/MessageExporter.cpp \
+	import_export/message/MessageImporter.cpp \
+	import_export/message/WonderBrush2Importer.cpp \
 	model/property/CommonPropertyIDs.cpp \
 	model/BaseObject.cpp \
 	model/CurrentColor.cpp \
@@ -151,6 +164,7 @@ SOURCES += \
 	platform/qt/system/BAppDefs.cpp \
 	platform/qt/system/BArchivable.cpp \
 	platform/qt/system/BBitmap.cpp \
+	platform/qt/system/BBitmapStream.cpp \
 	platform/qt/system/BByteOrder.cpp \
 	platform/qt/system/BControl.cpp \
 	platform/qt/system/BCursor.cpp \
@@ -187,23 +201,41 @@ SOURCES += \
 	platform/qt/system/BScreen.cpp \
 	platform/qt/system/BString.cpp \
 	platform/qt/system/BTranslationUtils.cpp \
+	platform/qt/system/BTranslatorRoster.cpp \
 	platform/qt/system/BView.cpp \
 	platform/qt/system/BWindow.cpp \
+	render/BlurResultCache.cpp \
+	render/BoxBlurFilter.cpp \
+	render/BrushStampCache.cpp \
+	render/FlattenedPath.cpp \
 	render/FontCache.cpp \
-	render/GaussFilter.cpp \
 	render/LayoutContext.cpp \
 	render/LayoutState.cpp \
+	render/MipPyramid.cpp \
+	render/OffscreenRenderer.cpp \
 	render/Path.cpp \
+	render/PixelKernels.cpp \
 	render/RenderBuffer.cpp \
 	render/RenderEngine.cpp \
+	render/RenderJobDeque.cpp \
 	render/RenderManager.cpp \
 	render/RenderThread.cpp \
+	render/RenderTrace.cpp \
 	render/StackBlurFilter.cpp \
 	render/TextLayout.cpp \
 	render/TextRenderer.cpp \
+	render/TileCache.cpp \
+	render/TiledRenderBuffer.cpp \
 	render/VertexSource.cpp \
 	render/text/FontRegistry.cpp \
+	savers/AttributeSaver.cpp \
+	savers/BitmapSetSaver.cpp \
+	savers/DocumentSaver.cpp \
+	savers/FileSaver.cpp \
+	savers/NativeSaver.cpp \
+	savers/SimpleFileSaver.cpp \
 	support/AbstractLOAdapter.cpp \
+	support/bitmap_compression.cpp \
 	support/Debug.cpp \
 	support/HashString.cpp \
 	support/Listener.cpp \
@@ -212,6 +244,7 @@ SOURCES += \
 	support/ObjectTracker.cpp \
 	support/Referenceable.cpp \
 	support/RWLocker.cpp \
+	support/SpatialIndex.cpp \
 	support/support.cpp \
 	support/support_ui.cpp \
 	support/Transformable.cpp \
@@ -231,6 +264,7 @@ HEADERS  += \
 	WonderBrush.h \
 	cimg/CImg.h \
         edits/AddObjectsEdit.h \
+        edits/CompactedBuffer.h \
         edits/InsertTextEdit.h \
         edits/MoveObjectsEdit.h \
         edits/ObjectAddedEdit.h \
@@ -243,6 +277,7 @@ HEADERS  += \
         edits/base/CompoundEdit.h \
         edits/base/EditManager.h \
         edits/base/EditStack.h \
+        edits/base/SpillFile.h \
         edits/base/UndoableEdit.h \
         gui/CanvasView.h \
 	gui/ToolConfigView.h \
@@ -270,6 +305,13 @@ HEADERS  += \
 	gui/tools/qt/BrushToolConfigView.h \
 	gui/tools/qt/TextToolConfigView.h \
 	gui/tools/qt/TransformToolConfigView.h \
+	import_export/Exporter.h \
+	import_export/bitmap/BitmapExporter.h \
+	import_export/message/ArchiveVisitor.h \
+	import_export/message/ChunkFile.h \
+	import_export/message/MessageExporter.h \
+	import_export/message/MessageImporter.h \
+	import_export/message/WonderBrush2Importer.h \
 	model/BaseObject.h \
 	model/CurrentColor.h \
 	model/Selectable.h \
@@ -336,6 +378,7 @@ HEADERS  += \
 	platform/qt/system/BAutolock.h \
 	platform/qt/system/BBeBuild.h \
 	platform/qt/system/BBitmap.h \
+	platform/qt/system/BBitmapStream.h \
 	platform/qt/system/BByteOrder.h \
 	platform/qt/system/Bclipping.h \
 	platform/qt/system/BControl.h \
@@ -381,7 +424,10 @@ HEADERS  += \
 	platform/qt/system/BString.h \
 	platform/qt/system/BStringPrivate.h \
 	platform/qt/system/BSupportDefs.h \
+	platform/qt/system/BTranslationDefs.h \
 	platform/qt/system/BTranslationUtils.h \
+	platform/qt/system/BTranslatorFormats.h \
+	platform/qt/system/BTranslatorRoster.h \
 	platform/qt/system/BTypeConstants.h \
 	platform/qt/system/Butf8_functions.h \
 	platform/qt/system/BView.h \
@@ -394,6 +440,7 @@ HEADERS  += \
 	platform/qt/system/include/Autolock.h \
 	platform/qt/system/include/BeBuild.h \
 	platform/qt/system/include/Bitmap.h \
+	platform/qt/system/include/BitmapStream.h \
 	platform/qt/system/include/ByteOrder.h \
 	platform/qt/system/include/clipping.h \
 	platform/qt/system/include/Control.h \
@@ -439,29 +486,49 @@ HEADERS  += \
 	platform/qt/system/include/String.h \
 	platform/qt/system/include/StringPrivate.h \
 	platform/qt/system/include/SupportDefs.h \
+	platform/qt/system/include/TranslationDefs.h \
 	platform/qt/system/include/TranslationUtils.h \
+	platform/qt/system/include/TranslatorFormats.h \
+	platform/qt/system/include/TranslatorRoster.h \
 	platform/qt/system/include/TypeConstants.h \
 	platform/qt/system/include/utf8_functions.h \
 	platform/qt/system/include/View.h \
 	platform/qt/system/include/Window.h \
+	render/BlurResultCache.h \
+	render/BoxBlurFilter.h \
+	render/BrushStampCache.h \
 	render/FauxWeight.h \
+	render/FlattenedPath.h \
 	render/FontCache.h \
-	render/GaussFilter.h \
 	render/LayoutContext.h \
 	render/LayoutState.h \
+	render/MipPyramid.h \
+	render/OffscreenRenderer.h \
 	render/Path.h \
+	render/PixelKernels.h \
 	render/RenderBuffer.h \
 	render/RenderEngine.h \
+	render/RenderJobDeque.h \
 	render/RenderManager.h \
 	render/RenderThread.h \
+	render/RenderTrace.h \
 	render/Scanline.h \
 	render/StackBlurFilter.h \
 	render/TextLayout.h \
 	render/TextRenderer.h \
+	render/TileCache.h \
+	render/TiledRenderBuffer.h \
 	render/VertexSource.h \
 	render/text/FontRegistry.h \
+	savers/AttributeSaver.h \
+	savers/BitmapSetSaver.h \
+	savers/DocumentSaver.h \
+	savers/FileSaver.h \
+	savers/NativeSaver.h \
+	savers/SimpleFileSaver.h \
 	support/AbstractLOAdapter.h \
 	support/AutoLocker.h \
+	support/bitmap_compression.h \
 	support/bitmap_support.h \
 	support/BuildSupport.h \
 	support/cursors.h \
@@ -476,6 +543,7 @@ HEADERS  += \
 	support/Referenceable.h \
 	support/rgb_hsv.h \
 	support/RWLocker.h \
+	support/SpatialIndex.h \
 	support/support.h \
 	support/support_ui.h \
 	support/Transformable.h \
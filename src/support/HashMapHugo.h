@@ -89,7 +89,7 @@ public:
 
 	bool ContainsKey(const HashMapKeyType& key) const
 	{
-		return Lookup(key) != NULL;
+		return HashTableType::Lookup(key) != NULL;
 	}
 
 	HashMapValueType Get(const HashMapKeyType& key) const
@@ -117,8 +117,8 @@ public:
 
 	bool RemoveKey(const HashMapKeyType& key)
 	{
-		LinkType* link = Lookup(key);
-		if (link != NULL && Remove(link)) {
+		LinkType* link = HashTableType::Lookup(key);
+		if (link != NULL && HashTableType::Remove(link)) {
 			delete link;
 			return true;
 		}
@@ -133,7 +133,7 @@ public:
 		while (iterator.HasNext()) {
 			LinkType* link = iterator.Next();
 			if (link->Value == value) {
-				bool removed = Remove(link);
+				bool removed = HashTableType::Remove(link);
 				delete link;
 				return removed;
 			}
@@ -0,0 +1,343 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <math.h>
+#include <new>
+
+#include "HashMapHugo.h"
+
+enum {
+	// Items covering more cells than this are not sorted into the grid.
+	MAX_CELLS_PER_ITEM	= 64
+};
+
+// cell_key
+static inline uint64
+cell_key(int32 x, int32 y)
+{
+	return (uint64)(uint32)x << 32 | (uint32)y;
+}
+
+// remove_index
+/*!	Removes the index from the list, the order of the other indices is not
+	preserved.
+*/
+static void
+remove_index(IndexList& list, int32 index)
+{
+	int32 count = list.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		if (list.ItemAtFast(i) == index) {
+			list.Replace(i, list.LastItem());
+			list.Remove();
+			return;
+		}
+	}
+}
+
+// CellMap
+class SpatialIndex::CellMap : public HashMap<HashKey64<uint64>, IndexList*> {
+};
+
+// constructor
+SpatialIndex::SpatialIndex(float cellSize)
+	: fCellSize(cellSize)
+	, fBounds()
+	, fCells(new(std::nothrow) CellMap())
+	, fLargeItems()
+{
+}
+
+// destructor
+SpatialIndex::~SpatialIndex()
+{
+	MakeEmpty();
+	delete fCells;
+}
+
+// Insert
+status_t
+SpatialIndex::Insert(int32 index, const BRect& bounds)
+{
+	if (index < 0 || index > CountItems())
+		return B_BAD_INDEX;
+
+	if (!fBounds.Add(bounds, index))
+		return B_NO_MEMORY;
+
+	if (index < CountItems() - 1)
+		_ShiftIndices(index, 1);
+
+	status_t ret = _AddToCells(index, bounds);
+	if (ret != B_OK)
+		Remove(index);
+	return ret;
+}
+
+// Remove
+void
+SpatialIndex::Remove(int32 index)
+{
+	if (index < 0 || index >= CountItems())
+		return;
+
+	_RemoveFromCells(index, BoundsAt(index));
+	fBounds.Remove(index);
+
+	if (index < CountItems())
+		_ShiftIndices(index + 1, -1);
+}
+
+// Update
+status_t
+SpatialIndex::Update(int32 index, const BRect& bounds)
+{
+	if (index < 0 || index >= CountItems())
+		return B_BAD_INDEX;
+
+	const BRect& oldBounds = BoundsAt(index);
+	if (oldBounds == bounds)
+		return B_OK;
+
+	_RemoveFromCells(index, oldBounds);
+	fBounds.Replace(index, bounds);
+	return _AddToCells(index, bounds);
+}
+
+// MakeEmpty
+void
+SpatialIndex::MakeEmpty()
+{
+	if (fCells != NULL) {
+		CellMap::Iterator iterator = fCells->GetIterator();
+		while (iterator.HasNext())
+			delete iterator.Next()->Value;
+		fCells->Clear();
+	}
+	fLargeItems.Clear();
+	fBounds.Clear();
+}
+
+// Intersects
+bool
+SpatialIndex::Intersects(int32 index, const BRect& area) const
+{
+	const BRect& bounds = BoundsAt(index);
+	return !bounds.IsValid() || bounds.Intersects(area);
+}
+
+// Query
+/*!	Fills the list with the indices of all items intersecting the area, in
+	ascending order.
+*/
+status_t
+SpatialIndex::Query(const BRect& area, IndexList& indices) const
+{
+	indices.Clear();
+	if (!area.IsValid())
+		return B_OK;
+
+	int32 count = CountItems();
+
+	int32 left;
+	int32 top;
+	int32 right;
+	int32 bottom;
+	if (fCells == NULL || !_GetCells(area, left, top, right, bottom)
+		|| (int64)(right - left + 1) * (bottom - top + 1) > count) {
+		// Checking each item is cheaper than looking at that many cells.
+		for (int32 i = 0; i < count; i++) {
+			if (Intersects(i, area) && !indices.Add(i))
+				return B_NO_MEMORY;
+		}
+		return B_OK;
+	}
+
+	int32 candidateCount = fLargeItems.CountItems();
+	for (int32 y = top; y <= bottom; y++) {
+		for (int32 x = left; x <= right; x++) {
+			IndexList* cell = fCells->Get(cell_key(x, y));
+			if (cell != NULL)
+				candidateCount += cell->CountItems();
+		}
+	}
+	if (candidateCount == 0)
+		return B_OK;
+
+	int32* candidates = new(std::nothrow) int32[candidateCount];
+	if (candidates == NULL)
+		return B_NO_MEMORY;
+
+	int32 index = 0;
+	for (int32 i = 0; i < fLargeItems.CountItems(); i++)
+		candidates[index++] = fLargeItems.ItemAtFast(i);
+	for (int32 y = top; y <= bottom; y++) {
+		for (int32 x = left; x <= right; x++) {
+			IndexList* cell = fCells->Get(cell_key(x, y));
+			if (cell == NULL)
+				continue;
+			for (int32 i = 0; i < cell->CountItems(); i++)
+				candidates[index++] = cell->ItemAtFast(i);
+		}
+	}
+
+	// Items spanning several cells are found more than once.
+	std::sort(candidates, candidates + candidateCount);
+	int32* end = std::unique(candidates, candidates + candidateCount);
+
+	status_t ret = B_OK;
+	for (int32* candidate = candidates; candidate < end; candidate++) {
+		if (Intersects(*candidate, area) && !indices.Add(*candidate)) {
+			ret = B_NO_MEMORY;
+			break;
+		}
+	}
+
+	delete[] candidates;
+	return ret;
+}
+
+// Query
+status_t
+SpatialIndex::Query(const BPoint& point, IndexList& indices) const
+{
+	return Query(BRect(point, point), indices);
+}
+
+// #pragma mark -
+
+// _GetCells
+/*!	Returns the range of cells covered by the bounds, or false if the
+	bounds are unbounded or would cover too many cells.
+*/
+bool
+SpatialIndex::_GetCells(const BRect& bounds, int32& left, int32& top,
+	int32& right, int32& bottom) const
+{
+	if (!bounds.IsValid())
+		return false;
+
+	double cellLeft = floor(bounds.left / fCellSize);
+	double cellTop = floor(bounds.top / fCellSize);
+	double cellRight = floor(bounds.right / fCellSize);
+	double cellBottom = floor(bounds.bottom / fCellSize);
+	if ((cellRight - cellLeft + 1) * (cellBottom - cellTop + 1)
+			> MAX_CELLS_PER_ITEM) {
+		return false;
+	}
+
+	left = (int32)cellLeft;
+	top = (int32)cellTop;
+	right = (int32)cellRight;
+	bottom = (int32)cellBottom;
+	return true;
+}
+
+// _AddToCells
+status_t
+SpatialIndex::_AddToCells(int32 index, const BRect& bounds)
+{
+	int32 left;
+	int32 top;
+	int32 right;
+	int32 bottom;
+	if (fCells != NULL && _GetCells(bounds, left, top, right, bottom)) {
+		if (_AddToCells(index, left, top, right, bottom) == B_OK)
+			return B_OK;
+		// Fall back to checking the item for each query.
+	}
+
+	return fLargeItems.Add(index) ? B_OK : B_NO_MEMORY;
+}
+
+// _AddToCells
+status_t
+SpatialIndex::_AddToCells(int32 index, int32 left, int32 top, int32 right,
+	int32 bottom)
+{
+	for (int32 y = top; y <= bottom; y++) {
+		for (int32 x = left; x <= right; x++) {
+			uint64 key = cell_key(x, y);
+			IndexList* cell = fCells->Get(key);
+			if (cell == NULL) {
+				cell = new(std::nothrow) IndexList();
+				if (cell == NULL || fCells->Put(key, cell) != B_OK) {
+					delete cell;
+					_RemoveFromCells(index, left, top, right, bottom);
+					return B_NO_MEMORY;
+				}
+			}
+			if (!cell->Add(index)) {
+				_RemoveFromCells(index, left, top, right, bottom);
+				return B_NO_MEMORY;
+			}
+		}
+	}
+	return B_OK;
+}
+
+// _RemoveFromCells
+void
+SpatialIndex::_RemoveFromCells(int32 index, const BRect& bounds)
+{
+	int32 left;
+	int32 top;
+	int32 right;
+	int32 bottom;
+	if (fCells != NULL && _GetCells(bounds, left, top, right, bottom))
+		_RemoveFromCells(index, left, top, right, bottom);
+
+	// The item may also have been added here when adding it to the cells
+	// failed.
+	remove_index(fLargeItems, index);
+}
+
+// _RemoveFromCells
+void
+SpatialIndex::_RemoveFromCells(int32 index, int32 left, int32 top,
+	int32 right, int32 bottom)
+{
+	for (int32 y = top; y <= bottom; y++) {
+		for (int32 x = left; x <= right; x++) {
+			uint64 key = cell_key(x, y);
+			IndexList* cell = fCells->Get(key);
+			if (cell == NULL)
+				continue;
+			remove_index(*cell, index);
+			if (cell->CountItems() == 0) {
+				fCells->RemoveKey(key);
+				delete cell;
+			}
+		}
+	}
+}
+
+// _ShiftIndices
+/*!	Adds the offset to all indices from the first index on.
+*/
+void
+SpatialIndex::_ShiftIndices(int32 firstIndex, int32 offset)
+{
+	if (fCells != NULL) {
+		CellMap::Iterator iterator = fCells->GetIterator();
+		while (iterator.HasNext()) {
+			IndexList* cell = iterator.Next()->Value;
+			for (int32 i = 0; i < cell->CountItems(); i++) {
+				int32 index = cell->ItemAtFast(i);
+				if (index >= firstIndex)
+					cell->Replace(i, index + offset);
+			}
+		}
+	}
+
+	for (int32 i = 0; i < fLargeItems.CountItems(); i++) {
+		int32 index = fLargeItems.ItemAtFast(i);
+		if (index >= firstIndex)
+			fLargeItems.Replace(i, index + offset);
+	}
+}
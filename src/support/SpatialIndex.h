@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <Rect.h>
+
+#include "List.h"
+
+typedef List<int32, true> IndexList;
+
+// The SpatialIndex finds the items of an ordered list, like the objects of a
+// layer, whose bounds intersect an area. The items are identified by their
+// index in the list, inserting and removing items shifts the following
+// indices just like in the list. Items with invalid bounds are unbounded
+// and intersect every area.
+//
+// The bounds are sorted into the cells of a uniform grid. Items which
+// would cover too many cells are kept in a separate list and are checked
+// for each query. Queries don't modify the index, so any number of threads
+// may query it at the same time.
+
+class SpatialIndex {
+public:
+								SpatialIndex(float cellSize = 256.0f);
+	virtual						~SpatialIndex();
+
+			status_t			Insert(int32 index, const BRect& bounds);
+			void				Remove(int32 index);
+			status_t			Update(int32 index, const BRect& bounds);
+			void				MakeEmpty();
+
+	inline	int32				CountItems() const
+									{ return fBounds.CountItems(); }
+	inline	const BRect&		BoundsAt(int32 index) const
+									{ return fBounds.ItemAtFast(index); }
+			bool				Intersects(int32 index,
+									const BRect& area) const;
+
+			status_t			Query(const BRect& area,
+									IndexList& indices) const;
+			status_t			Query(const BPoint& point,
+									IndexList& indices) const;
+
+private:
+			class CellMap;
+
+			bool				_GetCells(const BRect& bounds,
+									int32& left, int32& top,
+									int32& right, int32& bottom) const;
+			status_t			_AddToCells(int32 index, const BRect& bounds);
+			status_t			_AddToCells(int32 index, int32 left,
+									int32 top, int32 right, int32 bottom);
+			void				_RemoveFromCells(int32 index,
+									const BRect& bounds);
+			void				_RemoveFromCells(int32 index, int32 left,
+									int32 top, int32 right, int32 bottom);
+			void				_ShiftIndices(int32 firstIndex, int32 offset);
+
+private:
+			float				fCellSize;
+			List<BRect, true>	fBounds;
+			CellMap*			fCells;
+			IndexList			fLargeItems;
+};
+
+#endif // SPATIAL_INDEX_H
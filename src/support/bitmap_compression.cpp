@@ -1,22 +1,38 @@
 
+#include <algorithm>
 #include <malloc.h>
+#include <new>
 #include <stdio.h>
 #include <string.h>
 #include <zlib.h>
 
 #include <Bitmap.h>
+#include <ByteOrder.h>
 #include <Message.h>
+#include <OS.h>
 
 #if USE_LZO
 	#include "minilzo.h"
 #endif
 
+#include "bitmap_compression.h"
 #include "RenderBuffer.h"
+#include "support.h"
 
 enum {
 	COMPRESSION_NONE,
 	COMPRESSION_LZO,
 	COMPRESSION_ZLIB,
+	COMPRESSION_ZLIB_BANDS,
+};
+
+enum {
+	// The uncompressed size of one band of rows. Bands are compressed
+	// independently, so they can be processed in parallel.
+	BAND_SIZE				= 256 * 1024,
+	// The header of band compressed data is the number of bands and the
+	// rows per band, followed by the compressed size of each band.
+	BAND_HEADER_SIZE		= 8
 };
 
 #if USE_LZO
@@ -24,58 +40,20 @@ enum {
 static void* lzoWorkerMem = NULL;
 
 // init_lzo
-void*
+static void*
 init_lzo()
 {
 	if (!lzoWorkerMem)
 		lzoWorkerMem = malloc(LZO1X_MEM_COMPRESS);
 	return lzoWorkerMem;
 }
-
-// uninit_lzo
-void
-uninit_lzo()
-{
-	if (lzoWorkerMem)
-		free(lzoWorkerMem);
-}
 #endif // USE_LZO
 
-// compress_bitmap_lzo
-bool
-compress_buffer_lzo(const RenderBuffer* bitmap, void** buffer, unsigned int* size)
-{
-	bool result = false;
-#if USE_LZO
-	if (bitmap) {
-		lzo_byte* src = (lzo_byte*)bitmap->Bits();
-		lzo_uint srcLength = bitmap->BitsLength();
-		*size = srcLength  + (srcLength / 64) + 16 + 3;
-		*buffer = malloc(*size);
-		if (*buffer && init_lzo()) {
-			if (!lzo1x_1_compress(src, srcLength,
-								  (lzo_byte*)*buffer,
-								  (lzo_uint*)size,
-								  (lzo_byte*)lzoWorkerMem)) {
-//printf("compressed %d bytes bitmap into %d bytes\n", srcLength, *size);
-				if (srcLength  + (srcLength / 64) + 16 + 3 != *size)
-					*buffer = realloc(*buffer, *size);
-				result = true;
-			} else {
-				// error compressing
-				free(*buffer);
-				*buffer = NULL;
-				*size = 0;
-			}
-		} else
-			*size = 0;
-	}
-#endif // USE_LZO
-	return result;
-}
+// RenderBuffers are only written in bands by compress_buffer(), but older
+// files contain buffers compressed as a whole by one of the codecs.
 
 // decompress_bitmap_lzo
-RenderBuffer*
+static RenderBuffer*
 decompress_buffer_lzo(const void* buffer, unsigned int size, BRect frame)
 {
 	RenderBuffer* bitmap = NULL;
@@ -178,42 +156,8 @@ decompress_bitmap_lzo(const void* buffer, unsigned int size,
 
 // #pragma mark -
 
-// compress_bitmap_zlib
-bool
-compress_buffer_zlib(const RenderBuffer* bitmap, void** buffer, unsigned* size)
-{
-	bool result = false;
-	if (bitmap) {
-		Bytef* src = (Bytef*)bitmap->Bits();
-		uLong srcLength = bitmap->BitsLength();
-		*size = (unsigned)ceilf(srcLength * 1.01) + 12;
-		*buffer = malloc(*size);
-		if (*buffer) {
-			int ret = compress2((Bytef*)*buffer,
-								(uLongf*)size,
-								src,
-								srcLength,
-								3);
-			if (ret == Z_OK) {
-//printf("zlib compressed %ld bytes bitmap into %d bytes (%f%%)\n", srcLength, *size, ((float)*size / (float)srcLength) * 100.0);
-				if ((unsigned)ceilf(srcLength * 1.01) + 12 != *size)
-					*buffer = realloc(*buffer, *size);
-				result = true;
-			} else {
-				// error compressing
-				free(*buffer);
-				*buffer = NULL;
-				*size = 0;
-				fprintf(stderr, "zlib compression error: %d\n", ret);
-			}
-		} else
-			*size = 0;
-	}
-	return result;
-}
-
 // decompress_bitmap_zlib
-RenderBuffer*
+static RenderBuffer*
 decompress_buffer_zlib(const void* buffer, unsigned int size, BRect frame)
 {
 	RenderBuffer* bitmap = new RenderBuffer(frame);
@@ -305,34 +249,389 @@ decompress_bitmap_zlib(const void* buffer, unsigned int size,
 	return bitmap;
 }
 
-// #pragma mark - 
+// #pragma mark - bands
 
-// archive_bitmap
-status_t
-archive_buffer(const RenderBuffer* bitmap, BMessage* into, const char* fieldName)
+// The pixels of RenderBuffers are 16 bit linear premultiplied channels.
+// Before a band is compressed, each channel value is replaced by the
+// difference to the same channel of the pixel to the left. Neighbouring
+// pixels are usually similar, so most differences are small. The low and
+// the high bytes of the differences are then stored in separate planes,
+// which makes the mostly constant high bytes compress very well. This also
+// makes the compressed data independent of the byte order.
+
+// prefilter_band
+static void
+prefilter_band(const uint8* bits, uint32 bytesPerRow, uint32 width,
+	uint32 rows, uint8* planes)
 {
-	status_t ret = B_BAD_VALUE;
-	if (bitmap && bitmap->IsValid() && into) {
-		void* buffer;
-		unsigned size;
-#if USE_LZO
-		if (compress_buffer_lzo(bitmap, &buffer, &size)) {
-			ret = into->AddData(fieldName, B_RAW_TYPE, buffer, size);
-			if (ret >= B_OK)
-				ret = into->AddInt32("compression", COMPRESSION_LZO);
-			if (ret >= B_OK)
-				ret = into->AddRect("construction bounds", bitmap->Bounds());
+	uint32 valuesPerRow = width * 4;
+	uint8* low = planes;
+	uint8* high = planes + valuesPerRow * rows;
+	for (uint32 y = 0; y < rows; y++) {
+		const uint16* values = (const uint16*)(bits + y * bytesPerRow);
+		uint16 previous[4] = { 0, 0, 0, 0 };
+		for (uint32 x = 0; x < valuesPerRow; x += 4) {
+			for (uint32 c = 0; c < 4; c++) {
+				uint16 delta = values[x + c] - previous[c];
+				previous[c] = values[x + c];
+				*low++ = (uint8)delta;
+				*high++ = (uint8)(delta >> 8);
+			}
 		}
-#else
-		if (compress_buffer_zlib(bitmap, &buffer, &size)) {
-			ret = into->AddData(fieldName, B_RAW_TYPE, buffer, size);
-			if (ret >= B_OK)
-				ret = into->AddInt32("compression", COMPRESSION_ZLIB);
-			if (ret >= B_OK)
-				ret = into->AddRect("construction bounds", bitmap->Bounds());
+	}
+}
+
+// unfilter_band
+static void
+unfilter_band(const uint8* planes, uint8* bits, uint32 bytesPerRow,
+	uint32 width, uint32 rows)
+{
+	uint32 valuesPerRow = width * 4;
+	const uint8* low = planes;
+	const uint8* high = planes + valuesPerRow * rows;
+	for (uint32 y = 0; y < rows; y++) {
+		uint16* values = (uint16*)(bits + y * bytesPerRow);
+		uint16 previous[4] = { 0, 0, 0, 0 };
+		for (uint32 x = 0; x < valuesPerRow; x += 4) {
+			for (uint32 c = 0; c < 4; c++) {
+				uint16 delta = (uint16)(*low++ | (*high++ << 8));
+				previous[c] += delta;
+				values[x + c] = previous[c];
+			}
 		}
-#endif
 	}
+}
+
+struct band_job {
+	bool				compress;
+	int					level;
+
+	uint8*				bits;
+	uint32				bytesPerRow;
+	uint32				width;
+	uint32				height;
+	uint32				rowsPerBand;
+
+	// per band compressed data and size
+	uint8**				bandData;
+	uint32*				bandSizes;
+
+	int32				first;
+	int32				last;
+	status_t			status;
+};
+
+// band_rows
+static inline uint32
+band_rows(const band_job& job, int32 band)
+{
+	return std::min(job.rowsPerBand, job.height - band * job.rowsPerBand);
+}
+
+// process_bands
+static void
+process_bands(band_job& job)
+{
+	size_t planesSize = (size_t)job.width * 8 * job.rowsPerBand;
+	uint8* planes = (uint8*)malloc(planesSize);
+	if (planes == NULL) {
+		job.status = B_NO_MEMORY;
+		return;
+	}
+
+	job.status = B_OK;
+	for (int32 band = job.first; band <= job.last; band++) {
+		uint32 rows = band_rows(job, band);
+		uint8* bits = job.bits + (size_t)band * job.rowsPerBand
+			* job.bytesPerRow;
+		uLong rawSize = (uLong)job.width * 8 * rows;
+
+		if (job.compress) {
+			prefilter_band(bits, job.bytesPerRow, job.width, rows, planes);
+
+			uLongf size = compressBound(rawSize);
+			job.bandData[band] = (uint8*)malloc(size);
+			if (job.bandData[band] == NULL) {
+				job.status = B_NO_MEMORY;
+				break;
+			}
+			int ret = compress2(job.bandData[band], &size, planes, rawSize,
+				job.level);
+			if (ret != Z_OK) {
+				fprintf(stderr, "zlib compression error: %d\n", ret);
+				job.status = B_ERROR;
+				break;
+			}
+			job.bandSizes[band] = size;
+		} else {
+			uLongf size = rawSize;
+			int ret = uncompress(planes, &size, job.bandData[band],
+				job.bandSizes[band]);
+			if (ret != Z_OK || size != rawSize) {
+				job.status = B_BAD_DATA;
+				break;
+			}
+			unfilter_band(planes, bits, job.bytesPerRow, job.width, rows);
+		}
+	}
+
+	free(planes);
+}
+
+// band_job_entry
+static status_t
+band_job_entry(void* data)
+{
+	process_bands(*static_cast<band_job*>(data));
+	return B_OK;
+}
+
+// run_band_jobs
+/*!	Splits the bands of the job into parts for each worker thread. The last
+	part, and parts for which no thread could be spawned, are processed by
+	the calling thread.
+*/
+static status_t
+run_band_jobs(band_job& job, int32 bandCount)
+{
+	int32 count = std::max((int32)1,
+		std::min(get_optimal_worker_thread_count(), bandCount));
+
+	job.first = 0;
+	job.last = bandCount - 1;
+	if (count == 1) {
+		process_bands(job);
+		return job.status;
+	}
+
+	band_job* jobs = new(std::nothrow) band_job[count];
+	thread_id* threads = new(std::nothrow) thread_id[count];
+	if (jobs == NULL || threads == NULL) {
+		delete[] jobs;
+		delete[] threads;
+		process_bands(job);
+		return job.status;
+	}
+
+	int32 first = 0;
+	for (int32 i = 0; i < count; i++) {
+		jobs[i] = job;
+		jobs[i].first = first;
+		jobs[i].last = (int32)((int64)bandCount * (i + 1) / count) - 1;
+		first = jobs[i].last + 1;
+	}
+
+	for (int32 i = 0; i < count - 1; i++) {
+		threads[i] = spawn_thread(band_job_entry, "bitmap compression",
+			B_NORMAL_PRIORITY, &jobs[i]);
+		if (threads[i] < 0 || resume_thread(threads[i]) != B_OK) {
+			threads[i] = B_ERROR;
+			process_bands(jobs[i]);
+		}
+	}
+
+	process_bands(jobs[count - 1]);
+
+	status_t status = B_OK;
+	for (int32 i = 0; i < count; i++) {
+		if (i < count - 1 && threads[i] >= 0) {
+			status_t ret;
+			wait_for_thread(threads[i], &ret);
+		}
+		if (jobs[i].status != B_OK)
+			status = jobs[i].status;
+	}
+
+	delete[] jobs;
+	delete[] threads;
+
+	return status;
+}
+
+// compress_buffer_bands
+static status_t
+compress_buffer_bands(const RenderBuffer* bitmap, void** buffer,
+	size_t* size, compression_codec codec)
+{
+	band_job job;
+	job.compress = true;
+	job.level = codec == COMPRESSION_CODEC_DENSE
+		? Z_DEFAULT_COMPRESSION : Z_BEST_SPEED;
+	job.bits = bitmap->Bits();
+	job.bytesPerRow = bitmap->BytesPerRow();
+	job.width = bitmap->Width();
+	job.height = bitmap->Height();
+	job.rowsPerBand = std::min(job.height, std::max((uint32)1,
+		(uint32)BAND_SIZE / (job.width * 8)));
+
+	int32 bandCount = (job.height + job.rowsPerBand - 1) / job.rowsPerBand;
+	job.bandData = (uint8**)calloc(bandCount, sizeof(uint8*));
+	job.bandSizes = (uint32*)calloc(bandCount, sizeof(uint32));
+
+	status_t ret = B_NO_MEMORY;
+	if (job.bandData != NULL && job.bandSizes != NULL)
+		ret = run_band_jobs(job, bandCount);
+
+	if (ret == B_OK) {
+		size_t headerSize = BAND_HEADER_SIZE + bandCount * sizeof(uint32);
+		*size = headerSize;
+		for (int32 i = 0; i < bandCount; i++)
+			*size += job.bandSizes[i];
+
+		uint8* data = (uint8*)malloc(*size);
+		if (data != NULL) {
+			uint32* header = (uint32*)data;
+			header[0] = B_HOST_TO_BENDIAN_INT32(bandCount);
+			header[1] = B_HOST_TO_BENDIAN_INT32(job.rowsPerBand);
+			uint8* band = data + headerSize;
+			for (int32 i = 0; i < bandCount; i++) {
+				header[2 + i] = B_HOST_TO_BENDIAN_INT32(job.bandSizes[i]);
+				memcpy(band, job.bandData[i], job.bandSizes[i]);
+				band += job.bandSizes[i];
+			}
+			*buffer = data;
+		} else
+			ret = B_NO_MEMORY;
+	}
+
+	if (job.bandData != NULL) {
+		for (int32 i = 0; i < bandCount; i++)
+			free(job.bandData[i]);
+	}
+	free(job.bandData);
+	free(job.bandSizes);
+
+	return ret;
+}
+
+// decompress_buffer_bands
+static RenderBuffer*
+decompress_buffer_bands(const void* buffer, size_t size, BRect frame)
+{
+	if (buffer == NULL || size < BAND_HEADER_SIZE)
+		return NULL;
+
+	RenderBuffer* bitmap = new(std::nothrow) RenderBuffer(frame);
+	if (bitmap == NULL || !bitmap->IsValid()) {
+		delete bitmap;
+		return NULL;
+	}
+
+	const uint32* header = (const uint32*)buffer;
+	band_job job;
+	job.compress = false;
+	job.level = 0;
+	job.bits = bitmap->Bits();
+	job.bytesPerRow = bitmap->BytesPerRow();
+	job.width = bitmap->Width();
+	job.height = bitmap->Height();
+	job.rowsPerBand = B_BENDIAN_TO_HOST_INT32(header[1]);
+
+	int32 bandCount = B_BENDIAN_TO_HOST_INT32(header[0]);
+	if (job.rowsPerBand == 0 || bandCount <= 0
+		|| (size_t)bandCount > (size - BAND_HEADER_SIZE) / sizeof(uint32)
+		|| (uint64)bandCount * job.rowsPerBand < job.height
+		|| (uint64)(bandCount - 1) * job.rowsPerBand >= job.height) {
+		fprintf(stderr, "decompress_buffer_bands() - corrupted header!\n");
+		delete bitmap;
+		return NULL;
+	}
+	size_t headerSize = BAND_HEADER_SIZE + (size_t)bandCount * sizeof(uint32);
+
+	// A single band may claim more rows than the buffer has, the band
+	// buffers must not be sized after that.
+	job.rowsPerBand = std::min(job.rowsPerBand, job.height);
+
+	job.bandData = (uint8**)calloc(bandCount, sizeof(uint8*));
+	job.bandSizes = (uint32*)calloc(bandCount, sizeof(uint32));
+
+	status_t ret = B_NO_MEMORY;
+	if (job.bandData != NULL && job.bandSizes != NULL) {
+		ret = B_OK;
+		size_t offset = headerSize;
+		for (int32 i = 0; i < bandCount; i++) {
+			job.bandSizes[i] = B_BENDIAN_TO_HOST_INT32(header[2 + i]);
+			job.bandData[i] = (uint8*)buffer + offset;
+			if (job.bandSizes[i] > size - offset) {
+				ret = B_BAD_DATA;
+				break;
+			}
+			offset += job.bandSizes[i];
+		}
+	}
+
+	if (ret == B_OK)
+		ret = run_band_jobs(job, bandCount);
+
+	free(job.bandData);
+	free(job.bandSizes);
+
+	if (ret != B_OK) {
+		fprintf(stderr, "decompress_buffer_bands() failed "
+			"- corrupted input buffer or file!\n");
+		delete bitmap;
+		return NULL;
+	}
+	return bitmap;
+}
+
+// #pragma mark - 
+
+// compress_buffer
+status_t
+compress_buffer(const RenderBuffer* bitmap, void** data, size_t* size,
+	uint32* compression, compression_codec codec)
+{
+	if (bitmap == NULL || !bitmap->IsValid() || data == NULL || size == NULL
+		|| compression == NULL) {
+		return B_BAD_VALUE;
+	}
+
+	status_t ret = compress_buffer_bands(bitmap, data, size, codec);
+	if (ret == B_OK)
+		*compression = COMPRESSION_ZLIB_BANDS;
+	return ret;
+}
+
+// decompress_buffer
+RenderBuffer*
+decompress_buffer(const void* data, size_t size, BRect bounds,
+	uint32 compression)
+{
+	switch (compression) {
+		case COMPRESSION_LZO:
+			return decompress_buffer_lzo(data, size, bounds);
+		case COMPRESSION_ZLIB:
+			return decompress_buffer_zlib(data, size, bounds);
+		case COMPRESSION_ZLIB_BANDS:
+			return decompress_buffer_bands(data, size, bounds);
+	}
+	return NULL;
+}
+
+// archive_bitmap
+status_t
+archive_buffer(const RenderBuffer* bitmap, BMessage* into, const char* fieldName,
+	compression_codec codec)
+{
+	if (into == NULL)
+		return B_BAD_VALUE;
+
+	void* buffer;
+	size_t size;
+	uint32 compression;
+	status_t ret = compress_buffer(bitmap, &buffer, &size, &compression,
+		codec);
+	if (ret != B_OK)
+		return ret;
+
+	ret = into->AddData(fieldName, B_RAW_TYPE, buffer, size);
+	if (ret >= B_OK)
+		ret = into->AddInt32("compression", compression);
+	if (ret >= B_OK)
+		ret = into->AddRect("construction bounds", bitmap->Bounds());
+
+	free(buffer);
 	return ret;
 }
 
@@ -364,16 +663,8 @@ extract_buffer(RenderBuffer** bitmap, const BMessage* from, const char* fieldNam
 			if (from->FindInt32("compression", (int32*)&compression) < B_OK)
 				compression = COMPRESSION_LZO;
 
-			switch (compression) {
-				case COMPRESSION_LZO:
-					*bitmap = decompress_buffer_lzo(compressedData,
-						compressedSize, bounds);
-					break;
-				case COMPRESSION_ZLIB:
-					*bitmap = decompress_buffer_zlib(compressedData,
-						compressedSize, bounds);
-					break;
-			}
+			*bitmap = decompress_buffer(compressedData, compressedSize, bounds,
+				compression);
 		}
 		if (ret < B_OK) {
 			delete *bitmap;
@@ -3,14 +3,34 @@
 #ifndef BITMAP_COMPRESSION_H
 #define BITMAP_COMPRESSION_H
 
+#include <Rect.h>
 #include <SupportDefs.h>
 
 class BBitmap;
 class BMessage;
 class RenderBuffer;
 
+// The codec used for compressing RenderBuffers. The fast codec is meant for
+// saving often, the dense one for files which are written once.
+enum compression_codec {
+	COMPRESSION_CODEC_FAST,
+	COMPRESSION_CODEC_DENSE
+};
+
+// Compresses the pixels of the buffer into newly malloc()ed memory, which
+// the caller needs to free(). The buffer is split into bands of rows, which
+// are compressed independently and in parallel.
+status_t
+compress_buffer(const RenderBuffer* buffer, void** data, size_t* size,
+	uint32* compression, compression_codec codec = COMPRESSION_CODEC_FAST);
+
+RenderBuffer*
+decompress_buffer(const void* data, size_t size, BRect bounds,
+	uint32 compression);
+
 status_t
-archive_buffer(const RenderBuffer* buffer, BMessage* into, const char* fieldName);
+archive_buffer(const RenderBuffer* buffer, BMessage* into, const char* fieldName,
+	compression_codec codec = COMPRESSION_CODEC_FAST);
 
 status_t
 extract_buffer(RenderBuffer** buffer, const BMessage* from, const char* fieldName);
@@ -0,0 +1,320 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ByteOrder.h>
+
+#include "bitmap_compression.h"
+#include "RenderBuffer.h"
+#include "TestSupport.h"
+
+// Band compressed data starts with the number of bands and the rows per
+// band, followed by the compressed size of each band, all as big endian
+// uint32 values. The compressed bands follow the header.
+enum {
+	BAND_COUNT		= 0,
+	ROWS_PER_BAND	= 1,
+	FIRST_BAND_SIZE	= 2
+};
+
+// create_buffer
+/*!	Creates a buffer with gradients and some noise, the same bounds always
+	result in the same pixels.
+*/
+static RenderBuffer*
+create_buffer(const BRect& bounds)
+{
+	RenderBuffer* buffer = new(std::nothrow) RenderBuffer(bounds);
+	if (buffer == NULL)
+		return NULL;
+	if (!buffer->IsValid()) {
+		buffer->RemoveReference();
+		return NULL;
+	}
+
+	uint32 state = 0x9e3779b9;
+	uint32 width = buffer->Width();
+	uint32 height = buffer->Height();
+	for (uint32 y = 0; y < height; y++) {
+		uint16* pixel = (uint16*)(buffer->Bits() + y * buffer->BytesPerRow());
+		for (uint32 x = 0; x < width; x++) {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			uint16 noise = state & 0x00ff;
+			uint16 alpha = (uint16)(65535 - (x + y) % 256);
+			pixel[0] = (uint16)(x * 97 + noise) % alpha;
+			pixel[1] = (uint16)(y * 31 + noise) % alpha;
+			pixel[2] = (uint16)((x ^ y) * 7) % alpha;
+			pixel[3] = alpha;
+			pixel += 4;
+		}
+	}
+	return buffer;
+}
+
+// same_pixels
+static bool
+same_pixels(const RenderBuffer* a, const RenderBuffer* b)
+{
+	if (a == NULL || b == NULL || a->Bounds() != b->Bounds())
+		return false;
+
+	uint32 rowLength = a->Width() * 8;
+	for (uint32 y = 0; y < a->Height(); y++) {
+		if (memcmp(a->Bits() + y * a->BytesPerRow(),
+				b->Bits() + y * b->BytesPerRow(), rowLength) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// decompresses
+/*!	Returns whether the data decompresses, and deletes the result.
+*/
+static bool
+decompresses(const void* data, size_t size, const BRect& bounds,
+	uint32 compression)
+{
+	RenderBuffer* buffer = decompress_buffer(data, size, bounds, compression);
+	if (buffer == NULL)
+		return false;
+	buffer->RemoveReference();
+	return true;
+}
+
+// header_value
+static uint32
+header_value(const void* data, int32 index)
+{
+	return B_BENDIAN_TO_HOST_INT32(((const uint32*)data)[index]);
+}
+
+// set_header_value
+static void
+set_header_value(void* data, int32 index, uint32 value)
+{
+	((uint32*)data)[index] = B_HOST_TO_BENDIAN_INT32(value);
+}
+
+// round_trip
+static bool
+round_trip(const BRect& bounds, compression_codec codec)
+{
+	RenderBuffer* buffer = create_buffer(bounds);
+	if (buffer == NULL)
+		return false;
+
+	void* data = NULL;
+	size_t size = 0;
+	uint32 compression = 0;
+	bool success = compress_buffer(buffer, &data, &size, &compression, codec)
+		== B_OK;
+
+	if (success) {
+		RenderBuffer* result = decompress_buffer(data, size, bounds,
+			compression);
+		success = same_pixels(buffer, result);
+		if (result != NULL)
+			result->RemoveReference();
+	}
+
+	free(data);
+	buffer->RemoveReference();
+	return success;
+}
+
+// #pragma mark -
+
+TEST(band_compression_round_trip)
+{
+	// single pixel, one band with fewer rows than a full band, several
+	// bands with a partial last band, and a buffer not at the origin
+	CHECK(round_trip(BRect(0, 0, 0, 0), COMPRESSION_CODEC_FAST));
+	CHECK(round_trip(BRect(0, 0, 7, 7), COMPRESSION_CODEC_FAST));
+	CHECK(round_trip(BRect(0, 0, 299, 999), COMPRESSION_CODEC_FAST));
+	CHECK(round_trip(BRect(0, 0, 299, 999), COMPRESSION_CODEC_DENSE));
+	CHECK(round_trip(BRect(-20, 40, 179, 439), COMPRESSION_CODEC_FAST));
+	// a row which is larger than a band
+	CHECK(round_trip(BRect(0, 0, 40000, 2), COMPRESSION_CODEC_FAST));
+}
+
+TEST(band_compression_header)
+{
+	BRect bounds(0, 0, 299, 999);
+	RenderBuffer* buffer = create_buffer(bounds);
+	CHECK(buffer != NULL);
+	if (buffer == NULL)
+		return;
+
+	void* data = NULL;
+	size_t size = 0;
+	uint32 compression = 0;
+	CHECK(compress_buffer(buffer, &data, &size, &compression) == B_OK);
+	buffer->RemoveReference();
+	if (data == NULL)
+		return;
+
+	uint32 bandCount = header_value(data, BAND_COUNT);
+	uint32 rowsPerBand = header_value(data, ROWS_PER_BAND);
+	CHECK(bandCount > 1);
+	CHECK(bandCount * rowsPerBand >= 1000);
+	CHECK((bandCount - 1) * rowsPerBand < 1000);
+	CHECK(decompresses(data, size, bounds, compression));
+
+	// The bounds must match the compressed pixels.
+	CHECK(!decompresses(data, size, BRect(0, 0, 299, 1999), compression));
+	CHECK(!decompresses(data, size, BRect(0, 0, 298, 999), compression));
+	// An unknown compression
+	CHECK(!decompresses(data, size, bounds, 1000));
+
+	// Band counts that don't fit the rows or the data size
+	uint32 counts[] = { 0, bandCount - 1, bandCount + 1, 0x3fffffff,
+		0x7fffffff, 0x80000000, 0xffffffff };
+	for (uint32 i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		set_header_value(data, BAND_COUNT, counts[i]);
+		CHECK(!decompresses(data, size, bounds, compression));
+	}
+	set_header_value(data, BAND_COUNT, bandCount);
+
+	// Rows per band that don't fit the band count
+	uint32 rows[] = { 0, rowsPerBand - 1, 1000, 0xffffffff };
+	for (uint32 i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+		set_header_value(data, ROWS_PER_BAND, rows[i]);
+		CHECK(!decompresses(data, size, bounds, compression));
+	}
+	set_header_value(data, ROWS_PER_BAND, rowsPerBand);
+
+	CHECK(decompresses(data, size, bounds, compression));
+
+	// Data shorter than the header
+	CHECK(!decompresses(data, 0, bounds, compression));
+	CHECK(!decompresses(data, 7, bounds, compression));
+	CHECK(!decompresses(NULL, size, bounds, compression));
+
+	free(data);
+}
+
+TEST(band_compression_single_band_rows)
+{
+	// A single band may claim any number of rows of at least the height.
+	BRect bounds(0, 0, 15, 15);
+	RenderBuffer* buffer = create_buffer(bounds);
+	CHECK(buffer != NULL);
+	if (buffer == NULL)
+		return;
+
+	void* data = NULL;
+	size_t size = 0;
+	uint32 compression = 0;
+	CHECK(compress_buffer(buffer, &data, &size, &compression) == B_OK);
+	if (data != NULL) {
+		CHECK(header_value(data, BAND_COUNT) == 1);
+		set_header_value(data, ROWS_PER_BAND, 0x7fffffff);
+		RenderBuffer* result = decompress_buffer(data, size, bounds,
+			compression);
+		CHECK(same_pixels(buffer, result));
+		if (result != NULL)
+			result->RemoveReference();
+	}
+
+	free(data);
+	buffer->RemoveReference();
+}
+
+TEST(band_compression_band_sizes)
+{
+	BRect bounds(0, 0, 299, 999);
+	RenderBuffer* buffer = create_buffer(bounds);
+	CHECK(buffer != NULL);
+	if (buffer == NULL)
+		return;
+
+	void* data = NULL;
+	size_t size = 0;
+	uint32 compression = 0;
+	CHECK(compress_buffer(buffer, &data, &size, &compression) == B_OK);
+	buffer->RemoveReference();
+	if (data == NULL)
+		return;
+
+	uint32 bandCount = header_value(data, BAND_COUNT);
+	for (uint32 band = 0; band < bandCount; band++) {
+		uint32 bandSize = header_value(data, FIRST_BAND_SIZE + band);
+
+		// A band reaching beyond the data, a band which is cut short, and
+		// bands larger or smaller than the compressed rows.
+		uint32 sizes[] = { (uint32)size, 0xffffffff, 0, 1, bandSize - 1,
+			bandSize + 1 };
+		for (uint32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			set_header_value(data, FIRST_BAND_SIZE + band, sizes[i]);
+			CHECK(!decompresses(data, size, bounds, compression));
+		}
+		set_header_value(data, FIRST_BAND_SIZE + band, bandSize);
+	}
+
+	CHECK(decompresses(data, size, bounds, compression));
+
+	free(data);
+}
+
+TEST(band_compression_truncated)
+{
+	BRect bounds(0, 0, 99, 299);
+	RenderBuffer* buffer = create_buffer(bounds);
+	CHECK(buffer != NULL);
+	if (buffer == NULL)
+		return;
+
+	void* data = NULL;
+	size_t size = 0;
+	uint32 compression = 0;
+	CHECK(compress_buffer(buffer, &data, &size, &compression) == B_OK);
+	buffer->RemoveReference();
+	if (data == NULL)
+		return;
+
+	// Every length cuts into the header or into one of the bands.
+	for (size_t length = 0; length < size; length += 13)
+		CHECK(!decompresses(data, length, bounds, compression));
+	CHECK(!decompresses(data, size - 1, bounds, compression));
+
+	free(data);
+}
+
+TEST(band_compression_corrupted_band)
+{
+	BRect bounds(0, 0, 299, 999);
+	RenderBuffer* buffer = create_buffer(bounds);
+	CHECK(buffer != NULL);
+	if (buffer == NULL)
+		return;
+
+	void* data = NULL;
+	size_t size = 0;
+	uint32 compression = 0;
+	CHECK(compress_buffer(buffer, &data, &size, &compression) == B_OK);
+	buffer->RemoveReference();
+	if (data == NULL)
+		return;
+
+	// Flip bits in the last compressed band, zlib notices by the checksum
+	// at the latest.
+	uint8* bytes = (uint8*)data;
+	bytes[size - 1] ^= 0x5a;
+	CHECK(!decompresses(data, size, bounds, compression));
+	bytes[size - 1] ^= 0x5a;
+
+	uint32 bandCount = header_value(data, BAND_COUNT);
+	size_t firstBand = (FIRST_BAND_SIZE + bandCount) * sizeof(uint32);
+	bytes[firstBand] ^= 0xff;
+	CHECK(!decompresses(data, size, bounds, compression));
+
+	free(data);
+}
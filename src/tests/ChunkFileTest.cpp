@@ -0,0 +1,302 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include <new>
+#include <string.h>
+
+#include <ByteOrder.h>
+#include <DataIO.h>
+#include <Message.h>
+
+#include "Brush.h"
+#include "BrushStroke.h"
+#include "ChunkFile.h"
+#include "Document.h"
+#include "Image.h"
+#include "Layer.h"
+#include "MessageExporter.h"
+#include "MessageImporter.h"
+#include "Rect.h"
+#include "RenderBuffer.h"
+#include "TestSupport.h"
+
+static const char kData[] = "The pixels of an image";
+
+// The offset of the first entry in the table of contents: type, reserved,
+// offset and size follow each other.
+static const off_t kFirstEntryOffset = 8;
+
+// write_chunks
+static status_t
+write_chunks(BPositionIO* stream, uint32 extraType = 0)
+{
+	ChunkWriter writer(stream);
+	status_t ret = writer.WriteHeader();
+	if (ret == B_OK)
+		ret = writer.AddChunk(CHUNK_PIXELS, kData, sizeof(kData));
+
+	BMessage message('test');
+	message.AddInt32("value", 42);
+	message.AddString("name", "chunk");
+	if (ret == B_OK)
+		ret = writer.AddMessage(CHUNK_DOCUMENT, message);
+
+	if (ret == B_OK && extraType != 0)
+		ret = writer.AddChunk(extraType, kData, sizeof(kData));
+
+	if (ret == B_OK)
+		ret = writer.Finish();
+	return ret;
+}
+
+// toc_offset
+static off_t
+toc_offset(BMallocIO& stream)
+{
+	uint64 offset;
+	if (stream.ReadAt(8, &offset, sizeof(offset)) != sizeof(offset))
+		return -1;
+	return (off_t)B_BENDIAN_TO_HOST_INT64(offset);
+}
+
+// init_truncated
+/*!	Returns the result of reading the first \a length bytes of the stream
+	as a ChunkFile.
+*/
+static status_t
+init_truncated(BMallocIO& stream, size_t length)
+{
+	BMemoryIO truncated(stream.Buffer(), length);
+	ChunkFile file(&truncated, false);
+	return file.Init();
+}
+
+// create_document
+static Document*
+create_document()
+{
+	Document* document = new(std::nothrow) Document(BRect(0, 0, 99, 99));
+	if (document == NULL)
+		return NULL;
+
+	AutoWriteLocker locker(document);
+
+	Layer* layer = document->RootLayer();
+	layer->AddObject(new(std::nothrow) Rect(BRect(10, 10, 29, 29),
+		(rgb_color){ 0, 0, 255, 255 }));
+
+	BrushStroke* stroke = new(std::nothrow) BrushStroke();
+	Brush* brush = new(std::nothrow) Brush();
+	if (stroke != NULL && brush != NULL) {
+		stroke->SetBrush(brush);
+		for (int32 i = 0; i < 10; i++) {
+			stroke->AppendPoint(StrokePoint(BPoint(i * 2, i), 0.5f, 0.0f,
+				0.0f));
+		}
+		layer->AddObject(stroke);
+	} else
+		delete stroke;
+	if (brush != NULL)
+		brush->RemoveReference();
+
+	RenderBuffer* buffer = new(std::nothrow) RenderBuffer(8, 8);
+	if (buffer != NULL) {
+		if (buffer->IsValid()) {
+			uint16* pixel = (uint16*)buffer->Bits();
+			for (uint32 i = 0; i < 8 * 8; i++) {
+				pixel[0] = i * 1000;
+				pixel[1] = i * 500;
+				pixel[2] = i * 250;
+				pixel[3] = 65535;
+				pixel += 4;
+			}
+			layer->AddObject(new(std::nothrow) Image(buffer));
+		}
+		buffer->RemoveReference();
+	}
+
+	return document;
+}
+
+// export_document
+static status_t
+export_document(const DocumentRef& document, BPositionIO* stream)
+{
+	AutoReadLocker locker(document.Get());
+	MessageExporter exporter;
+	return exporter.Export(document, stream);
+}
+
+// import_document
+static status_t
+import_document(BPositionIO& stream, DocumentRef& document)
+{
+	document.SetTo(new(std::nothrow) Document(BRect(0, 0, 9, 9)), true);
+	if (document.Get() == NULL)
+		return B_NO_MEMORY;
+
+	AutoWriteLocker locker(document.Get());
+	MessageImporter importer(document);
+	return importer.Import(stream);
+}
+
+// #pragma mark -
+
+TEST(chunk_file_round_trip)
+{
+	BMallocIO stream;
+	CHECK(write_chunks(&stream) == B_OK);
+
+	stream.Seek(0, SEEK_SET);
+	ChunkFile file(&stream, false);
+	CHECK(file.Init() == B_OK);
+	CHECK(file.CountChunks() == 2);
+
+	int32 pixels = file.FindChunk(CHUNK_PIXELS);
+	CHECK(pixels == 0);
+	CHECK(file.ChunkType(pixels) == CHUNK_PIXELS);
+	CHECK(file.ChunkSize(pixels) == sizeof(kData));
+
+	char data[sizeof(kData)];
+	CHECK(file.ReadChunk(pixels, data, sizeof(data)) == B_OK);
+	CHECK(memcmp(data, kData, sizeof(kData)) == 0);
+	CHECK(file.ReadChunk(pixels, data, 4, 4) == B_OK);
+	CHECK(memcmp(data, kData + 4, 4) == 0);
+
+	// Reading beyond the chunk or a chunk that doesn't exist fails.
+	CHECK(file.ReadChunk(pixels, data, sizeof(data), 1) != B_OK);
+	CHECK(file.ReadChunk(2, data, 1) != B_OK);
+	CHECK(file.FindChunk(CHUNK_OBJECTS) < 0);
+
+	BMessage message;
+	CHECK(file.ReadMessage(file.FindChunk(CHUNK_DOCUMENT), &message)
+		== B_OK);
+	CHECK(message.what == 'test');
+	CHECK(message.FindInt32("value") == 42);
+	CHECK(strcmp(message.FindString("name"), "chunk") == 0);
+}
+
+TEST(chunk_file_truncated)
+{
+	BMallocIO stream;
+	CHECK(write_chunks(&stream) == B_OK);
+
+	size_t length = stream.BufferLength();
+	CHECK(init_truncated(stream, length) == B_OK);
+	for (size_t i = 0; i < length; i++)
+		CHECK(init_truncated(stream, i) != B_OK);
+}
+
+TEST(chunk_file_corrupt_size)
+{
+	BMallocIO stream;
+	CHECK(write_chunks(&stream) == B_OK);
+
+	// The first chunk claims to extend into the table of contents.
+	off_t sizeOffset = toc_offset(stream) + kFirstEntryOffset + 16;
+	uint64 size = B_HOST_TO_BENDIAN_INT64(sizeof(kData) + 1);
+	CHECK(stream.WriteAt(sizeOffset, &size, sizeof(size)) == sizeof(size));
+
+	stream.Seek(0, SEEK_SET);
+	ChunkFile file(&stream, false);
+	CHECK(file.Init() == B_BAD_DATA);
+	CHECK(file.CountChunks() == 0);
+
+	// A size that wraps around when added to the offset.
+	size = B_HOST_TO_BENDIAN_INT64(~(uint64)0);
+	CHECK(stream.WriteAt(sizeOffset, &size, sizeof(size)) == sizeof(size));
+	stream.Seek(0, SEEK_SET);
+	CHECK(file.Init() == B_BAD_DATA);
+}
+
+TEST(chunk_file_unknown_chunk)
+{
+	BMallocIO stream;
+	CHECK(write_chunks(&stream, 'XXXX') == B_OK);
+
+	stream.Seek(0, SEEK_SET);
+	ChunkFile file(&stream, false);
+	CHECK(file.Init() == B_BAD_DATA);
+	CHECK(file.CountChunks() == 0);
+
+	DocumentRef document;
+	stream.Seek(0, SEEK_SET);
+	CHECK(import_document(stream, document) != B_OK);
+}
+
+TEST(document_round_trip)
+{
+	DocumentRef document(create_document(), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	BMallocIO stream;
+	CHECK(export_document(document, &stream) == B_OK);
+
+	DocumentRef imported;
+	stream.Seek(0, SEEK_SET);
+	CHECK(import_document(stream, imported) == B_OK);
+	if (imported.Get() == NULL)
+		return;
+
+	CHECK(imported->Bounds() == document->Bounds());
+
+	Layer* layer = imported->RootLayer();
+	CHECK(layer->CountObjects() == 3);
+	if (layer->CountObjects() != 3)
+		return;
+
+	Rect* rect = dynamic_cast<Rect*>(layer->ObjectAt(0));
+	CHECK(rect != NULL && rect->Area() == BRect(10, 10, 29, 29));
+
+	BrushStroke* stroke = dynamic_cast<BrushStroke*>(layer->ObjectAt(1));
+	BrushStroke* original = dynamic_cast<BrushStroke*>(
+		document->RootLayer()->ObjectAt(1));
+	CHECK(stroke != NULL && original != NULL);
+	if (stroke != NULL && original != NULL)
+		CHECK(stroke->Stroke() == original->Stroke());
+
+	Image* image = dynamic_cast<Image*>(layer->ObjectAt(2));
+	Image* originalImage = dynamic_cast<Image*>(
+		document->RootLayer()->ObjectAt(2));
+	CHECK(image != NULL && originalImage != NULL);
+	if (image == NULL || originalImage == NULL)
+		return;
+
+	RenderBuffer* pixels = image->Buffer();
+	RenderBuffer* originalPixels = originalImage->Buffer();
+	CHECK(pixels != NULL && pixels != originalPixels);
+	if (pixels != NULL) {
+		CHECK(pixels->Bounds() == originalPixels->Bounds());
+		CHECK(pixels->BitsLength() == originalPixels->BitsLength());
+		CHECK(memcmp(pixels->Bits(), originalPixels->Bits(),
+			originalPixels->BitsLength()) == 0);
+	}
+}
+
+TEST(document_import_truncated)
+{
+	DocumentRef document(create_document(), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	BMallocIO stream;
+	CHECK(export_document(document, &stream) == B_OK);
+
+	// Cut the file at a few places, including right before the end of the
+	// table of contents.
+	size_t lengths[] = {
+		stream.BufferLength() / 4,
+		stream.BufferLength() / 2,
+		stream.BufferLength() - 1
+	};
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		BMemoryIO truncated(stream.Buffer(), lengths[i]);
+		DocumentRef imported;
+		CHECK(import_document(truncated, imported) != B_OK);
+	}
+}
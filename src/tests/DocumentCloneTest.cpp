@@ -0,0 +1,194 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include <new>
+
+#include "Brush.h"
+#include "BrushStroke.h"
+#include "CloneContext.h"
+#include "Document.h"
+#include "Image.h"
+#include "Layer.h"
+#include "Rect.h"
+#include "RenderBuffer.h"
+#include "TestSupport.h"
+
+static const BRect kDocumentBounds(0, 0, 99, 99);
+static const BRect kRectArea(10, 10, 29, 29);
+
+static const rgb_color kGreen = { 0, 255, 0, 255 };
+
+// create_stroke
+static BrushStroke*
+create_stroke(int32 pointCount)
+{
+	BrushStroke* stroke = new(std::nothrow) BrushStroke();
+	if (stroke == NULL)
+		return NULL;
+
+	Brush* brush = new(std::nothrow) Brush();
+	if (brush != NULL) {
+		stroke->SetBrush(brush);
+		brush->RemoveReference();
+	}
+
+	for (int32 i = 0; i < pointCount; i++)
+		stroke->AppendPoint(StrokePoint(BPoint(i, i), 1.0f, 0.0f, 0.0f));
+
+	return stroke;
+}
+
+// create_document
+static Document*
+create_document()
+{
+	Document* document = new(std::nothrow) Document(kDocumentBounds);
+	if (document == NULL)
+		return NULL;
+
+	AutoWriteLocker locker(document);
+
+	Layer* layer = document->RootLayer();
+	layer->AddObject(new(std::nothrow) Rect(kRectArea, kGreen));
+	layer->AddObject(create_stroke(10));
+
+	RenderBuffer* buffer = new(std::nothrow) RenderBuffer(16, 16);
+	if (buffer != NULL) {
+		layer->AddObject(new(std::nothrow) Image(buffer));
+		buffer->RemoveReference();
+	}
+
+	return document;
+}
+
+// clone_document
+static Document*
+clone_document(Document* document)
+{
+	AutoReadLocker locker(document);
+	return (Document*)document->BaseObject::Clone();
+}
+
+// #pragma mark -
+
+TEST(stroke_clone_shares_points)
+{
+	BrushStroke* stroke = create_stroke(10);
+	CHECK(stroke != NULL);
+	if (stroke == NULL)
+		return;
+
+	CloneContext context;
+	BrushStroke* clone = (BrushStroke*)stroke->Clone(context);
+	CHECK(clone != NULL);
+	if (clone == NULL) {
+		stroke->RemoveReference();
+		return;
+	}
+
+	CHECK(&clone->Stroke() == &stroke->Stroke());
+	CHECK(clone->Stroke().CountObjects() == 10);
+
+	stroke->RemoveReference();
+	clone->RemoveReference();
+}
+
+TEST(stroke_copy_on_write)
+{
+	BrushStroke* stroke = create_stroke(10);
+	CHECK(stroke != NULL);
+	if (stroke == NULL)
+		return;
+
+	CloneContext context;
+	BrushStroke* clone = (BrushStroke*)stroke->Clone(context);
+	CHECK(clone != NULL);
+	if (clone == NULL) {
+		stroke->RemoveReference();
+		return;
+	}
+
+	// Changing the clone copies the points, the original keeps its own.
+	CHECK(clone->AppendPoint(StrokePoint(BPoint(50, 50), 1.0f, 0.0f, 0.0f)));
+	CHECK(&clone->Stroke() != &stroke->Stroke());
+	CHECK(clone->Stroke().CountObjects() == 11);
+	CHECK(stroke->Stroke().CountObjects() == 10);
+	CHECK(clone->Stroke().LastObject()->point == BPoint(50, 50));
+
+	// The original can change as well, without copying again.
+	const ::Stroke* points = &stroke->Stroke();
+	CHECK(stroke->AppendPoint(StrokePoint(BPoint(60, 60), 1.0f, 0.0f,
+		0.0f)));
+	CHECK(&stroke->Stroke() == points);
+	CHECK(stroke->Stroke().CountObjects() == 11);
+	CHECK(stroke->Stroke().LastObject()->point == BPoint(60, 60));
+	CHECK(clone->Stroke().LastObject()->point == BPoint(50, 50));
+
+	stroke->RemoveReference();
+	clone->RemoveReference();
+}
+
+TEST(document_clone_independence)
+{
+	DocumentRef document(create_document(), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	DocumentRef clone(clone_document(document.Get()), true);
+	CHECK(clone.Get() != NULL);
+	if (clone.Get() == NULL)
+		return;
+
+	Layer* layer = document->RootLayer();
+	Layer* cloneLayer = clone->RootLayer();
+	CHECK(cloneLayer != layer);
+	CHECK(layer->CountObjects() == 3);
+	CHECK(cloneLayer->CountObjects() == 3);
+	if (layer->CountObjects() != 3 || cloneLayer->CountObjects() != 3)
+		return;
+
+	Rect* rect = dynamic_cast<Rect*>(layer->ObjectAt(0));
+	Rect* cloneRect = dynamic_cast<Rect*>(cloneLayer->ObjectAt(0));
+	BrushStroke* stroke = dynamic_cast<BrushStroke*>(layer->ObjectAt(1));
+	BrushStroke* cloneStroke = dynamic_cast<BrushStroke*>(
+		cloneLayer->ObjectAt(1));
+	Image* image = dynamic_cast<Image*>(layer->ObjectAt(2));
+	Image* cloneImage = dynamic_cast<Image*>(cloneLayer->ObjectAt(2));
+	CHECK(rect != NULL && cloneRect != NULL && rect != cloneRect);
+	CHECK(stroke != NULL && cloneStroke != NULL && stroke != cloneStroke);
+	CHECK(image != NULL && cloneImage != NULL && image != cloneImage);
+	if (rect == NULL || cloneRect == NULL || stroke == NULL
+		|| cloneStroke == NULL || image == NULL || cloneImage == NULL) {
+		return;
+	}
+
+	// The heavy data is shared.
+	CHECK(&cloneStroke->Stroke() == &stroke->Stroke());
+	CHECK(cloneImage->Buffer() == image->Buffer());
+
+	// Changing the document does not change the clone.
+	{
+		AutoWriteLocker locker(document.Get());
+		rect->SetArea(BRect(50, 50, 59, 59));
+		stroke->AppendPoint(StrokePoint(BPoint(70, 70), 1.0f, 0.0f, 0.0f));
+		layer->AddObject(new(std::nothrow) Rect(kRectArea, kGreen));
+	}
+
+	CHECK(cloneRect->Area() == kRectArea);
+	CHECK(cloneStroke->Stroke().CountObjects() == 10);
+	CHECK(stroke->Stroke().CountObjects() == 11);
+	CHECK(cloneLayer->CountObjects() == 3);
+
+	// Nor does changing the clone change the document.
+	{
+		AutoWriteLocker locker(clone.Get());
+		cloneLayer->RemoveObject((int32)0);
+	}
+
+	CHECK(cloneLayer->CountObjects() == 2);
+	CHECK(layer->CountObjects() == 4);
+	CHECK(rect->Area() == BRect(50, 50, 59, 59));
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include <new>
+
+#include <string.h>
+
+#include "AddObjectsEdit.h"
+#include "CompactedBuffer.h"
+#include "EditContext.h"
+#include "EditManager.h"
+#include "Image.h"
+#include "Layer.h"
+#include "RenderBuffer.h"
+#include "RWLocker.h"
+#include "SpillFile.h"
+#include "TestSupport.h"
+
+// An edit with a footprint which the tests control.
+class FootprintEdit : public UndoableEdit {
+public:
+	FootprintEdit(size_t footprint)
+		: UndoableEdit()
+		, fFootprint(footprint)
+		, fCompacted(false)
+	{
+	}
+
+	virtual size_t MemoryFootprint() const
+	{
+		return fFootprint;
+	}
+
+	virtual status_t Compact(SpillFile* file)
+	{
+		fFootprint = 1;
+		fCompacted = true;
+		return B_OK;
+	}
+
+	inline bool IsCompacted() const
+	{
+		return fCompacted;
+	}
+
+private:
+	size_t			fFootprint;
+	bool			fCompacted;
+};
+
+// perform
+static status_t
+perform(EditManager& manager, EditContext& context, size_t footprint)
+{
+	return manager.Perform(new(std::nothrow) FootprintEdit(footprint),
+		context);
+}
+
+// #pragma mark -
+
+TEST(spill_file_reuses_freed_ranges)
+{
+	SpillFileRef file(new(std::nothrow) SpillFile(), true);
+	CHECK(file.Get() != NULL && file->InitCheck() == B_OK);
+	if (file.Get() == NULL || file->InitCheck() != B_OK)
+		return;
+
+	char data[100];
+	memset(data, 'a', sizeof(data));
+
+	off_t first;
+	off_t second;
+	off_t third;
+	CHECK(file->Write(data, 100, &first) == B_OK);
+	CHECK(file->Write(data, 100, &second) == B_OK);
+	CHECK(file->Write(data, 100, &third) == B_OK);
+	CHECK(first == 0 && second == 100 && third == 200);
+	CHECK(file->Size() == 300);
+
+	// A smaller write goes into the freed range.
+	file->Free(second, 100);
+	CHECK(file->CountFreeRanges() == 1);
+
+	memset(data, 'b', sizeof(data));
+	off_t reused;
+	CHECK(file->Write(data, 60, &reused) == B_OK);
+	CHECK(reused == 100);
+	CHECK(file->Size() == 300);
+
+	char read[100];
+	CHECK(file->Read(reused, read, 60) == B_OK);
+	CHECK(memcmp(read, data, 60) == 0);
+	CHECK(file->Read(third, read, 100) == B_OK);
+	CHECK(read[0] == 'a' && read[99] == 'a');
+
+	// A larger write doesn't fit into the remainder.
+	off_t appended;
+	CHECK(file->Write(data, 100, &appended) == B_OK);
+	CHECK(appended == 300);
+	CHECK(file->Size() == 400);
+}
+
+TEST(spill_file_truncates_freed_end)
+{
+	SpillFileRef file(new(std::nothrow) SpillFile(), true);
+	CHECK(file.Get() != NULL && file->InitCheck() == B_OK);
+	if (file.Get() == NULL || file->InitCheck() != B_OK)
+		return;
+
+	char data[100];
+	memset(data, 'a', sizeof(data));
+
+	off_t offsets[3];
+	for (int32 i = 0; i < 3; i++)
+		CHECK(file->Write(data, 100, &offsets[i]) == B_OK);
+
+	file->Free(offsets[1], 100);
+	CHECK(file->Size() == 300);
+
+	// Freeing the end merges with the free range before it.
+	file->Free(offsets[2], 100);
+	CHECK(file->Size() == 100);
+	CHECK(file->CountFreeRanges() == 0);
+
+	file->Free(offsets[0], 100);
+	CHECK(file->Size() == 0);
+
+	off_t offset;
+	CHECK(file->Write(data, 100, &offset) == B_OK);
+	CHECK(offset == 0);
+}
+
+TEST(edit_history_running_footprint)
+{
+	RWLocker locker("edit history test");
+	EditManager manager(&locker);
+	EditContext context;
+
+	CHECK(manager.MemoryFootprint() == 0);
+
+	CHECK(perform(manager, context, 1000) == B_OK);
+	CHECK(perform(manager, context, 2000) == B_OK);
+	CHECK(perform(manager, context, 3000) == B_OK);
+	CHECK(manager.MemoryFootprint() == 6000);
+
+	// Undone edits are still part of the history.
+	CHECK(manager.Undo(context) == B_OK);
+	CHECK(manager.MemoryFootprint() == 6000);
+
+	// A new edit forgets the redo history.
+	CHECK(perform(manager, context, 500) == B_OK);
+	CHECK(manager.MemoryFootprint() == 3500);
+
+	manager.Clear();
+	CHECK(manager.MemoryFootprint() == 0);
+}
+
+TEST(edit_history_budget_compacts_old_edits)
+{
+	RWLocker locker("edit history test");
+	EditManager manager(&locker);
+	EditContext context;
+
+	manager.SetMemoryBudget(10000);
+
+	FootprintEdit* oldest = new(std::nothrow) FootprintEdit(5000);
+	CHECK(oldest != NULL);
+	if (oldest == NULL)
+		return;
+	UndoableEditRef oldestRef(oldest, true);
+	CHECK(manager.Perform(oldestRef, context) == B_OK);
+
+	// The most recent edits are never compacted.
+	for (int32 i = 0; i < 8; i++)
+		CHECK(perform(manager, context, 100) == B_OK);
+	CHECK(!oldest->IsCompacted());
+	CHECK(manager.MemoryFootprint() == 5800);
+
+	CHECK(perform(manager, context, 5000) == B_OK);
+	CHECK(oldest->IsCompacted());
+	CHECK(manager.MemoryFootprint() == 5801);
+
+	// The oldest edits are forgotten, when compacting is not enough, but
+	// the most recent ones are kept even beyond the budget.
+	manager.SetMemoryBudget(5500);
+	CHECK(manager.MemoryFootprint() == 5700);
+	CHECK(oldest->CountReferences() == 1);
+}
+
+TEST(add_objects_edit_compacts_removed_images)
+{
+	Layer* layer = new(std::nothrow) Layer(BRect(0, 0, 99, 99));
+	RenderBuffer* buffer = new(std::nothrow) RenderBuffer(64, 64);
+	Image* image = buffer != NULL ? new(std::nothrow) Image(buffer) : NULL;
+	Object** objects = new(std::nothrow) Object*[1];
+	CHECK(layer != NULL && image != NULL && objects != NULL);
+	if (layer == NULL || image == NULL || objects == NULL) {
+		if (layer != NULL)
+			layer->RemoveReference();
+		if (buffer != NULL)
+			buffer->RemoveReference();
+		if (image != NULL)
+			image->RemoveReference();
+		delete[] objects;
+		return;
+	}
+
+	rgb_color red = { 255, 0, 0, 255 };
+	buffer->Clear(buffer->Bounds(), red);
+	size_t bitsLength = buffer->BitsLength();
+	buffer->RemoveReference();
+
+	objects[0] = image;
+	AddObjectsEdit* edit = new(std::nothrow) AddObjectsEdit(objects, 1, layer,
+		0, NULL);
+	image->RemoveReference();
+	CHECK(edit != NULL);
+	if (edit == NULL) {
+		layer->RemoveReference();
+		return;
+	}
+	UndoableEditRef editRef(edit, true);
+
+	EditContext context;
+	CHECK(edit->Perform(context) == B_OK);
+	CHECK(layer->CountObjects() == 1);
+
+	// While the image is part of the layer, the edit doesn't own the pixels.
+	CHECK(edit->MemoryFootprint() < bitsLength);
+	CHECK(edit->Compact(NULL) == B_OK);
+	CHECK(image->GetLazyBuffer() == NULL);
+
+	CHECK(edit->Undo(context) == B_OK);
+	CHECK(layer->CountObjects() == 0);
+	CHECK(edit->MemoryFootprint() > bitsLength);
+
+	// A single color compresses well.
+	CHECK(edit->Compact(NULL) == B_OK);
+	CHECK(dynamic_cast<CompactedBuffer*>(image->GetLazyBuffer()) != NULL);
+	CHECK(edit->MemoryFootprint() < bitsLength);
+
+	// The pixels are read back after redo.
+	CHECK(edit->Redo(context) == B_OK);
+	CHECK(layer->CountObjects() == 1);
+	RenderBuffer* restored = image->Buffer();
+	CHECK(restored != NULL);
+	if (restored != NULL) {
+		CHECK(restored->Bounds() == BRect(0, 0, 63, 63));
+		CHECK(restored->BitsLength() == bitsLength);
+	}
+
+	layer->RemoveReference();
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include <new>
+#include <string.h>
+
+#include <Region.h>
+
+#include "Document.h"
+#include "Filter.h"
+#include "Layer.h"
+#include "LayerSnapshot.h"
+#include "LayoutContext.h"
+#include "LayoutState.h"
+#include "Rect.h"
+#include "RenderBuffer.h"
+#include "RenderEngine.h"
+#include "TestSupport.h"
+#include "TiledRenderBuffer.h"
+
+static const BRect kDocumentBounds(0, 0, 299, 199);
+
+static const rgb_color kRed = { 255, 0, 0, 255 };
+static const rgb_color kBlue = { 0, 0, 255, 255 };
+
+// render_layer
+/*!	Lays out and renders the snapshot the way the RenderManager does for
+	one frame, and returns the pixels of the layer in the buffer.
+*/
+static void
+render_layer(LayerSnapshot& snapshot, bool preview, RenderBuffer& buffer)
+{
+	LayoutState initialState;
+	LayoutContext context(&initialState);
+	context.Init(1.0);
+	context.SetPreview(preview);
+
+	LayoutState rootLayerState(context.State());
+	context.PushState(&rootLayerState);
+	snapshot.Layout(context, 0);
+	context.PopState();
+
+	BRect area = buffer.Bounds();
+	snapshot.Tiles()->AllocateTiles(area);
+	snapshot.PrepareCache(BRegion(area), area);
+
+	RenderEngine engine;
+	RenderBuffer scratch(area);
+	snapshot.Render(engine, area, &scratch);
+
+	buffer.Clear(area, (rgb_color){ 255, 255, 255, 255 });
+	snapshot.Tiles()->BlendTo(&buffer, area);
+}
+
+// move_probe
+static void
+move_probe(Document* document, LayerSnapshot& snapshot, Rect* probe,
+	const BRect& area)
+{
+	AutoWriteLocker locker(document);
+	probe->SetArea(area);
+	snapshot.Sync();
+}
+
+// same_pixels
+static bool
+same_pixels(const RenderBuffer& a, const RenderBuffer& b)
+{
+	if (a.Bounds() != b.Bounds() || a.BytesPerRow() != b.BytesPerRow())
+		return false;
+	return memcmp(a.Bits(), b.Bits(), a.BitsLength()) == 0;
+}
+
+// #pragma mark -
+
+TEST(layer_cache_refines_preview)
+{
+	DocumentRef document(new(std::nothrow) Document(kDocumentBounds), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	// The blurred rect is below the probe which is dragged, so it ends up
+	// in the cache of the layer.
+	Rect* probe = new(std::nothrow) Rect(BRect(200, 20, 239, 59), kBlue);
+	{
+		AutoWriteLocker locker(document.Get());
+		Layer* layer = document->RootLayer();
+		layer->AddObject(new(std::nothrow) Rect(BRect(40, 40, 119, 119),
+			kRed));
+		layer->AddObject(new(std::nothrow) Filter(12.0f));
+		layer->AddObject(probe);
+	}
+
+	LayerSnapshot snapshot(document->RootLayer());
+	RenderBuffer result(kDocumentBounds);
+	render_layer(snapshot, false, result);
+
+	// Drag the probe in preview mode.
+	move_probe(document.Get(), snapshot, probe, BRect(200, 80, 239, 119));
+	render_layer(snapshot, true, result);
+	move_probe(document.Get(), snapshot, probe, BRect(200, 120, 239, 159));
+	render_layer(snapshot, true, result);
+	CHECK(snapshot.CacheLevel() == 2);
+
+	RenderBuffer preview(kDocumentBounds);
+	preview.Clear(kDocumentBounds, (rgb_color){ 255, 255, 255, 255 });
+	snapshot.Tiles()->BlendTo(&preview, kDocumentBounds);
+
+	// Refine, then compare with a layer which was never previewed.
+	render_layer(snapshot, false, result);
+
+	LayerSnapshot freshSnapshot(document->RootLayer());
+	RenderBuffer fresh(kDocumentBounds);
+	render_layer(freshSnapshot, false, fresh);
+
+	CHECK(same_pixels(result, fresh));
+	CHECK(!same_pixels(preview, fresh));
+}
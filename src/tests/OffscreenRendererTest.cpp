@@ -0,0 +1,251 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include <new>
+
+#include "Document.h"
+#include "Layer.h"
+#include "OffscreenRenderer.h"
+#include "Rect.h"
+#include "RenderBuffer.h"
+#include "RenderEngine.h"
+#include "TestSupport.h"
+
+// The document is larger than one tile, so that the tests cover rendering
+// across tile boundaries.
+static const BRect kDocumentBounds(0, 0, 599, 299);
+
+static const rgb_color kRed = { 255, 0, 0, 255 };
+static const rgb_color kBlue = { 0, 0, 255, 128 };
+
+// create_document
+static Document*
+create_document(Rect** _probe, const BRect& bounds = kDocumentBounds)
+{
+	Document* document = new(std::nothrow) Document(bounds);
+	if (document == NULL)
+		return NULL;
+
+	AutoWriteLocker locker(document);
+
+	Layer* layer = document->RootLayer();
+	layer->AddObject(new(std::nothrow) Rect(BRect(8, 8, 31, 31), kRed));
+	// Crosses the tile boundary at x = 256.
+	layer->AddObject(new(std::nothrow) Rect(BRect(240, 40, 279, 79), kRed));
+
+	Rect* probe = new(std::nothrow) Rect(BRect(24, 24, 47, 47), kBlue);
+	layer->AddObject(probe);
+	if (_probe != NULL)
+		*_probe = probe;
+
+	return document;
+}
+
+// pixel_at
+static const uint16*
+pixel_at(const RenderBuffer& buffer, int32 x, int32 y)
+{
+	return (const uint16*)(buffer.Bits()
+		+ (y - buffer.Top()) * buffer.BytesPerRow()
+		+ (x - buffer.Left()) * 8);
+}
+
+// has_color
+static bool
+has_color(const RenderBuffer& buffer, int32 x, int32 y, uint16 blue,
+	uint16 green, uint16 red, uint16 alpha)
+{
+	const uint16* pixel = pixel_at(buffer, x, y);
+	return pixel[0] == blue && pixel[1] == green && pixel[2] == red
+		&& pixel[3] == alpha;
+}
+
+// same_pixels
+/*!	Compares the pixels of the buffers in the area they have in common.
+*/
+static bool
+same_pixels(const RenderBuffer& a, const RenderBuffer& b)
+{
+	BRect area = a.Bounds() & b.Bounds();
+	if (!area.IsValid())
+		return false;
+
+	for (int32 y = (int32)area.top; y <= (int32)area.bottom; y++) {
+		for (int32 x = (int32)area.left; x <= (int32)area.right; x++) {
+			const uint16* pixelA = pixel_at(a, x, y);
+			const uint16* pixelB = pixel_at(b, x, y);
+			for (int32 i = 0; i < 4; i++) {
+				if (pixelA[i] != pixelB[i])
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+// #pragma mark -
+
+TEST(offscreen_render_colors)
+{
+	DocumentRef document(create_document(NULL), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	OffscreenRenderer renderer(document.Get());
+	RenderBuffer buffer(kDocumentBounds);
+	CHECK(renderer.Render(&buffer, 1.0) == B_OK);
+
+	uint16 full = RenderEngine::GammaToLinear(255);
+	uint16 none = RenderEngine::GammaToLinear(0);
+
+	// background
+	CHECK(has_color(buffer, 500, 200, full, full, full, full));
+	// opaque red
+	CHECK(has_color(buffer, 12, 12, none, none, full, full));
+	// both sides of the tile boundary
+	CHECK(has_color(buffer, 255, 60, none, none, full, full));
+	CHECK(has_color(buffer, 256, 60, none, none, full, full));
+	// translucent blue over white
+	const uint16* pixel = pixel_at(buffer, 40, 40);
+	CHECK(pixel[0] == full);
+	CHECK(pixel[1] == pixel[2]);
+	CHECK(pixel[1] < full && pixel[1] > none);
+	CHECK(pixel[3] == full);
+	// translucent blue over red
+	pixel = pixel_at(buffer, 28, 28);
+	CHECK(pixel[0] > none && pixel[0] < full);
+	CHECK(pixel[1] == none);
+	CHECK(pixel[2] > none && pixel[2] < full);
+	CHECK(pixel[3] == full);
+
+}
+
+TEST(offscreen_render_sub_area)
+{
+	DocumentRef document(create_document(NULL), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	OffscreenRenderer renderer(document.Get());
+	RenderBuffer full(kDocumentBounds);
+	CHECK(renderer.Render(&full, 1.0) == B_OK);
+
+	// A buffer with an origin other than 0, 0 spanning two tiles.
+	RenderBuffer part(BRect(20, 20, 299, 69));
+	CHECK(renderer.Render(&part, 1.0) == B_OK);
+	CHECK(same_pixels(full, part));
+
+}
+
+TEST(offscreen_render_zoomed)
+{
+	DocumentRef document(create_document(NULL), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	OffscreenRenderer renderer(document.Get());
+	RenderBuffer buffer(OffscreenRenderer::ZoomedBounds(kDocumentBounds,
+		2.0));
+	CHECK(renderer.Render(&buffer, 2.0) == B_OK);
+
+	uint16 full = RenderEngine::GammaToLinear(255);
+	uint16 none = RenderEngine::GammaToLinear(0);
+
+	CHECK(has_color(buffer, 24, 24, none, none, full, full));
+	CHECK(has_color(buffer, 70, 70, none, none, full, full) == false);
+	CHECK(has_color(buffer, 1000, 500, full, full, full, full));
+
+}
+
+TEST(offscreen_render_after_change)
+{
+	Rect* probe;
+	DocumentRef document(create_document(&probe), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	OffscreenRenderer renderer(document.Get());
+	RenderBuffer before(kDocumentBounds);
+	CHECK(renderer.Render(&before, 1.0) == B_OK);
+
+	{
+		AutoWriteLocker locker(document.Get());
+		probe->SetArea(BRect(300, 100, 349, 149));
+	}
+
+	// The renderer syncs only the change, the result must be the same as
+	// rendering the changed document from scratch.
+	RenderBuffer after(kDocumentBounds);
+	CHECK(renderer.Render(&after, 1.0) == B_OK);
+
+	OffscreenRenderer freshRenderer(document.Get());
+	RenderBuffer fresh(kDocumentBounds);
+	CHECK(freshRenderer.Render(&fresh, 1.0) == B_OK);
+
+	CHECK(same_pixels(after, fresh));
+	CHECK(!same_pixels(before, after));
+
+}
+
+TEST(offscreen_render_threads)
+{
+	// Large enough for several blocks of tiles per layer.
+	BRect bounds(0, 0, 2299, 1099);
+	Rect* probe;
+	DocumentRef document(create_document(&probe, bounds), true);
+	CHECK(document.Get() != NULL);
+	if (document.Get() == NULL)
+		return;
+
+	{
+		AutoWriteLocker locker(document.Get());
+		Layer* subLayer = new(std::nothrow) Layer(bounds);
+		if (subLayer != NULL && document->RootLayer()->AddObject(subLayer)) {
+			subLayer->AddObject(new(std::nothrow) Rect(
+				BRect(1000, 1000, 1100, 1090), kBlue));
+			subLayer->AddObject(new(std::nothrow) Rect(
+				BRect(2000, 20, 2200, 1050), kRed));
+		}
+	}
+
+	OffscreenRenderer renderer(document.Get());
+	RenderBuffer single(bounds);
+	CHECK(renderer.Render(&single, 1.0) == B_OK);
+
+	OffscreenRenderer threadedRenderer(document.Get());
+	CHECK(threadedRenderer.SetThreadCount(4) == B_OK);
+	CHECK(threadedRenderer.ThreadCount() == 4);
+	threadedRenderer.SetKeepTiles(true);
+	RenderBuffer threaded(bounds);
+	CHECK(threadedRenderer.Render(&threaded, 1.0) == B_OK);
+	CHECK(same_pixels(single, threaded));
+
+	// With the tiles kept, rendering only the changed area gives the same
+	// result as rendering everything from scratch.
+	BRect dirtyArea;
+	{
+		AutoWriteLocker locker(document.Get());
+		dirtyArea = probe->Area();
+		probe->SetArea(BRect(1020, 500, 1040, 1080));
+		dirtyArea = dirtyArea | probe->Area();
+	}
+	dirtyArea.InsetBy(-2, -2);
+
+	RenderBuffer dirty(&threaded, dirtyArea, false);
+	CHECK(threadedRenderer.Render(&dirty, 1.0) == B_OK);
+
+	OffscreenRenderer freshRenderer(document.Get());
+	RenderBuffer fresh(bounds);
+	CHECK(freshRenderer.Render(&fresh, 1.0) == B_OK);
+	CHECK(same_pixels(threaded, fresh));
+	CHECK(!same_pixels(single, fresh));
+
+	CHECK(renderer.SetThreadCount(0) != B_OK);
+	CHECK(renderer.ThreadCount() == 1);
+}
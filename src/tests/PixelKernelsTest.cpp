@@ -0,0 +1,206 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include <string.h>
+
+#include "PixelKernels.h"
+#include "TestSupport.h"
+
+// Row lengths around the vector widths of the kernels, to cover their
+// loops as well as the tails which the C versions handle.
+static const int32 kLengths[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 31, 33, 64, 67
+};
+static const int32 kLengthCount = sizeof(kLengths) / sizeof(kLengths[0]);
+
+// The kernels work on the rows starting one pixel into the buffers, so the
+// rows are not aligned, and the pixel behind the row needs to stay as it
+// is.
+static const int32 kMaxPixels = 67 + 2;
+
+static const int32 kRowsPerLength = 8;
+
+struct kernel_rows {
+	uint16	fill[kMaxPixels * 4];
+	uint16	blend[kMaxPixels * 4];
+	uint8	gamma[kMaxPixels * 4];
+	uint16	linear[kMaxPixels * 4];
+	uint16	linearAlpha[kMaxPixels * 4];
+	uint16	contrast[kMaxPixels * 4];
+	uint16	desaturate[kMaxPixels * 4];
+	uint16	alpha[kMaxPixels];
+	uint16	shadow[kMaxPixels * 4];
+};
+
+struct kernel_input {
+	uint16	pixels[kMaxPixels * 4];
+	uint16	otherPixels[kMaxPixels * 4];
+	uint8	bytes[kMaxPixels * 4];
+	uint16	coverage[kMaxPixels];
+};
+
+// next_random
+static uint32
+next_random(uint32& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+// random_pixels
+/*!	Fills the pixels with premultiplied colors. Transparent and opaque
+	pixels are more likely than others, since the kernels treat them
+	specially.
+*/
+static void
+random_pixels(uint16* pixels, int32 count, uint32& state)
+{
+	for (int32 i = 0; i < count; i++) {
+		uint32 alpha = next_random(state) & 0xffff;
+		switch (next_random(state) % 4) {
+			case 0:
+				alpha = 0;
+				break;
+			case 1:
+				alpha = 65535;
+				break;
+		}
+		pixels[0] = alpha > 0 ? next_random(state) % (alpha + 1) : 0;
+		pixels[1] = alpha > 0 ? next_random(state) % (alpha + 1) : 0;
+		pixels[2] = alpha > 0 ? next_random(state) % (alpha + 1) : 0;
+		pixels[3] = alpha;
+		pixels += 4;
+	}
+}
+
+// random_input
+static void
+random_input(kernel_input& input, uint32& state)
+{
+	random_pixels(input.pixels, kMaxPixels, state);
+	random_pixels(input.otherPixels, kMaxPixels, state);
+	for (int32 i = 0; i < kMaxPixels * 4; i++)
+		input.bytes[i] = next_random(state) & 0xff;
+	// The extremes of the table lookups
+	input.bytes[4] = 0;
+	input.bytes[5] = 255;
+	input.pixels[4] = 65535;
+	input.pixels[5] = 0;
+	for (int32 i = 0; i < kMaxPixels; i++)
+		input.coverage[i] = next_random(state) & 0xffff;
+}
+
+// run_kernels
+/*!	Runs each kernel which is currently selected on a row of the given
+	length.
+*/
+static void
+run_kernels(const kernel_input& input, int32 count, kernel_rows& rows)
+{
+	static const uint16 kColor[4] = { 1000, 20000, 30000, 40000 };
+	static const uint16 kShadowColor[3] = { 65535, 32768, 1 };
+
+	memcpy(rows.fill, input.pixels, sizeof(rows.fill));
+	PixelKernels::FillRow(rows.fill + 4, kColor, count);
+
+	memcpy(rows.blend, input.otherPixels, sizeof(rows.blend));
+	PixelKernels::BlendRow(rows.blend + 4, input.pixels + 4, count);
+
+	memcpy(rows.gamma, input.bytes, sizeof(rows.gamma));
+	PixelKernels::LinearToGammaRow(rows.gamma + 4, input.pixels + 4, count);
+
+	memcpy(rows.linear, input.pixels, sizeof(rows.linear));
+	PixelKernels::GammaToLinearRow(rows.linear + 4, input.bytes + 4, count,
+		false);
+	memcpy(rows.linearAlpha, input.pixels, sizeof(rows.linearAlpha));
+	PixelKernels::GammaToLinearRow(rows.linearAlpha + 4, input.bytes + 4,
+		count, true);
+
+	memcpy(rows.contrast, input.pixels, sizeof(rows.contrast));
+	PixelKernels::ContrastRow(rows.contrast + 4, count, 128.0f, 1.7f);
+	PixelKernels::ContrastRow(rows.contrast + 4, count, 40.0f, 0.3f);
+
+	memcpy(rows.desaturate, input.pixels, sizeof(rows.desaturate));
+	PixelKernels::DesaturateRow(rows.desaturate + 4, count, 77);
+
+	memcpy(rows.alpha, input.coverage, sizeof(rows.alpha));
+	PixelKernels::ExtractAlphaRow(rows.alpha + 1, input.pixels + 4, count,
+		40000);
+
+	memcpy(rows.shadow, input.pixels, sizeof(rows.shadow));
+	PixelKernels::ShadowRow(rows.shadow + 4, input.coverage + 1, count,
+		kShadowColor);
+}
+
+// check_level
+/*!	Compares the kernels of the given level with the C versions on random
+	rows of all lengths.
+*/
+static void
+check_level(int32 level)
+{
+	kernel_input input;
+	kernel_rows expected;
+	kernel_rows result;
+
+	uint32 state = 0x2545f491;
+	for (int32 i = 0; i < kLengthCount; i++) {
+		for (int32 j = 0; j < kRowsPerLength; j++) {
+			random_input(input, state);
+
+			PixelKernels::Select(PixelKernels::C_KERNELS);
+			run_kernels(input, kLengths[i], expected);
+
+			PixelKernels::Select(level);
+			run_kernels(input, kLengths[i], result);
+
+			CHECK(memcmp(expected.fill, result.fill,
+				sizeof(expected.fill)) == 0);
+			CHECK(memcmp(expected.blend, result.blend,
+				sizeof(expected.blend)) == 0);
+			CHECK(memcmp(expected.gamma, result.gamma,
+				sizeof(expected.gamma)) == 0);
+			CHECK(memcmp(expected.linear, result.linear,
+				sizeof(expected.linear)) == 0);
+			CHECK(memcmp(expected.linearAlpha, result.linearAlpha,
+				sizeof(expected.linearAlpha)) == 0);
+			CHECK(memcmp(expected.contrast, result.contrast,
+				sizeof(expected.contrast)) == 0);
+			CHECK(memcmp(expected.desaturate, result.desaturate,
+				sizeof(expected.desaturate)) == 0);
+			CHECK(memcmp(expected.alpha, result.alpha,
+				sizeof(expected.alpha)) == 0);
+			CHECK(memcmp(expected.shadow, result.shadow,
+				sizeof(expected.shadow)) == 0);
+		}
+	}
+
+	PixelKernels::Init();
+}
+
+// #pragma mark -
+
+TEST(pixel_kernels_sse41_match_c)
+{
+	if (!PixelKernels::IsSupported(PixelKernels::SSE41_KERNELS))
+		return;
+	check_level(PixelKernels::SSE41_KERNELS);
+}
+
+TEST(pixel_kernels_avx2_match_c)
+{
+	if (!PixelKernels::IsSupported(PixelKernels::AVX2_KERNELS))
+		return;
+	check_level(PixelKernels::AVX2_KERNELS);
+}
+
+TEST(pixel_kernels_select_unsupported_level)
+{
+	CHECK(PixelKernels::IsSupported(PixelKernels::C_KERNELS));
+	CHECK(!PixelKernels::Select(PixelKernels::AVX2_KERNELS + 1));
+	CHECK(PixelKernels::Init());
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "RenderTrace.h"
+#include "TestSupport.h"
+
+// record_span
+static status_t
+record_span(void* cookie)
+{
+	TRACE_SPAN_AREA("test span", "object", BRect(0, 0, 9, 19));
+	return B_OK;
+}
+
+// count_spans
+/*!	Returns the number of recorded spans with the given name.
+*/
+static int32
+count_spans(const char* name)
+{
+	FILE* file = tmpfile();
+	if (file == NULL)
+		return -1;
+
+	int32 count = 0;
+	if (RenderTrace::Dump(file) == B_OK) {
+		char pattern[64];
+		snprintf(pattern, sizeof(pattern), "{\"name\":\"%s\"", name);
+
+		rewind(file);
+		char line[1024];
+		while (fgets(line, sizeof(line), file) != NULL) {
+			if (strstr(line, pattern) != NULL)
+				count++;
+		}
+	} else
+		count = -1;
+
+	fclose(file);
+	return count;
+}
+
+// #pragma mark -
+
+TEST(render_trace_many_threads)
+{
+	RenderTrace::Clear();
+	RenderTrace::SetEnabled(true);
+
+	// Far more threads than ever ran at the same time. Each one records
+	// a span and exits, like the threads of the offscreen renderer.
+	const int32 kThreadCount = 300;
+	int32 recorded = 0;
+	for (int32 i = 0; i < kThreadCount; i++) {
+		thread_id thread = spawn_thread(record_span, "trace test",
+			B_NORMAL_PRIORITY, NULL);
+		if (thread < 0 || resume_thread(thread) != B_OK)
+			continue;
+		status_t ret;
+		wait_for_thread(thread, &ret);
+		recorded++;
+	}
+
+	record_span(NULL);
+	recorded++;
+
+	RenderTrace::SetEnabled(false);
+
+	CHECK(recorded > 1);
+	CHECK(count_spans("test span") == recorded);
+
+	// Spans are not recorded while tracing is disabled.
+	record_span(NULL);
+	CHECK(count_spans("test span") == recorded);
+
+	RenderTrace::Clear();
+	CHECK(count_spans("test span") == 0);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+#include "TestSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct test_info {
+	const char*		name;
+	test_function	function;
+};
+
+static const int kMaxTests = 256;
+
+static test_info sTests[kMaxTests];
+static int sTestCount = 0;
+static int sFailureCount = 0;
+
+// constructor
+TestRegistration::TestRegistration(const char* name, test_function function)
+{
+	if (sTestCount == kMaxTests) {
+		fprintf(stderr, "Too many tests, '%s' is not run\n", name);
+		return;
+	}
+	sTests[sTestCount].name = name;
+	sTests[sTestCount].function = function;
+	sTestCount++;
+}
+
+// check_condition
+bool
+check_condition(bool condition, const char* expression, const char* file,
+	int line)
+{
+	if (!condition) {
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+		sFailureCount++;
+	}
+	return condition;
+}
+
+// #pragma mark -
+
+// main
+/*!	Runs all tests, or only those named on the command line. Returns 0 if
+	all of them passed.
+*/
+int
+main(int argc, char* argv[])
+{
+	int failedTests = 0;
+	int runTests = 0;
+
+	for (int i = 0; i < sTestCount; i++) {
+		if (argc > 1) {
+			bool selected = false;
+			for (int j = 1; j < argc; j++) {
+				if (strcmp(argv[j], sTests[i].name) == 0)
+					selected = true;
+			}
+			if (!selected)
+				continue;
+		}
+
+		int failures = sFailureCount;
+		sTests[i].function();
+		runTests++;
+
+		if (sFailureCount != failures) {
+			printf("%s: FAILED\n", sTests[i].name);
+			failedTests++;
+		} else
+			printf("%s: ok\n", sTests[i].name);
+	}
+
+	printf("%d of %d tests passed\n", runTests - failedTests, runTests);
+	return failedTests == 0 ? 0 : 1;
+}
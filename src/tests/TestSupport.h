@@ -0,0 +1,31 @@
+/*
+ * Copyright 2026, agent <agent@local>.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+// A minimal test harness for the WonderBrushTests program. Each test is a
+// function registered with the TEST() macro. The CHECK() macro records a
+// failure and continues, so one run reports every failed condition.
+
+typedef void (*test_function)();
+
+class TestRegistration {
+public:
+								TestRegistration(const char* name,
+									test_function function);
+};
+
+bool check_condition(bool condition, const char* expression,
+	const char* file, int line);
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistration sRegistration_##name(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	check_condition((condition), #condition, __FILE__, __LINE__)
+
+#endif // TEST_SUPPORT_H
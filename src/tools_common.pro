@@ -0,0 +1,109 @@
+# Common settings for the command line tools (Resizer, Cropper, Denoiser,
+# BatchRenderer, RenderBenchmark) and the tests. They don't use any widgets,
+# only the parts of the platform and render code needed to process bitmaps.
+
+QT       += core gui
+QT       -= widgets
+
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include (src_common.pro)
+
+OBJECTS_DIR = .obj/$$TARGET
+
+INCLUDEPATH += /usr/include/freetype2
+INCLUDEPATH += agg/font_freetype
+INCLUDEPATH += agg/include
+INCLUDEPATH += cimg
+
+QMAKE_CXXFLAGS += -iquote $$PWD/edits
+QMAKE_CXXFLAGS += -iquote $$PWD/edits/base
+QMAKE_CXXFLAGS += -iquote $$PWD/import_export
+QMAKE_CXXFLAGS += -iquote $$PWD/import_export/bitmap
+QMAKE_CXXFLAGS += -iquote $$PWD/import_export/message
+QMAKE_CXXFLAGS += -iquote $$PWD/model
+QMAKE_CXXFLAGS += -iquote $$PWD/model/document
+QMAKE_CXXFLAGS += -iquote $$PWD/model/fills
+QMAKE_CXXFLAGS += -iquote $$PWD/model/objects
+QMAKE_CXXFLAGS += -iquote $$PWD/model/property
+QMAKE_CXXFLAGS += -iquote $$PWD/model/property/specific_properties
+QMAKE_CXXFLAGS += -iquote $$PWD/model/snapshots
+QMAKE_CXXFLAGS += -iquote $$PWD/model/text
+QMAKE_CXXFLAGS += -iquote $$PWD/render
+QMAKE_CXXFLAGS += -iquote $$PWD/render/text
+QMAKE_CXXFLAGS += -iquote $$PWD/savers
+QMAKE_CXXFLAGS += -iquote $$PWD/support
+QMAKE_CXXFLAGS += -iquote $$PWD/tests
+
+LIBS += -Lagg -lagg -lfreetype -lz
+
+TARGETDEPS += agg/libagg.a
+
+SOURCES += \
+	model/BaseObject.cpp \
+	model/CloneContext.cpp \
+	model/fills/Color.cpp \
+	model/fills/ColorProvider.cpp \
+	model/fills/ColorShade.cpp \
+	model/fills/Gradient.cpp \
+	model/fills/Paint.cpp \
+	model/fills/StrokeProperties.cpp \
+	model/property/CommonPropertyIDs.cpp \
+	model/property/Property.cpp \
+	model/property/PropertyObject.cpp \
+	model/property/PropertyObjectProperty.cpp \
+	model/property/specific_properties/ColorProperty.cpp \
+	model/property/specific_properties/IconProperty.cpp \
+	model/property/specific_properties/Int64Property.cpp \
+	model/property/specific_properties/OptionProperty.cpp \
+	platform/qt/platform_bitmap_support.cpp \
+	platform/qt/platform_support.cpp \
+	platform/qt/PlatformResourceParser.cpp \
+	platform/qt/PlatformSemaphoreManager.cpp \
+	platform/qt/PlatformThread.cpp \
+	platform/qt/system/ArchivingManagers.cpp \
+	platform/qt/system/BArchivable.cpp \
+	platform/qt/system/BBitmap.cpp \
+	platform/qt/system/BBitmapStream.cpp \
+	platform/qt/system/BByteOrder.cpp \
+	platform/qt/system/BDataIO.cpp \
+	platform/qt/system/BDirectory.cpp \
+	platform/qt/system/BEntry.cpp \
+	platform/qt/system/BFile.cpp \
+	platform/qt/system/BFlattenable.cpp \
+	platform/qt/system/BGradient.cpp \
+	platform/qt/system/BGraphicsDefs.cpp \
+	platform/qt/system/BList.cpp \
+	platform/qt/system/BLocker.cpp \
+	platform/qt/system/BMessage.cpp \
+	platform/qt/system/BMessageAdapter.cpp \
+	platform/qt/system/BMessageUtils.cpp \
+	platform/qt/system/BOS.cpp \
+	platform/qt/system/BPath.cpp \
+	platform/qt/system/BPoint.cpp \
+	platform/qt/system/BPointerList.cpp \
+	platform/qt/system/BRect.cpp \
+	platform/qt/system/BRegion.cpp \
+	platform/qt/system/BRegionSupport.cpp \
+	platform/qt/system/BResources.cpp \
+	platform/qt/system/BShape.cpp \
+	platform/qt/system/BSize.cpp \
+	platform/qt/system/BString.cpp \
+	platform/qt/system/BTranslationUtils.cpp \
+	platform/qt/system/BTranslatorRoster.cpp \
+	render/BrushStampCache.cpp \
+	render/LayoutState.cpp \
+	render/MipPyramid.cpp \
+	render/PixelBuffer.cpp \
+	render/PixelKernels.cpp \
+	render/RenderBuffer.cpp \
+	render/RenderEngine.cpp \
+	render/RenderTrace.cpp \
+	support/Debug.cpp \
+	support/Listener.cpp \
+	support/Notifier.cpp \
+	support/Referenceable.cpp \
+	support/support.cpp \
+	support/Transformable.cpp
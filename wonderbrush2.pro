@@ -5,10 +5,42 @@ SUBDIRS += \
     src \
 	src/gui/colorpicker \
 	src/gui/scrollview \
-	src/icon
+	src/icon \
+	batchrenderer \
+	cropper \
+	denoiser \
+	renderbenchmark \
+	resizer \
+	tests
 
 src.depends = \
 	src/agg \
 	src/gui/colorpicker \
 	src/gui/scrollview \
 	src/icon
+
+# The command line tools live in the src directory as well, each needs its
+# own Makefile there.
+batchrenderer.file = src/BatchRenderer.pro
+batchrenderer.makefile = Makefile.BatchRenderer
+batchrenderer.depends = src/agg
+
+cropper.file = src/Cropper.pro
+cropper.makefile = Makefile.Cropper
+cropper.depends = src/agg
+
+denoiser.file = src/Denoiser.pro
+denoiser.makefile = Makefile.Denoiser
+denoiser.depends = src/agg
+
+renderbenchmark.file = src/RenderBenchmark.pro
+renderbenchmark.makefile = Makefile.RenderBenchmark
+renderbenchmark.depends = src/agg
+
+resizer.file = src/Resizer.pro
+resizer.makefile = Makefile.Resizer
+resizer.depends = src/agg
+
+tests.file = src/Tests.pro
+tests.makefile = Makefile.Tests
+tests.depends = src/agg